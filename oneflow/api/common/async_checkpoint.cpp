@@ -0,0 +1,192 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/api/common/async_checkpoint.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/singleton.h"
+#include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/ep/include/device_manager_registry.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/tensor_util.h"
+#include "oneflow/core/functional/functional_api.yaml.h"
+#include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/memory/memory_case_util.h"
+#include "oneflow/core/persistence/tensor_pack.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr size_t kStagingAlignment = 64;
+
+}  // namespace
+
+AsyncCheckpointFuture::AsyncCheckpointFuture(const std::string& path, uint64_t total_bytes)
+    : path_(path), total_bytes_(total_bytes), written_bytes_(0), done_(false) {}
+
+double AsyncCheckpointFuture::progress() const {
+  if (total_bytes_ == 0) { return done() ? 1.0 : 0.0; }
+  return static_cast<double>(written_bytes_) / total_bytes_;
+}
+
+bool AsyncCheckpointFuture::done() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return done_;
+}
+
+void AsyncCheckpointFuture::Wait() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return done_; });
+}
+
+void AsyncCheckpointFuture::SetDone() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  cond_.notify_all();
+}
+
+class AsyncCheckpointSaver::StagingArena final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(StagingArena);
+  StagingArena(const std::shared_ptr<ep::Device>& device, size_t size)
+      : device_(device), ptr_(nullptr), size_(size) {
+    CHECK_JUST(device_->AllocPinned(ep::AllocationOptions{}, &ptr_, size_));
+  }
+  ~StagingArena() { device_->FreePinned(ep::AllocationOptions{}, ptr_); }
+
+  const std::shared_ptr<ep::Device>& device() const { return device_; }
+  char* ptr() const { return static_cast<char*>(ptr_); }
+  size_t size() const { return size_; }
+
+ private:
+  std::shared_ptr<ep::Device> device_;
+  void* ptr_;
+  size_t size_;
+};
+
+AsyncCheckpointSaver::AsyncCheckpointSaver(size_t max_pending_saves)
+    : max_pending_saves_(max_pending_saves), num_pending_saves_(0) {
+  CHECK_GT(max_pending_saves_, 0);
+  writer_thread_ = std::thread([this]() { WriteLoop(); });
+}
+
+AsyncCheckpointSaver::~AsyncCheckpointSaver() {
+  tasks_.Close();
+  writer_thread_.join();
+}
+
+std::shared_ptr<AsyncCheckpointSaver::StagingArena> AsyncCheckpointSaver::AcquireArena(
+    const std::shared_ptr<ep::Device>& device, size_t size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return num_pending_saves_ < max_pending_saves_; });
+  num_pending_saves_ += 1;
+  for (auto it = free_arenas_.begin(); it != free_arenas_.end(); ++it) {
+    if ((*it)->device() == device && (*it)->size() >= size) {
+      auto arena = *it;
+      free_arenas_.erase(it);
+      return arena;
+    }
+  }
+  // arenas too small for the tensors are dropped, checkpoints rarely shrink
+  free_arenas_.clear();
+  return std::make_shared<StagingArena>(device, std::max<size_t>(size, kStagingAlignment));
+}
+
+void AsyncCheckpointSaver::ReleaseArena(std::shared_ptr<StagingArena>&& arena) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    free_arenas_.emplace_back(std::move(arena));
+    num_pending_saves_ -= 1;
+  }
+  cond_.notify_all();
+}
+
+Maybe<AsyncCheckpointFuture> AsyncCheckpointSaver::Save(
+    const std::string& path, const std::vector<std::string>& names,
+    const std::vector<std::shared_ptr<one::Tensor>>& tensors) {
+  CHECK_EQ_OR_RETURN(names.size(), tensors.size());
+  SaveTask task;
+  task.names = names;
+  size_t arena_size = 0;
+  uint64_t total_bytes = 0;
+  Symbol<Device> staging_device = JUST(Device::New("cpu"));
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    CHECK_OR_RETURN(tensors[i]->is_local())
+        << "only local tensors can be saved to a tensor pack, got global tensor " << names[i];
+    // the arena is pinned for the first non cpu device of the tensors
+    if (staging_device->enum_type() == DeviceType::kCPU) {
+      staging_device = JUST(tensors[i]->device());
+    }
+    task.data_types.emplace_back(tensors[i]->dtype()->data_type());
+    task.shapes.emplace_back(*tensors[i]->shape());
+    task.offsets.emplace_back(arena_size);
+    const size_t data_size =
+        task.shapes.back().elem_cnt() * GetSizeOfDataType(task.data_types.back());
+    arena_size += RoundUp(data_size, kStagingAlignment);
+    total_bytes += data_size;
+  }
+  task.arena = AcquireArena(Singleton<ep::DeviceManagerRegistry>::Get()->GetDevice(
+                                staging_device->enum_type(), staging_device->device_id()),
+                            arena_size);
+  const auto CopyToArena = [&]() -> Maybe<void> {
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      const auto tensor = JUST(one::functional::ToContiguous(tensors[i]));
+      char* dst = task.arena->ptr() + task.offsets[i];
+      const auto& callback = [&](ep::Stream* stream,
+                                 const std::shared_ptr<vm::EagerBlobObject>& eager_blob_object) {
+        SyncAutoMemcpy(stream, dst, eager_blob_object->dptr(),
+                       eager_blob_object->ByteSizeOfBlobBody(), memory::MakeHostMemCase(),
+                       eager_blob_object->mem_case());
+      };
+      JUST(one::SyncAccessTensorWithTimeOut(tensor, callback, "const"));
+    }
+    return Maybe<void>::Ok();
+  };
+  const auto& copied = CopyToArena();
+  if (!copied.IsOk()) {
+    ReleaseArena(std::move(task.arena));
+    return copied.stacked_error();
+  }
+  auto future = std::make_shared<AsyncCheckpointFuture>(path, total_bytes);
+  task.future = future;
+  CHECK_EQ_OR_RETURN(tasks_.Send(std::move(task)), kChannelStatusSuccess)
+      << "the checkpoint saver is closed";
+  return future;
+}
+
+void AsyncCheckpointSaver::WaitAll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return num_pending_saves_ == 0; });
+}
+
+void AsyncCheckpointSaver::WriteLoop() {
+  SaveTask task;
+  while (tasks_.Receive(&task) == kChannelStatusSuccess) {
+    TensorPackWriter writer(LocalFS(), task.future->path());
+    for (size_t i = 0; i < task.names.size(); ++i) {
+      writer.Add(task.names[i], task.data_types[i], task.shapes[i],
+                 task.arena->ptr() + task.offsets[i]);
+    }
+    const auto& future = task.future;
+    writer.Close([&future](uint64_t size) { future->AddWrittenBytes(size); });
+    ReleaseArena(std::move(task.arena));
+    future->SetDone();
+    task = SaveTask();
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_API_COMMON_ASYNC_CHECKPOINT_H_
+#define ONEFLOW_API_COMMON_ASYNC_CHECKPOINT_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/framework/tensor.h"
+
+namespace oneflow {
+
+namespace ep {
+
+class Device;
+
+}  // namespace ep
+
+// Progress and completion of a checkpoint saved by AsyncCheckpointSaver
+class AsyncCheckpointFuture final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncCheckpointFuture);
+  AsyncCheckpointFuture(const std::string& path, uint64_t total_bytes);
+  ~AsyncCheckpointFuture() = default;
+
+  const std::string& path() const { return path_; }
+  uint64_t total_bytes() const { return total_bytes_; }
+  uint64_t written_bytes() const { return written_bytes_; }
+  // Fraction of the tensor data written to the file
+  double progress() const;
+  // True once the file is synced and renamed to path
+  bool done() const;
+  void Wait() const;
+
+  void AddWrittenBytes(uint64_t size) { written_bytes_ += size; }
+  void SetDone();
+
+ private:
+  std::string path_;
+  uint64_t total_bytes_;
+  std::atomic<uint64_t> written_bytes_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable cond_;
+  bool done_;
+};
+
+// Saves local tensors to tensor pack files without blocking on disk I/O. Save only copies the
+// tensors into a host staging arena, which is pinned for device tensors, and a background
+// thread writes the arena to the file. Arenas are reused across saves, at most
+// max_pending_saves saves are in flight and Save blocks until an earlier one completes.
+class AsyncCheckpointSaver final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncCheckpointSaver);
+  explicit AsyncCheckpointSaver(size_t max_pending_saves);
+  // Waits for all pending saves
+  ~AsyncCheckpointSaver();
+
+  Maybe<AsyncCheckpointFuture> Save(const std::string& path, const std::vector<std::string>& names,
+                                    const std::vector<std::shared_ptr<one::Tensor>>& tensors);
+  void WaitAll();
+
+ private:
+  class StagingArena;
+  struct SaveTask {
+    std::vector<std::string> names;
+    std::vector<DataType> data_types;
+    std::vector<Shape> shapes;
+    std::vector<size_t> offsets;
+    std::shared_ptr<StagingArena> arena;
+    std::shared_ptr<AsyncCheckpointFuture> future;
+  };
+
+  std::shared_ptr<StagingArena> AcquireArena(const std::shared_ptr<ep::Device>& device,
+                                             size_t size);
+  void ReleaseArena(std::shared_ptr<StagingArena>&& arena);
+  void WriteLoop();
+
+  size_t max_pending_saves_;
+  size_t num_pending_saves_;
+  std::vector<std::shared_ptr<StagingArena>> free_arenas_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  Channel<SaveTask> tasks_;
+  std::thread writer_thread_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_API_COMMON_ASYNC_CHECKPOINT_H_
@@ -0,0 +1,152 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/api/common/tensor_pack.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/local_dep_object.h"
+#include "oneflow/core/eager/tensor_storage.h"
+#include "oneflow/core/framework/stream.h"
+#include "oneflow/core/framework/tensor_util.h"
+#include "oneflow/core/functional/functional_api.yaml.h"
+#include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/memory/memory_case_util.h"
+#include "oneflow/core/persistence/tensor_pack.h"
+
+namespace oneflow {
+
+namespace {
+
+// Wraps host memory as a cpu tensor without copying, free is called when the tensor is released
+Maybe<one::Tensor> NewCpuTensorFromBuffer(char* ptr, const std::function<void(char*)>& free,
+                                          const Shape& shape, DataType data_type,
+                                          Symbol<Device> device) {
+  const auto tensor_meta =
+      SymbolOf(one::LocalTensorMeta(shape, data_type, MemoryFormat::kContiguous, device));
+  auto tensor_data = std::make_shared<vm::TensorStorage>(false, device);
+  tensor_data->set_blob_dptr(std::unique_ptr<char, std::function<void(char*)>>(ptr, free),
+                             shape.elem_cnt() * GetSizeOfDataType(data_type));
+  auto tensor_storage = std::make_shared<one::TensorStorage>(tensor_data);
+  auto tensor_impl = std::make_shared<one::EagerLocalTensorImpl>(tensor_storage,
+                                                                 /*requires_grad=*/false,
+                                                                 /*is_leaf=*/true);
+  JUST(tensor_impl->InitEagerBlobObject(tensor_meta, NewLocalDepObject()));
+  const auto& stream = JUST(GetDefaultStreamByDevice(device));
+  const auto& eager_blob_object = JUST(tensor_impl->eager_blob_object());
+  JUST(eager_blob_object->init_producer_stream(stream));
+  eager_blob_object->set_last_used_stream(stream);
+  return std::static_pointer_cast<one::Tensor>(std::make_shared<one::LocalTensor>(tensor_impl));
+}
+
+}  // namespace
+
+Maybe<std::vector<std::string>> ListTensorPackFiles(const std::string& dir) {
+  std::vector<std::string> paths;
+  if (!LocalFS()->IsDirectory(dir)) { return paths; }
+  for (const auto& file : LocalFS()->ListDir(dir)) {
+    const size_t suffix_size = std::strlen(kTensorPackFileSuffix);
+    if (file.size() > suffix_size
+        && file.compare(file.size() - suffix_size, suffix_size, kTensorPackFileSuffix) == 0) {
+      paths.emplace_back(JoinPath(dir, file));
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+Maybe<std::tuple<std::vector<std::string>, std::vector<std::shared_ptr<one::Tensor>>>>
+LoadTensorPacks(const std::vector<std::string>& paths, Symbol<Device> device, bool use_mmap) {
+  const bool is_cpu = device->type() == "cpu";
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<one::Tensor>> tensors;
+  for (const auto& path : paths) {
+    CHECK_OR_RETURN(LocalFS()->FileExists(path)) << "tensor pack " << path << " does not exist";
+    const auto reader = std::make_shared<TensorPackReader>(LocalFS(), path, use_mmap && is_cpu);
+    std::vector<size_t> to_read;
+    std::vector<char*> dsts;
+    // host staging buffers of tensors on other devices
+    std::vector<std::vector<char>> staging(reader->num_tensors());
+    FOR_RANGE(size_t, i, 0, reader->num_tensors()) {
+      const Shape shape = reader->shape(i);
+      const DataType data_type = reader->data_type(i);
+      std::shared_ptr<one::Tensor> tensor;
+      if (is_cpu && reader->mapped()) {
+        // the mapping lives as long as any tensor of the file
+        tensor = JUST(NewCpuTensorFromBuffer(
+            reader->MappedData(i), [reader](char*) {}, shape, data_type, device));
+      } else if (is_cpu) {
+        char* buffer = new char[reader->data_size(i)];
+        tensor = JUST(NewCpuTensorFromBuffer(
+            buffer, [](char* ptr) { delete[] ptr; }, shape, data_type, device));
+        to_read.emplace_back(i);
+        dsts.emplace_back(buffer);
+      } else {
+        staging[i].resize(reader->data_size(i));
+        to_read.emplace_back(i);
+        dsts.emplace_back(staging[i].data());
+      }
+      CHECK_OR_RETURN(std::find(names.begin(), names.end(), reader->name(i)) == names.end())
+          << "tensor " << reader->name(i) << " appears in more than one tensor pack";
+      names.emplace_back(reader->name(i));
+      tensors.emplace_back(tensor);
+    }
+    reader->Read(to_read, dsts);
+    if (is_cpu) { continue; }
+    const size_t offset = tensors.size() - reader->num_tensors();
+    FOR_RANGE(size_t, i, 0, reader->num_tensors()) {
+      auto& tensor = tensors.at(offset + i);
+      tensor = JUST(one::functional::Empty(reader->shape(i),
+                                           JUST(DType::Get(reader->data_type(i))), device,
+                                           /*requires_grad=*/false, /*pin_memory=*/false));
+      const char* src = staging[i].data();
+      const auto& callback = [&](ep::Stream* stream,
+                                 const std::shared_ptr<vm::EagerBlobObject>& eager_blob_object) {
+        SyncAutoMemcpy(stream, eager_blob_object->mut_dptr(), src,
+                       eager_blob_object->ByteSizeOfBlobBody(), eager_blob_object->mem_case(),
+                       memory::MakeHostMemCase());
+      };
+      JUST(one::SyncAccessTensorWithTimeOut(tensor, callback, "mut"));
+    }
+  }
+  return std::make_tuple(names, tensors);
+}
+
+Maybe<void> SaveTensorPack(const std::string& path, const std::vector<std::string>& names,
+                           const std::vector<std::shared_ptr<one::Tensor>>& tensors) {
+  CHECK_EQ_OR_RETURN(names.size(), tensors.size());
+  std::vector<std::vector<char>> buffers(tensors.size());
+  TensorPackWriter writer(LocalFS(), path);
+  FOR_RANGE(size_t, i, 0, tensors.size()) {
+    CHECK_OR_RETURN(tensors[i]->is_local())
+        << "only local tensors can be saved to a tensor pack, got global tensor " << names[i];
+    const auto tensor = JUST(one::functional::ToContiguous(tensors[i]));
+    const DataType data_type = tensor->dtype()->data_type();
+    buffers[i].resize(tensor->shape()->elem_cnt() * GetSizeOfDataType(data_type));
+    char* dst = buffers[i].data();
+    const auto& callback = [&](ep::Stream* stream,
+                               const std::shared_ptr<vm::EagerBlobObject>& eager_blob_object) {
+      SyncAutoMemcpy(stream, dst, eager_blob_object->dptr(),
+                     eager_blob_object->ByteSizeOfBlobBody(), memory::MakeHostMemCase(),
+                     eager_blob_object->mem_case());
+    };
+    JUST(one::SyncAccessTensorWithTimeOut(tensor, callback, "const"));
+    writer.Add(names[i], data_type, *tensor->shape(), dst);
+  }
+  writer.Close();
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_API_COMMON_TENSOR_PACK_H_
+#define ONEFLOW_API_COMMON_TENSOR_PACK_H_
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/tensor.h"
+
+namespace oneflow {
+
+// Returns the sorted tensor pack files (shards) in dir
+Maybe<std::vector<std::string>> ListTensorPackFiles(const std::string& dir);
+
+// Loads every tensor of the tensor pack files as a local tensor on device. CPU tensors are not
+// copied: with use_mmap they alias the copy-on-write mapping of the file, otherwise the file
+// is read by multiple threads straight into the tensor memory.
+Maybe<std::tuple<std::vector<std::string>, std::vector<std::shared_ptr<one::Tensor>>>>
+LoadTensorPacks(const std::vector<std::string>& paths, Symbol<Device> device, bool use_mmap);
+
+// Saves local tensors to a tensor pack file
+Maybe<void> SaveTensorPack(const std::string& path, const std::vector<std::string>& names,
+                           const std::vector<std::shared_ptr<one::Tensor>>& tensors);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_API_COMMON_TENSOR_PACK_H_
@@ -23,5 +23,7 @@ limitations under the License.
 #include "framework/tensor.h"
 #include "framework/ivalue.h"
 #include "framework/graph.h"
+#include "framework/batching_server.h"
+#include "framework/graph_instance_pool.h"
 
 #endif  // ONEFLOW_API_CPP_FRAMEWORK_H_
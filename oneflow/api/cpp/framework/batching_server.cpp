@@ -0,0 +1,231 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/api/cpp/framework/batching_server.h"
+#include <algorithm>
+#include <stdexcept>
+#include "oneflow/api/cpp/framework/tensor.h"
+#include "oneflow/core/common/scalar.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/functional/functional.h"
+#include "oneflow/core/job/lazy_mode.h"
+
+namespace oneflow_api {
+
+namespace of = oneflow;
+namespace functional = of::one::functional;
+
+namespace {
+
+std::vector<Tensor> ToTensorVector(const IValue& value) {
+  if (value.IsTensor()) { return {value.ToTensor()}; }
+  if (value.IsTensorVector()) { return value.ToTensorVector(); }
+  throw std::invalid_argument("BatchingServer only supports Tensor/vector(Tensor) inputs");
+}
+
+IValue FromTensorVector(std::vector<Tensor>&& tensors) {
+  if (tensors.size() == 1) { return IValue(std::move(tensors.at(0))); }
+  return IValue(std::move(tensors));
+}
+
+// Rows [begin, end) of tensor, copied so that they outlive the output buffers of the graph
+Tensor SliceRows(const Tensor& tensor, int64_t begin, int64_t end) {
+  const auto& of_tensor = tensor.__internal_tensor();
+  const int64_t num_axes = of_tensor->shape()->NumAxes();
+  std::vector<int64_t> start(num_axes, 0);
+  std::vector<int64_t> stop(of_tensor->shape()->dim_vec().begin(),
+                            of_tensor->shape()->dim_vec().end());
+  std::vector<int64_t> step(num_axes, 1);
+  start[0] = begin;
+  stop[0] = end;
+  return Tensor(functional::Slice(of_tensor, start, stop, step, /*enable_view_slice=*/false)
+                    .GetPtrOrThrow());
+}
+
+}  // namespace
+
+BatchingServer::BatchingServer(const std::string& model_path, const Device& device,
+                               const BatchingOptions& options)
+    : options_(options), device_(device), closed_(false) {
+  if (options_.batch_size_buckets.empty()) {
+    throw std::invalid_argument("BatchingServer needs at least one batch size bucket");
+  }
+  std::sort(options_.batch_size_buckets.begin(), options_.batch_size_buckets.end());
+  for (int64_t batch_size : options_.batch_size_buckets) {
+    graphs_.emplace_back(Graph::Load(model_path, device));
+    graphs_.back().set_batch_size(batch_size);
+  }
+  worker_thread_ = std::thread([this]() { WorkLoop(); });
+}
+
+BatchingServer::~BatchingServer() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  cond_.notify_all();
+  worker_thread_.join();
+  for (auto& request : queue_) {
+    request.promise.set_exception(
+        std::make_exception_ptr(std::runtime_error("BatchingServer is destroyed")));
+  }
+}
+
+std::future<IValue> BatchingServer::Submit(const IValue& inputs) {
+  Request request;
+  request.inputs = ToTensorVector(inputs);
+  if (request.inputs.empty()) {
+    throw std::invalid_argument("BatchingServer needs at least one input tensor");
+  }
+  request.num_rows = request.inputs.at(0).shape().At(0);
+  for (const auto& input : request.inputs) {
+    if (input.shape().NumAxes() == 0 || input.shape().At(0) != request.num_rows) {
+      throw std::invalid_argument("all inputs of a request must have the same number of rows");
+    }
+  }
+  if (request.num_rows > options_.batch_size_buckets.back()) {
+    throw std::invalid_argument("the request has more rows than the largest batch size bucket");
+  }
+  request.enqueue_time = std::chrono::steady_clock::now();
+  std::future<IValue> future = request.promise.get_future();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.emplace_back(std::move(request));
+  }
+  cond_.notify_all();
+  return future;
+}
+
+void BatchingServer::Warmup() {
+  std::lock_guard<std::mutex> lock(forward_mutex_);
+  for (size_t i = 0; i < graphs_.size(); ++i) {
+    const int64_t batch_size = options_.batch_size_buckets.at(i);
+    const InputOutputInfos input_infos = graphs_.at(i).GetInputInfos();
+    std::vector<Tensor> inputs(input_infos.size());
+    for (const auto& input_info : input_infos) {
+      const auto& attribute = input_info.second;
+      std::vector<int64_t> dims{batch_size};
+      for (int64_t axis = 1; axis < attribute.input_output_shape_.NumAxes(); ++axis) {
+        dims.emplace_back(attribute.input_output_shape_.At(axis));
+      }
+      Tensor input(Shape(dims), device_, attribute.datatype_);
+      input.zeros_();
+      inputs.at(attribute.input_output_index_) = input;
+    }
+    graphs_.at(i).Forward(inputs);
+  }
+}
+
+BatchingStats BatchingServer::stats() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+size_t BatchingServer::BucketIndex(int64_t num_rows) const {
+  const auto& buckets = options_.batch_size_buckets;
+  return std::lower_bound(buckets.begin(), buckets.end(), num_rows) - buckets.begin();
+}
+
+void BatchingServer::WorkLoop() {
+  const int64_t max_batch_size = options_.batch_size_buckets.back();
+  const auto max_queue_delay = std::chrono::microseconds(options_.max_queue_delay_us);
+  while (true) {
+    std::vector<Request> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+      if (closed_) { return; }
+      const auto deadline = queue_.front().enqueue_time + max_queue_delay;
+      const auto QueuedRows = [this]() {
+        int64_t num_rows = 0;
+        for (const auto& request : queue_) { num_rows += request.num_rows; }
+        return num_rows;
+      };
+      cond_.wait_until(lock, deadline,
+                       [&]() { return closed_ || QueuedRows() >= max_batch_size; });
+      if (closed_) { return; }
+      int64_t num_rows = 0;
+      while (!queue_.empty() && num_rows + queue_.front().num_rows <= max_batch_size) {
+        num_rows += queue_.front().num_rows;
+        batch.emplace_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+    RunBatch(&batch);
+  }
+}
+
+void BatchingServer::RunBatch(std::vector<Request>* batch) {
+  try {
+    of::LazyMode::Guard lazy_mode_disabled_guard(/*is_enabled*/ false);
+    const size_t num_inputs = batch->front().inputs.size();
+    int64_t num_rows = 0;
+    for (const auto& request : *batch) {
+      if (request.inputs.size() != num_inputs) {
+        throw std::invalid_argument("requests of a batch have different numbers of inputs");
+      }
+      num_rows += request.num_rows;
+    }
+    const size_t bucket = BucketIndex(num_rows);
+    const int64_t batch_size = options_.batch_size_buckets.at(bucket);
+    std::vector<Tensor> inputs;
+    for (size_t i = 0; i < num_inputs; ++i) {
+      of::one::TensorTuple parts;
+      for (const auto& request : *batch) {
+        parts.emplace_back(request.inputs.at(i).__internal_tensor());
+      }
+      if (batch_size > num_rows) {
+        const auto& first = parts.front();
+        of::DimVector dims = first->shape()->dim_vec();
+        dims.at(0) = batch_size - num_rows;
+        parts.emplace_back(functional::Constant(of::Shape(dims), of::Scalar(0),
+                                                first->dtype(), first->device().GetOrThrow())
+                               .GetPtrOrThrow());
+      }
+      inputs.emplace_back(parts.size() == 1 ? Tensor(parts.front())
+                                            : Tensor(functional::Concat(parts, 0).GetPtrOrThrow()));
+    }
+    std::vector<Tensor> outputs;
+    {
+      std::lock_guard<std::mutex> lock(forward_mutex_);
+      outputs = ToTensorVector(graphs_.at(bucket).Forward(inputs));
+      int64_t begin = 0;
+      for (auto& request : *batch) {
+        std::vector<Tensor> request_outputs;
+        for (const auto& output : outputs) {
+          request_outputs.emplace_back(SliceRows(output, begin, begin + request.num_rows));
+        }
+        begin += request.num_rows;
+        request.promise.set_value(FromTensorVector(std::move(request_outputs)));
+      }
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats_.num_requests += batch->size();
+    stats_.num_batches += 1;
+    stats_.num_rows += num_rows;
+    stats_.num_padded_rows += batch_size - num_rows;
+  } catch (...) {
+    for (auto& request : *batch) {
+      try {
+        request.promise.set_exception(std::current_exception());
+      } catch (const std::future_error&) {
+        // the promise is already satisfied
+      }
+    }
+  }
+}
+
+}  // namespace oneflow_api
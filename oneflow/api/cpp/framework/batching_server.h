@@ -0,0 +1,97 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_API_CPP_FRAMEWORK_BATCHING_SERVER_H_
+#define ONEFLOW_API_CPP_FRAMEWORK_BATCHING_SERVER_H_
+
+#include "device.h"
+#include "graph.h"
+#include "ivalue.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace oneflow_api {
+
+struct BatchingOptions {
+  // Batch sizes of the compiled graphs, a batch runs on the smallest one that fits it and is
+  // padded with zeros up to that size
+  std::vector<int64_t> batch_size_buckets = {1, 2, 4, 8, 16, 32};
+  // How long the first request of a batch waits for more requests
+  int64_t max_queue_delay_us = 1000;
+};
+
+struct BatchingStats {
+  int64_t num_requests = 0;
+  int64_t num_batches = 0;
+  int64_t num_rows = 0;
+  int64_t num_padded_rows = 0;
+};
+
+// Serves a model to many concurrent callers by running their requests in batches. Every input
+// and output of the model is batched along axis 0; a request may carry any number of rows up
+// to the largest bucket. Requests are queued and a worker thread runs a batch once it reaches
+// the largest bucket or its first request has waited max_queue_delay_us, then scatters the
+// output rows back to the futures of the requests.
+class BatchingServer final {
+ public:
+  BatchingServer(const std::string& model_path, const Device& device,
+                 const BatchingOptions& options = BatchingOptions());
+  // Fails the requests which are still queued
+  ~BatchingServer();
+
+  BatchingServer(const BatchingServer& server) = delete;
+  BatchingServer& operator=(const BatchingServer& server) = delete;
+
+  // inputs is a Tensor or a vector of Tensor, the future holds the outputs of the request
+  std::future<IValue> Submit(const IValue& inputs);
+  // Compiles the graphs of all buckets, otherwise each is compiled by its first batch
+  void Warmup();
+  BatchingStats stats() const;
+
+ private:
+  struct Request {
+    std::vector<Tensor> inputs;
+    int64_t num_rows;
+    std::chrono::steady_clock::time_point enqueue_time;
+    std::promise<IValue> promise;
+  };
+
+  void WorkLoop();
+  void RunBatch(std::vector<Request>* batch);
+  size_t BucketIndex(int64_t num_rows) const;
+
+  BatchingOptions options_;
+  Device device_;
+  std::vector<Graph> graphs_;
+  std::deque<Request> queue_;
+  bool closed_;
+  BatchingStats stats_;
+  mutable std::mutex mutex_;
+  // serializes the forwards of the worker thread and Warmup
+  std::mutex forward_mutex_;
+  std::condition_variable cond_;
+  std::thread worker_thread_;
+};
+
+}  // namespace oneflow_api
+
+#endif  // ONEFLOW_API_CPP_FRAMEWORK_BATCHING_SERVER_H_
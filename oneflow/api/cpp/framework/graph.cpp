@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "nlohmann/json.hpp"
+#include "oneflow/api/common/tensor_pack.h"
 #include "oneflow/api/common/variable_tensor_mgr.h"
 #include "oneflow/api/cpp/env_impl.h"
 #include "oneflow/api/cpp/framework/device.h"
@@ -59,6 +60,7 @@ limitations under the License.
 #include "oneflow/core/operator/interface_blob_conf.pb.h"
 #include "oneflow/core/operator/op_conf.pb.h"
 #include "oneflow/core/register/logical_blob_id.pb.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/vm/vm_util.h"
 
 namespace oneflow_api {
@@ -157,13 +159,17 @@ class Graph::GraphImpl final {
 
   of::Maybe<void> RegisterJobPass(
       const std::function<std::string(const std::string& job)>& pass_fn);
+  std::unique_ptr<GraphImpl> NewInstance();
 
  private:
+  GraphImpl(const GraphImpl& prototype, const std::string& job_name_suffix);
+
   of::Maybe<void> CollectInputOutputInfos();
   of::Maybe<void> Compile(const std::vector<Tensor>& inputs);
   of::Maybe<std::vector<Tensor>> Run(const std::vector<Tensor>& inputs) const;
   of::Maybe<void> AddOp(of::OperatorConf op_conf);
   of::Maybe<void> BuildGraph();
+  of::Maybe<void> LoadVariables();
   of::Maybe<void> LoadCheckpoint();
   of::Maybe<void> RegisterTensors(const std::vector<Tensor>& inputs);
   of::Maybe<of::Job> ApplyJobPasses(const of::Job& job);
@@ -171,6 +177,7 @@ class Graph::GraphImpl final {
   std::shared_ptr<of::NNGraph> graph_ = nullptr;
   std::string model_path_;
   bool is_compiled_ = false;
+  bool is_variables_loaded_ = false;
   int batch_size_ = 0;
   Device device_;
   of::Job job_;
@@ -187,6 +194,8 @@ class Graph::GraphImpl final {
 Graph::Graph(const std::string& model_path, const Device& device)
     : graph_(std::make_unique<GraphImpl>(model_path, device)) {}
 
+Graph::Graph(std::unique_ptr<GraphImpl>&& graph) : graph_(std::move(graph)) {}
+
 Graph::~Graph() = default;
 
 Graph::Graph(Graph&& graph) noexcept : graph_(std::move(graph.graph_)) {}
@@ -229,6 +238,8 @@ IValue Graph::Forward(const IValue& inputs) {
 
 void Graph::set_batch_size(int batch_size) { graph_->set_batch_size(batch_size); }
 
+Graph Graph::NewInstance() { return Graph(graph_->NewInstance()); }
+
 Graph Graph::Load(const std::string& model_path, const Device& device) {
 #ifdef __linux__
   LoadOneEmbedding(model_path, device);
@@ -246,6 +257,25 @@ Graph::GraphImpl::GraphImpl(const std::string& model_path, const Device& device)
   job_.mutable_job_conf()->set_job_name(job_.mutable_job_conf()->job_name() + of::NewUniqueId());
 }
 
+Graph::GraphImpl::GraphImpl(const GraphImpl& prototype, const std::string& job_name_suffix)
+    : model_path_(prototype.model_path_),
+      is_variables_loaded_(prototype.is_variables_loaded_),
+      batch_size_(prototype.batch_size_),
+      device_(prototype.device_),
+      job_(prototype.job_),
+      input_infos_(prototype.input_infos_),
+      output_infos_(prototype.output_infos_),
+      variable_op_name_to_tensor_(prototype.variable_op_name_to_tensor_),
+      registered_job_passes_(prototype.registered_job_passes_) {
+  job_.mutable_job_conf()->set_job_name(job_.job_conf().job_name() + job_name_suffix);
+}
+
+std::unique_ptr<Graph::GraphImpl> Graph::GraphImpl::NewInstance() {
+  // the instances share the variable tensors, which are only read by inference
+  CHECK_JUST(LoadVariables());
+  return std::unique_ptr<GraphImpl>(new GraphImpl(*this, "_instance" + of::NewUniqueId()));
+}
+
 InputOutputInfos Graph::GraphImpl::GetInputInfos() { return input_infos_; }
 
 InputOutputInfos Graph::GraphImpl::GetOutputInfos() { return output_infos_; }
@@ -347,18 +377,10 @@ of::Maybe<void> Graph::GraphImpl::BuildGraph() {
     op_graph.TopoForEachNode([&](const of::OpNode* node) -> of::Maybe<void> {
       const of::OperatorConf& op_conf = node->op().op_conf();
       JUST(AddOp(op_conf));
-      if (op_conf.has_variable_conf()) {
-        const of::LazyMode::Guard lazy_mode_disabled_guard{false};
-        const of::VariableOpConf& variable_conf = op_conf.variable_conf();
-        variable_op_name_to_tensor_[op_conf.name()] = JUST(of::one::functional::Empty(
-            of::Shape(variable_conf.shape()),
-            JUST(of::DType::Get(static_cast<of::DataType>(variable_conf.data_type()))),
-            *device_.device_, /*requires_grad=*/false, /*pin_memory=*/false));
-      }
       return of::Maybe<void>::Ok();
     });
   }
-  JUST(LoadCheckpoint());
+  JUST(LoadVariables());
   JUST(of::CurJobBuildAndInferCtx_Complete());
   std::shared_ptr<of::Job> complete_job = JUST(of::GetCurrentJob());
   int64_t job_id = JUST(of::JobBuildAndInferCtx_GetCurrentJobId());
@@ -392,26 +414,78 @@ of::Maybe<void> Graph::GraphImpl::BuildGraph() {
   return of::Maybe<void>::Ok();
 }
 
+of::Maybe<void> Graph::GraphImpl::LoadVariables() {
+  if (is_variables_loaded_) { return of::Maybe<void>::Ok(); }
+  {
+    const of::LazyMode::Guard lazy_mode_disabled_guard{false};
+    for (const of::OperatorConf& op_conf : job_.net().op()) {
+      if (!op_conf.has_variable_conf()) { continue; }
+      const of::VariableOpConf& variable_conf = op_conf.variable_conf();
+      variable_op_name_to_tensor_[op_conf.name()] = JUST(of::one::functional::Empty(
+          of::Shape(variable_conf.shape()),
+          JUST(of::DType::Get(static_cast<of::DataType>(variable_conf.data_type()))),
+          *device_.device_, /*requires_grad=*/false, /*pin_memory=*/false));
+    }
+  }
+  JUST(LoadCheckpoint());
+  is_variables_loaded_ = true;
+  return of::Maybe<void>::Ok();
+}
+
 of::Maybe<void> Graph::GraphImpl::LoadCheckpoint() {
-  for (const auto& variable_op_name_and_tensor : variable_op_name_to_tensor_) {
-    const auto& variable_op_name = variable_op_name_and_tensor.first;
-    const auto& variable_tensor = variable_op_name_and_tensor.second;
-    const std::string variable_filename = model_path_ + "/" + variable_op_name + "/out";
-    const std::string buffer = [&]() {
+  const auto tensor_pack_paths = JUST(of::ListTensorPackFiles(model_path_));
+  if (!tensor_pack_paths->empty()) {
+    // cpu variables alias the mapped tensor packs instead of being copied
+    const of::LazyMode::Guard lazy_mode_disabled_guard{false};
+    const auto loaded = JUST(of::LoadTensorPacks(*tensor_pack_paths, *device_.device_,
+                                                 /*use_mmap=*/true));
+    const auto& names = std::get<0>(*loaded);
+    const auto& tensors = std::get<1>(*loaded);
+    size_t num_loaded_variables = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto it = variable_op_name_to_tensor_.find(names[i]);
+      // tensor packs may also hold tensors which are not used by this graph
+      if (it == variable_op_name_to_tensor_.end()) { continue; }
+      ++num_loaded_variables;
+      CHECK_OR_RETURN(*it->second->shape() == *tensors[i]->shape())
+          << "shape mismatch of variable " << names[i];
+      CHECK_OR_RETURN(it->second->dtype() == tensors[i]->dtype())
+          << "data type mismatch of variable " << names[i];
+      it->second = tensors[i];
+    }
+    if (num_loaded_variables != variable_op_name_to_tensor_.size()) {
+      const of::HashSet<std::string> loaded_names(names.begin(), names.end());
+      for (const auto& pair : variable_op_name_to_tensor_) {
+        CHECK_OR_RETURN(loaded_names.count(pair.first) > 0)
+            << "variable " << pair.first << " is not found in the tensor packs of " << model_path_;
+      }
+    }
+  } else {
+    const auto& pair = Unzip(variable_op_name_to_tensor_);
+    const auto& variable_op_names = pair.first;
+    const auto& variable_tensors = pair.second;
+    std::vector<std::string> buffers(variable_op_names.size());
+    of::MultiThreadLoop(variable_op_names.size(), [&](size_t i) {
+      const std::string variable_filename = model_path_ + "/" + variable_op_names[i] + "/out";
       std::ifstream variable_file(variable_filename, std::ios::binary);
       CHECK(variable_file.is_open());
       std::stringstream ss;
       ss << variable_file.rdbuf();
-      return ss.str();
-    }();
-    const auto& callback = [&](of::ep::Stream* stream,
-                               const std::shared_ptr<of::vm::EagerBlobObject>& eager_blob_object) {
-      of::AutoMemcpy(stream, eager_blob_object->mut_dptr(), buffer.data(),
-                     variable_tensor->shape()->elem_cnt()
-                         * of::GetSizeOfDataType(variable_tensor->dtype()->data_type()),
-                     eager_blob_object->mem_case(), of::memory::MakeHostMemCase());
-    };
-    JUST(of::one::SyncAccessTensorWithTimeOut(variable_tensor, callback, "mut"));
+      buffers[i] = ss.str();
+    });
+    for (size_t i = 0; i < variable_op_names.size(); ++i) {
+      const auto& variable_tensor = variable_tensors[i];
+      const std::string& buffer = buffers[i];
+      const auto& callback =
+          [&](of::ep::Stream* stream,
+              const std::shared_ptr<of::vm::EagerBlobObject>& eager_blob_object) {
+            of::AutoMemcpy(stream, eager_blob_object->mut_dptr(), buffer.data(),
+                           variable_tensor->shape()->elem_cnt()
+                               * of::GetSizeOfDataType(variable_tensor->dtype()->data_type()),
+                           eager_blob_object->mem_case(), of::memory::MakeHostMemCase());
+          };
+      JUST(of::one::SyncAccessTensorWithTimeOut(variable_tensor, callback, "mut"));
+    }
   }
   const auto& pair = Unzip(variable_op_name_to_tensor_);
   JUST(of::FillVariableTensorMgr(pair.first, pair.second));
@@ -64,6 +64,10 @@ class Graph {
   InputOutputInfos GetOutputInfos();
   IValue Forward(const IValue& inputs);
   void set_batch_size(int batch_size);
+  // Creates another execution instance of the model with its own runtime, so that instances
+  // run forwards concurrently. The instance shares the weights of this graph instead of
+  // loading them again.
+  Graph NewInstance();
 
   void RegisterJobPass(const std::function<std::string(const std::string& job)>& pass_fn);
 
@@ -71,6 +75,7 @@ class Graph {
 
  private:
   class GraphImpl;
+  explicit Graph(std::unique_ptr<GraphImpl>&& graph);
   std::unique_ptr<GraphImpl> graph_;
 };
 
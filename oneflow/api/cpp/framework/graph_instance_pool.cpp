@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/api/cpp/framework/graph_instance_pool.h"
+#include <stdexcept>
+#include "oneflow/api/cpp/framework/tensor.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/functional/functional.h"
+#include "oneflow/core/job/lazy_mode.h"
+
+namespace oneflow_api {
+
+namespace of = oneflow;
+namespace functional = of::one::functional;
+
+namespace {
+
+// The outputs of a graph are overwritten by its next forward, so they are cloned before the
+// instance is released
+Tensor CloneTensor(const Tensor& tensor) {
+  return Tensor(functional::Clone(tensor.__internal_tensor()).GetPtrOrThrow());
+}
+
+IValue CloneOutputs(const IValue& outputs) {
+  of::LazyMode::Guard lazy_mode_disabled_guard(/*is_enabled*/ false);
+  if (outputs.IsTensor()) { return IValue(CloneTensor(outputs.ToTensor())); }
+  if (outputs.IsTensorVector()) {
+    std::vector<Tensor> tensors;
+    for (const auto& tensor : outputs.ToTensorVector()) {
+      tensors.emplace_back(CloneTensor(tensor));
+    }
+    return IValue(std::move(tensors));
+  }
+  return outputs;
+}
+
+}  // namespace
+
+GraphInstancePool::GraphInstancePool(const std::string& model_path, const Device& device,
+                                     size_t num_instances, int batch_size) {
+  if (num_instances == 0) {
+    throw std::invalid_argument("GraphInstancePool needs at least one instance");
+  }
+  instances_.emplace_back(Graph::Load(model_path, device));
+  instances_.front().set_batch_size(batch_size);
+  for (size_t i = 1; i < num_instances; ++i) {
+    instances_.emplace_back(instances_.front().NewInstance());
+  }
+  for (size_t i = 0; i < num_instances; ++i) { free_instances_.emplace_back(i); }
+}
+
+IValue GraphInstancePool::Forward(const IValue& inputs) {
+  size_t instance = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return !free_instances_.empty(); });
+    instance = free_instances_.back();
+    free_instances_.pop_back();
+  }
+  const auto Release = [&]() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      free_instances_.emplace_back(instance);
+    }
+    cond_.notify_one();
+  };
+  try {
+    IValue outputs = CloneOutputs(instances_.at(instance).Forward(inputs));
+    Release();
+    return outputs;
+  } catch (...) {
+    Release();
+    throw;
+  }
+}
+
+}  // namespace oneflow_api
@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_API_CPP_FRAMEWORK_GRAPH_INSTANCE_POOL_H_
+#define ONEFLOW_API_CPP_FRAMEWORK_GRAPH_INSTANCE_POOL_H_
+
+#include "device.h"
+#include "graph.h"
+#include "ivalue.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace oneflow_api {
+
+// Runs the forwards of concurrent callers on num_instances instances of a model. Each instance
+// has its own runtime and all of them share one copy of the weights, so throughput scales
+// with the number of instances instead of serializing on one graph.
+class GraphInstancePool final {
+ public:
+  GraphInstancePool(const std::string& model_path, const Device& device, size_t num_instances,
+                    int batch_size = 0);
+  ~GraphInstancePool() = default;
+
+  GraphInstancePool(const GraphInstancePool& pool) = delete;
+  GraphInstancePool& operator=(const GraphInstancePool& pool) = delete;
+
+  // Thread safe, blocks until an instance is free
+  IValue Forward(const IValue& inputs);
+  size_t num_instances() const { return instances_.size(); }
+
+ private:
+  std::vector<Graph> instances_;
+  std::vector<size_t> free_instances_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+}  // namespace oneflow_api
+
+#endif  // ONEFLOW_API_CPP_FRAMEWORK_GRAPH_INSTANCE_POOL_H_
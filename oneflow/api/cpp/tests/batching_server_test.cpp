@@ -0,0 +1,86 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <future>
+#include <thread>
+#include <vector>
+#include "oneflow/api/cpp/framework.h"
+#include "oneflow/api/cpp/tests/api_test.h"
+
+namespace oneflow_api {
+
+namespace {
+
+constexpr char kModelPath[] = "./oneflow/api/cpp/tests/graph_test_model/affine_with_parameter";
+
+// The model computes x * a + b with a and b of ones, so every output element of a row is the
+// sum of the row plus one
+std::future<IValue> SubmitRows(BatchingServer& server, const Device& device, int64_t num_rows,
+                               float value) {
+  std::vector<float> data(num_rows * 3, value);
+  return server.Submit(
+      Tensor::from_buffer(data.data(), Shape({num_rows, 3}), device, DType::kFloat));
+}
+
+void CheckOutput(const IValue& value, int64_t num_rows, float input_value) {
+  ASSERT_TRUE(value.IsTensor());
+  const Tensor& output = value.ToTensor();
+  ASSERT_EQ(output.shape().At(0), num_rows);
+  ASSERT_EQ(output.shape().At(1), 4);
+  std::vector<float> buf(num_rows * 4);
+  output.copy_to(buf.data());
+  for (const float& element : buf) { ASSERT_EQ(element, input_value * 3 + 1); }
+}
+
+}  // namespace
+
+TEST(Api, batching_server_test) {
+  EnvScope scope;
+  Device device("cpu");
+  BatchingOptions options;
+  options.batch_size_buckets = {2, 8};
+  options.max_queue_delay_us = 10000;
+  BatchingServer server(kModelPath, device, options);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&server, &device, i]() {
+      const int64_t num_rows = i % 2 + 1;
+      for (int step = 0; step < 4; ++step) {
+        const float value = i * 10 + step;
+        CheckOutput(SubmitRows(server, device, num_rows, value).get(), num_rows, value);
+      }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+
+  const BatchingStats stats = server.stats();
+  ASSERT_EQ(stats.num_requests, 32);
+  ASSERT_EQ(stats.num_rows, 48);
+  ASSERT_LT(stats.num_batches, stats.num_requests);
+}
+
+TEST(Api, batching_server_reject_test) {
+  EnvScope scope;
+  Device device("cpu");
+  BatchingOptions options;
+  options.batch_size_buckets = {4};
+  BatchingServer server(kModelPath, device, options);
+  ASSERT_THROW(SubmitRows(server, device, 5, 1), std::invalid_argument);
+  CheckOutput(SubmitRows(server, device, 3, 1).get(), 3, 1);
+}
+
+}  // namespace oneflow_api
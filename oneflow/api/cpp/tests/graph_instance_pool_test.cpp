@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "oneflow/api/cpp/framework.h"
+#include "oneflow/api/cpp/tests/api_test.h"
+
+namespace oneflow_api {
+
+namespace {
+
+constexpr char kModelPath[] = "./oneflow/api/cpp/tests/graph_test_model/affine_with_parameter";
+
+// The model computes x * a + b with a and b of ones
+template<typename ForwardFn>
+void ForwardAndCheck(const ForwardFn& Forward, const Device& device, float value) {
+  std::vector<float> data(3, value);
+  const IValue output_value =
+      Forward(Tensor::from_buffer(data.data(), Shape({1, 3}), device, DType::kFloat));
+  ASSERT_TRUE(output_value.IsTensor());
+  std::vector<float> buf(4);
+  output_value.ToTensor().copy_to(buf.data());
+  for (const float& element : buf) { ASSERT_EQ(element, value * 3 + 1); }
+}
+
+}  // namespace
+
+TEST(Api, graph_new_instance_test) {
+  EnvScope scope;
+  Device device("cpu");
+  Graph graph = Graph::Load(kModelPath, device);
+  Graph instance = graph.NewInstance();
+  ForwardAndCheck([&](const IValue& inputs) { return instance.Forward(inputs); }, device, 1);
+  ForwardAndCheck([&](const IValue& inputs) { return graph.Forward(inputs); }, device, 2);
+}
+
+TEST(Api, graph_instance_pool_test) {
+  EnvScope scope;
+  Device device("cpu");
+  GraphInstancePool pool(kModelPath, device, 3);
+  ASSERT_EQ(pool.num_instances(), 3);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 6; ++i) {
+    threads.emplace_back([&pool, &device, i]() {
+      for (int step = 0; step < 8; ++step) {
+        ForwardAndCheck([&](const IValue& inputs) { return pool.Forward(inputs); }, device,
+                        i * 10 + step);
+      }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+}
+
+}  // namespace oneflow_api
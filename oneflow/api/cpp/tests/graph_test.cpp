@@ -19,6 +19,7 @@ limitations under the License.
 #include <array>
 #include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <thread>
@@ -27,6 +28,9 @@ limitations under the License.
 #include "oneflow/api/cpp/framework/dtype.h"
 #include "oneflow/api/cpp/framework/shape.h"
 #include "oneflow/api/cpp/tests/api_test.h"
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/tensor_pack.h"
 
 namespace oneflow_api {
 
@@ -38,7 +42,8 @@ inline Graph LoadGraph(const Device& device) {
   return graph;
 }
 
-inline void Forward(Graph& graph, const Device& device, int expected_batch_dim = 1) {
+inline void Forward(Graph& graph, const Device& device, int expected_batch_dim = 1,
+                    float expected_value = 4) {
   std::vector<float> data(expected_batch_dim * 3);
   std::fill(data.begin(), data.end(), 1);
   std::vector<Tensor> inputs;
@@ -52,7 +57,7 @@ inline void Forward(Graph& graph, const Device& device, int expected_batch_dim =
   ASSERT_EQ(shape.At(1), 4);
   std::vector<float> buf(expected_batch_dim * 4);
   output.copy_to(buf.data());
-  for (const float& element : buf) { ASSERT_EQ(element, 4); }
+  for (const float& element : buf) { ASSERT_EQ(element, expected_value); }
 }
 
 }  // namespace
@@ -84,6 +89,35 @@ TEST(Api, graph_multi_gpu_test) {
 }
 #endif
 
+TEST(Api, graph_cpu_tensor_pack_test) {
+  EnvScope scope;
+  const std::string model_path = oneflow::JoinPath(oneflow::GetCwd(), "tmp_graph_tensor_pack");
+  oneflow::LocalFS()->RecursivelyCreateDirIfNotExist(model_path);
+  {
+    std::ifstream src("./oneflow/api/cpp/tests/graph_test_model/affine_with_parameter/model.mlir");
+    std::ofstream dst(oneflow::JoinPath(model_path, "model.mlir"));
+    dst << src.rdbuf();
+  }
+  const std::string pack_path = oneflow::JoinPath(model_path, "model.ofpack");
+  std::vector<float> weight(3 * 4, 2);
+  std::vector<float> bias(4, 0.5);
+  {
+    oneflow::TensorPackWriter writer(oneflow::LocalFS(), pack_path);
+    writer.Add("model.a", oneflow::DataType::kFloat, oneflow::Shape({3, 4}),
+               reinterpret_cast<char*>(weight.data()));
+    writer.Add("model.b", oneflow::DataType::kFloat, oneflow::Shape({4}),
+               reinterpret_cast<char*>(bias.data()));
+    writer.Close();
+  }
+  {
+    Device device("cpu");
+    Graph graph = Graph::Load(model_path, device);
+    // the variables are read from the tensor pack instead of the per-variable files
+    Forward(graph, device, 1, 3 * 2 + 0.5);
+  }
+  oneflow::LocalFS()->RecursivelyDeleteDir(model_path);
+}
+
 TEST(Api, graph_cpu_batching_test) {
   EnvScope scope;
   Device device("cpu");
@@ -0,0 +1,42 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "oneflow/api/common/async_checkpoint.h"
+#include "oneflow/api/python/of_api_registry.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  py::class_<AsyncCheckpointFuture, std::shared_ptr<AsyncCheckpointFuture>>(
+      m, "AsyncCheckpointFuture")
+      .def_property_readonly("path", &AsyncCheckpointFuture::path)
+      .def_property_readonly("total_bytes", &AsyncCheckpointFuture::total_bytes)
+      .def_property_readonly("written_bytes", &AsyncCheckpointFuture::written_bytes)
+      .def("progress", &AsyncCheckpointFuture::progress)
+      .def("done", &AsyncCheckpointFuture::done)
+      .def("wait", &AsyncCheckpointFuture::Wait, py::call_guard<py::gil_scoped_release>());
+
+  py::class_<AsyncCheckpointSaver, std::shared_ptr<AsyncCheckpointSaver>>(m,
+                                                                          "AsyncCheckpointSaver")
+      .def(py::init<size_t>())
+      .def("save", &AsyncCheckpointSaver::Save)
+      .def("wait_all", &AsyncCheckpointSaver::WaitAll, py::call_guard<py::gil_scoped_release>());
+}
+
+}  // namespace oneflow
@@ -88,6 +88,53 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         return OpInterpUtil::Dispatch<Tensor>(*op, {},
                                               OpExprInterpContext(attrs, placement, nd_sbp));
       });
+  m.add_functor(
+      "DispatchFlatRecordReader",
+      [](const std::shared_ptr<OpExpr>& op, const std::string& data_dir, int32_t data_part_num,
+         const std::string& part_name_prefix, int32_t part_name_suffix_length, int32_t batch_size,
+         int32_t shuffle_buffer_size, bool random_shuffle, bool shuffle_after_epoch, int64_t seed,
+         const std::vector<std::string>& names, const std::vector<Shape>& shapes,
+         const std::vector<Symbol<DType>>& data_types, bool truncate,
+         const Optional<Symbol<Device>>& device) -> Maybe<TensorTuple> {
+        std::vector<DataType> out_data_types;
+        for (const auto& data_type : data_types) {
+          out_data_types.emplace_back(data_type->data_type());
+        }
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "data_dir", "data_part_num", "part_name_prefix", "part_name_suffix_length",
+            "batch_size", "shuffle_buffer_size", "random_shuffle", "shuffle_after_epoch", "seed",
+            "names", "shapes", "data_types", "truncate");
+        attrs.SetAllAttrs(data_dir, data_part_num, part_name_prefix, part_name_suffix_length,
+                          batch_size, shuffle_buffer_size, random_shuffle, shuffle_after_epoch,
+                          seed, names, shapes, out_data_types, truncate);
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, JUST(device)));
+      });
+  m.add_functor(
+      "DispatchFlatRecordReader",
+      [](const std::shared_ptr<OpExpr>& op, const std::string& data_dir, int32_t data_part_num,
+         const std::string& part_name_prefix, int32_t part_name_suffix_length, int32_t batch_size,
+         int32_t shuffle_buffer_size, bool random_shuffle, bool shuffle_after_epoch, int64_t seed,
+         const std::vector<std::string>& names, const std::vector<Shape>& shapes,
+         const std::vector<Symbol<DType>>& data_types, bool truncate,
+         const Symbol<ParallelDesc>& placement,
+         const std::vector<Symbol<SbpParallel>>& sbp_tuple) -> Maybe<TensorTuple> {
+        std::vector<DataType> out_data_types;
+        for (const auto& data_type : data_types) {
+          out_data_types.emplace_back(data_type->data_type());
+        }
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "data_dir", "data_part_num", "part_name_prefix", "part_name_suffix_length",
+            "batch_size", "shuffle_buffer_size", "random_shuffle", "shuffle_after_epoch", "seed",
+            "names", "shapes", "data_types", "truncate", "nd_sbp");
+        attrs.SetAllAttrs(data_dir, data_part_num, part_name_prefix, part_name_suffix_length,
+                          batch_size, shuffle_buffer_size, random_shuffle, shuffle_after_epoch,
+                          seed, names, shapes, out_data_types, truncate,
+                          *JUST(GetNdSbpStrList(sbp_tuple)));
+        auto nd_sbp = JUST(GetNdSbp(sbp_tuple));
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, placement, nd_sbp));
+      });
   m.add_functor("DispatchOfrecordRawDecoder",
                 [](const std::shared_ptr<OpExpr>& op, const std::shared_ptr<Tensor>& input,
                    const std::string& name, const Shape& shape, const Symbol<DType>& data_type,
@@ -231,6 +278,23 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         attrs.SetAllAttrs(color_space, data_type->data_type());
         return OpInterpUtil::Dispatch<Tensor>(*op, {input}, attrs);
       });
+  m.add_functor(
+      "DispatchImageDecodeRandomCropResizeNormalize",
+      [](const std::shared_ptr<OpExpr>& op, const TensorTuple& input,
+         const std::string& color_space, const std::string& output_layout, int64_t target_height,
+         int64_t target_width, const std::string& interpolation_type,
+         const std::vector<float>& mean, const std::vector<float>& std, bool random_crop,
+         const std::vector<float>& random_area, const std::vector<float>& random_aspect_ratio,
+         int32_t num_attempts, int64_t seed, bool has_seed, bool dct_scaling) -> Maybe<Tensor> {
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "color_space", "output_layout", "target_height", "target_width", "interpolation_type",
+            "mean", "std", "random_crop", "random_area", "random_aspect_ratio", "num_attempts",
+            "seed", "has_seed", "dct_scaling");
+        attrs.SetAllAttrs(color_space, output_layout, target_height, target_width,
+                          interpolation_type, mean, std, random_crop, random_area,
+                          random_aspect_ratio, num_attempts, seed, has_seed, dct_scaling);
+        return OpInterpUtil::Dispatch<Tensor>(*op, input, attrs);
+      });
   m.add_functor("DispatchImageNormalize",
                 [](const std::shared_ptr<OpExpr>& op, const std::shared_ptr<Tensor>& input,
                    const std::vector<float>& mean, const std::vector<float>& std) -> Maybe<Tensor> {
@@ -317,6 +381,42 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
         return OpInterpUtil::Dispatch<Tensor>(*op, {},
                                               OpExprInterpContext(attrs, placement, nd_sbp));
       });
+  m.add_functor(
+      "DispatchMegatronGptMmapPackedDataLoader",
+      [](const std::shared_ptr<OpExpr>& op, const std::string& data_file_prefix, int64_t seq_length,
+         int64_t label_length, int64_t num_samples, int64_t batch_size, const Symbol<DType>& dtype,
+         const std::vector<int64_t>& split_sizes, int64_t split_index, bool shuffle,
+         int64_t random_seed, int64_t max_num_segments, int64_t pad_token_id,
+         const Optional<Symbol<Device>>& device) -> Maybe<TensorTuple> {
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "data_file_prefix", "seq_length", "label_length", "num_samples", "batch_size", "dtype",
+            "split_sizes", "split_index", "shuffle", "random_seed", "max_num_segments",
+            "pad_token_id");
+        attrs.SetAllAttrs(data_file_prefix, seq_length, label_length, num_samples, batch_size,
+                          dtype->data_type(), split_sizes, split_index, shuffle, random_seed,
+                          max_num_segments, pad_token_id);
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, JUST(device)));
+      });
+  m.add_functor(
+      "DispatchMegatronGptMmapPackedDataLoader",
+      [](const std::shared_ptr<OpExpr>& op, const std::string& data_file_prefix, int64_t seq_length,
+         int64_t label_length, int64_t num_samples, int64_t batch_size, const Symbol<DType>& dtype,
+         const std::vector<int64_t>& split_sizes, int64_t split_index, bool shuffle,
+         int64_t random_seed, int64_t max_num_segments, int64_t pad_token_id,
+         const Symbol<ParallelDesc>& placement,
+         const std::vector<Symbol<SbpParallel>>& sbp_tuple) -> Maybe<TensorTuple> {
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "data_file_prefix", "seq_length", "label_length", "num_samples", "batch_size", "dtype",
+            "split_sizes", "split_index", "shuffle", "random_seed", "max_num_segments",
+            "pad_token_id");
+        attrs.SetAllAttrs(data_file_prefix, seq_length, label_length, num_samples, batch_size,
+                          dtype->data_type(), split_sizes, split_index, shuffle, random_seed,
+                          max_num_segments, pad_token_id);
+        auto nd_sbp = JUST(GetNdSbp(sbp_tuple));
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, placement, nd_sbp));
+      });
   m.add_functor("DispatchRmspropUpdate",
                 [](const std::shared_ptr<OpExpr>& op, const TensorTuple& inputs,
                    float learning_rate, double scale, float l1, float l2, bool centered,
@@ -451,6 +551,48 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
                   return OpInterpUtil::Dispatch<Tensor>(
                       *op, {}, OpExprInterpContext(attrs, placement, nd_sbp));
                 });
+  m.add_functor(
+      "DispatchColumnarReader",
+      [](const std::shared_ptr<OpExpr>& op, const std::vector<std::string>& files,
+         const std::vector<std::string>& columns, const std::vector<Shape>& shapes,
+         const std::vector<Symbol<DType>>& data_types, int64_t batch_size, bool random_shuffle,
+         int64_t seed, const std::string& predicate_column, double predicate_lower,
+         double predicate_upper, const Optional<Symbol<Device>>& device) -> Maybe<TensorTuple> {
+        std::vector<DataType> out_data_types;
+        for (const auto& data_type : data_types) {
+          out_data_types.emplace_back(data_type->data_type());
+        }
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "files", "columns", "shapes", "data_types", "batch_size", "random_shuffle", "seed",
+            "predicate_column", "predicate_lower", "predicate_upper", "nd_sbp");
+        attrs.SetAllAttrs(files, columns, shapes, out_data_types, batch_size, random_shuffle, seed,
+                          predicate_column, predicate_lower, predicate_upper,
+                          std::vector<std::string>());
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, JUST(device)));
+      });
+  m.add_functor(
+      "DispatchColumnarReader",
+      [](const std::shared_ptr<OpExpr>& op, const std::vector<std::string>& files,
+         const std::vector<std::string>& columns, const std::vector<Shape>& shapes,
+         const std::vector<Symbol<DType>>& data_types, int64_t batch_size, bool random_shuffle,
+         int64_t seed, const std::string& predicate_column, double predicate_lower,
+         double predicate_upper, const Symbol<ParallelDesc>& placement,
+         const std::vector<Symbol<SbpParallel>>& sbp_tuple) -> Maybe<TensorTuple> {
+        std::vector<DataType> out_data_types;
+        for (const auto& data_type : data_types) {
+          out_data_types.emplace_back(data_type->data_type());
+        }
+        auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP(
+            "files", "columns", "shapes", "data_types", "batch_size", "random_shuffle", "seed",
+            "predicate_column", "predicate_lower", "predicate_upper", "nd_sbp");
+        attrs.SetAllAttrs(files, columns, shapes, out_data_types, batch_size, random_shuffle, seed,
+                          predicate_column, predicate_lower, predicate_upper,
+                          *JUST(GetNdSbpStrList(sbp_tuple)));
+        auto nd_sbp = JUST(GetNdSbp(sbp_tuple));
+        return OpInterpUtil::Dispatch<TensorTuple>(*op, {},
+                                                   OpExprInterpContext(attrs, placement, nd_sbp));
+      });
 }
 
 }  // namespace impl
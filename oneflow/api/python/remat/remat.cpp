@@ -62,6 +62,14 @@ ONEFLOW_API_PYBIND11_MODULE("remat", m) {
     JUST(rematable_storage(t))->Evict(false);
     return Maybe<void>::Ok();
   });
+  m.def("swap_out", [](const std::shared_ptr<one::Tensor>& t) -> Maybe<void> {
+    // TODO: an instruction
+    JUST(rematable_storage(t))->SwapOut();
+    return Maybe<void>::Ok();
+  });
+  m.def("is_swapped", [](const std::shared_ptr<one::Tensor>& tensor) -> Maybe<bool> {
+    return JUST(rematable_storage(tensor))->is_swapped();
+  });
   m.def("is_evictable", [](const std::shared_ptr<one::Tensor>& t) -> Maybe<bool> {
     return JUST(rematable_storage(t))->is_evictable();
   });
@@ -78,10 +86,21 @@ ONEFLOW_API_PYBIND11_MODULE("remat", m) {
         []() { return Singleton<remat::Env>::Get()->forced_eviction_num(); });
   m.def("eager_eviction_num", []() { return Singleton<remat::Env>::Get()->eager_eviction_num(); });
   m.def("recomputation_num", []() { return Singleton<remat::Env>::Get()->recomputation_num(); });
+  m.def("swap_out_num", []() { return Singleton<remat::Env>::Get()->swap_out_num(); });
+  m.def("swap_out_bytes", []() { return Singleton<remat::Env>::Get()->swap_out_bytes(); });
+  m.def("swap_in_num", []() { return Singleton<remat::Env>::Get()->swap_in_num(); });
+  m.def("swap_in_bytes", []() { return Singleton<remat::Env>::Get()->swap_in_bytes(); });
+  m.def("swap_memory_in_bytes",
+        []() { return Singleton<remat::Env>::Get()->swap_memory_in_bytes(); });
   m.def("set_budget_in_bytes", [](size_t budget_in_bytes) {
     Singleton<remat::Env>::Get()->set_budget_in_bytes(budget_in_bytes);
   });
   m.def("budget_in_bytes", []() { return Singleton<remat::Env>::Get()->budget_in_bytes(); });
+  m.def("set_swap_budget_in_bytes", [](size_t budget_in_bytes) {
+    Singleton<remat::Env>::Get()->set_swap_budget_in_bytes(budget_in_bytes);
+  });
+  m.def("swap_budget_in_bytes",
+        []() { return Singleton<remat::Env>::Get()->swap_budget_in_bytes(); });
   m.def("set_small_pieces_optimization", [](bool enabled) {
     return Singleton<remat::Env>::Get()->set_small_pieces_optimization(enabled);
   });
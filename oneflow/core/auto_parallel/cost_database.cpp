@@ -0,0 +1,142 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/auto_parallel/cost_database.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/graph/op_graph.h"
+#include "oneflow/core/operator/operator.h"
+
+namespace oneflow {
+namespace auto_parallel {
+
+namespace {
+
+std::string OpType4OpConf(const OperatorConf& op_conf) {
+  if (op_conf.has_user_conf()) { return op_conf.user_conf().op_type_name(); }
+  return std::to_string(op_conf.op_type_case());
+}
+
+}  // namespace
+
+std::string CostDatabase::GenKernelKey(const OperatorConf& op_conf,
+                                       const std::vector<Shape>& physical_in_shapes) {
+  std::string key = OpType4OpConf(op_conf) + "@" + op_conf.device_tag();
+  for (const auto& shape : physical_in_shapes) { key += "|" + shape.ToString(); }
+  return key;
+}
+
+Maybe<std::string> CostDatabase::GenKernelKey(const OpNode& op_node,
+                                              const NdSbpSignature& nd_sbp_signature,
+                                              int64_t parallel_id) {
+  const Operator& op = op_node.op();
+  std::vector<Shape> physical_in_shapes;
+  physical_in_shapes.reserve(op.input_bns().size());
+  for (const auto& ibn : op.input_bns()) {
+    const BlobDesc& logical_blob_desc = op_node.LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn));
+    const auto& nd_sbp_it = nd_sbp_signature.bn_in_op2nd_sbp().find(ibn);
+    CHECK_OR_RETURN(nd_sbp_it != nd_sbp_signature.bn_in_op2nd_sbp().end())
+        << "No sbp found for " << ibn << " of " << op.op_name();
+    physical_in_shapes.emplace_back(*JUST(GetPhysicalShape(
+        logical_blob_desc.shape(), nd_sbp_it->second, op_node.parallel_desc(), parallel_id)));
+  }
+  return GenKernelKey(op.op_conf(), physical_in_shapes);
+}
+
+void CostDatabase::AddKernelTime(const std::string& key, double time_us) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto& time_and_sample_num = key2time_and_sample_num_[key];
+  time_and_sample_num.first += time_us;
+  time_and_sample_num.second++;
+}
+
+void CostDatabase::AddTransfer(int64_t byte_size, double time_us) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  transfer_total_byte_ += byte_size;
+  transfer_total_time_us_ += time_us;
+}
+
+Optional<double> CostDatabase::KernelTime(const std::string& key) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto& it = key2time_and_sample_num_.find(key);
+  if (it == key2time_and_sample_num_.end() || it->second.second <= 0) { return NullOpt; }
+  return it->second.first / it->second.second;
+}
+
+Optional<double> CostDatabase::TransferBandwidth() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (transfer_total_byte_ <= 0 || transfer_total_time_us_ <= 0) { return NullOpt; }
+  return transfer_total_byte_ / transfer_total_time_us_;
+}
+
+int64_t CostDatabase::KernelRecordNum() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return key2time_and_sample_num_.size();
+}
+
+Maybe<void> CostDatabase::Load(const std::string& path) {
+  CostDatabaseProto proto;
+  CHECK_OR_RETURN(TryParseProtoFromTextFile(path, &proto))
+      << "Failed to parse the cost database " << path;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const auto& record : proto.kernel_cost()) {
+    auto& time_and_sample_num = key2time_and_sample_num_[record.key()];
+    time_and_sample_num.first += record.total_time_us();
+    time_and_sample_num.second += record.sample_num();
+  }
+  transfer_total_byte_ += proto.transfer_total_byte();
+  transfer_total_time_us_ += proto.transfer_total_time_us();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CostDatabase::Save(const std::string& path) const {
+  CostDatabaseProto proto;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Sort the records to keep the file stable between runs
+    std::map<std::string, std::pair<double, int64_t>> sorted_records(
+        key2time_and_sample_num_.begin(), key2time_and_sample_num_.end());
+    for (const auto& pair : sorted_records) {
+      auto* record = proto.add_kernel_cost();
+      record->set_key(pair.first);
+      record->set_total_time_us(pair.second.first);
+      record->set_sample_num(pair.second.second);
+    }
+    proto.set_transfer_total_byte(transfer_total_byte_);
+    proto.set_transfer_total_time_us(transfer_total_time_us_);
+  }
+  PrintProtoToTextFile(proto, path);
+  return Maybe<void>::Ok();
+}
+
+Maybe<CostDatabase> LoadCostDatabase(const std::string& path) {
+  CHECK_OR_RETURN(!path.empty()) << "The path of the cost database is empty";
+  auto cost_database = std::make_shared<CostDatabase>();
+  JUST(cost_database->Load(path));
+  return cost_database;
+}
+
+Maybe<const CostDatabase> GetCostDatabase(const std::string& path) {
+  static std::mutex mutex;
+  static HashMap<std::string, std::shared_ptr<const CostDatabase>> path2cost_database;
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = path2cost_database.find(path);
+  if (it == path2cost_database.end()) {
+    it = path2cost_database.emplace(path, JUST(LoadCostDatabase(path))).first;
+  }
+  return it->second;
+}
+
+}  // namespace auto_parallel
+}  // namespace oneflow
@@ -0,0 +1,78 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_AUTO_PARALLEL_COST_DATABASE_H_
+#define ONEFLOW_CORE_AUTO_PARALLEL_COST_DATABASE_H_
+
+#include <mutex>
+#include "oneflow/core/common/optional.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/auto_parallel/cost_database.pb.h"
+
+namespace oneflow {
+
+class OpNode;
+class OperatorConf;
+class NdSbpSignature;
+
+namespace auto_parallel {
+
+// A database of measured kernel time and boxing bandwidth.
+// It is filled by the CostProfilingKernelObserver while running a job with
+// ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE, and is fed back into the auto parallel and the
+// straighten algorithm by job_conf.auto_parallel_cost_database_path in the next compilation.
+class CostDatabase final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CostDatabase);
+  CostDatabase() : transfer_total_byte_(0), transfer_total_time_us_(0) {}
+  ~CostDatabase() = default;
+
+  // The key of a kernel is made of its op type, device and the physical shapes of its inputs
+  static std::string GenKernelKey(const OperatorConf& op_conf,
+                                  const std::vector<Shape>& physical_in_shapes);
+  // Generate the key for an op node under the given sbp signature on the given parallel id
+  static Maybe<std::string> GenKernelKey(const OpNode& op_node,
+                                         const NdSbpSignature& nd_sbp_signature,
+                                         int64_t parallel_id);
+
+  void AddKernelTime(const std::string& key, double time_us);
+  void AddTransfer(int64_t byte_size, double time_us);
+
+  // The average time of the kernel in microseconds
+  Optional<double> KernelTime(const std::string& key) const;
+  // Measured boxing bandwidth in bytes per microsecond
+  Optional<double> TransferBandwidth() const;
+  int64_t KernelRecordNum() const;
+
+  // Merge the records in the file into this database
+  Maybe<void> Load(const std::string& path);
+  Maybe<void> Save(const std::string& path) const;
+
+ private:
+  mutable std::mutex mutex_;
+  HashMap<std::string, std::pair<double, int64_t>> key2time_and_sample_num_;
+  double transfer_total_byte_;
+  double transfer_total_time_us_;
+};
+
+Maybe<CostDatabase> LoadCostDatabase(const std::string& path);
+// Load the database at the path once in a process, the later calls share the loaded one
+Maybe<const CostDatabase> GetCostDatabase(const std::string& path);
+
+}  // namespace auto_parallel
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_AUTO_PARALLEL_COST_DATABASE_H_
@@ -0,0 +1,65 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "oneflow/core/auto_parallel/cost_database.h"
+#include "oneflow/core/operator/op_conf.pb.h"
+
+namespace oneflow {
+namespace auto_parallel {
+
+namespace test {
+
+TEST(CostDatabase, kernel_key) {
+  OperatorConf op_conf;
+  op_conf.set_device_tag("cpu");
+  op_conf.mutable_user_conf()->set_op_type_name("matmul");
+  const std::string key = CostDatabase::GenKernelKey(op_conf, {Shape({4, 8}), Shape({8, 16})});
+  ASSERT_EQ(key, CostDatabase::GenKernelKey(op_conf, {Shape({4, 8}), Shape({8, 16})}));
+  ASSERT_NE(key, CostDatabase::GenKernelKey(op_conf, {Shape({2, 8}), Shape({8, 16})}));
+  op_conf.set_device_tag("cuda");
+  ASSERT_NE(key, CostDatabase::GenKernelKey(op_conf, {Shape({4, 8}), Shape({8, 16})}));
+}
+
+TEST(CostDatabase, save_and_load) {
+  CostDatabase cost_database;
+  ASSERT_FALSE(cost_database.KernelTime("a").has_value());
+  ASSERT_FALSE(cost_database.TransferBandwidth().has_value());
+  cost_database.AddKernelTime("a", 10.0);
+  cost_database.AddKernelTime("a", 20.0);
+  cost_database.AddTransfer(1000, 4.0);
+  ASSERT_DOUBLE_EQ(CHECK_JUST(cost_database.KernelTime("a")), 15.0);
+  ASSERT_DOUBLE_EQ(CHECK_JUST(cost_database.TransferBandwidth()), 250.0);
+
+  const std::string path = "./tmp_cost_database_test.prototxt";
+  CHECK_JUST(cost_database.Save(path));
+  auto loaded = CHECK_JUST(LoadCostDatabase(path));
+  ASSERT_DOUBLE_EQ(CHECK_JUST(loaded->KernelTime("a")), 15.0);
+  ASSERT_DOUBLE_EQ(CHECK_JUST(loaded->TransferBandwidth()), 250.0);
+  // Loading into a database accumulates the samples
+  loaded->AddKernelTime("a", 45.0);
+  ASSERT_DOUBLE_EQ(CHECK_JUST(loaded->KernelTime("a")), 25.0);
+  // The cached database is loaded only once
+  auto cached = CHECK_JUST(GetCostDatabase(path));
+  ASSERT_EQ(cached, CHECK_JUST(GetCostDatabase(path)));
+  ASSERT_DOUBLE_EQ(CHECK_JUST(cached->KernelTime("a")), 15.0);
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+
+}  // namespace auto_parallel
+}  // namespace oneflow
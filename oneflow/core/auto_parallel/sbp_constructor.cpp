@@ -285,7 +285,14 @@ Maybe<void> SbpConstructor::StealSbpSignatureFromOpNode(const OpGraph& op_graph,
 }
 
 Maybe<void> SbpConstructor::InitComputationCost(const OpGraph& op_graph) {
-  // Compute computation cost for sbp nodes
+  // The profiled cost is measured by bytes, the unit of the copy cost. The static computation
+  // complexity of the other ops is converted into bytes by the ratio between the profiled cost and
+  // the complexity of the profiled ops, and by auto_parallel_computation_cost_ratio if none is
+  // profiled.
+  HashMap<const SbpNode*, std::vector<Optional<double>>> sbp_node2profiled_costs;
+  double total_profiled_cost = 0.0;
+  double total_profiled_complexity = 0.0;
+  // Compute computation complexity for sbp nodes
   JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
     // get corresponding sbp node producer
     SbpNode* sbp_node = op_name2sbp_node_[op_node->op().op_name()];
@@ -297,15 +304,39 @@ Maybe<void> SbpConstructor::InitComputationCost(const OpGraph& op_graph) {
       const LogicalBlobId& lbi = op_node->op().BnInOp2Lbi(bn);
       return op_node->LogicalBlobDesc4Lbi(lbi);
     };
+    auto& profiled_costs = sbp_node2profiled_costs[sbp_node];
+    profiled_costs.resize(sbp_node->sbp_sig_list_.size());
     for (int32_t sbp_id = 0; sbp_id < sbp_node->sbp_sig_list_.size(); sbp_id++) {
       double comp_cost = JUST(op_node->op().GetComputeComplexity(
           &sbp_node->sbp_sig_list_[sbp_id], LogicalBlobDesc4Bn, parallel_desc));
-      if (comp_cost > GetValidMaxCopyCost()) {
-        sbp_node->cost_[sbp_id] = comp_cost;
-      } else {
-        sbp_node->cost_[sbp_id] =
-            cost_ratio_ * comp_cost
-            * JUST(op_node->op().GetInputOutputFastestTimeShape())->elem_cnt();
+      profiled_costs[sbp_id] =
+          *JUST(GetProfiledComputationCost(*op_node, sbp_node->sbp_sig_list_[sbp_id]));
+      if (profiled_costs[sbp_id].has_value() && comp_cost > 0.0
+          && comp_cost <= GetValidMaxCopyCost()) {
+        total_profiled_cost += JUST(profiled_costs[sbp_id]);
+        total_profiled_complexity += comp_cost;
+      }
+      // Hold the complexity until the ratio is known
+      sbp_node->cost_[sbp_id] = comp_cost;
+    }
+    return Maybe<void>::Ok();
+  }));
+  double cost_ratio = cost_ratio_;
+  if (total_profiled_complexity > 0.0) {
+    cost_ratio = total_profiled_cost / total_profiled_complexity;
+    LOG(INFO) << "Computation cost ratio fitted by the cost database: " << cost_ratio;
+  }
+  // Compute computation cost for sbp nodes
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
+    SbpNode* sbp_node = op_name2sbp_node_[op_node->op().op_name()];
+    const auto& profiled_costs = sbp_node2profiled_costs.at(sbp_node);
+    const int64_t time_shape_elem_cnt =
+        JUST(op_node->op().GetInputOutputFastestTimeShape())->elem_cnt();
+    for (int32_t sbp_id = 0; sbp_id < sbp_node->sbp_sig_list_.size(); sbp_id++) {
+      if (profiled_costs[sbp_id].has_value()) {
+        sbp_node->cost_[sbp_id] = JUST(profiled_costs[sbp_id]) * time_shape_elem_cnt;
+      } else if (sbp_node->cost_[sbp_id] <= GetValidMaxCopyCost()) {
+        sbp_node->cost_[sbp_id] = cost_ratio * sbp_node->cost_[sbp_id] * time_shape_elem_cnt;
       }
     }
     return Maybe<void>::Ok();
@@ -313,6 +344,33 @@ Maybe<void> SbpConstructor::InitComputationCost(const OpGraph& op_graph) {
   return Maybe<void>::Ok();
 }
 
+// The copy cost is measured by bytes. Convert the measured kernel time to the bytes transferred
+// in the same period with the measured boxing bandwidth, so that both costs are comparable.
+// Only the master rank writes the database, so the kernels of the other ranks might be missing.
+// The slowest one among the profiled ranks is taken since it bounds the whole op.
+Maybe<Optional<double>> SbpConstructor::GetProfiledComputationCost(
+    const OpNode& op_node, const NdSbpSignature& nd_sbp_signature) {
+  if (!cost_database_) { return Optional<double>(); }
+  const auto& bandwidth = cost_database_->TransferBandwidth();
+  if (!bandwidth.has_value()) { return Optional<double>(); }
+  Optional<double> max_kernel_time;
+  // Ranks with the same physical shapes share a key
+  HashSet<std::string> visited_keys;
+  for (int64_t parallel_id = 0; parallel_id < op_node.parallel_desc().parallel_num();
+       ++parallel_id) {
+    const std::string& key =
+        *JUST(CostDatabase::GenKernelKey(op_node, nd_sbp_signature, parallel_id));
+    if (!visited_keys.insert(key).second) { continue; }
+    const auto& kernel_time = cost_database_->KernelTime(key);
+    if (!kernel_time.has_value()) { continue; }
+    if (!max_kernel_time.has_value() || JUST(kernel_time) > JUST(max_kernel_time)) {
+      max_kernel_time = kernel_time;
+    }
+  }
+  if (!max_kernel_time.has_value()) { return Optional<double>(); }
+  return Optional<double>(JUST(max_kernel_time) * JUST(bandwidth));
+}
+
 // Init copy cost and memory for edges
 Maybe<void> SbpConstructor::InitCopyAndMemoryCost(const OpGraph& op_graph) {
   bool nccl_not_use_compute_stream = !nccl_use_compute_stream_;
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/auto_parallel/sbp_graph.h"
+#include "oneflow/core/auto_parallel/cost_database.h"
 #include "oneflow/core/job/global_for.h"
 
 namespace oneflow {
@@ -45,6 +46,10 @@ class SbpConstructor final {
                            && job->job_conf().enable_auto_parallel_sbp_collector()),
         op_graph_(&op_graph) {
     sbp_graph_.SetWaitTime(job->job_conf().auto_parallel_wait_time());
+    if (!job->job_conf().auto_parallel_cost_database_path().empty()) {
+      cost_database_ =
+          CHECK_JUST(GetCostDatabase(job->job_conf().auto_parallel_cost_database_path()));
+    }
     CHECK_JUST(Init(op_graph, job));
   }
   ~SbpConstructor() = default;
@@ -63,6 +68,9 @@ class SbpConstructor final {
   Maybe<void> FillSbpSignatureForOpNode(const OpGraph& op_graph, const Job& job);
   Maybe<void> StealSbpSignatureFromOpNode(const OpGraph& op_graph, const Job& job);
   Maybe<void> InitComputationCost(const OpGraph& op_graph);
+  // Measured computation cost, return NullOpt if not profiled
+  Maybe<Optional<double>> GetProfiledComputationCost(const OpNode& op_node,
+                                                     const NdSbpSignature& nd_sbp_signature);
   Maybe<void> InitCopyAndMemoryCost(const OpGraph& op_graph);
   Maybe<void> ApplyTrunkAlgo();
   Maybe<HashMap<const OpNode*, HashSet<std::string>>> GetMutableOpCtrlDeps(const OpGraph& op_graph);
@@ -79,6 +87,7 @@ class SbpConstructor final {
   HashMap<std::string, SbpNode*> op_name2sbp_node_;
   bool nccl_use_compute_stream_;
   int64_t available_memory_;
+  std::shared_ptr<const CostDatabase> cost_database_;
 };
 
 }  // namespace auto_parallel
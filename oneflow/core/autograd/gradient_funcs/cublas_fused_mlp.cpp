@@ -23,7 +23,6 @@ limitations under the License.
 #include "oneflow/core/common/container_util.h"
 #include "oneflow/core/functional/functional.h"
 #include "oneflow/core/functional/functional_api.yaml.h"
-#if CUDA_VERSION >= 11060
 
 namespace oneflow {
 
@@ -125,7 +124,9 @@ Maybe<void> CublasFusedMLP::Apply(const CublasFusedMLPCaptureState* ctx,
   std::shared_ptr<one::Tensor> cublas_dy = last_bias_dy;
 
   // Use Fully Fused MLP Backward.
-  if (ParseBooleanFromEnv("ONEFLOW_ONE_EMBEDDING_FUSED_MLP_ASYNC_GRAD", false)) {
+  // The fully fused backward is only implemented for CUDA.
+  if (cublas_dy->is_cuda()
+      && ParseBooleanFromEnv("ONEFLOW_ONE_EMBEDDING_FUSED_MLP_ASYNC_GRAD", false)) {
     const std::vector<float> alpha_list(weight_num - 1, 1.0);
     const auto& fused_mlp_grad =
         JUST(functional::FusedMLPGrad(cublas_dy, JUST(VectorAt(ctx->SavedTensors(), 0)), weights,
@@ -212,4 +213,3 @@ REGISTER_OP_EXPR_GRAD_FUNCTION("cublas_fused_mlp", CublasFusedMLP);
 }  // namespace one
 
 }  // namespace oneflow
-#endif  // CUDA_VERSION >= 11060
@@ -23,7 +23,6 @@ limitations under the License.
 #include "oneflow/core/common/container_util.h"
 #include "oneflow/core/functional/functional.h"
 #include "oneflow/core/functional/functional_api.yaml.h"
-#if CUDA_VERSION >= 11060
 
 namespace oneflow {
 
@@ -137,7 +136,9 @@ Maybe<void> FusedMatmulBiasAddReluDropout::Apply(
                                                          cublas_auxs[weight_num - 1], scale));
   }
 
-  if (ParseBooleanFromEnv("ONEFLOW_ONE_EMBEDDING_FUSED_MLP_ASYNC_GRAD", false)) {
+  // The fully fused backward is only implemented for CUDA.
+  if (last_bias_dy->is_cuda()
+      && ParseBooleanFromEnv("ONEFLOW_ONE_EMBEDDING_FUSED_MLP_ASYNC_GRAD", false)) {
     std::vector<float> alpha_list(weight_num - 1, 1.0);
     for (int i = 0; i < weight_num - 1; i++) {
       rate = ctx->dropout_rate_list.at(i);
@@ -234,4 +235,3 @@ REGISTER_OP_EXPR_GRAD_FUNCTION("fused_matmul_bias_add_relu_dropout", FusedMatmul
 }  // namespace one
 
 }  // namespace oneflow
-#endif  // CUDA_VERSION >= 11060
@@ -26,5 +26,9 @@ DEFINE_ENV_BOOL(ONEFLOW_REMAT_NEIGHBOR, true);
 DEFINE_ENV_BOOL(ONEFLOW_REMAT_HEURISTIC_DTE, false);
 DEFINE_ENV_BOOL(ONEFLOW_REMAT_HEURISTIC_DTR, false);
 DEFINE_ENV_BOOL(ONEFLOW_REMAT_LOG, false);
+// Units of remat::GetComputeTime per second, used to compare recomputation with swapping
+DEFINE_ENV_INTEGER(ONEFLOW_REMAT_COMPUTE_THROUGHPUT, 1000000000000);
+// Device <-> host copy bandwidth in bytes per second for swapping, measured if 0
+DEFINE_ENV_INTEGER(ONEFLOW_REMAT_SWAP_BANDWIDTH, 0);
 
 }  // namespace oneflow
@@ -15,6 +15,10 @@ limitations under the License.
 */
 #include "oneflow/core/eager/tensor_storage.h"
 #include "oneflow/core/common/env_var/remat.h"
+#include "oneflow/core/ep/include/device_manager_registry.h"
+#include "oneflow/core/ep/include/primitive/memcpy.h"
+#include "oneflow/core/framework/shut_down_util.h"
+#include "oneflow/core/vm/remat/allocator.h"
 #include "oneflow/core/vm/op_call_instruction_policy.h"
 #include "oneflow/core/vm/remat/disjoint_set.h"
 #include "oneflow/core/vm/remat/env.h"
@@ -29,6 +33,20 @@ int64_t unique_id() {
   return id++;
 }
 
+Maybe<vm::Stream*> GetDefaultVmStream(Symbol<Device> device) {
+  auto stream = JUST(GetDefaultStreamByDevice(device));
+  return Singleton<VirtualMachine>::Get()->GetVmStream(stream);
+}
+
+void LaunchMemcpy(vm::Stream* vm_stream, ep::primitive::MemcpyKind kind, void* dst,
+                  const void* src, size_t size) {
+  ep::Stream* stream = vm_stream->mut_stream_policy()->stream();
+  auto memcpy =
+      ep::primitive::NewPrimitive<ep::primitive::MemcpyFactory>(stream->device_type(), kind);
+  CHECK(memcpy);
+  memcpy->Launch(stream, dst, src, size);
+}
+
 }  // namespace
 
 TensorStorage::TensorStorage(bool is_allocated_in_vm, Symbol<Device> device)
@@ -87,8 +105,11 @@ void RematableTensorStorage::LogEviction(bool eager_eviction) const {
 
 void RematableTensorStorage::Remat() {
   if (is_in_memory()) { return; }
-  auto stream = CHECK_JUST(GetDefaultStreamByDevice(device_));
-  auto* vm_stream = CHECK_JUST(Singleton<VirtualMachine>::Get()->GetVmStream(stream));
+  auto* vm_stream = CHECK_JUST(GetDefaultVmStream(device_));
+  if (is_swapped()) {
+    CHECK_JUST(SwapIn(vm_stream));
+    return;
+  }
   auto op = compute_op();
   CHECK_JUST(Recompute(&op, vm_stream));
 }
@@ -96,9 +117,60 @@ void RematableTensorStorage::Remat() {
 void RematableTensorStorage::Evict(bool eager_eviction) {
   CHECK(!is_eviction_disabled());
   LogEviction(eager_eviction);
+  // Eager eviction drops tensors which are not needed any more, while forced eviction makes room
+  // for other tensors and swaps the tensor out if that is cheaper than recomputing it later.
+  if (!eager_eviction && (has_host_copy() || remat::ShouldSwapOut(*this))) { return SwapOut(); }
   return _Release();
 }
 
+void RematableTensorStorage::SwapOut() {
+  CHECK(!is_eviction_disabled());
+  CHECK(is_in_memory());
+  if (!has_host_copy() && blob_bytes_ > 0) {
+    const auto ep_device = Singleton<ep::DeviceManagerRegistry>::Get()->GetDevice(
+        device_->enum_type(), device_->device_id());
+    const size_t bytes = blob_bytes_;
+    void* host_ptr = nullptr;
+    CHECK_JUST(ep_device->AllocPinned(ep::AllocationOptions{}, &host_ptr, bytes));
+    const auto FreeHostCopy = [ep_device, bytes](char* ptr) {
+      if (IsShuttingDown()) { return; }
+      ep_device->FreePinned(ep::AllocationOptions{}, ptr);
+      Singleton<remat::Env>::Get()->add_swap_memory(-static_cast<int64_t>(bytes));
+    };
+    host_copy_ = std::unique_ptr<char, std::function<void(char*)>>(static_cast<char*>(host_ptr),
+                                                                   FreeHostCopy);
+    Singleton<remat::Env>::Get()->add_swap_memory(bytes);
+    // The copy is launched on the compute stream, so it finishes reading the device memory before
+    // the released memory is written by the next kernel.
+    LaunchMemcpy(CHECK_JUST(GetDefaultVmStream(device_)), ep::primitive::MemcpyKind::kDtoH,
+                 host_copy_.get(), blob_dptr_.get(), bytes);
+    Singleton<remat::Env>::Get()->add_swap_out(bytes);
+  }
+  VLOG(1) << "swap out storage " << id_;
+  return _Release();
+}
+
+Maybe<void> RematableTensorStorage::SwapIn(vm::Stream* vm_stream) {
+  CHECK_OR_RETURN(is_swapped()) << "storage " << id_ << " is not swapped out";
+  Allocator* allocator = vm_stream->mut_stream_policy()->mut_allocator();
+  const size_t bytes = blob_bytes_;
+  char* dptr = nullptr;
+  JUST(allocator->Allocate(&dptr, bytes));
+  const auto Free = [allocator, bytes](char* dptr) {
+    if (IsShuttingDown()) { return; }
+    allocator->Deallocate(dptr, bytes);
+  };
+  set_blob_dptr(std::unique_ptr<char, std::function<void(char*)>>(dptr, Free), bytes);
+  if (auto* dtr_allocator = dynamic_cast<DtrEpAllocatorProxy*>(allocator)) {
+    dtr_allocator->allocator->LinkStorageAndPtr(this, dptr);
+  }
+  LaunchMemcpy(vm_stream, ep::primitive::MemcpyKind::kHtoD, dptr, host_copy_.get(), bytes);
+  Singleton<remat::Env>::Get()->add_swap_in(bytes);
+  VLOG(1) << "swap in storage " << id_;
+  Access();
+  return Maybe<void>::Ok();
+}
+
 void RematableTensorStorage::Release() {
   CHECK(device_->rematable());
   if (is_eviction_disabled()) { return; }
@@ -107,6 +179,19 @@ void RematableTensorStorage::Release() {
 
 std::vector<std::string> random_ops{"uniform", "uniform_int", "normal", "randperm"};
 
+void RematableTensorStorage::set_eviction_disabled(bool disabled) {
+  eviction_disabled_ = disabled;
+  // the tensor may be mutated from now on, which makes the host copy stale
+  if (disabled && is_in_memory()) { DropHostCopy(); }
+}
+
+void RematableTensorStorage::DropHostCopy() {
+  if (!has_host_copy()) { return; }
+  VLOG(1) << "drop host copy of storage " << id_;
+  // the deleter gives the bytes back to the swap memory budget
+  host_copy_.reset();
+}
+
 bool RematableTensorStorage::is_evictable() const {
   return compute_op_ != nullptr
          && std::find(random_ops.begin(), random_ops.end(), compute_op_type_name())
@@ -145,6 +230,8 @@ void RematableTensorStorage::clear_compute_op() {
 void RematableTensorStorage::set_compute_op(
     const std::shared_ptr<DtrOpCallInstructionPolicy>& compute_op, double compute_time) {
   CHECK_ISNULL(compute_op_);
+  // a new compute op means the storage is (re)written by it, so the host copy is stale
+  DropHostCopy();
   compute_op_ = compute_op;
   VLOG(1) << "set_compute_op: " << id_ << ", compute op: " << compute_op.get();
   Singleton<remat::Env>::Get()->ops.push_back(CHECK_NOTNULL(compute_op_.get()));
@@ -169,8 +256,12 @@ Maybe<double> RematableTensorStorage::cost(size_t override_size) const {
   if (EnvBool<ONEFLOW_REMAT_HEURISTIC_DTE>() || EnvBool<ONEFLOW_REMAT_HEURISTIC_DTR>()) {
     size = override_size == 0 ? blob_bytes_ : override_size;
   }
-  return (EnvBool<ONEFLOW_REMAT_NEIGHBOR>() ? approx_neighbor_cost() : compute_time_)
-         / time_since_last_access / static_cast<double>(size);
+  const double remat_cost = std::min(recompute_cost(), remat::GetSwapCost(*this));
+  return remat_cost / time_since_last_access / static_cast<double>(size);
+}
+
+double RematableTensorStorage::recompute_cost() const {
+  return EnvBool<ONEFLOW_REMAT_NEIGHBOR>() ? approx_neighbor_cost() : compute_time_;
 }
 
 double RematableTensorStorage::approx_neighbor_cost() const {
@@ -30,6 +30,7 @@ namespace vm {
 
 class OpCallInstructionPolicy;
 class DtrOpCallInstructionPolicy;
+class Stream;
 
 class TensorStorage {
  public:
@@ -96,6 +97,13 @@ class RematableTensorStorage final : public TensorStorage {
   void Release() override;
   void Remat();
   void Evict(bool eager_eviction);
+  // Copies the tensor to host memory before releasing it, so that it is paged back by SwapIn
+  // instead of being recomputed. The host copy is kept until the tensor is mutated, so evicting
+  // it again needs no copy.
+  void SwapOut();
+  Maybe<void> SwapIn(vm::Stream* vm_stream);
+  // Must be called whenever the content of the storage changes.
+  void DropHostCopy();
   void Pin();
   void Unpin();
   void Access();
@@ -103,10 +111,13 @@ class RematableTensorStorage final : public TensorStorage {
   bool is_pinned() const { return num_pinned() > 0; }
   int32_t num_pinned() const { return num_pinned_; }
   bool is_evictable() const;
-  void set_eviction_disabled(bool disabled) { eviction_disabled_ = disabled; }
+  bool is_swapped() const { return !is_in_memory() && has_host_copy(); }
+  bool has_host_copy() const { return host_copy_ != nullptr; }
+  void set_eviction_disabled(bool disabled);
   bool is_eviction_disabled() const { return eviction_disabled_; }
   int64_t id() const { return id_; }
   Maybe<double> cost(size_t override_size) const;
+  double recompute_cost() const;
   double approx_neighbor_cost() const;
   std::string compute_op_type_name() const;
   bool is_initialized() const { return is_initialized_; }
@@ -124,6 +135,7 @@ class RematableTensorStorage final : public TensorStorage {
   double compute_time_{};
   std::shared_ptr<DtrOpCallInstructionPolicy> compute_op_;
   bool is_needed_by_backward_ = false;
+  std::unique_ptr<char, std::function<void(char*)>> host_copy_;
 
   void LogEviction(bool eager_eviction) const;
 };
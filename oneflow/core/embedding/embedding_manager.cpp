@@ -22,10 +22,10 @@ namespace oneflow {
 
 namespace embedding {
 
-#ifdef WITH_CUDA
-
 constexpr size_t kDefaultMaxQueryLength = 131072;
 
+#ifdef WITH_CUDA
+
 constexpr int64_t kRingBufferSize = 8;
 
 struct IdStatistics {
@@ -489,6 +489,8 @@ EmbeddingState* EmbeddingManager::GetEmbeddingState(const std::string& embedding
   return it->second.get();
 }
 
+#endif  // WITH_CUDA
+
 KeyValueStore* EmbeddingManager::GetKeyValueStore(const std::string& embedding_name,
                                                   int64_t rank_id) {
   std::pair<std::string, int64_t> map_key = std::make_pair(embedding_name, rank_id);
@@ -499,16 +501,49 @@ KeyValueStore* EmbeddingManager::GetKeyValueStore(const std::string& embedding_n
   return it->second.get();
 }
 
+namespace {
+
+std::unique_ptr<KeyValueStore> NewStore(const KeyValueStoreOptions& key_value_store_options,
+                                        const PersistentTableKeyValueStoreOptions& options) {
+  if (key_value_store_options.GetDeviceType() == DeviceType::kCPU) {
+    return NewCpuPersistentTableKeyValueStore(options);
+  }
+#ifdef WITH_CUDA
+  std::unique_ptr<KeyValueStore> store = NewPersistentTableKeyValueStore(options);
+  const std::vector<CacheOptions>& cache_options = key_value_store_options.GetCachesOptions();
+  for (int i = cache_options.size() - 1; i >= 0; --i) {
+    std::unique_ptr<Cache> cache = NewCache(cache_options.at(i));
+    store = NewCachedKeyValueStore(std::move(store), std::move(cache));
+  }
+  return store;
+#else
+  UNIMPLEMENTED() << "The cuda kv_store needs oneflow built with CUDA, use a cpu kv_store instead";
+  return nullptr;
+#endif  // WITH_CUDA
+}
+
+#ifdef WITH_CUDA
+std::unique_ptr<CudaCurrentDeviceGuard> NewDeviceGuard(DeviceType device_type,
+                                                       int64_t local_rank_id) {
+  if (device_type != DeviceType::kCUDA) { return nullptr; }
+  return std::make_unique<CudaCurrentDeviceGuard>(local_rank_id);
+}
+#endif  // WITH_CUDA
+
+}  // namespace
+
 void EmbeddingManager::CreateKeyValueStore(const KeyValueStoreOptions& key_value_store_options,
                                            int64_t local_rank_id, int64_t rank_id,
                                            int64_t world_size) {
-  CudaCurrentDeviceGuard guard(local_rank_id);
+  const DeviceType device_type = key_value_store_options.GetDeviceType();
+#ifdef WITH_CUDA
+  auto guard = NewDeviceGuard(device_type, local_rank_id);
+#endif  // WITH_CUDA
   const std::string& name = key_value_store_options.Name();
   const uint32_t line_size = key_value_store_options.LineSize();
   std::pair<std::string, int64_t> map_key = std::make_pair(name, rank_id);
   std::unique_lock<std::mutex> lock(mutex_);
 
-  std::unique_ptr<KeyValueStore> store;
   PersistentTableKeyValueStoreOptions options{};
   const std::vector<std::string>& persistent_table_paths =
       key_value_store_options.PersistentTablePaths();
@@ -520,16 +555,15 @@ void EmbeddingManager::CreateKeyValueStore(const KeyValueStoreOptions& key_value
       key_value_store_options.PersistentTablePhysicalBlockSize();
   options.table_options.target_chunk_size_mb = 4 * 1024;
   options.table_options.capacity_hint = key_value_store_options.PersistentTableCapacityHint();
-  store = NewPersistentTableKeyValueStore(options);
-  const std::vector<CacheOptions>& cache_options = key_value_store_options.GetCachesOptions();
-  for (int i = cache_options.size() - 1; i >= 0; --i) {
-    std::unique_ptr<Cache> cache = NewCache(cache_options.at(i));
-    store = NewCachedKeyValueStore(std::move(store), std::move(cache));
-  }
+  std::unique_ptr<KeyValueStore> store = NewStore(key_value_store_options, options);
   store->ReserveQueryLength(kDefaultMaxQueryLength);
   CHECK(key_value_store_map_.emplace(map_key, std::move(store)).second)
       << "Can't create an embedding with same name of an existing embedding, the name: " << name;
+  key_value_store_device_type_map_[map_key] = device_type;
+  // The CPU kernels read the number of unique ids from their inputs and need no embedding state
+  if (device_type == DeviceType::kCPU) { return; }
 
+#ifdef WITH_CUDA
   if (UseDynamicMemoryAllocation()) {
 #if CUDA_VERSION >= 11020
     CHECK(embedding_state_map_.emplace(map_key, std::make_unique<DynamicAllocationEmbeddingState>())
@@ -545,27 +579,32 @@ void EmbeddingManager::CreateKeyValueStore(const KeyValueStoreOptions& key_value
         << "Can't create an embedding state with same name of an existing embedding, the name: "
         << name;
   }
+#endif  // WITH_CUDA
 }
 
 void EmbeddingManager::SaveSnapshot(const std::string& embedding_name, int64_t local_rank_id,
                                     int64_t rank_id, const std::string& snapshot_name) {
-  CudaCurrentDeviceGuard guard(local_rank_id);
   std::pair<std::string, int64_t> map_key = std::make_pair(embedding_name, rank_id);
   std::unique_lock<std::mutex> lock(mutex_);
 
   auto it = key_value_store_map_.find(map_key);
   CHECK(it != key_value_store_map_.end())
       << "Can not find embedding: " << embedding_name << "-" << rank_id;
+#ifdef WITH_CUDA
+  auto guard = NewDeviceGuard(key_value_store_device_type_map_.at(map_key), local_rank_id);
+#endif  // WITH_CUDA
   it->second->SaveSnapshot(snapshot_name);
 }
 
 void EmbeddingManager::LoadSnapshot(const std::string& embedding_name, int64_t local_rank_id,
                                     int64_t rank_id, const std::string& snapshot_name) {
-  CudaCurrentDeviceGuard guard(local_rank_id);
   std::pair<std::string, int64_t> map_key = std::make_pair(embedding_name, rank_id);
   auto it = key_value_store_map_.find(map_key);
   CHECK(it != key_value_store_map_.end())
       << "Can not find embedding: " << embedding_name << "-" << rank_id;
+#ifdef WITH_CUDA
+  auto guard = NewDeviceGuard(key_value_store_device_type_map_.at(map_key), local_rank_id);
+#endif  // WITH_CUDA
   if (it->second->SnapshotExists(snapshot_name)) {
     it->second->LoadSnapshot(snapshot_name);
   } else {
@@ -574,8 +613,6 @@ void EmbeddingManager::LoadSnapshot(const std::string& embedding_name, int64_t l
   }
 }
 
-#endif  // WITH_CUDA
-
 }  // namespace embedding
 
 }  // namespace oneflow
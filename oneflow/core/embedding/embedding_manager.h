@@ -164,6 +164,8 @@ class EmbeddingState {
   virtual const std::vector<uint32_t>& GetIdNumUniqueMatrix(int64_t iter) = 0;
 };
 
+#endif  // WITH_CUDA
+
 class EmbeddingManager final {
  public:
   EmbeddingManager() = default;
@@ -175,18 +177,22 @@ class EmbeddingManager final {
                     const std::string& snapshot_name);
 
   KeyValueStore* GetKeyValueStore(const std::string& embedding_name, int64_t rank_id);
+#ifdef WITH_CUDA
   EmbeddingState* GetEmbeddingState(const std::string& embedding_name, int64_t rank_id);
+#endif  // WITH_CUDA
   void CreateKeyValueStore(const KeyValueStoreOptions& options, int64_t local_rank_id,
                            int64_t rank_id, int64_t world_size);
 
  private:
   HashMap<std::pair<std::string, int64_t>, std::unique_ptr<KeyValueStore>> key_value_store_map_;
+  // Stores on kCPU are served from host memory and don't touch any CUDA device
+  HashMap<std::pair<std::string, int64_t>, DeviceType> key_value_store_device_type_map_;
+#ifdef WITH_CUDA
   HashMap<std::pair<std::string, int64_t>, std::unique_ptr<EmbeddingState>> embedding_state_map_;
+#endif  // WITH_CUDA
   std::mutex mutex_;
 };
 
-#endif  // WITH_CUDA
-
 }  // namespace embedding
 }  // namespace oneflow
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_EMBEDDING_KEY_VALUE_STORE_OPTIONS_H_
 #include "nlohmann/json.hpp"
 #include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/common/device_type.h"
 #include "oneflow/core/embedding/cache.h"
 
 namespace oneflow {
@@ -103,6 +104,17 @@ class KeyValueStoreOptions final {
     CHECK(json_object.contains("kv_store"));
     auto kv_store = json_object["kv_store"];
 
+    device_type_ = DeviceType::kCUDA;
+    if (kv_store.contains("device")) {
+      CHECK(kv_store["device"].is_string());
+      const std::string device = kv_store["device"].get<std::string>();
+      if (device == "cpu") {
+        device_type_ = DeviceType::kCPU;
+      } else {
+        CHECK_EQ(device, "cuda") << "Unsupported kv_store device";
+      }
+    }
+
     auto caches = kv_store["caches"];
     if (caches != nlohmann::detail::value_t::null && caches.size() > 0) {
       CHECK(caches.is_array());
@@ -114,6 +126,8 @@ class KeyValueStoreOptions final {
         ParseCacheOptions(caches.at(i), &cache_options_.at(i));
       }
     }
+    CHECK(device_type_ != DeviceType::kCPU || cache_options_.empty())
+        << "The cpu kv_store reads the persistent table directly and has no caches";
 
     CHECK(kv_store.contains("persistent_table"));
     auto persistent_table = kv_store["persistent_table"];
@@ -152,6 +166,7 @@ class KeyValueStoreOptions final {
   int64_t KeyTypeSize() const { return key_type_size_; }
   int64_t ValueTypeSize() const { return value_type_size_; }
   DataType ValueType() const { return value_type_; }
+  DeviceType GetDeviceType() const { return device_type_; }
   const std::string& Name() const { return name_; }
   int64_t LineSize() const { return line_size_; }
   const std::vector<CacheOptions>& GetCachesOptions() const { return cache_options_; }
@@ -169,6 +184,7 @@ class KeyValueStoreOptions final {
   int64_t key_type_size_;
   int64_t value_type_size_;
   DataType value_type_;
+  DeviceType device_type_;
   std::string name_;
   int64_t line_size_;
   std::vector<std::string> persistent_table_paths_;
@@ -28,8 +28,6 @@ namespace embedding {
 
 namespace {
 
-#ifdef WITH_CUDA
-
 std::string CreateTempDirectory() {
   const char* tmp_env = getenv("TMPDIR");
   const char* tmp_dir = tmp_env == nullptr ? "/tmp" : tmp_env;
@@ -39,6 +37,52 @@ std::string CreateTempDirectory() {
   return std::string(path);
 }
 
+TEST(CpuPersistentTableKeyValueStore, CpuPersistentTableKeyValueStore) {
+  PersistentTableKeyValueStoreOptions options{};
+  const uint32_t value_length = 16;
+  const uint32_t num_keys = 128;
+  std::string path = CreateTempDirectory();
+  options.table_options.path = path;
+  options.table_options.value_size = value_length * sizeof(float);
+  options.table_options.key_size = GetSizeOfDataType(DataType::kUInt64);
+  options.table_options.physical_block_size = 512;
+
+  std::unique_ptr<KeyValueStore> store = NewCpuPersistentTableKeyValueStore(options);
+  store->ReserveQueryLength(num_keys);
+  std::vector<uint64_t> keys(num_keys);
+  std::vector<float> values(num_keys * value_length);
+  for (uint32_t i = 0; i < num_keys; ++i) {
+    keys[i] = i * 3 + 1;
+    for (uint32_t j = 0; j < value_length; ++j) { values[i * value_length + j] = i * j; }
+  }
+  uint32_t n_missing = 0;
+  std::vector<uint32_t> missing_indices(num_keys);
+  std::vector<float> values_out(num_keys * value_length);
+  store->Get(nullptr, num_keys, keys.data(), values_out.data(), &n_missing,
+             missing_indices.data());
+  ASSERT_EQ(n_missing, num_keys);
+
+  store->Put(nullptr, num_keys / 2, keys.data(), values.data());
+  store->SaveSnapshot("half");
+  store->Put(nullptr, num_keys, keys.data(), values.data());
+  store->Get(nullptr, num_keys, keys.data(), values_out.data(), &n_missing,
+             missing_indices.data());
+  ASSERT_EQ(n_missing, 0);
+  ASSERT_EQ(values_out, values);
+
+  store->LoadSnapshot("half");
+  store->Get(nullptr, num_keys, keys.data(), values_out.data(), &n_missing,
+             missing_indices.data());
+  ASSERT_EQ(n_missing, num_keys / 2);
+  for (uint32_t i = 0; i < n_missing; ++i) { ASSERT_GE(missing_indices[i], num_keys / 2); }
+  ASSERT_TRUE(std::equal(values.begin(), values.begin() + num_keys / 2 * value_length,
+                         values_out.begin()));
+  store.reset();
+  PosixFile::RecursiveDelete(path);
+}
+
+#ifdef WITH_CUDA
+
 bool HasCudaDevice() {
   int device_count = 0;
   if (cudaGetDeviceCount(&device_count) != cudaSuccess) { return false; }
@@ -38,6 +38,7 @@ limitations under the License.
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/job/collective_boxing/scheduler.h"
 #include "oneflow/core/graph/task_stream_index_manager.h"
+#include "oneflow/core/job/intra_job_mem_sharing_util.h"
 #include "oneflow/core/framework/variable_tensor_mgr.h"
 #ifdef WITH_CUDA
 #include <cuda.h>
@@ -96,6 +97,7 @@ Maybe<void> MultiClientSessionContext::TryInit(const ConfigProto& config_proto)
     Singleton<ResourceDesc, ForSession>::New(resource, GlobalProcessCtx::NumOfProcessPerNode());
     Singleton<IDMgr>::New();
     Singleton<TaskStreamIndexManager>::New();
+    Singleton<MemShareWarmStart>::New();
     // TODO(chengcheng): refactor JobBuildAndInferCtxMgr
     Singleton<LazyJobBuildAndInferCtxMgr>::New();
 
@@ -163,6 +165,7 @@ Maybe<void> MultiClientSessionContext::TryClose() {
     }
 
     Singleton<LazyJobBuildAndInferCtxMgr>::Delete();
+    Singleton<MemShareWarmStart>::Delete();
     Singleton<TaskStreamIndexManager>::Delete();
     Singleton<IDMgr>::Delete();
 
@@ -591,10 +591,35 @@ class TensorDotFunctor {
   }
 };
 
+namespace {
+
+// The CPU kernels of the fused matmul ops support float and double.
+bool IsFusedMatmulCpuKernelAvailable(DeviceType device_type, DataType data_type) {
+  return device_type == DeviceType::kCPU
+         && (data_type == DataType::kFloat || data_type == DataType::kDouble);
+}
+
+// cublas_fused_mlp and fused_matmul_bias_add_relu_dropout have CUDA kernels since CUDA 11.6
+bool IsFusedMLPKernelAvailable(DeviceType device_type, DataType data_type) {
+#if CUDA_VERSION >= 11060
+  if (device_type == DeviceType::kCUDA) { return true; }
+#endif  // CUDA_VERSION >= 11060
+  return IsFusedMatmulCpuKernelAvailable(device_type, data_type);
+}
+
+// fused_matmul_bias has CUDA kernels since CUDA 11.2
+bool IsFusedMatmulBiasKernelAvailable(DeviceType device_type, DataType data_type) {
+#if CUDA_VERSION >= 11020
+  if (device_type == DeviceType::kCUDA) { return true; }
+#endif  // CUDA_VERSION >= 11020
+  return IsFusedMatmulCpuKernelAvailable(device_type, data_type);
+}
+
+}  // namespace
+
 class FusedMLPFunctor {
  public:
   FusedMLPFunctor() {
-#if CUDA_VERSION >= 11060
     fused_op_.resize(kMaxInputCount /*the maximum number of inputs*/);
     for (int n = 1; n < fused_op_.size(); ++n) {
       fused_op_[n] = CHECK_JUST(one::OpBuilder("cublas_fused_mlp")
@@ -606,7 +631,6 @@ class FusedMLPFunctor {
                                     .Output("hidden", n)
                                     .Build());
     }
-#endif
   }
   Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& x, const TensorTuple& weights,
                            const TensorTuple& biases, bool skip_final_activation) const {
@@ -644,7 +668,6 @@ class FusedMLPFunctor {
       k = n;
     }
 
-#if CUDA_VERSION >= 11060
     DeviceType device_type{};
     if (x->is_global()) {
       device_type = JUST(x->parallel_desc())->device_type();
@@ -652,7 +675,8 @@ class FusedMLPFunctor {
       device_type = JUST(x->device())->enum_type();
     }
 
-    if ((device_type == DeviceType::kCUDA) && (weight_size <= kMaxInputCount)
+    if (IsFusedMLPKernelAvailable(device_type, x->dtype()->data_type())
+        && (weight_size <= kMaxInputCount)
         && (!ParseBooleanFromEnv("ONEFLOW_FUNCTOR_DISABLE_FUSED_MLP", false))) {
       TensorTuple input(2 * weight_size + 1);
       input[0] = x;
@@ -663,7 +687,6 @@ class FusedMLPFunctor {
       attrs.SetAllAttrs(skip_final_activation);
       return OpInterpUtil::Dispatch<Tensor>(*fused_op_[weight_size], input, attrs);
     }
-#endif  // CUDA_VERSION >= 11060
 
     // Fall back to Naive matmul + bias_add + relu
     std::shared_ptr<one::Tensor> out = x;
@@ -683,9 +706,7 @@ class FusedMLPFunctor {
   }
 
  private:
-#if CUDA_VERSION >= 11060
   std::vector<std::shared_ptr<OpExpr>> fused_op_;
-#endif
 };
 
 class FusedMatmulBiasFunctor {
@@ -732,7 +753,6 @@ class FusedMatmulBiasFunctor {
     CHECK_EQ_OR_RETURN(weight_shape->At(1), k)
         << Error::RuntimeError() << "weight's second dim should be equal to input's second dim. ";
 
-#if CUDA_VERSION >= 11020
     DeviceType device_type{};
     if (x->is_global()) {
       device_type = JUST(x->parallel_desc())->device_type();
@@ -742,7 +762,7 @@ class FusedMatmulBiasFunctor {
 
     auto& attrs = THREAD_CACHED_MUTABLE_ATTR_MAP("alpha", "beta");
     attrs.SetAllAttrs(alpha, beta);
-    if (device_type == DeviceType::kCUDA) {
+    if (IsFusedMatmulBiasKernelAvailable(device_type, x->dtype()->data_type())) {
       if (_add_to_output) {
         return OpInterpUtil::Dispatch<Tensor>(*_with_add_to_output_op,
                                               {x, weight, bias, JUST(_add_to_output)}, attrs);
@@ -750,7 +770,6 @@ class FusedMatmulBiasFunctor {
         return OpInterpUtil::Dispatch<Tensor>(*_without_add_to_output_op, {x, weight, bias}, attrs);
       }
     }
-#endif  // CUDA_VERSION >= 11020
 
     auto matmul_bias = JUST(functional::BiasAdd(
         JUST(functional::MatMul(x, weight, false, true, alpha)), bias, x->shape()->NumAxes() - 1));
@@ -774,7 +793,6 @@ class FusedMatmulBiasFunctor {
 class FusedMatmulBiasAddReluDropoutFunctor {
  public:
   FusedMatmulBiasAddReluDropoutFunctor() {
-#if CUDA_VERSION >= 11060
     fused_op_.resize(kMaxInputCount /*the maximum number of inputs*/);
     for (int n = 1; n < fused_op_.size(); ++n) {
       fused_op_[n] = CHECK_JUST(one::OpBuilder("fused_matmul_bias_add_relu_dropout")
@@ -786,7 +804,6 @@ class FusedMatmulBiasAddReluDropoutFunctor {
                                     .Output("hidden", n)
                                     .Build());
     }
-#endif
   }
   Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& x, const TensorTuple& weights,
                            const TensorTuple& biases, bool skip_final_activation,
@@ -829,14 +846,14 @@ class FusedMatmulBiasAddReluDropoutFunctor {
 
     auto gen = generator.value_or(JUST(one::DefaultAutoGenerator()));
 
-#if CUDA_VERSION >= 11060
     DeviceType device_type{};
     if (x->is_global()) {
       device_type = JUST(x->parallel_desc())->device_type();
     } else {
       device_type = JUST(x->device())->enum_type();
     }
-    if ((device_type == DeviceType::kCUDA) && (weight_size <= kMaxInputCount)
+    if (IsFusedMLPKernelAvailable(device_type, x->dtype()->data_type())
+        && (weight_size <= kMaxInputCount)
         && (!ParseBooleanFromEnv("ONEFLOW_FUNCTOR_DISABLE_FUSED_MLP", false))) {
       TensorTuple input(2 * weight_size + 1);
       input[0] = x;
@@ -852,7 +869,6 @@ class FusedMatmulBiasAddReluDropoutFunctor {
       return OpInterpUtil::Dispatch<Tensor>(*fused_op_[weight_size], input,
                                             OpExprInterpContext(attrs, dropout_state));
     }
-#endif  // CUDA_VERSION >= 11060
 
     // Fall back to Naive matmul + bias_add + relu + dropout
     std::shared_ptr<one::Tensor> out = x;
@@ -877,9 +893,7 @@ class FusedMatmulBiasAddReluDropoutFunctor {
   }
 
  private:
-#if CUDA_VERSION >= 11060
   std::vector<std::shared_ptr<OpExpr>> fused_op_;
-#endif
 };
 
 class LayerNormFunctor {
@@ -57,6 +57,16 @@ struct relu_f {
   }
 };
 
+Maybe<DeviceType> get_device_type(const std::shared_ptr<one::Tensor>& t) {
+  if (t->is_global()) { return JUST(t->parallel_desc())->device_type(); }
+  return JUST(t->device())->enum_type();
+}
+
+// Devices with fused_lstm_cell and fused_gru_cell kernels, which add the biases of the gates
+bool has_fused_rnn_cell_kernel(DeviceType device_type) {
+  return device_type == DeviceType::kCUDA || device_type == DeviceType::kCPU;
+}
+
 Maybe<void> check_rnn_cell_forward_input(const std::shared_ptr<one::Tensor>& input,
                                          int64_t input_size) {
   CHECK_OR_RETURN(input->shape()->At(1) == input_size)
@@ -217,6 +227,8 @@ struct SimpleCell {
     }
     return nonlinearity{}(output);
   }
+
+  static bool input_gates_include_bias(DeviceType) { return true; }
 };
 
 template<typename cell_params>
@@ -231,10 +243,9 @@ struct GRUCell {
       input_device = JUST(input->device())->enum_type();
     }
 
-    if (input_device == DeviceType::kCUDA) {
-      CHECK_OR_RETURN(!pre_compute_input);
-
-      std::shared_ptr<one::Tensor> igates = JUST(params.matmul_ih(input));
+    if (has_fused_rnn_cell_kernel(input_device)) {
+      std::shared_ptr<one::Tensor> igates = input;
+      if (!pre_compute_input) { igates = JUST(params.matmul_ih(input)); }
       std::shared_ptr<one::Tensor> hgates = JUST(params.matmul_hh(hidden));
 
       std::shared_ptr<TensorTuple> result =
@@ -267,6 +278,10 @@ struct GRUCell {
     output = JUST(functional::Add(output, new_gate, 1.0, false));
     return output;
   }
+
+  static bool input_gates_include_bias(DeviceType device_type) {
+    return !has_fused_rnn_cell_kernel(device_type);
+  }
 };
 
 template<typename cell_params>
@@ -284,10 +299,9 @@ struct LSTMCell {
       input_device = JUST(input->device())->enum_type();
     }
 
-    if (input_device == DeviceType::kCUDA) {
-      CHECK_OR_RETURN(!pre_compute_input);
-
-      std::shared_ptr<one::Tensor> igates = JUST(params.matmul_ih(input));
+    if (has_fused_rnn_cell_kernel(input_device)) {
+      std::shared_ptr<one::Tensor> igates = input;
+      if (!pre_compute_input) { igates = JUST(params.matmul_ih(input)); }
       std::shared_ptr<one::Tensor> hgates = JUST(params.matmul_hh(hx));
 
       std::shared_ptr<TensorTuple> result =
@@ -321,8 +335,25 @@ struct LSTMCell {
     (*outputs)[1] = cy;
     return outputs;
   }
+
+  static bool input_gates_include_bias(DeviceType device_type) {
+    return !has_fused_rnn_cell_kernel(device_type);
+  }
 };
 
+// Projects the inputs of all timesteps with one matmul instead of a small matmul per step, so
+// the recurrence only multiplies the hidden state. Returns the input gates of every step, which
+// include b_ih only if the cell does not add it itself.
+Maybe<TensorTuple> precompute_input_gates(const std::shared_ptr<one::Tensor>& inputs,
+                                          const CellParams& params, bool include_bias) {
+  // inputs shape: [seq_len, batch_size, input_size]
+  std::shared_ptr<one::Tensor> gates = JUST(params.matmul_ih(inputs));
+  if (include_bias && params.b_ih() != nullptr) {
+    gates = JUST(functional::Add(gates, params.b_ih(), 1.0, false));
+  }
+  return functional::Unbind(gates, 0);
+}
+
 class RnnTanhCellFunctor {
  public:
   RnnTanhCellFunctor() {}
@@ -663,17 +694,20 @@ Maybe<TensorTuple> _rnn_impl(const std::shared_ptr<one::Tensor>& input,
   std::shared_ptr<TensorTuple> rnn_inputs = JUST(functional::Unbind(rnn_input, 0));
 
   auto generator = JUST(one::DefaultAutoGenerator());
+  const bool include_bias = cell_type::input_gates_include_bias(JUST(get_device_type(input)));
 
   TensorTuple final_hiddens;
   if (bidirectional) {
     std::shared_ptr<TensorTuple> fw_outputs = std::make_shared<TensorTuple>(rnn_inputs->size());
     std::shared_ptr<TensorTuple> bw_outputs = std::make_shared<TensorTuple>(rnn_inputs->size());
     for (int32_t l = 0; l < num_layers; ++l) {
+      std::shared_ptr<one::Tensor> layer_input = JUST(functional::Stack(*rnn_inputs, 0));
       // forward direction
       std::shared_ptr<one::Tensor> fw_hidden = (*rnn_hiddens)[l * 2];
       auto& fw_cell_param = (*rnn_params)[l * 2];
+      auto fw_input_gates = JUST(precompute_input_gates(layer_input, fw_cell_param, include_bias));
       for (int32_t i = 0; i < rnn_inputs->size(); ++i) {
-        fw_hidden = JUST(cell_type{}((*rnn_inputs)[i], fw_hidden, fw_cell_param));
+        fw_hidden = JUST(cell_type{}((*fw_input_gates)[i], fw_hidden, fw_cell_param, true));
         (*fw_outputs)[i] = fw_hidden;
       }
       final_hiddens.emplace_back(fw_hidden);
@@ -681,8 +715,9 @@ Maybe<TensorTuple> _rnn_impl(const std::shared_ptr<one::Tensor>& input,
       // reverse direction
       std::shared_ptr<one::Tensor> bw_hidden = (*rnn_hiddens)[l * 2 + 1];
       auto& bw_cell_param = (*rnn_params)[l * 2 + 1];
+      auto bw_input_gates = JUST(precompute_input_gates(layer_input, bw_cell_param, include_bias));
       for (int32_t i = rnn_inputs->size() - 1; i >= 0; i--) {
-        bw_hidden = JUST(cell_type{}((*rnn_inputs)[i], bw_hidden, bw_cell_param));
+        bw_hidden = JUST(cell_type{}((*bw_input_gates)[i], bw_hidden, bw_cell_param, true));
         (*bw_outputs)[i] = bw_hidden;
       }
       final_hiddens.emplace_back(bw_hidden);
@@ -704,8 +739,10 @@ Maybe<TensorTuple> _rnn_impl(const std::shared_ptr<one::Tensor>& input,
     for (int32_t l = 0; l < num_layers; ++l) {
       std::shared_ptr<one::Tensor> hidden = (*rnn_hiddens)[l];
       auto& cell_param = (*rnn_params)[l];
+      auto input_gates = JUST(precompute_input_gates(JUST(functional::Stack(*rnn_inputs, 0)),
+                                                     cell_param, include_bias));
       for (int32_t i = 0; i < rnn_inputs->size(); ++i) {
-        hidden = JUST(cell_type{}((*rnn_inputs)[i], hidden, cell_param));
+        hidden = JUST(cell_type{}((*input_gates)[i], hidden, cell_param, true));
         (*rnn_inputs)[i] = hidden;
       }
       final_hiddens.emplace_back(hidden);
@@ -959,6 +996,8 @@ Maybe<TensorTuple> _lstm_impl(const std::shared_ptr<one::Tensor>& input, const o
   std::shared_ptr<TensorTuple> rnn_inputs = JUST(functional::Unbind(rnn_input, 0));
 
   auto generator = JUST(one::DefaultAutoGenerator());
+  const bool include_bias =
+      LSTMCell<CellParams>::input_gates_include_bias(JUST(get_device_type(input)));
 
   TensorTuple final_hy;
   TensorTuple final_cy;
@@ -969,13 +1008,15 @@ Maybe<TensorTuple> _lstm_impl(const std::shared_ptr<one::Tensor>& input, const o
     std::shared_ptr<TensorTuple> bw_outputs = std::make_shared<TensorTuple>(rnn_inputs->size());
 
     for (int32_t l = 0; l < num_layers; ++l) {
+      std::shared_ptr<one::Tensor> layer_input = JUST(functional::Stack(*rnn_inputs, 0));
       // forward direction
       (*lstm_cell_out)[0] = (*layer_hxs)[l * 2];
       (*lstm_cell_out)[1] = (*layer_cxs)[l * 2];
       auto& fw_cell_param = (*rnn_params)[l * 2];
+      auto fw_input_gates = JUST(precompute_input_gates(layer_input, fw_cell_param, include_bias));
       for (int32_t i = 0; i < rnn_inputs->size(); ++i) {
-        lstm_cell_out =
-            JUST(LSTMCell<CellParams>{}((*rnn_inputs)[i], *lstm_cell_out, fw_cell_param));
+        lstm_cell_out = JUST(
+            LSTMCell<CellParams>{}((*fw_input_gates)[i], *lstm_cell_out, fw_cell_param, true));
         (*fw_outputs)[i] = (*lstm_cell_out)[0];
       }
       final_hy.emplace_back((*lstm_cell_out)[0]);
@@ -985,9 +1026,10 @@ Maybe<TensorTuple> _lstm_impl(const std::shared_ptr<one::Tensor>& input, const o
       (*lstm_cell_out)[0] = (*layer_hxs)[l * 2 + 1];
       (*lstm_cell_out)[1] = (*layer_cxs)[l * 2 + 1];
       auto& bw_cell_param = (*rnn_params)[l * 2 + 1];
+      auto bw_input_gates = JUST(precompute_input_gates(layer_input, bw_cell_param, include_bias));
       for (int32_t i = rnn_inputs->size() - 1; i >= 0; i--) {
-        lstm_cell_out =
-            JUST(LSTMCell<CellParams>{}((*rnn_inputs)[i], *lstm_cell_out, bw_cell_param));
+        lstm_cell_out = JUST(
+            LSTMCell<CellParams>{}((*bw_input_gates)[i], *lstm_cell_out, bw_cell_param, true));
         (*bw_outputs)[i] = (*lstm_cell_out)[0];
       }
       final_hy.emplace_back((*lstm_cell_out)[0]);
@@ -1014,8 +1056,11 @@ Maybe<TensorTuple> _lstm_impl(const std::shared_ptr<one::Tensor>& input, const o
       auto& cell_param = (*rnn_params)[l];
       (*lstm_cell_out)[0] = (*layer_hxs)[l];
       (*lstm_cell_out)[1] = (*layer_cxs)[l];
+      auto input_gates = JUST(precompute_input_gates(JUST(functional::Stack(*rnn_inputs, 0)),
+                                                     cell_param, include_bias));
       for (int32_t i = 0; i < rnn_inputs->size(); ++i) {
-        lstm_cell_out = JUST(LSTMCell<CellParams>{}((*rnn_inputs)[i], *lstm_cell_out, cell_param));
+        lstm_cell_out =
+            JUST(LSTMCell<CellParams>{}((*input_gates)[i], *lstm_cell_out, cell_param, true));
         (*rnn_inputs)[i] = (*lstm_cell_out)[0];
       }
       final_hy.emplace_back((*lstm_cell_out)[0]);
@@ -19,6 +19,14 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+bool IsSoleDevicePerMachine(const ParallelDesc& parallel_desc) {
+  return parallel_desc.sorted_machine_ids().size() == parallel_desc.parallel_num();
+}
+
+}  // namespace
+
 CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
   const CollectiveBoxingConf collective_boxing_conf =
       Singleton<ResourceDesc, ForSession>::Get()->collective_boxing_conf();
@@ -39,6 +47,12 @@ CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
     LOG(WARNING) << "nccl_enable_all_to_all is unavailable unless NCCL_VERSION > 2.7.0";
 #endif
   }
+  if (collective_boxing_conf.cpu_enable_collective_boxing()) {
+    builders.emplace_back(new CclAllReduceSubTskGphBuilder(DeviceType::kCPU));
+    builders.emplace_back(new CclReduceScatterSubTskGphBuilder(DeviceType::kCPU));
+    builders.emplace_back(new CclAllGatherSubTskGphBuilder(DeviceType::kCPU));
+    builders.emplace_back(new CclBroadcastSubTskGphBuilder(DeviceType::kCPU));
+  }
   chain_builder_.reset(new ChainSubTskGphBuilder(builders));
 }
 
@@ -51,6 +65,11 @@ Maybe<SubTskGphBuilderStatus> CollectiveBoxingSubTskGphBuilder::Build(
     const SbpParallel& out_sbp_parallel, const Shape& time_shape) const {
   if (!GlobalJobDesc().Bool("__is_user_function__")) { return Error::BoxingNotSupportedError(); }
   if (!IsSourceTimeShape(time_shape)) { return Error::BoxingNotSupportedError(); }
+  // the cpu executor backend runs one rank per process
+  if (out_parallel_desc.device_type() == DeviceType::kCPU
+      && !(IsSoleDevicePerMachine(in_parallel_desc) && IsSoleDevicePerMachine(out_parallel_desc))) {
+    return Error::BoxingNotSupportedError();
+  }
   return chain_builder_->Build(ctx, sorted_in_tasks, sorted_out_tasks, sorted_ctrl_tasks,
                                in_parallel_desc, out_parallel_desc, lbi, logical_blob_desc,
                                in_sbp_parallel, out_sbp_parallel, time_shape);
@@ -79,6 +79,8 @@ class Node {
 
   int64_t node_id() const { return node_id_; }
   std::string node_id_str() const { return std::to_string(node_id_); }
+  // Draws a new id for a node that was constructed in a nondeterministic order
+  void RenewNodeId() { node_id_ = NewNodeId(); }
 
   EdgeType* SoleInEdge() const {
     CHECK_EQ(in_edges_.size(), 1);
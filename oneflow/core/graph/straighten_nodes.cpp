@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include <memory>
 #include <string>
+#include "oneflow/core/auto_parallel/cost_database.h"
 #include "oneflow/core/common/singleton.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/graph/compute_task_node.h"
@@ -108,6 +109,12 @@ class TopoStruct {
 
 static StraightenAlgorithmTag sat;
 
+// Measured kernel time from job_conf.auto_parallel_cost_database_path, nullptr if not provided
+static std::shared_ptr<const auto_parallel::CostDatabase> cost_database;
+
+// Kernels below this time (us) are dominated by the cpu launching time
+static const double kShortGpuTimeThreshold = 10.0;
+
 // NOTE: Leave these code for debugging in the future
 // static std::vector<StraightenOrder> decide_parameters({ParseIntegerFromEnv("Parameter0", 3),
 //                                                        ParseIntegerFromEnv("Parameter1", 0),
@@ -172,6 +179,21 @@ bool IsTransferNode(TaskType task_type) {
   }
 }
 
+// Use the measured kernel time if profiled, otherwise fall back to the static rule
+bool ShortGpuTime(const TaskNode* node) {
+  const auto* comp_task_node = dynamic_cast<const CompTaskNode*>(node);
+  if (cost_database) {
+    const auto& key = auto_parallel::CostDatabase::GenKernelKey(
+        *comp_task_node->op_node(), comp_task_node->op_node()->nd_sbp_signature(),
+        comp_task_node->parallel_id());
+    if (key.IsOk()) {
+      const auto& kernel_time = cost_database->KernelTime(*CHECK_JUST(key));
+      if (kernel_time.has_value()) { return CHECK_JUST(kernel_time) < kShortGpuTimeThreshold; }
+    }
+  }
+  return ShortGpuTime(comp_task_node->op()->op_conf());
+}
+
 // Classifier for the set according to the task type
 TaskClassifier GetTaskClassifier(const TaskNode* node, bool nccl_use_compute_stream) {
   // Check task.pb.h for detail
@@ -179,8 +201,7 @@ TaskClassifier GetTaskClassifier(const TaskNode* node, bool nccl_use_compute_str
   // frequency of judgement = the number of occurrences / the times of judgement
   TaskType task_type = node->GetTaskType();
   if (task_type == TaskType::kNormalForward) {
-    const auto& op_conf = dynamic_cast<const CompTaskNode*>(node)->op()->op_conf();
-    if (sat == StraightenAlgorithmTag::kOverlap4CpuGpu && ShortGpuTime(op_conf)) {
+    if (sat == StraightenAlgorithmTag::kOverlap4CpuGpu && ShortGpuTime(node)) {
       return TaskClassifier::kWaitingOverlapNode;
     } else {
       return TaskClassifier::kWaitingMainComputation;
@@ -336,8 +357,7 @@ void TopoStruct::ComputeMemoryIncrement() {
 
 // Exceed time = time of cpu - time of gpu
 void TopoStruct::ComputeExceedTime() {
-  if (node->GetTaskType() == TaskType::kNormalForward
-      && ShortGpuTime(dynamic_cast<const CompTaskNode*>(node)->op()->op_conf())) {
+  if (node->GetTaskType() == TaskType::kNormalForward && ShortGpuTime(node)) {
     exceed_time = 1;
   } else {
     exceed_time = 0;
@@ -522,6 +542,13 @@ int32_t MaximumOverlapNum(StraightenAlgorithmTag sat, bool nccl_use_compute_stre
 
 void StraightenNodes(TaskGraph* task_graph, std::vector<TaskNode*>* ordered_task_nodes,
                      bool nccl_use_compute_stream) {
+  // Load the measured kernel time before computing the exceed time
+  const auto& cost_database_path = GlobalJobDesc().job_conf().auto_parallel_cost_database_path();
+  if (cost_database_path.empty()) {
+    cost_database.reset();
+  } else {
+    cost_database = CHECK_JUST(auto_parallel::GetCostDatabase(cost_database_path));
+  }
   // Generate topological data structure for each task node
   HashMap<TaskNode*, TopoStruct> task_node2topo_struct;
   // Determine the same nodes which should run simultaneously by the keys
@@ -38,6 +38,7 @@ limitations under the License.
 #include "oneflow/core/graph/task_stream_index_manager.h"
 #include "oneflow/core/ep/include/primitive/memcpy.h"
 #include "oneflow/core/graph/straighten_nodes.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/register/runtime_register_desc.h"
 #include "oneflow/core/common/env_var/env_var.h"
 #include "oneflow/core/graph/boxing_task_graph.pb.h"
@@ -49,6 +50,7 @@ namespace oneflow {
 
 // TODO(Chengcheng): default false.
 DEFINE_ENV_BOOL(ONEFLOW_ENABLE_OUTDATED_OPT_FW_CHAIN_MERGE, true);
+DEFINE_ENV_BOOL(ONEFLOW_ENABLE_PARALLEL_COMP_TASK_NODE_CREATION, true);
 
 namespace {
 
@@ -322,12 +324,9 @@ TaskType TaskType4OpNode(const OpNode* op_node) {
   return comp_task_node->GetTaskType();
 }
 
-}  // namespace
-
-CompTaskNode* GenCompTaskNode(
-    const OpNode* op_node, int64_t parallel_id,
-    const std::function<StreamId(const OpNode* op_node, int64_t parallel_id, TaskType task_type)>&
-        GetOrCreateStreamId) {
+// Allocates the compute task node of op_node on parallel_id without its thrd id and task id, which
+// are drawn from generators shared by all nodes. It may run for different op nodes in parallel.
+CompTaskNode* NewCompTaskNodeWithoutThrdId(const OpNode* op_node, int64_t parallel_id) {
   const ParallelDesc& parallel_desc = op_node->parallel_desc();
   int64_t parallel_num = parallel_desc.parallel_num();
   CompTaskNode* comp_task_node = NewCompTaskNode4OpNode(op_node);
@@ -335,9 +334,19 @@ CompTaskNode* GenCompTaskNode(
   comp_task_node->set_machine_id(machine_id);
   comp_task_node->mut_parallel_ctx()->set_parallel_id(parallel_id);
   comp_task_node->mut_parallel_ctx()->set_parallel_num(parallel_num);
+  comp_task_node->set_op_node(op_node);
+  return comp_task_node;
+}
+
+}  // namespace
+
+CompTaskNode* GenCompTaskNode(
+    const OpNode* op_node, int64_t parallel_id,
+    const std::function<StreamId(const OpNode* op_node, int64_t parallel_id, TaskType task_type)>&
+        GetOrCreateStreamId) {
+  CompTaskNode* comp_task_node = NewCompTaskNodeWithoutThrdId(op_node, parallel_id);
   StreamId stream_id = GetOrCreateStreamId(op_node, parallel_id, comp_task_node->GetTaskType());
   comp_task_node->set_thrd_id(EncodeStreamIdToInt64(stream_id));
-  comp_task_node->set_op_node(op_node);
   return comp_task_node;
 }
 
@@ -1055,11 +1064,38 @@ Maybe<void> GlobalTaskGraph::Init() {
   hierarchical_sub_tsk_gph_builder_.reset(new DispatchHierarchicalSubTskGphBuilder());
   HashMap<const OpNode*, std::vector<CompTaskNode*>> op_node2sorted_comp_tasks;
 
-  op_graph->ForEachNode([&](const OpNode* op_node) {
-    std::vector<CompTaskNode*>* sorted_comp_tasks = &(op_node2sorted_comp_tasks[op_node]);
-    GenSortedCompTaskNodes(op_node, sorted_comp_tasks);
-    for (CompTaskNode* comp_task : *sorted_comp_tasks) { AddAllocatedNode(comp_task); }
-  });
+  // Compute task nodes are allocated in parallel, one op node per loop index. Their node ids,
+  // stream indexes and task ids are then drawn on one thread in the order of the op graph, so
+  // the task graph does not depend on thread scheduling.
+  std::vector<const OpNode*> op_nodes;
+  op_nodes.reserve(op_graph->node_num());
+  op_graph->ForEachNode([&](const OpNode* op_node) { op_nodes.push_back(op_node); });
+  std::vector<std::vector<CompTaskNode*>> op_node_index2sorted_comp_tasks(op_nodes.size());
+  const auto NewSortedCompTaskNodes = [&](size_t i) {
+    const OpNode* op_node = op_nodes.at(i);
+    std::vector<CompTaskNode*>* sorted_comp_tasks = &op_node_index2sorted_comp_tasks.at(i);
+    const int64_t parallel_num = op_node->parallel_desc().parallel_num();
+    sorted_comp_tasks->reserve(parallel_num);
+    FOR_RANGE(int64_t, parallel_id, 0, parallel_num) {
+      sorted_comp_tasks->push_back(NewCompTaskNodeWithoutThrdId(op_node, parallel_id));
+    }
+  };
+  if (EnvBool<ONEFLOW_ENABLE_PARALLEL_COMP_TASK_NODE_CREATION>()) {
+    MultiThreadLoop(op_nodes.size(), NewSortedCompTaskNodes);
+  } else {
+    FOR_RANGE(size_t, i, 0, op_nodes.size()) { NewSortedCompTaskNodes(i); }
+  }
+  FOR_RANGE(size_t, i, 0, op_nodes.size()) {
+    for (CompTaskNode* comp_task : op_node_index2sorted_comp_tasks.at(i)) {
+      comp_task->RenewNodeId();
+      StreamId stream_id =
+          GetStreamId(op_nodes.at(i), comp_task->parallel_id(), comp_task->GetTaskType());
+      comp_task->set_thrd_id(EncodeStreamIdToInt64(stream_id));
+      AddAllocatedNode(comp_task);
+    }
+    op_node2sorted_comp_tasks.emplace(op_nodes.at(i),
+                                      std::move(op_node_index2sorted_comp_tasks.at(i)));
+  }
 
   op_graph->ForEachEdge([&](const OpEdge* op_edge) {
     BldSubTskGphMthd method = GetMthdForBldSubTskGph(op_edge);
@@ -0,0 +1,351 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/collective_boxing/executor_backend_manager.h"
+#include "oneflow/core/job/collective_boxing/request_store.h"
+#include "oneflow/core/graph/boxing/collective_boxing_util.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/thread/thread_global_id.h"
+#include "oneflow/user/kernels/collective_communication/include/communication_context.h"
+#include "oneflow/user/kernels/collective_communication/include/all_reduce.h"
+#include "oneflow/user/kernels/collective_communication/include/reduce_scatter.h"
+#include "oneflow/user/kernels/collective_communication/include/all_gather.h"
+#include "oneflow/user/kernels/collective_communication/include/broadcast.h"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace {
+
+constexpr int64_t kCpuFusionAlignSize = 64;
+
+int64_t GetCpuFusionAlignedSize(int64_t size) {
+  return ((size + kCpuFusionAlignSize - 1) / kCpuFusionAlignSize) * kCpuFusionAlignSize;
+}
+
+ccl::ReduceType GetCclReduceType(ReduceMethod reduce_method) {
+  if (reduce_method == kReduceMethodSum) {
+    return ccl::kSum;
+  } else {
+    UNIMPLEMENTED();
+    return ccl::kInvalidReduceFunctorType;
+  }
+}
+
+std::shared_ptr<ccl::CommunicationContext> NewCpuCommunicationContext(
+    const DeviceSet& device_set) {
+  // The cpu ccl implementations address peers by process rank and locate the current rank by
+  // (machine_id, device_id), so every machine holds exactly one rank of the device set and the
+  // ranks are laid out in machine order, which keeps parallel_id equal to the collective rank.
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  int64_t prev_machine_id = -1;
+  for (const DeviceDesc& device : device_set.device()) {
+    CHECK_EQ(device.device_type(), DeviceType::kCPU);
+    CHECK_GT(device.machine_id(), prev_machine_id)
+        << "cpu collective boxing requires one rank per machine in ascending machine order";
+    prev_machine_id = device.machine_id();
+    parallel_conf.add_device_name("@" + std::to_string(device.machine_id()) + ":"
+                                  + std::to_string(device.device_id()));
+  }
+  return ccl::NewCommunicationContext(DeviceType::kCPU, SymbolOf(ParallelDesc(parallel_conf)));
+}
+
+struct CpuGroupTask {
+  std::shared_ptr<ccl::CommunicationContext> comm_ctx;
+  std::vector<RequestEntry*> request_entries;
+  std::vector<std::shared_ptr<const RuntimeRequestInfo>> runtime_request_infos;
+};
+
+}  // namespace
+
+class CpuExecutorBackend : public ExecutorBackend {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuExecutorBackend);
+  CpuExecutorBackend();
+  ~CpuExecutorBackend() override;
+
+ private:
+  void Init(std::shared_ptr<RequestStore> request_store) override;
+  void InitJob(int64_t job_id) override;
+  void DeinitJob(int64_t job_id) override;
+  void GroupRequests(const std::vector<RequestId>& request_ids,
+                     const std::function<void(std::vector<RequestId>&&, void*)>& Handler) override;
+  void ExecuteGroup(void* group_token) override;
+  void* CreateGroupToken(const std::vector<RequestId>& group) override;
+  void DestroyGroupToken(void* group_token) override;
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+struct CpuExecutorBackend::Impl {
+  Impl(const CollectiveBoxingConf& conf, std::shared_ptr<RequestStore> request_store)
+      : conf(conf), request_store(std::move(request_store)) {
+    CHECK_GE(conf.cpu_fusion_threshold_mb(), 0);
+    CHECK_GT(conf.cpu_fusion_max_ops(), 0);
+    fusion_threshold = conf.cpu_fusion_threshold_mb() * 1024 * 1024;
+  }
+  ~Impl() {
+    task_chan.Close();
+    if (worker.joinable()) { worker.join(); }
+    device_set2comm_ctx.clear();
+  }
+
+  // All collectives of this backend run on one thread, in the order the coordinator issues them,
+  // with a dedicated thread global id so that their transport tokens never interleave with those
+  // of the eager workers. The backend is registered in every session, the thread is only started
+  // once a cpu collective is executed.
+  void StartWorkerOnce() {
+    std::call_once(worker_started, [this]() { worker = std::thread(&Impl::PollTask, this); });
+  }
+
+  void InitCommContext(int64_t job_id) {
+    request_store->ForEachMutRequestEntryInJob(
+        job_id, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const auto& request = request_entry->desc();
+          if (request.op_desc().device_type() != DeviceType::kCPU) { return; }
+          if (!request_entry->HasRankOnThisNode()) { return; }
+          CHECK_EQ(request_entry->LocalRankCount(), 1);
+          const DeviceSet& device_set = request.device_set();
+          if (device_set2comm_ctx.count(device_set) > 0) { return; }
+          device_set2comm_ctx.emplace(device_set, NewCpuCommunicationContext(device_set));
+        });
+  }
+
+  bool CanRequestEntryFuse(const RequestEntry* lhs, const RequestEntry* rhs) const {
+    if (lhs->device_set_symbol() != rhs->device_set_symbol()) { return false; }
+    if (!conf.cpu_fusion_all_reduce()) { return false; }
+    const auto& lhs_op_desc = lhs->desc().op_desc();
+    const auto& rhs_op_desc = rhs->desc().op_desc();
+    if (lhs_op_desc.op_type() != OpType::kOpTypeAllReduce
+        || rhs_op_desc.op_type() != OpType::kOpTypeAllReduce) {
+      return false;
+    }
+    CHECK(lhs_op_desc.has_reduce_method());
+    CHECK(rhs_op_desc.has_reduce_method());
+    return lhs_op_desc.reduce_method() == rhs_op_desc.reduce_method()
+           && lhs_op_desc.data_type() == rhs_op_desc.data_type();
+  }
+
+  void GroupRequests(const std::vector<RequestId>& request_ids,
+                     const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+    std::vector<RequestId> group;
+    int64_t group_size = 0;
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        request_ids, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const int64_t size = GetCpuFusionAlignedSize(request_entry->size_in_bytes());
+          if (group.empty()
+              || !CanRequestEntryFuse(request_store->MutRequestEntry(group.back()), request_entry)
+              || group_size + size > fusion_threshold
+              || group.size() >= conf.cpu_fusion_max_ops()) {
+            if (!group.empty()) {
+              void* token = CreateGroupToken(group);
+              Handler(std::move(group), token);
+              group.clear();
+              group_size = 0;
+            }
+          }
+          group.emplace_back(request_id);
+          group_size += size;
+        });
+    if (!group.empty()) {
+      void* token = CreateGroupToken(group);
+      Handler(std::move(group), token);
+    }
+  }
+
+  struct GroupToken {
+    GroupToken(const std::vector<RequestId>& group,
+               std::shared_ptr<ccl::CommunicationContext> comm_ctx)
+        : request_ids(group), comm_ctx(std::move(comm_ctx)) {}
+    std::vector<RequestId> request_ids;
+    std::shared_ptr<ccl::CommunicationContext> comm_ctx;
+  };
+
+  void* CreateGroupToken(const std::vector<RequestId>& group) {
+    CHECK_GT(group.size(), 0);
+    const DeviceSet& first_device_set =
+        request_store->MutRequestEntry(group.front())->desc().device_set();
+    auto it = device_set2comm_ctx.find(first_device_set);
+    CHECK(it != device_set2comm_ctx.end());
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        group, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          CHECK(first_device_set == request_entry->desc().device_set());
+        });
+    return new GroupToken(group, it->second);
+  }
+
+  void DestroyGroupToken(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    delete token;
+  }
+
+  void ExecuteGroup(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    if (token->request_ids.empty()) { return; }
+    CpuGroupTask task;
+    task.comm_ctx = token->comm_ctx;
+    task.request_entries.reserve(token->request_ids.size());
+    task.runtime_request_infos.reserve(token->request_ids.size());
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        token->request_ids,
+        [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          task.request_entries.emplace_back(request_entry);
+          task.runtime_request_infos.emplace_back(
+              std::move(request_entry->ResetRuntimeRequest().at(0)));
+        });
+    StartWorkerOnce();
+    CHECK_EQ(task_chan.Send(std::move(task)), kChannelStatusSuccess);
+  }
+
+  void PollTask() {
+    ThreadGlobalIdGuard guard(kThreadGlobalIdCollectiveBoxing);
+    while (true) {
+      CpuGroupTask task;
+      ChannelStatus status = task_chan.Receive(&task);
+      if (status == kChannelStatusErrorClosed) { break; }
+      CHECK_EQ(status, kChannelStatusSuccess);
+      if (task.request_entries.size() > 1) {
+        LaunchFusedAllReduce(task);
+      } else {
+        LaunchOp(task.comm_ctx, task.request_entries.front(),
+                 task.runtime_request_infos.front().get());
+      }
+      for (const auto& runtime_request_info : task.runtime_request_infos) {
+        runtime_request_info->callback(Maybe<void>::Ok());
+      }
+    }
+  }
+
+  void LaunchFusedAllReduce(const CpuGroupTask& task) {
+    const auto& first_op_desc = task.request_entries.front()->desc().op_desc();
+    std::vector<int64_t> offset_vec;
+    offset_vec.reserve(task.request_entries.size());
+    int64_t offset = 0;
+    for (const RequestEntry* request_entry : task.request_entries) {
+      offset_vec.emplace_back(offset);
+      offset += GetCpuFusionAlignedSize(request_entry->size_in_bytes());
+    }
+    CHECK_LE(offset, fusion_threshold);
+    if (fusion_buffer.size() < static_cast<size_t>(offset)) { fusion_buffer.resize(offset); }
+    char* buffer = fusion_buffer.data();
+    for (size_t i = 0; i < task.request_entries.size(); ++i) {
+      std::memcpy(buffer + offset_vec.at(i), task.runtime_request_infos.at(i)->send_buff,
+                  task.request_entries.at(i)->size_in_bytes());
+    }
+    std::unique_ptr<ccl::AllReduce> all_reduce = ccl::NewCollectiveCommunication<ccl::AllReduce>(
+        DeviceType::kCPU, first_op_desc.data_type(),
+        GetCclReduceType(first_op_desc.reduce_method()));
+    const int64_t elem_cnt = offset / GetSizeOfDataType(first_op_desc.data_type());
+    all_reduce->Launch(nullptr, buffer, buffer, elem_cnt, task.comm_ctx);
+    for (size_t i = 0; i < task.request_entries.size(); ++i) {
+      std::memcpy(task.runtime_request_infos.at(i)->recv_buff, buffer + offset_vec.at(i),
+                  task.request_entries.at(i)->size_in_bytes());
+    }
+  }
+
+  void LaunchOp(const std::shared_ptr<ccl::CommunicationContext>& comm_ctx,
+                const RequestEntry* request_entry, const RuntimeRequestInfo* runtime_request_info) {
+    const auto& op_desc = request_entry->desc().op_desc();
+    const OpType op_type = op_desc.op_type();
+    const void* send_buff = runtime_request_info->send_buff;
+    void* recv_buff = runtime_request_info->recv_buff;
+    const int64_t elem_cnt = request_entry->elem_cnt();
+    const int64_t num_ranks = op_desc.num_ranks();
+    if (op_type == OpType::kOpTypeAllReduce) {
+      std::unique_ptr<ccl::AllReduce> all_reduce = ccl::NewCollectiveCommunication<ccl::AllReduce>(
+          DeviceType::kCPU, op_desc.data_type(), GetCclReduceType(op_desc.reduce_method()));
+      all_reduce->Launch(nullptr, send_buff, recv_buff, elem_cnt, comm_ctx);
+    } else if (op_type == OpType::kOpTypeReduceScatter) {
+      CHECK_EQ(elem_cnt % num_ranks, 0);
+      std::unique_ptr<ccl::ReduceScatter> reduce_scatter =
+          ccl::NewCollectiveCommunication<ccl::ReduceScatter>(
+              DeviceType::kCPU, op_desc.data_type(), GetCclReduceType(op_desc.reduce_method()));
+      reduce_scatter->Launch(nullptr, send_buff, recv_buff, elem_cnt / num_ranks, comm_ctx);
+    } else if (op_type == OpType::kOpTypeAllGather) {
+      CHECK_EQ(elem_cnt % num_ranks, 0);
+      std::unique_ptr<ccl::AllGather> all_gather =
+          ccl::NewCollectiveCommunication<ccl::AllGather>(DeviceType::kCPU, op_desc.data_type());
+      all_gather->Launch(nullptr, send_buff, recv_buff, elem_cnt / num_ranks, comm_ctx);
+    } else if (op_type == OpType::kOpTypeBroadcast) {
+      // cpu ccl takes the process rank of the root rather than its collective rank
+      const int64_t root = request_entry->desc().device_set().device(op_desc.root()).machine_id();
+      std::unique_ptr<ccl::Broadcast> broadcast =
+          ccl::NewCollectiveCommunication<ccl::Broadcast>(DeviceType::kCPU, op_desc.data_type());
+      broadcast->Launch(nullptr, send_buff, recv_buff, elem_cnt, root, comm_ctx);
+    } else {
+      UNIMPLEMENTED() << "cpu collective boxing does not support " << OpType_Name(op_type);
+    }
+  }
+
+  CollectiveBoxingConf conf;
+  int64_t fusion_threshold;
+  std::vector<char> fusion_buffer;
+  std::shared_ptr<RequestStore> request_store;
+  HashMap<DeviceSet, std::shared_ptr<ccl::CommunicationContext>> device_set2comm_ctx;
+  Channel<CpuGroupTask> task_chan;
+  std::once_flag worker_started;
+  std::thread worker;
+};
+
+CpuExecutorBackend::CpuExecutorBackend() = default;
+
+CpuExecutorBackend::~CpuExecutorBackend() = default;
+
+void CpuExecutorBackend::Init(std::shared_ptr<RequestStore> request_store) {
+  impl_ = std::make_unique<Impl>(
+      Singleton<ResourceDesc, ForSession>::Get()->collective_boxing_conf(), request_store);
+}
+
+void CpuExecutorBackend::InitJob(int64_t job_id) { impl_->InitCommContext(job_id); }
+
+void CpuExecutorBackend::DeinitJob(int64_t job_id) {}
+
+void CpuExecutorBackend::GroupRequests(
+    const std::vector<RequestId>& request_ids,
+    const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+  impl_->GroupRequests(request_ids, Handler);
+}
+
+void* CpuExecutorBackend::CreateGroupToken(const std::vector<RequestId>& group) {
+  return impl_->CreateGroupToken(group);
+}
+
+void CpuExecutorBackend::DestroyGroupToken(void* group_token) {
+  return impl_->DestroyGroupToken(group_token);
+}
+
+void CpuExecutorBackend::ExecuteGroup(void* group_token) { impl_->ExecuteGroup(group_token); }
+
+REGISTER_EXECUTOR_BACKEND(DeviceType::kCPU, CpuExecutorBackend);
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
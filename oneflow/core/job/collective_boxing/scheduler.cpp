@@ -121,9 +121,6 @@ void ExecutorImpl::Init(std::shared_ptr<RequestStore> request_store) {
   request_store_ = request_store;
   backends_.resize(DeviceType_ARRAYSIZE);
   const auto& vaild_executor_device_types = ExecutorBackendMgr::Get().vaild_executor_device_types();
-  CHECK_LE(vaild_executor_device_types.size(), 1)
-      << "Currently only one backend is supported at the same time";
-
   for (DeviceType device_type : vaild_executor_device_types) {
     size_t dev_count = Singleton<ep::DeviceManagerRegistry>::Get()->GetDeviceCount(device_type);
     if (dev_count > 0) {
@@ -139,7 +136,7 @@ void ExecutorImpl::Init(std::shared_ptr<RequestStore> request_store) {
 void ExecutorImpl::InitJob(int64_t job_id) {
   const auto& vaild_executor_device_types = ExecutorBackendMgr::Get().vaild_executor_device_types();
   for (DeviceType device_type : vaild_executor_device_types) {
-    CHECK(backends_.at(device_type));
+    if (!backends_.at(device_type)) { continue; }
     backends_.at(device_type)->InitJob(job_id);
   }
 }
@@ -147,7 +144,7 @@ void ExecutorImpl::InitJob(int64_t job_id) {
 void ExecutorImpl::DeinitJob(int64_t job_id) {
   const auto& vaild_executor_device_types = ExecutorBackendMgr::Get().vaild_executor_device_types();
   for (DeviceType device_type : vaild_executor_device_types) {
-    CHECK(backends_.at(device_type));
+    if (!backends_.at(device_type)) { continue; }
     backends_.at(device_type)->DeinitJob(job_id);
   }
 }
@@ -158,11 +155,9 @@ GroupToken* ExecutorImpl::CreateGroupToken(const std::vector<RequestId>& group,
 }
 
 void ExecutorImpl::DestroyGroupToken(GroupToken* group_token) {
-  const auto& vaild_executor_device_types = ExecutorBackendMgr::Get().vaild_executor_device_types();
-  for (DeviceType device_type : vaild_executor_device_types) {
-    CHECK(backends_.at(device_type));
-    backends_.at(device_type)->DestroyGroupToken(group_token->backend_group_token());
-  }
+  const DeviceType device_type = group_token->device_type();
+  CHECK(backends_.at(device_type));
+  backends_.at(device_type)->DestroyGroupToken(group_token->backend_group_token());
   delete group_token;
 }
 
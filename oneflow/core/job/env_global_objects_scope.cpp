@@ -49,6 +49,8 @@ limitations under the License.
 #include "oneflow/core/kernel/sync_check_kernel_observer.h"
 #include "oneflow/core/kernel/blob_access_checker_kernel_observer.h"
 #include "oneflow/core/kernel/profiler_kernel_observer.h"
+#include "oneflow/core/kernel/cost_profiling_kernel_observer.h"
+#include "oneflow/core/auto_parallel/cost_database.h"
 #include "oneflow/core/embedding/embedding_manager.h"
 #include "oneflow/core/vm/remat/env.h"
 #ifdef WITH_RDMA
@@ -195,8 +197,8 @@ Maybe<void> EnvGlobalObjectsScope::Init(const EnvProto& env_proto) {
 #ifdef WITH_CUDA
   Singleton<CudnnConvAlgoCache>::New();
   Singleton<CudnnHandlePool>::New();
-  Singleton<embedding::EmbeddingManager>::New();
 #endif
+  Singleton<embedding::EmbeddingManager>::New();
   const auto& vaild_ccl_comm_mgr_device_types =
       EagerCclCommMgrBuilder::Get().vaild_ccl_comm_mgr_device_types();
   CHECK_LE_OR_RETURN(vaild_ccl_comm_mgr_device_types.size(), 1)
@@ -227,6 +229,19 @@ Maybe<void> EnvGlobalObjectsScope::Init(const EnvProto& env_proto) {
       kernel_observers.emplace_back(new BlobAccessCheckerKernelObserver());
     }
     kernel_observers.emplace_back(new ProfilerKernelObserver());
+    const std::string& cost_database_path =
+        GetStringFromEnv("ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE", "");
+    if (!cost_database_path.empty()) {
+      LOG(WARNING) << "Environment variable ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE has been "
+                      "set, kernels will be synchronized and profiled into "
+                   << cost_database_path;
+      Singleton<auto_parallel::CostDatabase>::New();
+      // Accumulate the measurement of the previous profiling runs
+      if (LocalFS()->FileExists(cost_database_path)) {
+        JUST(Singleton<auto_parallel::CostDatabase>::Get()->Load(cost_database_path));
+      }
+      kernel_observers.emplace_back(new CostProfilingKernelObserver());
+    }
     Singleton<KernelObserver>::SetAllocated(new ChainKernelObserver(kernel_observers));
   }
   TensorBufferPool::New();
@@ -239,6 +254,14 @@ EnvGlobalObjectsScope::~EnvGlobalObjectsScope() {
   if (is_normal_exit_.has_value() && !CHECK_JUST(is_normal_exit_)) { return; }
   TensorBufferPool::Delete();
   Singleton<KernelObserver>::Delete();
+  if (Singleton<auto_parallel::CostDatabase>::Get()) {
+    // Ranks run the same kernels in most cases, only the master rank writes the database.
+    if (GlobalProcessCtx::IsThisProcessMaster()) {
+      CHECK_JUST(Singleton<auto_parallel::CostDatabase>::Get()->Save(
+          GetStringFromEnv("ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE", "")));
+    }
+    Singleton<auto_parallel::CostDatabase>::Delete();
+  }
 #ifdef __linux__
   if (Singleton<ResourceDesc, ForSession>::Get()->process_ranks().size() > 1) {
     if (Singleton<EpollCommNet>::Get() != dynamic_cast<EpollCommNet*>(Singleton<CommNet>::Get())) {
@@ -249,8 +272,8 @@ EnvGlobalObjectsScope::~EnvGlobalObjectsScope() {
   Singleton<EpollCommNet>::Delete();
 #endif  // __linux__
   Singleton<vm::VirtualMachineScope>::Delete();
-#ifdef WITH_CUDA
   Singleton<embedding::EmbeddingManager>::Delete();
+#ifdef WITH_CUDA
   Singleton<CudnnConvAlgoCache>::Delete();
   Singleton<CudnnHandlePool>::Delete();
 #endif
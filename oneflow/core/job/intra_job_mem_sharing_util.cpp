@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/job/intra_job_mem_sharing_util.h"
+#include <mutex>
+#include <random>
 #include <vector>
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/common/data_type.h"
@@ -475,6 +477,182 @@ void InitAlgo2Result(
   }
 }
 
+// A register is identified by the rank of its producer, its memory zone, its producer op name and
+// its regst name, so the registers of a recompiled job share the same keys
+struct WarmStartKey {
+  int64_t rank;
+  std::string regst_key;
+};
+
+void GenRegst2WarmStartKey(Plan* plan, HashMap<RegstDescProto*, WarmStartKey>* regst2key) {
+  for (int64_t i = 0; i < plan->task_size(); ++i) {
+    TaskProto* task = plan->mutable_task(i);
+    if (task->exec_sequence().exec_node_size() == 0) { continue; }
+    const KernelConf& kernel_conf = task->exec_sequence().exec_node(0).kernel_conf();
+    const std::string& op_name = kernel_conf.has_op_attribute_ref()
+                                     ? kernel_conf.op_attribute_ref()
+                                     : kernel_conf.op_attribute().op_conf().name();
+    for (auto& pair : *(task->mutable_produced_regst_desc())) {
+      const MemoryCase& mem_case = pair.second.mem_case();
+      const std::string mem_zone = DeviceType_Name(mem_case.device_type()) + ":"
+                                   + std::to_string(mem_case.device_id());
+      (*regst2key)[&pair.second] =
+          WarmStartKey{task->machine_id(), mem_zone + "/" + op_name + "/" + pair.first};
+    }
+  }
+}
+
+// Return false if any register does not appear in the previous solution
+bool TryInitWarmStartOrder(const HashMap<RegstDescProto*, int64_t>& best_regst2offset,
+                           const HashMap<RegstDescProto*, WarmStartKey>& regst2key,
+                           HashMap<RegstDescProto*, int64_t>* regst_desc2offset) {
+  MemShareWarmStart* warm_start = Singleton<MemShareWarmStart>::Get();
+  const std::string& job_name = GlobalJobDesc().job_name();
+  std::unique_lock<std::mutex> lock(warm_start->mutex);
+  for (const auto& pair : best_regst2offset) {
+    auto key_it = regst2key.find(pair.first);
+    if (key_it == regst2key.end()) { return false; }
+    auto job_it = warm_start->job_rank2regst_key2offset.find({job_name, key_it->second.rank});
+    if (job_it == warm_start->job_rank2regst_key2offset.end()) { return false; }
+    auto offset_it = job_it->second.find(key_it->second.regst_key);
+    if (offset_it == job_it->second.end()) { return false; }
+    (*regst_desc2offset)[pair.first] = offset_it->second;
+  }
+  return true;
+}
+
+void UpdateWarmStart(const HashMap<RegstDescProto*, int64_t>& regst_desc2offset,
+                     const HashMap<RegstDescProto*, WarmStartKey>& regst2key) {
+  MemShareWarmStart* warm_start = Singleton<MemShareWarmStart>::Get();
+  const std::string& job_name = GlobalJobDesc().job_name();
+  std::unique_lock<std::mutex> lock(warm_start->mutex);
+  for (const auto& pair : regst_desc2offset) {
+    auto key_it = regst2key.find(pair.first);
+    if (key_it == regst2key.end()) { continue; }
+    warm_start->job_rank2regst_key2offset[{job_name, key_it->second.rank}]
+                                         [key_it->second.regst_key] = pair.second;
+  }
+}
+
+// Randomly swap some neighboring registers in the order of the given offsets
+void InitPerturbedOrder(const HashMap<RegstDescProto*, int64_t>& best_regst2offset, int64_t seed,
+                        HashMap<RegstDescProto*, int64_t>* regst_desc2offset) {
+  std::vector<RegstDescProto*> order;
+  order.reserve(best_regst2offset.size());
+  for (const auto& pair : best_regst2offset) { order.emplace_back(pair.first); }
+  std::sort(order.begin(), order.end(), [&](RegstDescProto* lhs, RegstDescProto* rhs) {
+    return best_regst2offset.at(lhs) < best_regst2offset.at(rhs);
+  });
+  if (order.size() > 1) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> distribution(0, order.size() - 2);
+    for (size_t i = 0; i < order.size() / 10 + 1; ++i) {
+      size_t pos = distribution(generator);
+      std::swap(order[pos], order[pos + 1]);
+    }
+  }
+  for (int64_t i = 0; i < order.size(); ++i) { (*regst_desc2offset)[order[i]] = i; }
+}
+
+// A start point of the memory compression
+struct MemShareStart {
+  int64_t mem_chain_id;
+  std::string name;
+  // The initial offsets only provide an order of registers and need to be compacted
+  bool need_compact;
+  MemBlockResultInfo<RegstDescProto*> result;
+};
+
+// Compress the memory from several start points in parallel and keep the best one. The start
+// points are the result of the best heuristic algorithm, the warm start and its random
+// perturbations.
+void CompressMemory4MemChains(
+    Plan* plan,
+    const HashMap<int64_t, HashMap<RegstDescProto*, std::pair<int32_t, int32_t>>>&
+        mem_chain2regst2lifetime,
+    const HashMap<RegstDescProto*, size_t>& mem_reused_regst2size,
+    const HashMap<int64_t, size_t>& mem_chain2peak_memory,
+    HashMap<int64_t, MemBlockResultInfo<RegstDescProto*>*>* mem_chain2best_result) {
+  const JobConfigProto& job_conf = GlobalJobDesc().job_conf();
+  HashMap<RegstDescProto*, WarmStartKey> regst2warm_start_key;
+  if (job_conf.enable_compress_memory_warm_start() && Singleton<MemShareWarmStart>::Get()) {
+    GenRegst2WarmStartKey(plan, &regst2warm_start_key);
+  }
+  std::vector<MemShareStart> starts;
+  for (const auto& pair : *mem_chain2best_result) {
+    int64_t mem_chain_id = pair.first;
+    const auto& best_regst2offset = pair.second->regst_desc2offset;
+    // Only the result of the best heuristic algorithm is compressed
+    starts.push_back({mem_chain_id, "heuristic algorithm", false, *pair.second});
+    if (!regst2warm_start_key.empty()) {
+      MemShareStart warm_start{mem_chain_id, "warm start", true,
+                               MemBlockResultInfo<RegstDescProto*>()};
+      if (TryInitWarmStartOrder(best_regst2offset, regst2warm_start_key,
+                                &warm_start.result.regst_desc2offset)) {
+        starts.emplace_back(std::move(warm_start));
+      }
+    }
+    for (int32_t i = 0; i < job_conf.compress_memory_random_search_num(); ++i) {
+      starts.push_back({mem_chain_id, "random " + std::to_string(i), true,
+                        MemBlockResultInfo<RegstDescProto*>()});
+      InitPerturbedOrder(best_regst2offset, i, &starts.back().result.regst_desc2offset);
+    }
+  }
+
+  {
+    int64_t work_size = starts.size();
+    int64_t thread_pool_size = std::min<int64_t>(work_size, std::thread::hardware_concurrency());
+    BlockingCounter counter(work_size);
+    ThreadPool thread_pool(thread_pool_size);
+    for (MemShareStart& start : starts) {
+      MemShareStart* start_ptr = &start;
+      thread_pool.AddWork([start_ptr, &mem_chain2regst2lifetime, &mem_reused_regst2size,
+                           &mem_chain2peak_memory, &counter]() {
+        const auto& regst2lifetime = mem_chain2regst2lifetime.at(start_ptr->mem_chain_id);
+        MemBlockResultInfo<RegstDescProto*>* result = &start_ptr->result;
+        MemoryShareStrategy mss;
+        if (start_ptr->need_compact) {
+          mss.CompactOffset(mem_reused_regst2size, regst2lifetime, &result->mem_block_size,
+                            &result->regst_desc2offset);
+        }
+        mss.AdaptivelyUpdateOffset(mem_reused_regst2size, regst2lifetime,
+                                   mem_chain2peak_memory.at(start_ptr->mem_chain_id),
+                                   &result->mem_block_size, &result->regst_desc2offset);
+        counter.Decrease();
+      });
+    }
+    counter.WaitForeverUntilCntEqualZero();
+  }
+
+  HashMap<int64_t, const MemShareStart*> mem_chain2best_start;
+  for (const MemShareStart& start : starts) {
+    const MemShareStart*& best_start = mem_chain2best_start[start.mem_chain_id];
+    if (!best_start || start.result.mem_block_size < best_start->result.mem_block_size) {
+      best_start = &start;
+    }
+  }
+  size_t total_lower_bound = 0;
+  size_t total_mem_size = 0;
+  for (auto& pair : *mem_chain2best_result) {
+    const MemShareStart* best_start = mem_chain2best_start.at(pair.first);
+    size_t lower_bound = mem_chain2peak_memory.at(pair.first);
+    size_t mem_size = best_start->result.mem_block_size;
+    VLOG(1) << "Memory chain " << pair.first << ": lower bound " << lower_bound
+            << ", heuristic algorithm " << pair.second->mem_block_size << ", compressed "
+            << mem_size << " from " << best_start->name << ", ratio to lower bound "
+            << (lower_bound > 0 ? static_cast<double>(mem_size) / lower_bound : 1.0);
+    total_lower_bound += lower_bound;
+    total_mem_size += mem_size;
+    *pair.second = best_start->result;
+    if (!regst2warm_start_key.empty()) {
+      UpdateWarmStart(pair.second->regst_desc2offset, regst2warm_start_key);
+    }
+  }
+  VLOG(1) << "Job " << GlobalJobDesc().job_name() << " compressed memory: lower bound "
+          << total_lower_bound << ", achieved " << total_mem_size << " with " << starts.size()
+          << " start points";
+}
+
 }  // namespace
 
 void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan) {
@@ -532,7 +710,8 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan) {
     counter.WaitForeverUntilCntEqualZero();
   }
 
-  // step 3: choose best one for each mem chain and set offset for inplace consumer regst
+  // step 3: choose best one for each mem chain
+  HashMap<int64_t, MemBlockResultInfo<RegstDescProto*>*> mem_chain2best_result;
   for (auto& pair : mem_chain2algo2result) {
     MemBlockResultInfo<RegstDescProto*>* best_result = nullptr;
     for (auto& algo_result_pair : pair.second) {
@@ -541,16 +720,19 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan) {
       }
     }
     CHECK(best_result != nullptr);
+    mem_chain2best_result[pair.first] = best_result;
+  }
 
-    // Update the offset with a smaller total memory size if the current size is greater than the
-    // lower bound
-    if (GlobalJobDesc().job_conf().enable_compress_memory()) {
-      MemoryShareStrategy mss;
-      mss.AdaptivelyUpdateOffset(mem_reused_regst2size, mem_chain2regst2lifetime.at(pair.first),
-                                 mem_chain2peak_memory[pair.first], &best_result->mem_block_size,
-                                 &best_result->regst_desc2offset);
-    }
+  // step 4: update the offset with a smaller total memory size if the current size is greater than
+  // the lower bound
+  if (GlobalJobDesc().job_conf().enable_compress_memory()) {
+    CompressMemory4MemChains(plan, mem_chain2regst2lifetime, mem_reused_regst2size,
+                             mem_chain2peak_memory, &mem_chain2best_result);
+  }
 
+  // step 5: set offset for inplace consumer regst
+  for (auto& pair : mem_chain2best_result) {
+    MemBlockResultInfo<RegstDescProto*>* best_result = pair.second;
     int64_t mem_block_id = Singleton<IDMgr>::Get()->NewMemBlockId();
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
@@ -17,10 +17,12 @@ limitations under the License.
 #define ONEFLOW_CORE_JOB_IN_JOB_MEM_SHARING_UTIL_H_
 
 #include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/hash.h"
 #include "oneflow/core/common/hash_container.h"
 #include "oneflow/core/job/memory_share_strategy.h"
 #include "oneflow/core/job/plan.pb.h"
 #include <functional>
+#include <mutex>
 #include <string>
 
 namespace oneflow {
@@ -29,6 +31,16 @@ struct IntraJobMemSharingUtil {
   static void InferMemBlockId4MemReusedRegst(Plan* plan);
 };
 
+// The register offsets of the jobs compiled in this session, which are the warm start of the
+// memory compression when a job is compiled again. Plans are not cached across sessions, so the
+// offsets are dropped with the session.
+struct MemShareWarmStart {
+  std::mutex mutex;
+  // (job name, rank) -> memory zone/producer op name/regst name -> offset
+  HashMap<std::pair<std::string, int64_t>, HashMap<std::string, int64_t>>
+      job_rank2regst_key2offset;
+};
+
 template<class T>
 struct MemBlockResultInfo {
   size_t mem_block_size;
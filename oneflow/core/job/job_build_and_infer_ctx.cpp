@@ -1022,6 +1022,8 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
     // TODO(guoran): loop multiple times inside the pass
     JUST(DoPass("FuseAddToOutputPass", 1));
     JUST(DoPass("FuseConsecutiveAddPass"));
+    // run after the add_to_output fusion so that residual adds move into the converted region
+    JUST(DoPass("CpuChannelsLastLayoutPass"));
     JUST(DoPass("IndexedSlicesOptimizerRewritePass"));
     JUST(DoPass("SplitSparseSoftmaxCrossEntropyOpPass"));
     JUST(DoPass("DoParallelCastBeforeWideningTypeCast"));
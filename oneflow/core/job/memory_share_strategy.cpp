@@ -450,4 +450,17 @@ void MemoryShareStrategy::GenerateOffset(
   UpdateOffset(mem_block_size, regst_desc2offset);
 }
 
+// Compact the registers with the relative order of the given offsets.
+void MemoryShareStrategy::CompactOffset(
+    const HashMap<RegstDescProto*, size_t>& mem_reused_regst2size,
+    const HashMap<RegstDescProto*, std::pair<int32_t, int32_t>>& register2lifetime,
+    size_t* mem_block_size, HashMap<RegstDescProto*, int64_t>* regst_desc2offset) {
+  StealCompactPosition(*regst_desc2offset, mem_reused_regst2size, register2lifetime);
+  *mem_block_size = ComputeOptimalCostFrom0();
+  CHECK_JUST(CheckConflict());
+  for (auto& pair : *regst_desc2offset) {
+    pair.second = register_offset_[register2index_[pair.first]];
+  }
+}
+
 }  // namespace oneflow
@@ -45,6 +45,13 @@ class MemoryShareStrategy {
       const HashMap<RegstDescProto*, std::pair<int32_t, int32_t>>& register2lifetime,
       size_t* mem_block_size, HashMap<RegstDescProto*, int64_t>* regst_desc2offset);
 
+  // Compact the registers with the relative order of the given offsets.
+  // The given offsets might come from a previous solution or a random permutation, which do not
+  // need to be free of conflict. The compacted offsets and memory size would be written back.
+  void CompactOffset(const HashMap<RegstDescProto*, size_t>& mem_reused_regst2size,
+                     const HashMap<RegstDescProto*, std::pair<int32_t, int32_t>>& register2lifetime,
+                     size_t* mem_block_size, HashMap<RegstDescProto*, int64_t>* regst_desc2offset);
+
  private:
   size_t mem_block_size_;
   int32_t max_iteration_step_;
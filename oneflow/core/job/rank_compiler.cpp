@@ -22,7 +22,9 @@ limitations under the License.
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/cost_util.h"
 #include "oneflow/core/rpc/include/global_process_ctx.h"
 
 namespace oneflow {
@@ -34,7 +36,10 @@ Maybe<void> RankCompiler::Compile(const HashSet<std::string>& var_op_names, Job*
   // context on cuda:0.
   CudaCurrentDeviceGuard guard(GetCudaDeviceIndex());
 #endif  // WITH_CUDA
+  const auto& job_name = job->job_conf().job_name() + " rank " + std::to_string(rank_);
+  auto compile_tc = std::make_unique<CostCounter<std::chrono::milliseconds>>(true, true);
   auto task_gph = JUST(RankTaskGraph::New(boxing_task_graph_proto_, var_op_names, rank_));
+  compile_tc->Count("[GraphCompile]" + job_name + " NewRankTaskGraph", 1);
   using std::placeholders::_1;
   const auto& IsNotMyDuty = [&](const CompTaskNode* comp_task_node) {
     if (comp_task_node == nullptr) { return false; }
@@ -59,11 +64,14 @@ Maybe<void> RankCompiler::Compile(const HashSet<std::string>& var_op_names, Job*
       task_node->PinConsumedRegst();
     }
   });
+  compile_tc->Count("[GraphCompile]" + job_name + " ConsumeRegsts", 1);
   task_gph->TopoForEachNode(&TaskNode::Build);
   task_gph->RemoveEmptyRegsts();
   task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  compile_tc->Count("[GraphCompile]" + job_name + " BuildTaskNodes", 1);
   task_gph->DecideExecutionOrder();
   task_gph->MergeChainAndAddOrderingCtrlEdgeInSameChain();
+  compile_tc->Count("[GraphCompile]" + job_name + " DecideExecutionOrder", 1);
   auto IsReachable = Singleton<OpGraph>::Get()->MakePredicatorIsOpNameDataOrCtrlReachable();
   const JobDesc& job_desc = GlobalJobDesc();
   if (job_desc.enable_inplace()) {
@@ -74,27 +82,36 @@ Maybe<void> RankCompiler::Compile(const HashSet<std::string>& var_op_names, Job*
     });
   }
   task_gph->ForEachEdge([&](TaskEdge* task_edge) { task_edge->CheckRegstLbiValid(); });
+  compile_tc->Count("[GraphCompile]" + job_name + " EnableInplaceMemSharing", 1, true);
 
   // put infomation from task_gph into plan.
+  // Erasing fake registers modifies the consumers of the producers' registers, so it is done
+  // before serializing task nodes in parallel.
+  std::vector<TaskNode*> task_nodes;
+  task_nodes.reserve(task_gph->node_num());
   task_gph->ForEachNode([&](TaskNode* task_node) {
     if (task_node->IsMeaningLess()) { return; }
     auto* comp_task_node = dynamic_cast<CompTaskNode*>(task_node);
-    if (comp_task_node != nullptr) {
-      const auto& parallel_desc = comp_task_node->op_node()->parallel_desc();
-      if (!task_gph->IsDutyRank(parallel_desc, task_node->machine_id())) {
-        auto* fake_consumed_regsts_provider =
-            dynamic_cast<FakeConsumedRegstProvider*>(comp_task_node);
-        CHECK_NOTNULL(fake_consumed_regsts_provider)->EraseFakeRegstsIf();
-      }
-    }
-    TaskProto task_proto;
-    task_node->ToProto(&task_proto);
-    if (task_node->GetTaskType() == kNormalForward || task_node->GetTaskType() == kRepeat
-        || task_node->GetTaskType() == kAcc) {
-      PlanUtil::CreateOpAttributeRef(plan, job_desc.job_id(), &task_proto);
+    if (IsNotMyDuty(comp_task_node)) {
+      auto* fake_consumed_regsts_provider =
+          dynamic_cast<FakeConsumedRegstProvider*>(comp_task_node);
+      CHECK_NOTNULL(fake_consumed_regsts_provider)->EraseFakeRegstsIf();
     }
-    plan->mutable_task()->Add(std::move(task_proto));
+    task_nodes.push_back(task_node);
   });
+  // Task nodes are serialized in parallel into their own slots, and added to the plan in the order
+  // of the task graph so that the plan is deterministic.
+  std::vector<TaskProto> task_protos(task_nodes.size());
+  MultiThreadLoop(task_nodes.size(),
+                  [&](size_t i) { task_nodes.at(i)->ToProto(&task_protos.at(i)); });
+  for (size_t i = 0; i < task_nodes.size(); ++i) {
+    const TaskType task_type = task_nodes.at(i)->GetTaskType();
+    if (task_type == kNormalForward || task_type == kRepeat || task_type == kAcc) {
+      PlanUtil::CreateOpAttributeRef(plan, job_desc.job_id(), &task_protos.at(i));
+    }
+    plan->mutable_task()->Add(std::move(task_protos.at(i)));
+  }
+  compile_tc->Count("[GraphCompile]" + job_name + " AddTaskToPlan", 1, true);
 
   // post-process for plan and delete Singleton<OpGraph>.
   auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
@@ -104,6 +121,7 @@ Maybe<void> RankCompiler::Compile(const HashSet<std::string>& var_op_names, Job*
   PlanUtil::MergeMemBlockIdByLogicalChainId(plan, *job, rank_);
   PlanUtil::SetUniqueMemBlockId4UnreusedMemRegst(plan);
   PlanUtil::SetForceInplaceMemBlock(plan, rank_);
+  compile_tc->Count("[GraphCompile]" + job_name + " InferMemShare", 1, true);
   return Maybe<void>::Ok();
 }
 
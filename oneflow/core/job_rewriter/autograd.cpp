@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/common/container_util.h"
 #include "oneflow/core/common/throw.h"
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/nd_sbp.h"
 #include "oneflow/core/job_rewriter/job_pass.h"
 #include "oneflow/core/job_rewriter/dynamic_loss_scale_job_pass_state.h"
 #include "oneflow/core/framework/scope_util.h"
@@ -964,11 +965,172 @@ void ClipGradient(JobPassCtx* ctx, const OpGraph& op_graph, JobBuilder* job_buil
   }
 }
 
+namespace {
+
+// Flatten and concatenate the gradients in a bucket, so that they are reduced across devices as
+// one contiguous buffer, then narrow and reshape them back.
+void AddBucketedDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                                 const std::vector<LogicalBlobId>& model_lbi_bucket,
+                                 HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  const OpNode* model_op_node = op_graph.OpNode4OpName(model_lbi_bucket.front().op_name());
+  const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+  std::vector<std::string> nd_sbp;
+  const std::string& variable_sole_obn = model_op_node->op().SoleObn();
+  for (const auto& sbp_parallel : model_op_node->NdSbp4BnInOp(variable_sole_obn).sbp_parallel()) {
+    nd_sbp.emplace_back(SbpParallelToString(sbp_parallel));
+  }
+  const std::string op_name_prefix = "System-AutoGrad-BucketParallelCast-" + NewUniqueId();
+  std::vector<OperatorConf> op_confs;
+  user_op::UserOpConfWrapperBuilder concat_builder(op_name_prefix + "-Concat");
+  concat_builder.Op("cat");
+  int64_t total_elem_cnt = 0;
+  for (int64_t i = 0; i < model_lbi_bucket.size(); ++i) {
+    const LogicalBlobId& diff_lbi = lbi2diff_lbi->at(model_lbi_bucket.at(i));
+    const int64_t elem_cnt = op_graph.GetLogicalBlobDesc(model_lbi_bucket.at(i)).shape().elem_cnt();
+    auto flatten_op =
+        user_op::UserOpConfWrapperBuilder(op_name_prefix + "-Flatten-" + std::to_string(i))
+            .Op("reshape")
+            .Input("in", GenLogicalBlobName(diff_lbi))
+            .Output("out")
+            .Attr<Shape>("shape", Shape({elem_cnt}))
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    op_confs.emplace_back(flatten_op.op_conf());
+    concat_builder.Input("in", flatten_op.output("out", 0));
+    total_elem_cnt += elem_cnt;
+  }
+  auto concat_op = concat_builder.Output("out")
+                       .Attr<int64_t>("axis", 0)
+                       .Attr<int64_t>("max_dim_size", total_elem_cnt)
+                       .ScopeSymbolId(scope_symbol_id)
+                       .Build();
+  op_confs.emplace_back(concat_op.op_conf());
+  auto parallel_cast_op =
+      user_op::UserOpConfWrapperBuilder(op_name_prefix + "-ParallelCast")
+          .Op("hierarchical_parallel_cast")
+          .Input("in", concat_op.output("out", 0))
+          .Output("out")
+          .Attr<std::vector<std::string>>("nd_sbp", nd_sbp)
+          .Attr<std::string>("grad_mode", "auto")
+          .Attr<std::vector<std::string>>("grad_nd_sbp", std::vector<std::string>())
+          .ScopeSymbolId(scope_symbol_id)
+          .Build();
+  op_confs.emplace_back(parallel_cast_op.op_conf());
+  int64_t offset = 0;
+  for (int64_t i = 0; i < model_lbi_bucket.size(); ++i) {
+    LogicalBlobId& diff_lbi = lbi2diff_lbi->at(model_lbi_bucket.at(i));
+    const Shape& shape = op_graph.GetLogicalBlobDesc(model_lbi_bucket.at(i)).shape();
+    auto narrow_op =
+        user_op::UserOpConfWrapperBuilder(op_name_prefix + "-Narrow-" + std::to_string(i))
+            .Op("narrow")
+            .Input("in", parallel_cast_op.output("out", 0))
+            .Output("out")
+            .Attr<int64_t>("dim", 0)
+            .Attr<int64_t>("start", offset)
+            .Attr<int64_t>("length", shape.elem_cnt())
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    auto reshape_op =
+        user_op::UserOpConfWrapperBuilder(op_name_prefix + "-Reshape-" + std::to_string(i))
+            .Op("reshape")
+            .Input("in", narrow_op.output("out", 0))
+            .Output("out")
+            .Attr<Shape>("shape", shape)
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    op_confs.emplace_back(narrow_op.op_conf());
+    op_confs.emplace_back(reshape_op.op_conf());
+    diff_lbi = GenLogicalBlobId(reshape_op.output("out", 0));
+    offset += shape.elem_cnt();
+  }
+  job_builder->AddOps(model_op_node->parallel_desc().parallel_conf(), op_confs);
+}
+
+}  // namespace
+
+void GetModelLbiBuckets4ParallelCast(const OpGraph& op_graph, int64_t bucket_size,
+                                     const HashSet<LogicalBlobId>& compressed_model_lbis,
+                                     DataType compressed_data_type,
+                                     const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi,
+                                     std::vector<std::vector<LogicalBlobId>>* model_lbi_buckets) {
+  HashMap<const OpNode*, int64_t> op_node2topo_order;
+  op_graph.TopoForEachNode([&](OpNode* op_node) {
+    op_node2topo_order.emplace(op_node, op_node2topo_order.size());
+  });
+  std::vector<std::pair<int64_t, LogicalBlobId>> topo_order_and_model_lbis;
+  for (const auto& pair : lbi2diff_lbi) {
+    const OpNode* model_op_node = op_graph.OpNode4OpName(pair.first.op_name());
+    if (model_op_node->parallel_desc().parallel_num() <= 1) { continue; }
+    // Flattened gradients could only be concatenated if the model is broadcast
+    const NdSbp& model_nd_sbp = model_op_node->NdSbp4BnInOp(model_op_node->op().SoleObn());
+    if (!std::all_of(model_nd_sbp.sbp_parallel().begin(), model_nd_sbp.sbp_parallel().end(),
+                     [](const SbpParallel& sbp) { return sbp.has_broadcast_parallel(); })) {
+      continue;
+    }
+    const OpNode* diff_op_node = op_graph.OpNode4OpName(pair.second.op_name());
+    const NdSbp& diff_nd_sbp = diff_op_node->NdSbp4Lbi(pair.second);
+    if (std::any_of(diff_nd_sbp.sbp_parallel().begin(), diff_nd_sbp.sbp_parallel().end(),
+                    [](const SbpParallel& sbp) { return sbp.has_split_parallel(); })
+        || std::none_of(diff_nd_sbp.sbp_parallel().begin(), diff_nd_sbp.sbp_parallel().end(),
+                        [](const SbpParallel& sbp) { return sbp.has_partial_sum_parallel(); })) {
+      continue;
+    }
+    topo_order_and_model_lbis.emplace_back(op_node2topo_order.at(diff_op_node), pair.first);
+  }
+  // The gradients produced earlier in backward are put into the earlier buckets, so that their
+  // reduction could start while the rest of backward is running.
+  std::sort(topo_order_and_model_lbis.begin(), topo_order_and_model_lbis.end(),
+            [](const std::pair<int64_t, LogicalBlobId>& lhs,
+               const std::pair<int64_t, LogicalBlobId>& rhs) { return lhs.first < rhs.first; });
+  // Only the gradients with the same placement, sbp and data type could share a bucket. The data
+  // type is the one the gradient is reduced in: compressed gradients are cast before the reduction,
+  // the others have been cast to the data type of the model.
+  HashMap<std::string, int64_t> key2open_bucket_id;
+  std::vector<std::vector<LogicalBlobId>> buckets;
+  std::vector<int64_t> bucket_sizes;
+  for (const auto& pair : topo_order_and_model_lbis) {
+    const LogicalBlobId& lbi = pair.second;
+    const OpNode* model_op_node = op_graph.OpNode4OpName(lbi.op_name());
+    const BlobDesc& blob_desc = op_graph.GetLogicalBlobDesc(lbi);
+    const DataType reduced_data_type =
+        compressed_model_lbis.count(lbi) > 0 ? compressed_data_type : blob_desc.data_type();
+    const std::string key =
+        model_op_node->parallel_desc().parallel_conf().DebugString()
+        + NdSbpToString(model_op_node->NdSbp4BnInOp(model_op_node->op().SoleObn()))
+        + DataType_Name(reduced_data_type);
+    auto it = key2open_bucket_id.find(key);
+    if (it == key2open_bucket_id.end() || bucket_sizes.at(it->second) >= bucket_size) {
+      key2open_bucket_id[key] = buckets.size();
+      buckets.emplace_back();
+      bucket_sizes.emplace_back(0);
+    }
+    const int64_t bucket_id = key2open_bucket_id.at(key);
+    buckets.at(bucket_id).emplace_back(lbi);
+    bucket_sizes.at(bucket_id) +=
+        blob_desc.shape().elem_cnt() * GetSizeOfDataType(reduced_data_type);
+  }
+  for (auto& bucket : buckets) {
+    if (bucket.size() > 1) { model_lbi_buckets->emplace_back(std::move(bucket)); }
+  }
+}
+
+void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                         HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  AddDiffParallelCast(op_graph, job_builder, {}, lbi2diff_lbi);
+}
+
 void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                         const std::vector<std::vector<LogicalBlobId>>& model_lbi_buckets,
                          HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  HashSet<LogicalBlobId> bucketed_model_lbis;
+  for (const auto& model_lbi_bucket : model_lbi_buckets) {
+    AddBucketedDiffParallelCast(op_graph, job_builder, model_lbi_bucket, lbi2diff_lbi);
+    bucketed_model_lbis.insert(model_lbi_bucket.begin(), model_lbi_bucket.end());
+  }
   for (auto& pair : *lbi2diff_lbi) {
     const LogicalBlobId& lbi = pair.first;
     LogicalBlobId& diff_lbi = pair.second;
+    if (bucketed_model_lbis.count(lbi) > 0) { continue; }
     const OpNode* model_op_node = op_graph.OpNode4OpName(lbi.op_name());
     if (model_op_node->parallel_desc().parallel_num() <= 1) { continue; }
     const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
@@ -994,6 +1156,87 @@ void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
   }
 }
 
+void GetModelLbis4GradientCompression(const OpGraph& op_graph,
+                                      const GradientCompressionConf& compression_conf,
+                                      const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi,
+                                      HashSet<LogicalBlobId>* model_lbis) {
+  for (const auto& pair : lbi2diff_lbi) {
+    const LogicalBlobId& diff_lbi = pair.second;
+    const OpNode* diff_op_node = op_graph.OpNode4OpName(diff_lbi.op_name());
+    if (diff_op_node->parallel_desc().parallel_num() <= 1) { continue; }
+    const BlobDesc& diff_blob_desc = op_graph.GetLogicalBlobDesc(diff_lbi);
+    if (diff_blob_desc.data_type() != DataType::kFloat) { continue; }
+    if (diff_blob_desc.shape().elem_cnt() < compression_conf.min_elem_cnt()) { continue; }
+    // Only the partial sum gradients would be reduced across devices
+    const NdSbp& diff_nd_sbp = diff_op_node->NdSbp4Lbi(diff_lbi);
+    if (std::any_of(diff_nd_sbp.sbp_parallel().begin(), diff_nd_sbp.sbp_parallel().end(),
+                    [](const SbpParallel& sbp) { return sbp.has_partial_sum_parallel(); })) {
+      model_lbis->insert(pair.first);
+    }
+  }
+}
+
+namespace {
+
+void AddDiffCastWithScale(const OpGraph& op_graph, JobBuilder* job_builder,
+                          const std::string& op_name_prefix, DataType data_type, double scale,
+                          bool scale_before_cast, const HashSet<LogicalBlobId>& model_lbis,
+                          HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  for (const LogicalBlobId& lbi : model_lbis) {
+    LogicalBlobId& diff_lbi = lbi2diff_lbi->at(lbi);
+    const OpNode* model_op_node = op_graph.OpNode4OpName(lbi.op_name());
+    const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+    const ParallelConf& parallel_conf = model_op_node->parallel_desc().parallel_conf();
+    const auto Scale = [&]() {
+      if (scale == 1.0) { return; }
+      auto scalar_mul_op =
+          user_op::UserOpConfWrapperBuilder(op_name_prefix + "-ScalarMul-" + NewUniqueId())
+              .Op("scalar_mul")
+              .Input("in", GenLogicalBlobName(diff_lbi))
+              .Output("out")
+              .Attr<bool>("has_float_operand", true)
+              .Attr<double>("float_operand", scale)
+              .Attr<bool>("has_int_operand", false)
+              .Attr<int64_t>("int_operand", 0)
+              .ScopeSymbolId(scope_symbol_id)
+              .Build();
+      job_builder->AddOps(parallel_conf, {scalar_mul_op.op_conf()});
+      diff_lbi = GenLogicalBlobId(scalar_mul_op.output("out", 0));
+    };
+    if (scale_before_cast) { Scale(); }
+    auto cast_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "-Cast-" + NewUniqueId())
+                       .Op("cast")
+                       .Input("in", GenLogicalBlobName(diff_lbi))
+                       .Output("out")
+                       .Attr<DataType>("dtype", data_type)
+                       .ScopeSymbolId(scope_symbol_id)
+                       .Build();
+    job_builder->AddOps(parallel_conf, {cast_op.op_conf()});
+    diff_lbi = GenLogicalBlobId(cast_op.output("out", 0));
+    if (!scale_before_cast) { Scale(); }
+  }
+}
+
+}  // namespace
+
+void AddDiffCompressionCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                            const GradientCompressionConf& compression_conf,
+                            const HashSet<LogicalBlobId>& model_lbis,
+                            HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  AddDiffCastWithScale(op_graph, job_builder, "System-AutoGrad-GradientCompression",
+                       compression_conf.data_type(), compression_conf.scale(),
+                       /*scale_before_cast=*/true, model_lbis, lbi2diff_lbi);
+}
+
+void AddDiffDecompressionCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                              const GradientCompressionConf& compression_conf,
+                              const HashSet<LogicalBlobId>& model_lbis,
+                              HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  AddDiffCastWithScale(op_graph, job_builder, "System-AutoGrad-GradientDecompression",
+                       DataType::kFloat, 1.0 / compression_conf.scale(),
+                       /*scale_before_cast=*/false, model_lbis, lbi2diff_lbi);
+}
+
 void AddDiffHalf2FloatCast(const OpGraph& op_graph, JobBuilder* job_builder,
                            HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
   for (auto& pair : *lbi2diff_lbi) {
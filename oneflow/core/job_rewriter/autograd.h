@@ -28,8 +28,36 @@ void AddDiffHalf2FloatCast(const OpGraph& op_graph, JobBuilder* job_builder,
                            HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
 void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
                          HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
+// Group the partial sum gradients into buckets of about bucket_size bytes in the order of backward.
+// The gradients of compressed_model_lbis are counted in compressed_data_type, the data type they
+// are reduced in. It should be called before any op is added to the gradients.
+void GetModelLbiBuckets4ParallelCast(const OpGraph& op_graph, int64_t bucket_size,
+                                     const HashSet<LogicalBlobId>& compressed_model_lbis,
+                                     DataType compressed_data_type,
+                                     const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi,
+                                     std::vector<std::vector<LogicalBlobId>>* model_lbi_buckets);
+// The gradients in each bucket are reduced across devices as one contiguous buffer
+void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                         const std::vector<std::vector<LogicalBlobId>>& model_lbi_buckets,
+                         HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
 void AddDiffStaticShapeCast(const OpGraph& op_graph, JobBuilder* job_builder,
                             HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
+// Collect the models whose float gradients would be reduced across devices in lower precision.
+// It should be called before any op is added to the gradients.
+void GetModelLbis4GradientCompression(const OpGraph& op_graph,
+                                      const GradientCompressionConf& compression_conf,
+                                      const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi,
+                                      HashSet<LogicalBlobId>* model_lbis);
+// Scale and cast the gradients before AddDiffParallelCast, so that the boxing reduces them in
+// compression_conf.data_type(), and recover them after AddDiffParallelCast.
+void AddDiffCompressionCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                            const GradientCompressionConf& compression_conf,
+                            const HashSet<LogicalBlobId>& model_lbis,
+                            HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
+void AddDiffDecompressionCast(const OpGraph& op_graph, JobBuilder* job_builder,
+                              const GradientCompressionConf& compression_conf,
+                              const HashSet<LogicalBlobId>& model_lbis,
+                              HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
 Maybe<void> CountNotFiniteIfNeeded(JobPassCtx* ctx, const OpGraph& op_graph,
                                    JobBuilder* job_builder,
                                    const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi);
@@ -0,0 +1,216 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// Converts the channels_first conv2d of a CPU inference job to channels_last, together with the
+// normalization, max_pool_2d, relu and add_n ops which only consume converted tensors, so that
+// activations stay NHWC between convolutions. Transposes are only inserted where a tensor enters
+// or leaves the converted region, and on the conv weights.
+class CpuChannelsLastLayoutPass final : public JobPass {
+ public:
+  CpuChannelsLastLayoutPass() = default;
+  ~CpuChannelsLastLayoutPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_cpu_channels_last_layout()
+           && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+const std::vector<int32_t> kToChannelsLastPerm = {0, 2, 3, 1};
+const std::vector<int32_t> kToChannelsFirstPerm = {0, 3, 1, 2};
+
+struct LayoutOpInfo {
+  // 4-D inputs which are in channels_last once the op is converted
+  std::vector<std::string> data_inputs;
+  std::string data_output;
+};
+
+const HashMap<std::string, LayoutOpInfo>& LayoutOpType2Info() {
+  static const HashMap<std::string, LayoutOpInfo> op_type2info{
+      {"conv2d", {{"in", "_add_to_output"}, "out"}},
+      {"normalization", {{"x", "_add_to_output"}, "y"}},
+      {"max_pool_2d", {{"x"}, "y"}},
+      {"relu", {{"x"}, "y"}},
+      {"add_n", {{"in"}, "out"}}};
+  return op_type2info;
+}
+
+bool IsOutputConsumed(const OpNode* node, const LogicalBlobId& lbi) {
+  for (const OpEdge* out_edge : node->out_edges()) {
+    if (std::find(out_edge->lbis().cbegin(), out_edge->lbis().cend(), lbi)
+        != out_edge->lbis().cend()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether the op could run channels_last, seeds are the conv2d ops, the others are only
+// converted when every data input is already channels_last.
+bool IsConvertible(const OpGraph& op_graph, const OpNode* node,
+                   const HashSet<std::string>& channels_last_lbns) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (!op_conf.has_user_conf()) { return false; }
+  const std::string& op_type_name = op_conf.user_conf().op_type_name();
+  const auto it = LayoutOpType2Info().find(op_type_name);
+  if (it == LayoutOpType2Info().end()) { return false; }
+  const user_op::UserOpConfWrapper user_op_conf(op_conf);
+  const auto Is4D = [&](const std::string& lbn) {
+    return op_graph.GetLogicalBlobDesc(GenLogicalBlobId(lbn)).shape().NumAxes() == 4;
+  };
+  if (!Is4D(user_op_conf.output(it->second.data_output, 0))) { return false; }
+  bool all_inputs_channels_last = true;
+  for (const std::string& arg_name : it->second.data_inputs) {
+    if (!user_op_conf.has_input(arg_name, 0)) { continue; }
+    for (int32_t i = 0; i < user_op_conf.input_size(arg_name); ++i) {
+      const std::string& lbn = user_op_conf.input(arg_name, i);
+      if (!Is4D(lbn)) { return false; }
+      if (channels_last_lbns.count(lbn) == 0) { all_inputs_channels_last = false; }
+    }
+  }
+  if (op_type_name == "conv2d") {
+    return user_op_conf.attr<std::string>("data_format") == "channels_first"
+           && user_op_conf.attr<int32_t>("groups") == 1;
+  } else if (op_type_name == "normalization") {
+    return all_inputs_channels_last && user_op_conf.attr<int32_t>("axis") == 1;
+  } else if (op_type_name == "max_pool_2d") {
+    // indices of a channels_last pooling are in another layout
+    return all_inputs_channels_last
+           && user_op_conf.attr<std::string>("data_format") == "channels_first"
+           && !IsOutputConsumed(node, GenLogicalBlobId(user_op_conf.output("indice", 0)));
+  } else {
+    return all_inputs_channels_last;
+  }
+}
+
+Maybe<void> CpuChannelsLastLayoutPass::Apply(const OpGraph& op_graph,
+                                             JobBuilder* job_builder) const {
+  std::vector<const OpNode*> converted_nodes;
+  HashSet<std::string> channels_last_lbns;
+  bool has_conv = false;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    if (!IsConvertible(op_graph, node, channels_last_lbns)) { return; }
+    const user_op::UserOpConfWrapper user_op_conf(node->op().op_conf());
+    const auto& info = LayoutOpType2Info().at(user_op_conf.op_type_name());
+    channels_last_lbns.insert(user_op_conf.output(info.data_output, 0));
+    converted_nodes.emplace_back(node);
+    if (user_op_conf.op_type_name() == "conv2d") { has_conv = true; }
+  });
+  if (!has_conv) { return Maybe<void>::Ok(); }
+
+  HashMap<std::string, std::string> transposed_lbns;
+  const auto GetOrAddTranspose = [&](const std::string& lbn, const std::vector<int32_t>& perm,
+                                     const OpNode* node) -> std::string {
+    const std::string suffix = perm == kToChannelsLastPerm ? "-to_nhwc" : "-to_nchw";
+    const auto it = transposed_lbns.find(lbn + suffix);
+    if (it != transposed_lbns.end()) { return it->second; }
+    const LogicalBlobId lbi = GenLogicalBlobId(lbn);
+    const auto transpose_op =
+        user_op::UserOpConfWrapperBuilder(lbi.op_name() + "-" + lbi.blob_name() + suffix)
+            .Op("transpose")
+            .Input("input", lbn)
+            .Output("output")
+            .Attr<std::vector<int32_t>>("perm", perm)
+            .ScopeSymbolId(node->op().op_conf().scope_symbol_id())
+            .Build();
+    job_builder->AddOps(node->parallel_desc().parallel_conf(), {transpose_op.op_conf()});
+    const std::string& transposed_lbn = transpose_op.output("output", 0);
+    transposed_lbns.emplace(lbn + suffix, transposed_lbn);
+    return transposed_lbn;
+  };
+
+  HashMap<std::string, OperatorConf> op_name2new_conf;
+  const auto MutOpConf = [&](const OpNode* node) -> OperatorConf* {
+    auto it = op_name2new_conf.find(node->op().op_name());
+    if (it == op_name2new_conf.end()) {
+      it = op_name2new_conf.emplace(node->op().op_name(), node->op().op_conf()).first;
+    }
+    return &it->second;
+  };
+
+  for (const OpNode* node : converted_nodes) {
+    OperatorConf* op_conf = MutOpConf(node);
+    const user_op::UserOpConfWrapper user_op_conf(node->op().op_conf());
+    const std::string& op_type_name = user_op_conf.op_type_name();
+    auto* attrs = op_conf->mutable_user_conf()->mutable_attr();
+    if (op_type_name == "conv2d") {
+      (*attrs)["data_format"].set_at_string("channels_last");
+      // weight [F, C, KH, KW] -> [F, KH, KW, C]
+      const std::string new_weight_lbn =
+          GetOrAddTranspose(user_op_conf.input("weight", 0), kToChannelsLastPerm, node);
+      ReplaceInputLbnInOpCustomizedConf(op_conf, GenRepeatedBn("weight", 0), new_weight_lbn);
+    } else if (op_type_name == "normalization") {
+      (*attrs)["axis"].set_at_int32(3);
+    } else if (op_type_name == "max_pool_2d") {
+      (*attrs)["data_format"].set_at_string("channels_last");
+    }
+    for (const std::string& arg_name : LayoutOpType2Info().at(op_type_name).data_inputs) {
+      if (!user_op_conf.has_input(arg_name, 0)) { continue; }
+      for (int32_t i = 0; i < user_op_conf.input_size(arg_name); ++i) {
+        const std::string& lbn = user_op_conf.input(arg_name, i);
+        if (channels_last_lbns.count(lbn) > 0) { continue; }
+        ReplaceInputLbnInOpCustomizedConf(op_conf, GenRepeatedBn(arg_name, i),
+                                          GetOrAddTranspose(lbn, kToChannelsLastPerm, node));
+      }
+    }
+  }
+
+  // consumers outside the converted region read the tensor transposed back to channels_first
+  HashSet<std::string> converted_op_names;
+  for (const OpNode* node : converted_nodes) { converted_op_names.insert(node->op().op_name()); }
+  for (const OpNode* node : converted_nodes) {
+    for (const OpEdge* out_edge : node->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      if (converted_op_names.count(consumer->op().op_name()) > 0) { continue; }
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        const LogicalBlobId& lbi = consumer->op().BnInOp2Lbi(ibn);
+        if (lbi.op_name() != node->op().op_name()) { continue; }
+        const std::string lbn = GenLogicalBlobName(lbi);
+        if (channels_last_lbns.count(lbn) == 0) { continue; }
+        const std::string old_lbn = ReplaceInputLbnInOpCustomizedConf(
+            MutOpConf(consumer), ibn, GetOrAddTranspose(lbn, kToChannelsFirstPerm, node));
+        CHECK_EQ_OR_RETURN(old_lbn, lbn);
+      }
+    }
+  }
+
+  std::vector<OperatorConf> new_op_confs;
+  new_op_confs.reserve(op_name2new_conf.size());
+  for (auto& pair : op_name2new_conf) { new_op_confs.emplace_back(std::move(pair.second)); }
+  job_builder->MutOpsOnlyOnce(new_op_confs);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("CpuChannelsLastLayoutPass", CpuChannelsLastLayoutPass);
+
+}  // namespace oneflow
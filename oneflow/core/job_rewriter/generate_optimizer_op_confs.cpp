@@ -122,9 +122,27 @@ Maybe<void> GenerateOptimizerOpConfs::Apply(Job* job, JobPassCtx* ctx) const {
   const JobBuilder* old_job_builder = job_builder.get();
   job_builder = JUST(WithCalculationPassScope(kOptimizerPass, job, [&]() -> Maybe<void> {
     CHECK(old_job_builder == job_builder.get());  // Check this lambda never been async called
+    const auto& compression_conf = job->job_conf().gradient_compression_conf();
+    HashSet<LogicalBlobId> compressed_model_lbis;
+    if (job->job_conf().has_gradient_compression_conf()) {
+      GetModelLbis4GradientCompression(op_graph, compression_conf, model_lbi2model_diff_lbi,
+                                       &compressed_model_lbis);
+    }
+    std::vector<std::vector<LogicalBlobId>> model_lbi_buckets;
+    const int64_t bucket_size = job->job_conf().gradient_bucket_size_mbyte() * 1024 * 1024;
+    if (bucket_size > 0) {
+      GetModelLbiBuckets4ParallelCast(op_graph, bucket_size, compressed_model_lbis,
+                                      compression_conf.data_type(), model_lbi2model_diff_lbi,
+                                      &model_lbi_buckets);
+    }
     AddDiffHalf2FloatCast(op_graph, job_builder.get(), &model_lbi2model_diff_lbi);
     AddDiffStaticShapeCast(op_graph, job_builder.get(), &model_lbi2model_diff_lbi);
-    AddDiffParallelCast(op_graph, job_builder.get(), &model_lbi2model_diff_lbi);
+    AddDiffCompressionCast(op_graph, job_builder.get(), compression_conf, compressed_model_lbis,
+                           &model_lbi2model_diff_lbi);
+    AddDiffParallelCast(op_graph, job_builder.get(), model_lbi_buckets,
+                        &model_lbi2model_diff_lbi);
+    AddDiffDecompressionCast(op_graph, job_builder.get(), compression_conf,
+                             compressed_model_lbis, &model_lbi2model_diff_lbi);
     JUST(ScaleModelDiffByLossInstanceNum(op_graph, job_builder.get(), &model_lbi2model_diff_lbi));
     JUST(ScaleInitialDiffByLossScale(ctx, op_graph, job_builder.get(), &loss_lbi2initial_diff_lbi));
     ScaleModelDiffByLossScale(ctx, op_graph, job_builder.get(), &model_lbi2model_diff_lbi);
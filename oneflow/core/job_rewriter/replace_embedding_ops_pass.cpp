@@ -1121,7 +1121,10 @@ Maybe<void> ReplaceEmbeddingOps::Apply(const OpGraph& op_graph, JobBuilder* job_
                    &inverse_indices_lbn, &num_unique_matrix_lbn);
     const bool is_train_job = job_builder->job().job_conf().has_train_conf();
     const bool no_optimizer_states = (embedding_size == line_size);
-    const bool has_embedding_prefetch = (!is_full_cache) && (is_train_job || no_optimizer_states);
+    // the host store has no cache, there is nothing to prefetch into
+    const bool is_cpu_store = (op_node->parallel_desc().device_type() == DeviceType::kCPU);
+    const bool has_embedding_prefetch =
+        (!is_full_cache) && (!is_cpu_store) && (is_train_job || no_optimizer_states);
 
     OperatorConf embedding_prefetch_op_conf;
     OperatorConf embedding_lookup_op_conf;
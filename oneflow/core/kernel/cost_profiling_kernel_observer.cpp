@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/kernel/cost_profiling_kernel_observer.h"
+#include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/auto_parallel/cost_database.h"
+
+namespace oneflow {
+
+namespace {
+
+// Kernels are launched one by one in an actor thread, so a thread local start point is enough.
+thread_local std::chrono::steady_clock::time_point kernel_start_point;
+
+// A boxing without collective boxing, such as a CPU boxing, is made of slice boxing kernels around
+// the comm net transfers, so they are measured as boxing too
+bool IsBoxingKernel(const OperatorConf& op_conf) {
+  return op_conf.has_collective_boxing_generic_conf() || op_conf.has_nccl_send_recv_boxing_conf()
+         || op_conf.has_slice_boxing_copy_conf() || op_conf.has_slice_boxing_add_conf();
+}
+
+}  // namespace
+
+void CostProfilingKernelObserver::WillForwardDataContent(KernelContext* kernel_ctx,
+                                                         const Kernel* kernel) {
+  // Wait for the previous kernels so that only this kernel is measured
+  CHECK_JUST_MSG(kernel_ctx->stream()->Sync(), kernel->op_conf().name());
+  kernel_start_point = std::chrono::steady_clock::now();
+}
+
+void CostProfilingKernelObserver::DidForwardDataContent(KernelContext* kernel_ctx,
+                                                        const Kernel* kernel) {
+  CHECK_JUST_MSG(kernel_ctx->stream()->Sync(), kernel->op_conf().name());
+  const double time_us = std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - kernel_start_point)
+                             .count();
+  auto* cost_database = Singleton<auto_parallel::CostDatabase>::Get();
+  if (cost_database == nullptr) { return; }
+  const auto& op_attribute = kernel->op_attribute();
+  if (IsBoxingKernel(kernel->op_conf())) {
+    int64_t byte_size = 0;
+    for (const auto& obn : op_attribute.output_bns()) {
+      const Blob* blob = kernel_ctx->BnInOp2Blob(obn);
+      if (blob) { byte_size += blob->ByteSizeOfBlobBody(); }
+    }
+    cost_database->AddTransfer(byte_size, time_us);
+    return;
+  }
+  std::vector<Shape> physical_in_shapes;
+  physical_in_shapes.reserve(op_attribute.input_bns().size());
+  for (const auto& ibn : op_attribute.input_bns()) {
+    const Blob* blob = kernel_ctx->BnInOp2Blob(ibn);
+    // Keep the position of the missing blob to match the key generated from the op graph
+    physical_in_shapes.emplace_back(blob ? blob->static_shape() : Shape());
+  }
+  cost_database->AddKernelTime(
+      auto_parallel::CostDatabase::GenKernelKey(kernel->op_conf(), physical_in_shapes), time_us);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,37 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_COST_PROFILING_KERNEL_OBSERVER_H_
+#define ONEFLOW_CORE_KERNEL_COST_PROFILING_KERNEL_OBSERVER_H_
+
+#include "oneflow/core/kernel/kernel_observer.h"
+
+namespace oneflow {
+
+// Measure the time of each kernel and record it into Singleton<auto_parallel::CostDatabase>.
+// The stream is synchronized around each kernel, so it should only be used in a profiling run.
+class CostProfilingKernelObserver final : public KernelObserver {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CostProfilingKernelObserver);
+  CostProfilingKernelObserver() = default;
+  ~CostProfilingKernelObserver() override = default;
+
+  void WillForwardDataContent(KernelContext* kernel_ctx, const Kernel* kernel) override;
+  void DidForwardDataContent(KernelContext* kernel_ctx, const Kernel* kernel) override;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_COST_PROFILING_KERNEL_OBSERVER_H_
@@ -17,32 +17,306 @@ limitations under the License.
 #include "oneflow/core/common/preprocessor.h"
 #include "oneflow/core/ndarray/ndarray_reduce_impl.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
 
 namespace oneflow {
 
-#define SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(struct_name)                                        \
-  template<typename T, template<typename> class binary_func>                                   \
-  struct struct_name<DeviceType::kCPU, T, binary_func> final {                                 \
-    using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;                        \
-    static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {       \
-      return false;                                                                            \
-    }                                                                                          \
-    static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,                       \
-                       const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) { \
-      UNIMPLEMENTED();                                                                         \
-    }                                                                                          \
-  }
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
-#undef SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL
+namespace {
+
+// Elements reduced by one task of ParallelFor, also the chunk a long reduction is split into. The
+// chunks do not depend on the number of threads, so every reduction is deterministic.
+constexpr int64_t kCpuReduceChunkSize = 32768;
+// Rows of a column reduction folded into one partial result
+constexpr int64_t kCpuReduceRowBlockSize = 128;
+// Columns of a column reduction handled by one task, small enough to stay in L1
+constexpr int64_t kCpuReduceColBlockSize = 1024;
+// Independent accumulators of a contiguous reduction, which break the dependency chain of the
+// fold so that the loop is vectorized
+constexpr int64_t kCpuReduceNumLanes = 8;
+// Elements summed linearly at the leaves of the pairwise summation
+constexpr int64_t kPairwiseSumLeafSize = 256;
+
+// Floating point sums are computed pairwise, their error grows with log(n) instead of n
+template<typename T, template<typename> class binary_func>
+struct IsPairwiseReduce final {
+  static constexpr bool value = !std::is_integral<T>::value
+                                && (std::is_same<binary_func<T>, BinaryFuncSum<T>>::value
+                                    || std::is_same<binary_func<T>, BinaryFuncNanSum<T>>::value);
+};
+
+template<typename T, template<typename> class binary_func>
+T FoldContiguous(const T* x, int64_t n) {
+  const T unit = UnitOfBinaryFunc<T, binary_func>::Val();
+  T lanes[kCpuReduceNumLanes];
+  std::fill(lanes, lanes + kCpuReduceNumLanes, unit);
+  int64_t i = 0;
+  for (; i + kCpuReduceNumLanes <= n; i += kCpuReduceNumLanes) {
+    for (int64_t lane = 0; lane < kCpuReduceNumLanes; ++lane) {
+      lanes[lane] = binary_func<T>::Invoke(lanes[lane], x[i + lane]);
+    }
+  }
+  T reduced = unit;
+  for (int64_t lane = 0; lane < kCpuReduceNumLanes; ++lane) {
+    reduced = binary_func<T>::Invoke(reduced, lanes[lane]);
+  }
+  for (; i < n; ++i) { reduced = binary_func<T>::Invoke(reduced, x[i]); }
+  return reduced;
+}
+
+template<typename T, template<typename> class binary_func>
+T ReduceContiguous(const T* x, int64_t n) {
+  if (!IsPairwiseReduce<T, binary_func>::value || n <= kPairwiseSumLeafSize) {
+    return FoldContiguous<T, binary_func>(x, n);
+  }
+  const int64_t half = n / 2;
+  return binary_func<T>::Invoke(ReduceContiguous<T, binary_func>(x, half),
+                                ReduceContiguous<T, binary_func>(x + half, n - half));
+}
+
+int64_t ReduceRowsBufferSize(int64_t num_rows, int64_t num_cols) {
+  const int64_t num_chunks = RoundUp(num_cols, kCpuReduceChunkSize) / kCpuReduceChunkSize;
+  return num_chunks > 1 ? num_rows * num_chunks : 0;
+}
+
+int64_t ReduceColsBufferSize(int64_t num_batches, int64_t num_rows, int64_t num_cols) {
+  return num_batches * RoundUp(num_rows, kCpuReduceRowBlockSize) / kCpuReduceRowBlockSize
+         * num_cols;
+}
+
+bool IsOverlapping(const void* lhs, size_t lhs_bytes, const void* rhs, size_t rhs_bytes) {
+  const auto lhs_begin = reinterpret_cast<uintptr_t>(lhs);
+  const auto rhs_begin = reinterpret_cast<uintptr_t>(rhs);
+  return lhs_begin < rhs_begin + rhs_bytes && rhs_begin < lhs_begin + lhs_bytes;
+}
+
+// tmp_storage is as large as x when it comes from the reduce kernels, other callers may pass less.
+// Some callers also pass x itself as tmp_storage, the partials must not overwrite x or y then.
+template<typename T, typename RetT>
+T* GetPartialBuffer(const XpuVarNdarray<T>& tmp_storage, int64_t size,
+                    const XpuVarNdarray<const T>& x, const XpuVarNdarray<RetT>& y,
+                    std::unique_ptr<T[]>* fallback) {
+  if (size == 0) { return nullptr; }
+  const size_t bytes = size * sizeof(T);
+  if (tmp_storage.ptr() != nullptr && tmp_storage.shape().ElemNum() >= size
+      && !IsOverlapping(tmp_storage.ptr(), bytes, x.ptr(), x.shape().ElemNum() * sizeof(T))
+      && !IsOverlapping(tmp_storage.ptr(), bytes, y.ptr(), y.shape().ElemNum() * sizeof(RetT))) {
+    return tmp_storage.ptr();
+  }
+  fallback->reset(new T[size]);
+  return fallback->get();
+}
+
+// y[r] = reduce(x[r, :]), rows longer than a chunk are split into chunks whose partial results are
+// combined pairwise
+template<typename T, typename RetT, template<typename> class binary_func>
+void ReduceRows(ep::CpuStream* stream, const T* x, int64_t num_rows, int64_t num_cols, RetT* y,
+                T* partials) {
+  const int64_t num_chunks = RoundUp(num_cols, kCpuReduceChunkSize) / kCpuReduceChunkSize;
+  if (num_chunks <= 1) {
+    stream->ParallelFor(
+        0, num_rows,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            y[row] =
+                static_cast<RetT>(ReduceContiguous<T, binary_func>(x + row * num_cols, num_cols));
+          }
+        },
+        std::max<int64_t>(1, kCpuReduceChunkSize / std::max<int64_t>(num_cols, 1)));
+    return;
+  }
+  stream->ParallelFor(
+      0, num_rows * num_chunks,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t col_begin = (i % num_chunks) * kCpuReduceChunkSize;
+          partials[i] = ReduceContiguous<T, binary_func>(
+              x + (i / num_chunks) * num_cols + col_begin,
+              std::min(kCpuReduceChunkSize, num_cols - col_begin));
+        }
+      },
+      1);
+  stream->ParallelFor(
+      0, num_rows,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          y[row] = static_cast<RetT>(
+              ReduceContiguous<T, binary_func>(partials + row * num_chunks, num_chunks));
+        }
+      },
+      std::max<int64_t>(1, kCpuReduceChunkSize / num_chunks));
+}
+
+// y[b, c] = reduce(x[b, :, c]). Blocks of rows are folded row by row into partial rows, so the
+// inner loop runs along contiguous columns, and the partial rows are then combined by a pairwise
+// tree.
+template<typename T, typename RetT, template<typename> class binary_func>
+void ReduceCols(ep::CpuStream* stream, const T* x, int64_t num_batches, int64_t num_rows,
+                int64_t num_cols, RetT* y, T* partials) {
+  const int64_t num_row_blocks = RoundUp(num_rows, kCpuReduceRowBlockSize) / kCpuReduceRowBlockSize;
+  const int64_t num_col_blocks = RoundUp(num_cols, kCpuReduceColBlockSize) / kCpuReduceColBlockSize;
+  const int64_t col_block_size = std::min(num_cols, kCpuReduceColBlockSize);
+  stream->ParallelFor(
+      0, num_batches * num_row_blocks * num_col_blocks,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          // i / num_col_blocks is the index of the row block among all batches
+          const int64_t batch = i / num_col_blocks / num_row_blocks;
+          const int64_t row_begin = (i / num_col_blocks % num_row_blocks) * kCpuReduceRowBlockSize;
+          const int64_t row_end = std::min(row_begin + kCpuReduceRowBlockSize, num_rows);
+          const int64_t col_begin = (i % num_col_blocks) * kCpuReduceColBlockSize;
+          const int64_t col_end = std::min(col_begin + kCpuReduceColBlockSize, num_cols);
+          T* acc = partials + (i / num_col_blocks) * num_cols;
+          std::fill(acc + col_begin, acc + col_end, UnitOfBinaryFunc<T, binary_func>::Val());
+          for (int64_t row = row_begin; row < row_end; ++row) {
+            const T* x_row = x + (batch * num_rows + row) * num_cols;
+            for (int64_t col = col_begin; col < col_end; ++col) {
+              acc[col] = binary_func<T>::Invoke(acc[col], x_row[col]);
+            }
+          }
+        }
+      },
+      std::max<int64_t>(1, kCpuReduceChunkSize / (kCpuReduceRowBlockSize * col_block_size)));
+  stream->ParallelFor(
+      0, num_batches * num_cols,
+      [&](int64_t begin, int64_t end) {
+        // [begin, end) is split at batch boundaries into column ranges of a single batch
+        for (int64_t i = begin; i < end;) {
+          const int64_t batch = i / num_cols;
+          const int64_t col_begin = i % num_cols;
+          const int64_t col_end = std::min(num_cols, col_begin + (end - i));
+          T* batch_partials = partials + batch * num_row_blocks * num_cols;
+          for (int64_t stride = 1; stride < num_row_blocks; stride *= 2) {
+            for (int64_t block = 0; block + stride < num_row_blocks; block += 2 * stride) {
+              T* dst = batch_partials + block * num_cols;
+              const T* src = batch_partials + (block + stride) * num_cols;
+              for (int64_t col = col_begin; col < col_end; ++col) {
+                dst[col] = binary_func<T>::Invoke(dst[col], src[col]);
+              }
+            }
+          }
+          for (int64_t col = col_begin; col < col_end; ++col) {
+            y[batch * num_cols + col] = static_cast<RetT>(batch_partials[col]);
+          }
+          i += col_end - col_begin;
+        }
+      },
+      std::max<int64_t>(1, kCpuReduceChunkSize / num_row_blocks));
+}
+
+}  // namespace
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayScalarReduce<DeviceType::kCPU, T, binary_func> final {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {
+    return y.shape().ElemNum() == 1;
+  }
+  static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,
+                     const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t elem_cnt = x.shape().ElemNum();
+    std::unique_ptr<T[]> fallback;
+    T* partials = GetPartialBuffer(tmp_storage, ReduceRowsBufferSize(1, elem_cnt), x, y, &fallback);
+    ReduceRows<T, RetT, binary_func>(stream->As<ep::CpuStream>(), x.ptr(), 1, elem_cnt, y.ptr(),
+                                     partials);
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixRowReduce<DeviceType::kCPU, T, binary_func> final {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2 || y.shape().NumAxes() != 2) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1;
+  }
+  static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,
+                     const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    std::unique_ptr<T[]> fallback;
+    T* partials =
+        GetPartialBuffer(tmp_storage, ReduceRowsBufferSize(num_rows, num_cols), x, y, &fallback);
+    ReduceRows<T, RetT, binary_func>(stream->As<ep::CpuStream>(), x.ptr(), num_rows, num_cols,
+                                     y.ptr(), partials);
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixColReduce<DeviceType::kCPU, T, binary_func> final {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2 || y.shape().NumAxes() != 2) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1);
+  }
+  static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,
+                     const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    std::unique_ptr<T[]> fallback;
+    T* partials =
+        GetPartialBuffer(tmp_storage, ReduceColsBufferSize(1, num_rows, num_cols), x, y, &fallback);
+    ReduceCols<T, RetT, binary_func>(stream->As<ep::CpuStream>(), x.ptr(), 1, num_rows, num_cols,
+                                     y.ptr(), partials);
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, T, binary_func> final {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3 || y.shape().NumAxes() != 3) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1) && y.shape().At(2) == 1;
+  }
+  // every row of z elements is reduced first, the [x, y] results are then reduced over x
+  static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,
+                     const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    const int64_t buffer_size = dim_x * dim_y
+                                + std::max(ReduceRowsBufferSize(dim_x * dim_y, dim_z),
+                                           ReduceColsBufferSize(1, dim_x, dim_y));
+    std::unique_ptr<T[]> fallback;
+    T* row_results = GetPartialBuffer(tmp_storage, buffer_size, x, y, &fallback);
+    T* partials = row_results + dim_x * dim_y;
+    auto* cpu_stream = stream->As<ep::CpuStream>();
+    ReduceRows<T, T, binary_func>(cpu_stream, x.ptr(), dim_x * dim_y, dim_z, row_results, partials);
+    ReduceCols<T, RetT, binary_func>(cpu_stream, row_results, 1, dim_x, dim_y, y.ptr(), partials);
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeYReduce<DeviceType::kCPU, T, binary_func> final {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  static bool Matched(const XpuVarNdarray<RetT>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3 || y.shape().NumAxes() != 3) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1
+           && x.shape().At(2) == y.shape().At(2);
+  }
+  // every [y, z] matrix is reduced over its rows
+  static void Reduce(ep::Stream* stream, const XpuVarNdarray<RetT>& y,
+                     const XpuVarNdarray<const T>& x, const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    std::unique_ptr<T[]> fallback;
+    T* partials =
+        GetPartialBuffer(tmp_storage, ReduceColsBufferSize(dim_x, dim_y, dim_z), x, y, &fallback);
+    ReduceCols<T, RetT, binary_func>(stream->As<ep::CpuStream>(), x.ptr(), dim_x, dim_y, dim_z,
+                                     y.ptr(), partials);
+  }
+};
 
 #define INSTANTIATE_NDARRAY_REDUCE_IMPL(dtype, binary_func)                                       \
   template struct NdarrayScalarReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;    \
   template struct NdarrayMatrixRowReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>; \
   template struct NdarrayMatrixColReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>; \
-  template struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;
+  template struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>; \
+  template struct NdarrayXYZCubeYReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;
 OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(INSTANTIATE_NDARRAY_REDUCE_IMPL,
                                  ARITHMETIC_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ
                                      UNSIGNED_INT_DATA_TYPE_SEQ BOOL_DATA_TYPE_SEQ,
@@ -51,7 +325,7 @@ OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(INSTANTIATE_NDARRAY_REDUCE_IMPL, FLOATING_DATA_
                                  NANSUM_REDUCE_BINARY_FUNC_SEQ);
 
 OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(INSTANTIATE_NDARRAY_REDUCE_IMPL, COMPLEX_DATA_TYPE_SEQ,
-                                 REDUCE_BINARY_FUNC_SEQ);
+                                 REDUCE_COMPLEX_BINARY_FUNC_SEQ);
 
 template<typename T, int NDIMS, template<typename> class binary_func>
 struct NdarrayReduceCoreWrapper<DeviceType::kCPU, T, NDIMS, binary_func> final {
@@ -69,6 +69,10 @@ class WritableFile {
   // persisted, depending on the implementation.
   virtual void Flush() = 0;
 
+  // Flushes the file and syncs its contents to the storage device, the contents survive an
+  // OS or machine crash after a successful sync.
+  virtual void Sync() = 0;
+
  private:
 };
 
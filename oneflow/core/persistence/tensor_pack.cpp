@@ -0,0 +1,187 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/tensor_pack.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+#ifdef OF_PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+namespace {
+
+constexpr size_t kReadChunkSize = 64 * 1024 * 1024;
+
+}  // namespace
+
+TensorPackReader::TensorPackReader(fs::FileSystem* fs, const std::string& path, bool use_mmap)
+    : path_(path), mapped_ptr_(nullptr), mapped_size_(0) {
+  const uint64_t file_size = fs->GetFileSize(path);
+  CHECK_GE(file_size, sizeof(TensorPackHeader)) << path << " is not a tensor pack";
+  fs->NewRandomAccessFile(path, &file_);
+  TensorPackHeader header{};
+  file_->Read(0, sizeof(header), reinterpret_cast<char*>(&header));
+  CHECK_EQ(header.magic, kTensorPackMagic) << path << " is not a tensor pack";
+  CHECK_EQ(header.version, kTensorPackVersion) << "unsupported tensor pack version";
+  const size_t index_size = sizeof(header) + header.num_tensors * sizeof(TensorPackEntry);
+  CHECK_LE(index_size, file_size);
+  entries_.resize(header.num_tensors);
+  if (!entries_.empty()) {
+    file_->Read(sizeof(header), entries_.size() * sizeof(TensorPackEntry),
+                reinterpret_cast<char*>(entries_.data()));
+  }
+  for (const auto& entry : entries_) {
+    CHECK_LE(entry.name_offset + entry.name_size, file_size);
+    CHECK_LE(entry.num_axes, kTensorPackMaxAxes);
+    CHECK_LE(entry.data_offset + entry.data_size, file_size);
+    std::string name(entry.name_size, '\0');
+    file_->Read(entry.name_offset, entry.name_size, &name[0]);
+    names_.emplace_back(std::move(name));
+  }
+  if (use_mmap && file_size > 0) {
+#ifdef OF_PLATFORM_POSIX
+    const int fd = open(path.c_str(), O_RDONLY);
+    PCHECK(fd != -1) << path;
+    // private mapping, writes to the tensors never reach the file
+    void* ptr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    PCHECK(ptr != MAP_FAILED) << path;
+    PCHECK(close(fd) == 0);
+    mapped_ptr_ = ptr;
+    mapped_size_ = file_size;
+#else
+    UNIMPLEMENTED() << "mmap is not supported on this platform";
+#endif  // OF_PLATFORM_POSIX
+  }
+}
+
+TensorPackReader::~TensorPackReader() {
+#ifdef OF_PLATFORM_POSIX
+  if (mapped_ptr_ != nullptr) { PCHECK(munmap(mapped_ptr_, mapped_size_) == 0); }
+#endif  // OF_PLATFORM_POSIX
+}
+
+Shape TensorPackReader::shape(size_t i) const {
+  const TensorPackEntry& entry = entries_.at(i);
+  return Shape(DimVector(entry.dims, entry.dims + entry.num_axes));
+}
+
+int64_t TensorPackReader::Find(const std::string& name) const {
+  FOR_RANGE(size_t, i, 0, names_.size()) {
+    if (names_[i] == name) { return i; }
+  }
+  return -1;
+}
+
+char* TensorPackReader::MappedData(size_t i) const {
+  CHECK(mapped()) << path_ << " is not mapped";
+  return static_cast<char*>(mapped_ptr_) + entries_.at(i).data_offset;
+}
+
+void TensorPackReader::Read(const std::vector<size_t>& tensors,
+                            const std::vector<char*>& dsts) const {
+  CHECK_EQ(tensors.size(), dsts.size());
+  struct Chunk {
+    uint64_t file_offset;
+    size_t size;
+    char* dst;
+  };
+  std::vector<Chunk> chunks;
+  FOR_RANGE(size_t, k, 0, tensors.size()) {
+    const TensorPackEntry& entry = entries_.at(tensors[k]);
+    for (uint64_t offset = 0; offset < entry.data_size; offset += kReadChunkSize) {
+      const size_t size = std::min<uint64_t>(kReadChunkSize, entry.data_size - offset);
+      chunks.emplace_back(Chunk{entry.data_offset + offset, size, dsts[k] + offset});
+    }
+  }
+  MultiThreadLoop(chunks.size(), [&](size_t i) {
+    const Chunk& chunk = chunks[i];
+    if (mapped()) {
+      std::memcpy(chunk.dst, static_cast<const char*>(mapped_ptr_) + chunk.file_offset,
+                  chunk.size);
+    } else {
+      file_->Read(chunk.file_offset, chunk.size, chunk.dst);
+    }
+  });
+}
+
+TensorPackWriter::TensorPackWriter(fs::FileSystem* fs, const std::string& path)
+    : fs_(fs), path_(path), closed_(false) {}
+
+void TensorPackWriter::Add(const std::string& name, DataType data_type, const Shape& shape,
+                           const char* data) {
+  CHECK(!closed_) << "the writer is closed";
+  CHECK_LE(shape.NumAxes(), kTensorPackMaxAxes) << "too many axes of tensor " << name;
+  TensorPackEntry entry{};
+  entry.name_size = name.size();
+  entry.data_type = data_type;
+  entry.num_axes = shape.NumAxes();
+  FOR_RANGE(int64_t, i, 0, shape.NumAxes()) { entry.dims[i] = shape.At(i); }
+  entry.data_size = shape.elem_cnt() * GetSizeOfDataType(data_type);
+  entries_.emplace_back(entry);
+  names_.emplace_back(name);
+  data_.emplace_back(data);
+}
+
+uint64_t TensorPackWriter::data_size() const {
+  uint64_t size = 0;
+  for (const auto& entry : entries_) { size += entry.data_size; }
+  return size;
+}
+
+void TensorPackWriter::Close() { Close([](uint64_t) {}); }
+
+void TensorPackWriter::Close(const std::function<void(uint64_t)>& OnDataWritten) {
+  CHECK(!closed_) << "the writer is closed";
+  closed_ = true;
+  TensorPackHeader header{kTensorPackMagic, kTensorPackVersion, entries_.size()};
+  uint64_t offset = sizeof(header) + entries_.size() * sizeof(TensorPackEntry);
+  FOR_RANGE(size_t, i, 0, entries_.size()) {
+    entries_[i].name_offset = offset;
+    offset += names_[i].size();
+  }
+  FOR_RANGE(size_t, i, 0, entries_.size()) {
+    offset = RoundUp(offset, kTensorPackDataAlignment);
+    entries_[i].data_offset = offset;
+    offset += entries_[i].data_size;
+  }
+
+  const std::string tmp_path = path_ + ".tmp";
+  std::unique_ptr<fs::WritableFile> file;
+  fs_->NewWritableFile(tmp_path, &file);
+  uint64_t written = 0;
+  const auto Append = [&](const char* data, size_t size) {
+    if (size > 0) { file->Append(data, size); }
+    written += size;
+  };
+  Append(reinterpret_cast<const char*>(&header), sizeof(header));
+  Append(reinterpret_cast<const char*>(entries_.data()), entries_.size() * sizeof(TensorPackEntry));
+  for (const auto& name : names_) { Append(name.data(), name.size()); }
+  const std::vector<char> padding(kTensorPackDataAlignment, 0);
+  FOR_RANGE(size_t, i, 0, entries_.size()) {
+    Append(padding.data(), entries_[i].data_offset - written);
+    Append(data_[i], entries_[i].data_size);
+    OnDataWritten(entries_[i].data_size);
+  }
+  file->Sync();
+  file->Close();
+  fs_->RenameFile(tmp_path, path_);
+}
+
+}  // namespace oneflow
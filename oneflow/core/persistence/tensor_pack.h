@@ -0,0 +1,116 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_TENSOR_PACK_H_
+#define ONEFLOW_CORE_PERSISTENCE_TENSOR_PACK_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+// A tensor pack stores named dense tensors in a single file whose index comes first, so a
+// reader finds every tensor after one small read and can map the whole file into memory:
+//
+//   TensorPackHeader | TensorPackEntry x num_tensors | names | tensor data ...
+//
+// All integers are little endian. The data of every tensor starts at a multiple of
+// kTensorPackDataAlignment, so tensors of a mapped file are page aligned.
+constexpr uint32_t kTensorPackMagic = 0x4B50464F;  // "OFPK"
+constexpr uint32_t kTensorPackVersion = 1;
+constexpr size_t kTensorPackDataAlignment = 4096;
+constexpr size_t kTensorPackMaxAxes = 8;
+constexpr char kTensorPackFileSuffix[] = ".ofpack";
+
+struct TensorPackHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t num_tensors;
+};
+
+struct TensorPackEntry {
+  uint32_t name_offset;
+  uint32_t name_size;
+  int32_t data_type;
+  uint32_t num_axes;
+  int64_t dims[kTensorPackMaxAxes];
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+
+static_assert(sizeof(TensorPackHeader) == 16, "");
+static_assert(sizeof(TensorPackEntry) == 96, "");
+
+class TensorPackReader final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorPackReader);
+  // When use_mmap is true the path must be on the local file system and the file is mapped
+  // copy-on-write, otherwise tensors are read through fs.
+  TensorPackReader(fs::FileSystem* fs, const std::string& path, bool use_mmap);
+  ~TensorPackReader();
+
+  size_t num_tensors() const { return entries_.size(); }
+  const std::string& name(size_t i) const { return names_.at(i); }
+  DataType data_type(size_t i) const { return static_cast<DataType>(entries_.at(i).data_type); }
+  Shape shape(size_t i) const;
+  size_t data_size(size_t i) const { return entries_.at(i).data_size; }
+  // Returns -1 if there is no tensor with the name
+  int64_t Find(const std::string& name) const;
+
+  bool mapped() const { return mapped_ptr_ != nullptr; }
+  // The data of tensor i inside the mapping, only valid when mapped()
+  char* MappedData(size_t i) const;
+  // Reads the tensors into dsts[k] = buffer of tensors[k], large tensors are split into
+  // chunks so that a few big tensors still use all threads.
+  void Read(const std::vector<size_t>& tensors, const std::vector<char*>& dsts) const;
+
+ private:
+  std::string path_;
+  std::unique_ptr<fs::RandomAccessFile> file_;
+  std::vector<TensorPackEntry> entries_;
+  std::vector<std::string> names_;
+  void* mapped_ptr_;
+  size_t mapped_size_;
+};
+
+class TensorPackWriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorPackWriter);
+  // The pack is written and synced to a temporary file which is renamed to path on Close
+  TensorPackWriter(fs::FileSystem* fs, const std::string& path);
+  ~TensorPackWriter() = default;
+
+  // data must hold shape.elem_cnt() values and stay valid until Close
+  void Add(const std::string& name, DataType data_type, const Shape& shape, const char* data);
+  // Total size of the tensor data added so far
+  uint64_t data_size() const;
+  void Close();
+  // OnDataWritten is called with the data size of every tensor once it is written
+  void Close(const std::function<void(uint64_t)>& OnDataWritten);
+
+ private:
+  fs::FileSystem* fs_;
+  std::string path_;
+  std::vector<TensorPackEntry> entries_;
+  std::vector<std::string> names_;
+  std::vector<const char*> data_;
+  bool closed_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_TENSOR_PACK_H_
@@ -0,0 +1,69 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/tensor_pack.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(TensorPack, write_and_read) {
+  const std::string file_name = JoinPath(GetCwd(), "tmp_test_tensor_pack.ofpack");
+  std::vector<float> weight(6 * 7);
+  std::vector<int64_t> step(1, 42);
+  std::iota(weight.begin(), weight.end(), 0.5f);
+  {
+    TensorPackWriter writer(LocalFS(), file_name);
+    writer.Add("fc.weight", DataType::kFloat, Shape({6, 7}),
+               reinterpret_cast<char*>(weight.data()));
+    writer.Add("step", DataType::kInt64, Shape({1}), reinterpret_cast<char*>(step.data()));
+    writer.Add("empty", DataType::kFloat, Shape({0, 3}), nullptr);
+    writer.Close();
+  }
+  ASSERT_FALSE(LocalFS()->FileExists(file_name + ".tmp"));
+
+  for (bool use_mmap : {false, true}) {
+    TensorPackReader reader(LocalFS(), file_name, use_mmap);
+    ASSERT_EQ(reader.mapped(), use_mmap);
+    ASSERT_EQ(reader.num_tensors(), 3);
+    ASSERT_EQ(reader.Find("step"), 1);
+    ASSERT_EQ(reader.Find("missing"), -1);
+    ASSERT_EQ(reader.name(0), "fc.weight");
+    ASSERT_EQ(reader.data_type(0), DataType::kFloat);
+    ASSERT_EQ(reader.shape(0), Shape({6, 7}));
+    ASSERT_EQ(reader.shape(2), Shape({0, 3}));
+    ASSERT_EQ(reader.data_size(0), weight.size() * sizeof(float));
+
+    std::vector<float> weight_out(weight.size());
+    std::vector<int64_t> step_out(1);
+    reader.Read({1, 0}, {reinterpret_cast<char*>(step_out.data()),
+                         reinterpret_cast<char*>(weight_out.data())});
+    ASSERT_EQ(weight_out, weight);
+    ASSERT_EQ(step_out, step);
+    if (use_mmap) {
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(reader.MappedData(0)) % kTensorPackDataAlignment, 0);
+      const float* mapped = reinterpret_cast<const float*>(reader.MappedData(0));
+      ASSERT_TRUE(std::equal(weight.begin(), weight.end(), mapped));
+    }
+  }
+  LocalFS()->DelFile(file_name);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
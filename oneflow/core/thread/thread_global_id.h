@@ -23,6 +23,7 @@ limitations under the License.
 namespace oneflow {
 
 const static int kThreadGlobalIdDefaultWorker = 0;
+const static int kThreadGlobalIdCollectiveBoxing = 1;
 const static int kThreadGlobalIdMain = 7;
 
 int64_t GetThisThreadGlobalId();
@@ -127,6 +127,8 @@ Env::~Env() {
   LOG(INFO) << "forced eviction num: " << forced_eviction_num_;
   LOG(INFO) << "eager eviction num: " << eager_eviction_num_;
   LOG(INFO) << "recomputation num: " << recomputation_num_;
+  LOG(INFO) << "swap out num: " << swap_out_num_ << ", bytes: " << swap_out_bytes_;
+  LOG(INFO) << "swap in num: " << swap_in_num_ << ", bytes: " << swap_in_bytes_;
   LOG(INFO) << "duration: " << time_now_;
 
   const char* prefix = std::getenv("ONEFLOW_REMAT_SUMMARY_FILE_PREFIX");
@@ -135,6 +137,8 @@ Env::~Env() {
     json cpp_summary{{"forced eviction", forced_eviction_num_},
                      {"eager eviction", eager_eviction_num_},
                      {"recomputation", recomputation_num_},
+                     {"swap out", swap_out_num_},
+                     {"swap in", swap_in_num_},
                      {"dataset time", time_now_}};
 
     json full_json;
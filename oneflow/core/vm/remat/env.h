@@ -54,11 +54,28 @@ class Env {
   void add_recomputation_num() { recomputation_num_++; }
   int recomputation_num() const { return recomputation_num_; }
 
+  void add_swap_out(size_t bytes) {
+    swap_out_num_++;
+    swap_out_bytes_ += bytes;
+  }
+  int swap_out_num() const { return swap_out_num_; }
+  size_t swap_out_bytes() const { return swap_out_bytes_; }
+  void add_swap_in(size_t bytes) {
+    swap_in_num_++;
+    swap_in_bytes_ += bytes;
+  }
+  int swap_in_num() const { return swap_in_num_; }
+  size_t swap_in_bytes() const { return swap_in_bytes_; }
+
   void clear_stats() {
     time_now_ = 0;
     eager_eviction_num_ = 0;
     forced_eviction_num_ = 0;
     recomputation_num_ = 0;
+    swap_out_num_ = 0;
+    swap_out_bytes_ = 0;
+    swap_in_num_ = 0;
+    swap_in_bytes_ = 0;
   }
 
   std::set<vm::RematableTensorStorage*> need_eager_eviction_storages;
@@ -69,6 +86,12 @@ class Env {
   void set_small_pieces_optimization(bool enabled) { small_pieces_optimization_ = enabled; }
   bool is_small_pieces_optimization_enabled() const { return small_pieces_optimization_; }
 
+  // Host memory for the copies of swapped out tensors, swapping is disabled when it is 0
+  void set_swap_budget_in_bytes(size_t budget_in_bytes) { swap_budget_in_bytes_ = budget_in_bytes; }
+  size_t swap_budget_in_bytes() const { return swap_budget_in_bytes_; }
+  void add_swap_memory(int64_t bytes) { swap_memory_in_bytes_ += bytes; }
+  size_t swap_memory_in_bytes() const { return swap_memory_in_bytes_; }
+
   bool log_enabled() const { return EnvBool<ONEFLOW_REMAT_LOG>(); }
 
  private:
@@ -77,8 +100,14 @@ class Env {
   int eager_eviction_num_ = 0;
   int forced_eviction_num_ = 0;
   int recomputation_num_ = 0;
+  int swap_out_num_ = 0;
+  size_t swap_out_bytes_ = 0;
+  int swap_in_num_ = 0;
+  size_t swap_in_bytes_ = 0;
 
   size_t budget_in_bytes_ = 0;
+  size_t swap_budget_in_bytes_ = 0;
+  size_t swap_memory_in_bytes_ = 0;
   bool small_pieces_optimization_ = true;
 };
 
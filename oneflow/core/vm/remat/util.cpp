@@ -17,11 +17,15 @@ limitations under the License.
 #include "oneflow/core/vm/remat/util.h"
 
 #include <algorithm>
+#include <chrono>
 
 #include "nlohmann/json.hpp"
 #include "oneflow/core/common/env_var/remat.h"
 #include "oneflow/core/common/env_var/vm.h"
 #include "oneflow/core/eager/tensor_storage.h"
+#include "oneflow/core/ep/include/device_manager_registry.h"
+#include "oneflow/core/ep/include/primitive/memcpy.h"
+#include "oneflow/core/framework/device.h"
 #include "oneflow/core/framework/compute_complexity_fn_context.h"
 #include "oneflow/core/vm/op_call_instruction_policy.h"
 #include "oneflow/core/vm/remat/env.h"
@@ -242,6 +246,75 @@ Maybe<double> GetComputeTime(const vm::OpCallInstructionPolicy& operand) {
   return GetComputeComplexity(operand);
 }
 
+namespace {
+
+// Times a device to host and a host to device copy of a pinned buffer
+Maybe<double> MeasureSwapBandwidth(DeviceType device_type, size_t device_index) {
+  constexpr size_t kBufferSize = 16 * 1024 * 1024;
+  const auto device =
+      Singleton<ep::DeviceManagerRegistry>::Get()->GetDevice(device_type, device_index);
+  CHECK_NOTNULL_OR_RETURN(device);
+  const ep::AllocationOptions options{};
+  void* device_ptr = nullptr;
+  void* host_ptr = nullptr;
+  JUST(device->Alloc(options, &device_ptr, kBufferSize));
+  JUST(device->AllocPinned(options, &host_ptr, kBufferSize));
+  ep::Stream* stream = device->CreateStream();
+  auto d2h = ep::primitive::NewPrimitive<ep::primitive::MemcpyFactory>(
+      device_type, ep::primitive::MemcpyKind::kDtoH);
+  auto h2d = ep::primitive::NewPrimitive<ep::primitive::MemcpyFactory>(
+      device_type, ep::primitive::MemcpyKind::kHtoD);
+  CHECK_OR_RETURN(d2h && h2d);
+  double seconds = 0;
+  // the first round trip warms up the buffers and is not timed
+  for (int i = 0; i < 2; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    d2h->Launch(stream, host_ptr, device_ptr, kBufferSize);
+    h2d->Launch(stream, device_ptr, host_ptr, kBufferSize);
+    JUST(stream->Sync());
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  device->DestroyStream(stream);
+  device->FreePinned(options, host_ptr);
+  device->Free(options, device_ptr);
+  return 2.0 * kBufferSize / std::max(seconds, 1e-9);
+}
+
+// Device <-> host copy bandwidth in bytes per second
+double GetSwapBandwidth(Symbol<Device> device) {
+  const int64_t bandwidth = EnvInteger<ONEFLOW_REMAT_SWAP_BANDWIDTH>();
+  if (bandwidth > 0) { return bandwidth; }
+  static std::map<std::pair<DeviceType, size_t>, double> device2bandwidth;
+  const auto key = std::make_pair(device->enum_type(), static_cast<size_t>(device->device_id()));
+  auto it = device2bandwidth.find(key);
+  if (it == device2bandwidth.end()) {
+    const double measured = CHECK_JUST(MeasureSwapBandwidth(key.first, key.second));
+    VLOG_REMAT(1) << "swap bandwidth of " << device->ToString() << ": " << measured << " bytes/s";
+    it = device2bandwidth.emplace(key, measured).first;
+  }
+  return it->second;
+}
+
+}  // namespace
+
+double GetSwapCost(const vm::RematableTensorStorage& storage) {
+  const auto* env = Singleton<Env>::Get();
+  const size_t bytes = storage.blob_bytes();
+  if (!storage.has_host_copy()
+      && (env->swap_budget_in_bytes() == 0
+          || env->swap_memory_in_bytes() + bytes > env->swap_budget_in_bytes())) {
+    return std::numeric_limits<double>::infinity();
+  }
+  const int num_copies = storage.has_host_copy() ? 1 : 2;
+  const double seconds = num_copies * bytes / GetSwapBandwidth(storage.device());
+  return seconds * EnvInteger<ONEFLOW_REMAT_COMPUTE_THROUGHPUT>();
+}
+
+bool ShouldSwapOut(const vm::RematableTensorStorage& storage) {
+  if (storage.dtr_compute_op() == nullptr) { return false; }
+  return GetSwapCost(storage) < storage.recompute_cost();
+}
+
 }  // namespace remat
 
 namespace vm {
@@ -285,10 +358,12 @@ Maybe<void> RematHelper::_IncReferenceNumOfRecomputedTensor(
     storage->Pin();
     VLOG_REMAT(1) << "No." << i << " input is in memory? " << storage->is_in_memory();
     if (!storage->is_in_memory()) {
-      OpCallInstructionPolicy tmp_op = storage->compute_op();
       if (!storage->is_needed_by_backward()) {
         Singleton<remat::Env>::Get()->need_eager_eviction_storages.insert(storage.get());
       }
+      // a swapped out tensor is copied back without recomputing its inputs
+      if (storage->is_swapped()) { continue; }
+      OpCallInstructionPolicy tmp_op = storage->compute_op();
 
       if (visited_ops.find(storage->dtr_compute_op().get()) == visited_ops.end()) {
         visited_ops.insert(storage->dtr_compute_op().get());
@@ -320,7 +395,10 @@ Maybe<void> RematHelper::RematInputs(
 
   for (int i = 0; i < input_storages_.size(); i++) {
     auto& storage = input_storages_[i];
-    if (!storage->is_in_memory()) {
+    if (storage->is_swapped()) {
+      VLOG_REMAT(1) << "swap in No." << i << " input. Storage id: " << storage->id();
+      JUST(storage->SwapIn(vm_stream));
+    } else if (!storage->is_in_memory()) {
       VLOG_REMAT(1) << "recompute No." << i << " input by " << storage->compute_op_type_name()
                     << ". Storage id: " << storage->id();
       OpCallInstructionPolicy tmp_op = storage->compute_op();
@@ -362,6 +440,8 @@ Maybe<void> RematHelper::UpdateRematInfo(bool first, bool recompute, bool includ
         if (storage_is_initialized_[i] && !recompute) {
           VLOG_REMAT(1) << "storage->is_initialized(), op is " << storage->compute_op_type_name()
                         << std::endl;
+          // the in-place write makes the host copy of the old content stale
+          storage->DropHostCopy();
           compute_op = std::make_unique<OpCallInstructionPolicy>(
               Singleton<remat::Env>::Get()->update_tensor_with_storage(
                   storage.get(), op_call_instruction_policy_));
@@ -23,7 +23,8 @@ namespace oneflow {
 
 namespace vm {
 class OpCallInstructionPolicy;
-}
+class RematableTensorStorage;
+}  // namespace vm
 
 namespace remat {
 
@@ -31,6 +32,13 @@ double append_memory_frag_info_and_get(size_t free_mem, size_t threshold);
 
 Maybe<double> GetComputeTime(const vm::OpCallInstructionPolicy& operand);
 
+// The time of copying the tensor to host memory and back, in the unit of GetComputeTime. Only
+// the copy back is counted if the tensor already has a host copy, and it is infinite if swapping
+// is disabled or the host memory budget is used up.
+double GetSwapCost(const vm::RematableTensorStorage& storage);
+// Returns true if swapping the tensor out is cheaper than recomputing it
+bool ShouldSwapOut(const vm::RematableTensorStorage& storage);
+
 }  // namespace remat
 
 namespace vm {
@@ -0,0 +1,230 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_COLUMNAR_DATASET_H_
+#define ONEFLOW_USER_DATA_COLUMNAR_DATASET_H_
+
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/rpc/include/global_process_ctx.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/data/columnar_file.h"
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// The requested columns of one row group, column i holds num_rows * row_elem_cnt values
+struct ColumnarRowGroup {
+  int64_t num_rows;
+  std::vector<DataType> data_types;
+  std::vector<std::vector<char>> columns;
+};
+
+// The rows [begin, end) of a loaded row group, or end - begin zero padding rows when row_group
+// is null
+struct ColumnarRowRange {
+  std::shared_ptr<const ColumnarRowGroup> row_group;
+  int64_t begin;
+  int64_t end;
+};
+
+// Every Next() returns the row ranges of one local batch. Only the chunks of the requested
+// columns (and of the predicate column) are read, row groups whose statistics fail the
+// predicate are skipped without being read, and row groups are split among the parallel ranks
+// like OFRecordDataset splits part files.
+class ColumnarDataset final : public Dataset<ColumnarRowRange> {
+ public:
+  using Base = Dataset<ColumnarRowRange>;
+  using SampleType = typename Base::SampleType;
+  using BatchType = typename Base::BatchType;
+
+  OF_DISALLOW_COPY_AND_MOVE(ColumnarDataset);
+
+  ColumnarDataset(user_op::KernelInitContext* ctx, int64_t batch_size)
+      : batch_size_(batch_size),
+        random_shuffle_(ctx->Attr<bool>("random_shuffle")),
+        next_row_group_(0),
+        epoch_num_rows_(0),
+        cur_row_(0) {
+    int64_t seed = ctx->Attr<int64_t>("seed");
+    if (seed == -1) { seed = NewRandomSeed(); }
+    std::seed_seq seq({seed});
+    gen_ = std::mt19937(seq);
+
+    const auto& column_names = ctx->Attr<std::vector<std::string>>("columns");
+    const auto& shapes = ctx->Attr<std::vector<Shape>>("shapes");
+    const std::string& predicate_column = ctx->Attr<std::string>("predicate_column");
+    predicate_lower_ = ctx->Attr<double>("predicate_lower");
+    predicate_upper_ = ctx->Attr<double>("predicate_upper");
+    std::vector<ColumnarRowGroupRef> row_groups;
+    for (const auto& path : ctx->Attr<std::vector<std::string>>("files")) {
+      std::shared_ptr<ColumnarFileReader> file(new ColumnarFileReader(DataFS(), path));
+      std::vector<int64_t> cols;
+      FOR_RANGE(size_t, j, 0, column_names.size()) {
+        const int64_t col = file->FindColumn(column_names[j]);
+        CHECK_GE(col, 0) << "Column " << column_names[j] << " not found in " << path;
+        CHECK_EQ(file->column_row_elem_cnt(col), shapes[j].elem_cnt())
+            << "Column " << column_names[j] << " of " << path << " does not match the shape";
+        cols.emplace_back(col);
+      }
+      int64_t predicate_col = -1;
+      if (!predicate_column.empty()) {
+        predicate_col = file->FindColumn(predicate_column);
+        CHECK_GE(predicate_col, 0) << "Column " << predicate_column << " not found in " << path;
+        CHECK_EQ(file->column_row_elem_cnt(predicate_col), 1)
+            << "The predicate column must hold one value per row";
+      }
+      FOR_RANGE(size_t, row_group, 0, file->num_row_groups()) {
+        if (file->row_group_num_rows(row_group) == 0) { continue; }
+        if (predicate_col >= 0) {
+          const ColumnarChunkMeta& chunk = file->chunk(row_group, predicate_col);
+          if (chunk.max_value < predicate_lower_ || chunk.min_value > predicate_upper_) {
+            continue;
+          }
+        }
+        row_groups.emplace_back(ColumnarRowGroupRef{file, cols, predicate_col, row_group});
+      }
+    }
+
+    int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+    int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+    if (ctx->Attr<std::vector<std::string>>("nd_sbp").empty()) {
+      // NOTE: like OFRecordDataset, a reader without nd_sbp is assumed to work in DDP
+      parallel_id = GlobalProcessCtx::Rank();
+      parallel_num = GlobalProcessCtx::WorldSize();
+    }
+    CHECK(!row_groups.empty()) << "No row group passes the predicate";
+    // With fewer row groups than ranks the extra ranks get an empty shard, see Next()
+    BalancedSplitter bs(row_groups.size(), parallel_num);
+    const Range range = bs.At(parallel_id);
+    local_row_groups_.assign(row_groups.begin() + range.begin(),
+                             row_groups.begin() + range.end());
+    if (local_row_groups_.empty()) {
+      LOG(WARNING) << "Rank " << parallel_id << " of the columnar reader has no row group, only "
+                   << row_groups.size() << " row groups for " << parallel_num << " ranks";
+    }
+    if (random_shuffle_) {
+      std::shuffle(local_row_groups_.begin(), local_row_groups_.end(), gen_);
+    }
+  }
+  ~ColumnarDataset() = default;
+
+  BatchType Next() override {
+    BatchType batch;
+    if (local_row_groups_.empty()) {
+      // an empty shard still has to fill the static batch shape, with zero padding rows
+      batch.emplace_back(ColumnarRowRange{nullptr, 0, batch_size_});
+      return batch;
+    }
+    int64_t remaining = batch_size_;
+    while (remaining > 0) {
+      if (!cur_row_group_ || cur_row_ == cur_row_group_->num_rows) { LoadNextRowGroup(); }
+      const int64_t end = std::min(cur_row_group_->num_rows, cur_row_ + remaining);
+      batch.emplace_back(ColumnarRowRange{cur_row_group_, cur_row_, end});
+      remaining -= end - cur_row_;
+      cur_row_ = end;
+    }
+    return batch;
+  }
+
+ private:
+  struct ColumnarRowGroupRef {
+    std::shared_ptr<ColumnarFileReader> file;
+    std::vector<int64_t> cols;
+    int64_t predicate_col;
+    size_t row_group;
+  };
+
+  void LoadNextRowGroup() {
+    do {
+      if (next_row_group_ == local_row_groups_.size()) {
+        CHECK_GT(epoch_num_rows_, 0) << "No row passes the predicate";
+        next_row_group_ = 0;
+        epoch_num_rows_ = 0;
+        if (random_shuffle_) {
+          std::shuffle(local_row_groups_.begin(), local_row_groups_.end(), gen_);
+        }
+      }
+      cur_row_group_ = ReadRowGroup(local_row_groups_.at(next_row_group_));
+      next_row_group_ += 1;
+      epoch_num_rows_ += cur_row_group_->num_rows;
+    } while (cur_row_group_->num_rows == 0);
+    cur_row_ = 0;
+  }
+
+  std::shared_ptr<const ColumnarRowGroup> ReadRowGroup(const ColumnarRowGroupRef& ref) {
+    const ColumnarFileReader& file = *ref.file;
+    std::vector<int64_t> cols = ref.cols;
+    // the predicate column is read as an extra column when it is not requested
+    const size_t predicate_index =
+        std::find(cols.begin(), cols.end(), ref.predicate_col) - cols.begin();
+    if (ref.predicate_col >= 0 && predicate_index == cols.size()) {
+      cols.emplace_back(ref.predicate_col);
+    }
+    std::shared_ptr<ColumnarRowGroup> row_group(new ColumnarRowGroup);
+    row_group->num_rows = file.row_group_num_rows(ref.row_group);
+    row_group->columns.resize(cols.size());
+    MultiThreadLoop(cols.size(), [&](size_t i) {
+      row_group->columns[i].resize(file.ChunkSize(ref.row_group, cols[i]));
+      file.ReadChunk(ref.row_group, cols[i], row_group->columns[i].data());
+    });
+    for (int64_t col : cols) { row_group->data_types.emplace_back(file.column_data_type(col)); }
+
+    std::vector<int64_t> rows;
+    if (ref.predicate_col >= 0) {
+      SelectColumnarRowsInRange(file.column_data_type(ref.predicate_col),
+                                row_group->columns[predicate_index].data(), row_group->num_rows,
+                                predicate_lower_, predicate_upper_, &rows);
+    } else if (random_shuffle_) {
+      rows.resize(row_group->num_rows);
+      std::iota(rows.begin(), rows.end(), 0);
+    }
+    if (random_shuffle_) { std::shuffle(rows.begin(), rows.end(), gen_); }
+    row_group->columns.resize(ref.cols.size());
+    row_group->data_types.resize(ref.cols.size());
+    if (ref.predicate_col >= 0 || random_shuffle_) { GatherRows(rows, row_group.get()); }
+    return row_group;
+  }
+
+  static void GatherRows(const std::vector<int64_t>& rows, ColumnarRowGroup* row_group) {
+    MultiThreadLoop(row_group->columns.size(), [&](size_t i) {
+      const std::vector<char>& src = row_group->columns[i];
+      const size_t row_size = src.size() / row_group->num_rows;
+      std::vector<char> dst(rows.size() * row_size);
+      FOR_RANGE(size_t, k, 0, rows.size()) {
+        std::memcpy(dst.data() + k * row_size, src.data() + rows[k] * row_size, row_size);
+      }
+      row_group->columns[i].swap(dst);
+    });
+    row_group->num_rows = rows.size();
+  }
+
+  int64_t batch_size_;
+  bool random_shuffle_;
+  std::mt19937 gen_;
+  double predicate_lower_;
+  double predicate_upper_;
+  std::vector<ColumnarRowGroupRef> local_row_groups_;
+  size_t next_row_group_;
+  int64_t epoch_num_rows_;
+  std::shared_ptr<const ColumnarRowGroup> cur_row_group_;
+  int64_t cur_row_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_COLUMNAR_DATASET_H_
@@ -0,0 +1,207 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/columnar_file.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+template<typename T>
+void ComputeMinMax(const T* data, int64_t elem_cnt, double* min_value, double* max_value) {
+  if (elem_cnt == 0) {
+    *min_value = 0;
+    *max_value = 0;
+    return;
+  }
+  T min_v = data[0];
+  T max_v = data[0];
+  FOR_RANGE(int64_t, i, 1, elem_cnt) {
+    min_v = std::min(min_v, data[i]);
+    max_v = std::max(max_v, data[i]);
+  }
+  *min_value = static_cast<double>(min_v);
+  *max_value = static_cast<double>(max_v);
+}
+
+template<typename T>
+void SelectRowsInRange(const T* data, int64_t num_rows, double lower, double upper,
+                       std::vector<int64_t>* selected_rows) {
+  FOR_RANGE(int64_t, i, 0, num_rows) {
+    const double value = static_cast<double>(data[i]);
+    if (value >= lower && value <= upper) { selected_rows->emplace_back(i); }
+  }
+}
+
+}  // namespace
+
+void ComputeColumnarMinMax(DataType data_type, const void* data, int64_t elem_cnt,
+                           double* min_value, double* max_value) {
+  switch (data_type) {
+#define MAKE_ENTRY(cpp_type, data_type)                                                          \
+  case data_type:                                                                                \
+    ComputeMinMax<cpp_type>(static_cast<const cpp_type*>(data), elem_cnt, min_value, max_value); \
+    break;
+    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, COLUMNAR_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+    default: UNIMPLEMENTED() << "unsupported columnar data type " << data_type;
+  }
+}
+
+void SelectColumnarRowsInRange(DataType data_type, const void* data, int64_t num_rows,
+                               double lower, double upper, std::vector<int64_t>* selected_rows) {
+  switch (data_type) {
+#define MAKE_ENTRY(cpp_type, data_type)                                                     \
+  case data_type:                                                                           \
+    SelectRowsInRange<cpp_type>(static_cast<const cpp_type*>(data), num_rows, lower, upper, \
+                                selected_rows);                                             \
+    break;
+    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, COLUMNAR_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+    default: UNIMPLEMENTED() << "unsupported columnar data type " << data_type;
+  }
+}
+
+ColumnarFileReader::ColumnarFileReader(fs::FileSystem* fs, const std::string& path)
+    : path_(path) {
+  const uint64_t file_size = fs->GetFileSize(path);
+  CHECK_GE(file_size, sizeof(ColumnarFileTrailer)) << path << " is not a columnar file";
+  fs->NewRandomAccessFile(path, &file_);
+  ColumnarFileTrailer trailer{};
+  file_->Read(file_size - sizeof(trailer), sizeof(trailer), reinterpret_cast<char*>(&trailer));
+  CHECK_EQ(trailer.magic, kColumnarFileMagic) << path << " is not a columnar file";
+  CHECK_EQ(trailer.version, kColumnarFileVersion) << "unsupported columnar file version";
+  CHECK_GE(trailer.footer_size, sizeof(ColumnarFooterHeader));
+  CHECK_LE(trailer.footer_size + sizeof(trailer), file_size);
+  std::vector<char> footer(trailer.footer_size);
+  const uint64_t footer_offset = file_size - sizeof(trailer) - trailer.footer_size;
+  file_->Read(footer_offset, footer.size(), footer.data());
+
+  const auto* header = reinterpret_cast<const ColumnarFooterHeader*>(footer.data());
+  num_row_groups_ = header->num_row_groups;
+  const size_t num_cols = header->num_columns;
+  CHECK_GT(num_cols, 0);
+  const size_t metas_size = sizeof(ColumnarFooterHeader) + num_cols * sizeof(ColumnarColumnMeta)
+                            + num_row_groups_ * num_cols * sizeof(ColumnarChunkMeta);
+  CHECK_LE(metas_size, footer.size());
+  const auto* columns =
+      reinterpret_cast<const ColumnarColumnMeta*>(footer.data() + sizeof(ColumnarFooterHeader));
+  columns_.assign(columns, columns + num_cols);
+  const auto* chunks = reinterpret_cast<const ColumnarChunkMeta*>(columns + num_cols);
+  chunks_.assign(chunks, chunks + num_row_groups_ * num_cols);
+  for (const auto& column : columns_) {
+    CHECK_LE(column.name_offset + column.name_size, footer.size());
+    column_names_.emplace_back(footer.data() + column.name_offset, column.name_size);
+  }
+  FOR_RANGE(size_t, row_group, 0, num_row_groups_) {
+    FOR_RANGE(size_t, col, 0, num_cols) {
+      CHECK_EQ(chunk(row_group, col).num_rows, row_group_num_rows(row_group));
+      CHECK_LE(chunk(row_group, col).offset + ChunkSize(row_group, col), footer_offset);
+    }
+  }
+}
+
+int64_t ColumnarFileReader::FindColumn(const std::string& name) const {
+  FOR_RANGE(size_t, col, 0, num_columns()) {
+    if (column_names_[col] == name) { return col; }
+  }
+  return -1;
+}
+
+size_t ColumnarFileReader::ChunkSize(size_t row_group, size_t col) const {
+  return chunk(row_group, col).num_rows * column_row_elem_cnt(col)
+         * GetSizeOfDataType(column_data_type(col));
+}
+
+void ColumnarFileReader::ReadChunk(size_t row_group, size_t col, char* dst) const {
+  const size_t size = ChunkSize(row_group, col);
+  if (size > 0) { file_->Read(chunk(row_group, col).offset, size, dst); }
+}
+
+ColumnarFileWriter::ColumnarFileWriter(fs::FileSystem* fs, const std::string& path,
+                                       const std::vector<std::string>& names,
+                                       const std::vector<DataType>& data_types,
+                                       const std::vector<int64_t>& row_elem_cnts)
+    : offset_(0), names_(names) {
+  CHECK_GT(names.size(), 0);
+  CHECK_EQ(names.size(), data_types.size());
+  CHECK_EQ(names.size(), row_elem_cnts.size());
+  columns_.resize(names.size());
+  FOR_RANGE(size_t, i, 0, names.size()) {
+    columns_[i].data_type = data_types[i];
+    columns_[i].reserved = 0;
+    columns_[i].row_elem_cnt = row_elem_cnts[i];
+  }
+  fs->NewWritableFile(path, &file_);
+}
+
+ColumnarFileWriter::~ColumnarFileWriter() {
+  if (file_) { Close(); }
+}
+
+void ColumnarFileWriter::Append(const char* data, size_t size) {
+  file_->Append(data, size);
+  offset_ += size;
+}
+
+void ColumnarFileWriter::AppendRowGroup(int64_t num_rows, const std::vector<const void*>& columns) {
+  CHECK(file_) << "the writer is closed";
+  CHECK_EQ(columns.size(), columns_.size());
+  const std::vector<char> padding(kColumnarChunkAlignment, 0);
+  FOR_RANGE(size_t, i, 0, columns_.size()) {
+    const size_t padding_size = RoundUp(offset_, kColumnarChunkAlignment) - offset_;
+    if (padding_size > 0) { Append(padding.data(), padding_size); }
+    const DataType data_type = static_cast<DataType>(columns_[i].data_type);
+    const int64_t elem_cnt = num_rows * columns_[i].row_elem_cnt;
+    ColumnarChunkMeta chunk{};
+    chunk.offset = offset_;
+    chunk.num_rows = num_rows;
+    ComputeColumnarMinMax(data_type, columns[i], elem_cnt, &chunk.min_value, &chunk.max_value);
+    chunks_.emplace_back(chunk);
+    Append(static_cast<const char*>(columns[i]), elem_cnt * GetSizeOfDataType(data_type));
+  }
+}
+
+void ColumnarFileWriter::Close() {
+  CHECK(file_) << "the writer is closed";
+  std::string footer;
+  ColumnarFooterHeader header{};
+  header.num_columns = columns_.size();
+  header.num_row_groups = chunks_.size() / columns_.size();
+  size_t name_offset = sizeof(header) + columns_.size() * sizeof(ColumnarColumnMeta)
+                       + chunks_.size() * sizeof(ColumnarChunkMeta);
+  FOR_RANGE(size_t, i, 0, columns_.size()) {
+    columns_[i].name_offset = name_offset;
+    columns_[i].name_size = names_[i].size();
+    name_offset += names_[i].size();
+  }
+  footer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  footer.append(reinterpret_cast<const char*>(columns_.data()),
+                columns_.size() * sizeof(ColumnarColumnMeta));
+  if (!chunks_.empty()) {
+    footer.append(reinterpret_cast<const char*>(chunks_.data()),
+                  chunks_.size() * sizeof(ColumnarChunkMeta));
+  }
+  for (const auto& name : names_) { footer.append(name); }
+  ColumnarFileTrailer trailer{footer.size(), kColumnarFileVersion, kColumnarFileMagic};
+  Append(footer.data(), footer.size());
+  Append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+  file_->Close();
+  file_.reset();
+}
+
+}  // namespace data
+}  // namespace oneflow
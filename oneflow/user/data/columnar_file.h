@@ -0,0 +1,139 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_COLUMNAR_FILE_H_
+#define ONEFLOW_USER_DATA_COLUMNAR_FILE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace data {
+
+// A columnar file stores a table of fixed width columns split into row groups. The rows of one
+// column in one row group form a contiguous chunk, so readers only touch the columns they need:
+//
+//   chunk(0, 0) chunk(0, 1) ... chunk(1, 0) ... | footer | ColumnarFileTrailer
+//
+//   footer = ColumnarFooterHeader | ColumnarColumnMeta x num_columns
+//            | ColumnarChunkMeta x (num_row_groups * num_columns) | column names
+//
+// All integers are little endian, chunks are aligned to 64 bytes and every chunk records the
+// min and max of its values, which readers use to skip row groups that fail a predicate.
+constexpr uint32_t kColumnarFileMagic = 0x4C43464F;  // "OFCL"
+constexpr uint32_t kColumnarFileVersion = 1;
+constexpr size_t kColumnarChunkAlignment = 64;
+
+struct ColumnarFooterHeader {
+  uint32_t num_columns;
+  uint32_t reserved;
+  uint64_t num_row_groups;
+};
+
+struct ColumnarColumnMeta {
+  // relative to the start of the footer
+  uint32_t name_offset;
+  uint32_t name_size;
+  int32_t data_type;
+  uint32_t reserved;
+  uint64_t row_elem_cnt;
+};
+
+struct ColumnarChunkMeta {
+  uint64_t offset;
+  uint64_t num_rows;
+  double min_value;
+  double max_value;
+};
+
+struct ColumnarFileTrailer {
+  uint64_t footer_size;
+  uint32_t version;
+  uint32_t magic;
+};
+
+static_assert(sizeof(ColumnarFooterHeader) == 16, "");
+static_assert(sizeof(ColumnarColumnMeta) == 24, "");
+static_assert(sizeof(ColumnarChunkMeta) == 32, "");
+static_assert(sizeof(ColumnarFileTrailer) == 16, "");
+
+#define COLUMNAR_DATA_TYPE_SEQ \
+  ARITHMETIC_DATA_TYPE_SEQ CHAR_DATA_TYPE_SEQ UNSIGNED_INT_DATA_TYPE_SEQ
+
+void ComputeColumnarMinMax(DataType data_type, const void* data, int64_t elem_cnt,
+                           double* min_value, double* max_value);
+// Appends the indices of the rows whose value lies in [lower, upper] to selected_rows
+void SelectColumnarRowsInRange(DataType data_type, const void* data, int64_t num_rows,
+                               double lower, double upper, std::vector<int64_t>* selected_rows);
+
+class ColumnarFileReader final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ColumnarFileReader);
+  ColumnarFileReader(fs::FileSystem* fs, const std::string& path);
+  ~ColumnarFileReader() = default;
+
+  size_t num_columns() const { return columns_.size(); }
+  size_t num_row_groups() const { return num_row_groups_; }
+  // Returns -1 if there is no column with the name
+  int64_t FindColumn(const std::string& name) const;
+  const std::string& column_name(size_t col) const { return column_names_.at(col); }
+  DataType column_data_type(size_t col) const {
+    return static_cast<DataType>(columns_.at(col).data_type);
+  }
+  int64_t column_row_elem_cnt(size_t col) const { return columns_.at(col).row_elem_cnt; }
+  int64_t row_group_num_rows(size_t row_group) const { return chunk(row_group, 0).num_rows; }
+  const ColumnarChunkMeta& chunk(size_t row_group, size_t col) const {
+    return chunks_.at(row_group * num_columns() + col);
+  }
+  size_t ChunkSize(size_t row_group, size_t col) const;
+  // Reads the chunk of the column in the row group, dst must hold ChunkSize bytes
+  void ReadChunk(size_t row_group, size_t col, char* dst) const;
+
+ private:
+  std::string path_;
+  std::unique_ptr<fs::RandomAccessFile> file_;
+  size_t num_row_groups_;
+  std::vector<ColumnarColumnMeta> columns_;
+  std::vector<std::string> column_names_;
+  std::vector<ColumnarChunkMeta> chunks_;
+};
+
+class ColumnarFileWriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ColumnarFileWriter);
+  ColumnarFileWriter(fs::FileSystem* fs, const std::string& path,
+                     const std::vector<std::string>& names, const std::vector<DataType>& data_types,
+                     const std::vector<int64_t>& row_elem_cnts);
+  ~ColumnarFileWriter();
+
+  // columns[i] points to num_rows * row_elem_cnts[i] values of column i
+  void AppendRowGroup(int64_t num_rows, const std::vector<const void*>& columns);
+  void Close();
+
+ private:
+  void Append(const char* data, size_t size);
+
+  std::unique_ptr<fs::WritableFile> file_;
+  uint64_t offset_;
+  std::vector<std::string> names_;
+  std::vector<ColumnarColumnMeta> columns_;
+  std::vector<ColumnarChunkMeta> chunks_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_COLUMNAR_FILE_H_
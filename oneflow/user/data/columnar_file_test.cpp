@@ -0,0 +1,79 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/user/data/columnar_file.h"
+#include "oneflow/user/data/columnar_parser.h"
+
+namespace oneflow {
+namespace data {
+namespace test {
+
+TEST(ColumnarFile, write_and_read) {
+  const std::string file_name = JoinPath(GetCwd(), "tmp_test_columnar_file");
+  const int64_t num_rows = 10;
+  std::vector<int64_t> label(num_rows);
+  std::vector<float> dense(num_rows * 3);
+  std::iota(label.begin(), label.end(), 0);
+  std::iota(dense.begin(), dense.end(), 0.5f);
+  {
+    ColumnarFileWriter writer(LocalFS(), file_name, {"label", "dense"},
+                              {DataType::kInt64, DataType::kFloat}, {1, 3});
+    // two row groups of 6 and 4 rows
+    writer.AppendRowGroup(6, {label.data(), dense.data()});
+    writer.AppendRowGroup(4, {label.data() + 6, dense.data() + 6 * 3});
+    writer.Close();
+  }
+
+  ColumnarFileReader reader(LocalFS(), file_name);
+  ASSERT_EQ(reader.num_columns(), 2);
+  ASSERT_EQ(reader.num_row_groups(), 2);
+  ASSERT_EQ(reader.FindColumn("dense"), 1);
+  ASSERT_EQ(reader.FindColumn("missing"), -1);
+  ASSERT_EQ(reader.column_data_type(1), DataType::kFloat);
+  ASSERT_EQ(reader.column_row_elem_cnt(1), 3);
+  ASSERT_EQ(reader.row_group_num_rows(0), 6);
+  ASSERT_EQ(reader.row_group_num_rows(1), 4);
+  ASSERT_EQ(reader.chunk(1, 0).min_value, 6);
+  ASSERT_EQ(reader.chunk(1, 0).max_value, 9);
+  FOR_RANGE(size_t, row_group, 0, 2) {
+    FOR_RANGE(size_t, col, 0, 2) {
+      ASSERT_EQ(reader.chunk(row_group, col).offset % kColumnarChunkAlignment, 0);
+    }
+  }
+
+  std::vector<float> dense_out(4 * 3);
+  ASSERT_EQ(reader.ChunkSize(1, 1), dense_out.size() * sizeof(float));
+  reader.ReadChunk(1, 1, reinterpret_cast<char*>(dense_out.data()));
+  ASSERT_TRUE(std::equal(dense_out.begin(), dense_out.end(), dense.begin() + 6 * 3));
+
+  std::vector<int64_t> label_out(6);
+  reader.ReadChunk(0, 0, reinterpret_cast<char*>(label_out.data()));
+  std::vector<int64_t> selected_rows;
+  SelectColumnarRowsInRange(DataType::kInt64, label_out.data(), 6, 1.5, 4, &selected_rows);
+  ASSERT_EQ(selected_rows, std::vector<int64_t>({2, 3, 4}));
+
+  std::vector<int32_t> label_int32(6);
+  DecodeColumnarValues<int32_t>(DataType::kInt64, reinterpret_cast<const char*>(label_out.data()),
+                                6, label_int32.data());
+  ASSERT_EQ(label_int32, std::vector<int32_t>({0, 1, 2, 3, 4, 5}));
+  LocalFS()->DelFile(file_name);
+}
+
+}  // namespace test
+}  // namespace data
+}  // namespace oneflow
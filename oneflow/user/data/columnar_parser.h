@@ -0,0 +1,110 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_COLUMNAR_PARSER_H_
+#define ONEFLOW_USER_DATA_COLUMNAR_PARSER_H_
+
+#include "oneflow/user/data/parser.h"
+#include "oneflow/user/data/columnar_dataset.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+namespace data {
+
+template<typename T>
+void DecodeColumnarValues(DataType src_data_type, const char* src, int64_t elem_cnt, T* dst) {
+  if (src_data_type == GetDataType<T>::value) {
+    std::memcpy(dst, src, elem_cnt * sizeof(T));
+    return;
+  }
+  switch (src_data_type) {
+#define MAKE_ENTRY(cpp_type, data_type)                                         \
+  case data_type: {                                                             \
+    const auto* src_ptr = reinterpret_cast<const cpp_type*>(src);               \
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { dst[i] = static_cast<T>(src_ptr[i]); } \
+    break;                                                                      \
+  }
+    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, COLUMNAR_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+    default: UNIMPLEMENTED() << "unsupported columnar data type " << src_data_type;
+  }
+}
+
+// Copies the row ranges of a batch straight into the output tensors, one task per column and
+// row range, converting the values when the stored type differs from the output type.
+class ColumnarParser final : public Parser<ColumnarRowRange> {
+ public:
+  using Base = Parser<ColumnarRowRange>;
+  using SampleType = typename Base::SampleType;
+  using BatchType = typename Base::BatchType;
+
+  explicit ColumnarParser(user_op::KernelInitContext* ctx)
+      : shapes_(ctx->Attr<std::vector<Shape>>("shapes")),
+        data_types_(ctx->Attr<std::vector<DataType>>("data_types")) {}
+  ~ColumnarParser() = default;
+
+  void Parse(BatchType& batch_data, user_op::KernelComputeContext* ctx) override {
+    std::vector<user_op::Tensor*> out_tensors(shapes_.size());
+    FOR_RANGE(size_t, j, 0, shapes_.size()) {
+      out_tensors[j] = ctx->Tensor4ArgNameAndIndex("out", j);
+      CHECK_EQ(out_tensors[j]->data_type(), data_types_[j]);
+    }
+    std::vector<int64_t> dst_rows(batch_data.size() + 1, 0);
+    FOR_RANGE(size_t, k, 0, batch_data.size()) {
+      dst_rows[k + 1] = dst_rows[k] + batch_data[k].end - batch_data[k].begin;
+    }
+    FOR_RANGE(size_t, j, 0, shapes_.size()) {
+      CHECK_EQ(out_tensors[j]->shape_view().At(0), dst_rows.back());
+    }
+    MultiThreadLoop(shapes_.size() * batch_data.size(), [&](size_t task) {
+      const size_t j = task / batch_data.size();
+      const ColumnarRowRange& range = batch_data[task % batch_data.size()];
+      const int64_t row_elem_cnt = shapes_[j].elem_cnt();
+      const int64_t dst_offset = dst_rows[task % batch_data.size()] * row_elem_cnt;
+      if (!range.row_group) {
+        const size_t dst_size =
+            (range.end - range.begin) * row_elem_cnt * GetSizeOfDataType(data_types_[j]);
+        std::memset(static_cast<char*>(out_tensors[j]->mut_raw_dptr())
+                        + dst_offset * GetSizeOfDataType(data_types_[j]),
+                    0, dst_size);
+        return;
+      }
+      const DataType src_data_type = range.row_group->data_types[j];
+      const char* src = range.row_group->columns[j].data()
+                        + range.begin * row_elem_cnt * GetSizeOfDataType(src_data_type);
+      const int64_t elem_cnt = (range.end - range.begin) * row_elem_cnt;
+      switch (data_types_[j]) {
+#define MAKE_ENTRY(cpp_type, data_type)                                \
+  case data_type: {                                                    \
+    cpp_type* dst = out_tensors[j]->mut_dptr<cpp_type>() + dst_offset; \
+    DecodeColumnarValues<cpp_type>(src_data_type, src, elem_cnt, dst); \
+    break;                                                             \
+  }
+        OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, COLUMNAR_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+        default: UNIMPLEMENTED();
+      }
+    });
+  }
+
+ private:
+  std::vector<Shape> shapes_;
+  std::vector<DataType> data_types_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_COLUMNAR_PARSER_H_
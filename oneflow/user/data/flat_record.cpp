@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/flat_record.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+namespace data {
+
+FlatRecordView::FlatRecordView(const char* data, size_t size) : data_(data) {
+  CHECK_GE(size, sizeof(FlatRecordHeader));
+  header_ = reinterpret_cast<const FlatRecordHeader*>(data);
+  CHECK_EQ(header_->magic, kFlatRecordMagic) << "not a flat record";
+  const size_t headers_size =
+      sizeof(FlatRecordHeader) + header_->num_fields * sizeof(FlatRecordFieldHeader);
+  CHECK_GE(size, headers_size);
+  fields_ = reinterpret_cast<const FlatRecordFieldHeader*>(data + sizeof(FlatRecordHeader));
+  FOR_RANGE(size_t, i, 0, num_fields()) {
+    const FlatRecordFieldHeader& field = fields_[i];
+    CHECK_LE(field.name_offset + field.name_size, size);
+    CHECK_EQ(field.data_offset % kFlatRecordDataAlignment, 0);
+    CHECK_LE(field.data_offset + field.elem_cnt * GetSizeOfDataType(data_type(i)), size);
+  }
+}
+
+bool FlatRecordView::FieldNameEquals(size_t i, const std::string& name) const {
+  const FlatRecordFieldHeader& field = fields_[i];
+  return field.name_size == name.size()
+         && std::memcmp(data_ + field.name_offset, name.data(), name.size()) == 0;
+}
+
+int64_t FlatRecordView::FindField(const std::string& name) const {
+  FOR_RANGE(size_t, i, 0, num_fields()) {
+    if (FieldNameEquals(i, name)) { return i; }
+  }
+  return -1;
+}
+
+void FlatRecordBuilder::AddField(const std::string& name, DataType data_type, const void* data,
+                                 int64_t elem_cnt) {
+  const size_t nbytes = elem_cnt * GetSizeOfDataType(data_type);
+  fields_.emplace_back(Field{name, data_type, std::string(static_cast<const char*>(data), nbytes),
+                             elem_cnt});
+}
+
+void FlatRecordBuilder::Serialize(std::string* out) const {
+  size_t offset = sizeof(FlatRecordHeader) + fields_.size() * sizeof(FlatRecordFieldHeader);
+  std::vector<FlatRecordFieldHeader> headers(fields_.size());
+  FOR_RANGE(size_t, i, 0, fields_.size()) {
+    headers[i].name_offset = offset;
+    headers[i].name_size = fields_[i].name.size();
+    headers[i].data_type = fields_[i].data_type;
+    headers[i].reserved = 0;
+    headers[i].elem_cnt = fields_[i].elem_cnt;
+    offset += fields_[i].name.size();
+  }
+  FOR_RANGE(size_t, i, 0, fields_.size()) {
+    offset = RoundUp(offset, kFlatRecordDataAlignment);
+    headers[i].data_offset = offset;
+    offset += fields_[i].bytes.size();
+  }
+  out->assign(offset, '\0');
+  char* dst = &(*out)[0];
+  FlatRecordHeader header{kFlatRecordMagic, static_cast<uint32_t>(fields_.size())};
+  std::memcpy(dst, &header, sizeof(header));
+  if (!headers.empty()) {
+    std::memcpy(dst + sizeof(header), headers.data(), headers.size() * sizeof(headers[0]));
+  }
+  FOR_RANGE(size_t, i, 0, fields_.size()) {
+    std::memcpy(dst + headers[i].name_offset, fields_[i].name.data(), fields_[i].name.size());
+    std::memcpy(dst + headers[i].data_offset, fields_[i].bytes.data(), fields_[i].bytes.size());
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
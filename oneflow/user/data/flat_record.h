@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_FLAT_RECORD_H_
+#define ONEFLOW_USER_DATA_FLAT_RECORD_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.pb.h"
+
+namespace oneflow {
+namespace data {
+
+// A FlatRecord holds the same named typed lists as an OFRecord, but is laid out so that every
+// field is located by pointer arithmetic on the record bytes instead of protobuf parsing:
+//
+//   FlatRecordHeader | FlatRecordFieldHeader x num_fields | field names | field data
+//
+// All integers are little endian and the data of every field is aligned to 8 bytes relative to
+// the start of the record. In files, records are framed like OFRecords by an int64 size prefix.
+constexpr uint32_t kFlatRecordMagic = 0x5246464F;  // "OFFR"
+constexpr size_t kFlatRecordDataAlignment = 8;
+
+struct FlatRecordHeader {
+  uint32_t magic;
+  uint32_t num_fields;
+};
+
+struct FlatRecordFieldHeader {
+  uint32_t name_offset;
+  uint32_t name_size;
+  int32_t data_type;
+  uint32_t reserved;
+  uint64_t data_offset;
+  uint64_t elem_cnt;
+};
+
+static_assert(sizeof(FlatRecordHeader) == 8, "");
+static_assert(sizeof(FlatRecordFieldHeader) == 32, "");
+
+class FlatRecordView final {
+ public:
+  FlatRecordView(const char* data, size_t size);
+  ~FlatRecordView() = default;
+
+  size_t num_fields() const { return header_->num_fields; }
+  bool FieldNameEquals(size_t i, const std::string& name) const;
+  // Returns -1 if there is no field with the name
+  int64_t FindField(const std::string& name) const;
+  DataType data_type(size_t i) const { return static_cast<DataType>(fields_[i].data_type); }
+  int64_t elem_cnt(size_t i) const { return fields_[i].elem_cnt; }
+  const void* field_data(size_t i) const { return data_ + fields_[i].data_offset; }
+
+ private:
+  const char* data_;
+  const FlatRecordHeader* header_;
+  const FlatRecordFieldHeader* fields_;
+};
+
+class FlatRecordBuilder final {
+ public:
+  FlatRecordBuilder() = default;
+  ~FlatRecordBuilder() = default;
+
+  void AddField(const std::string& name, DataType data_type, const void* data, int64_t elem_cnt);
+  void Serialize(std::string* out) const;
+
+ private:
+  struct Field {
+    std::string name;
+    DataType data_type;
+    std::string bytes;
+    int64_t elem_cnt;
+  };
+  std::vector<Field> fields_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_FLAT_RECORD_H_
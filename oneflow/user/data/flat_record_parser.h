@@ -0,0 +1,117 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_FLAT_RECORD_PARSER_H_
+#define ONEFLOW_USER_DATA_FLAT_RECORD_PARSER_H_
+
+#include "oneflow/user/data/parser.h"
+#include "oneflow/user/data/flat_record.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+namespace data {
+
+#define FLAT_RECORD_DATA_TYPE_SEQ \
+  ARITHMETIC_DATA_TYPE_SEQ CHAR_DATA_TYPE_SEQ UNSIGNED_INT_DATA_TYPE_SEQ
+
+template<typename T>
+void DecodeFlatRecordField(const FlatRecordView& record, size_t field, T* dst,
+                           int64_t sample_elem_cnt, bool truncate) {
+  int64_t elem_cnt = record.elem_cnt(field);
+  if (truncate) {
+    elem_cnt = std::min(elem_cnt, sample_elem_cnt);
+  } else {
+    CHECK_EQ(elem_cnt, sample_elem_cnt);
+  }
+  const DataType src_data_type = record.data_type(field);
+  if (src_data_type == GetDataType<T>::value) {
+    std::memcpy(dst, record.field_data(field), elem_cnt * sizeof(T));
+  } else {
+    switch (src_data_type) {
+#define MAKE_ENTRY(cpp_type, data_type)                                                     \
+  case data_type: {                                                                         \
+    const auto* src = static_cast<const cpp_type*>(record.field_data(field));               \
+    std::transform(src, src + elem_cnt, dst, [](cpp_type v) { return static_cast<T>(v); }); \
+    break;                                                                                  \
+  }
+      OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, FLAT_RECORD_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+      default: UNIMPLEMENTED() << "unsupported flat record data type " << src_data_type;
+    }
+  }
+  if (elem_cnt < sample_elem_cnt) { std::fill(dst + elem_cnt, dst + sample_elem_cnt, T(0)); }
+}
+
+class FlatRecordParser final : public Parser<TensorBuffer> {
+ public:
+  using Base = Parser<TensorBuffer>;
+  using SampleType = typename Base::SampleType;
+  using BatchType = typename Base::BatchType;
+
+  explicit FlatRecordParser(user_op::KernelInitContext* ctx)
+      : names_(ctx->Attr<std::vector<std::string>>("names")),
+        shapes_(ctx->Attr<std::vector<Shape>>("shapes")),
+        data_types_(ctx->Attr<std::vector<DataType>>("data_types")),
+        truncate_(ctx->Attr<bool>("truncate")) {}
+  ~FlatRecordParser() = default;
+
+  void Parse(BatchType& batch_data, user_op::KernelComputeContext* ctx) override {
+    std::vector<user_op::Tensor*> out_tensors(names_.size());
+    FOR_RANGE(size_t, j, 0, names_.size()) {
+      out_tensors[j] = ctx->Tensor4ArgNameAndIndex("out", j);
+      CHECK_EQ(out_tensors[j]->data_type(), data_types_[j]);
+      CHECK_EQ(out_tensors[j]->shape_view().At(0), batch_data.size());
+    }
+    MultiThreadLoop(batch_data.size(), [&](size_t i) {
+      const TensorBuffer& sample = batch_data[i];
+      const FlatRecordView record(sample.data<char>(), sample.nbytes());
+      FOR_RANGE(size_t, j, 0, names_.size()) {
+        // records written by one converter share the field order, so try the same slot first
+        int64_t field = -1;
+        if (j < record.num_fields() && record.FieldNameEquals(j, names_[j])) {
+          field = j;
+        } else {
+          field = record.FindField(names_[j]);
+        }
+        CHECK_GE(field, 0) << "Field " << names_[j] << " not found";
+        const int64_t sample_elem_cnt = shapes_[j].elem_cnt();
+        switch (data_types_[j]) {
+#define MAKE_ENTRY(cpp_type, data_type)                                              \
+  case data_type: {                                                                  \
+    cpp_type* dst = out_tensors[j]->mut_dptr<cpp_type>() + i * sample_elem_cnt;      \
+    DecodeFlatRecordField<cpp_type>(record, field, dst, sample_elem_cnt, truncate_); \
+    break;                                                                           \
+  }
+          OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, FLAT_RECORD_DATA_TYPE_SEQ)
+#undef MAKE_ENTRY
+          default: UNIMPLEMENTED();
+        }
+      }
+    });
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<Shape> shapes_;
+  std::vector<DataType> data_types_;
+  bool truncate_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_FLAT_RECORD_PARSER_H_
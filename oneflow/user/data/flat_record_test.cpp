@@ -0,0 +1,60 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/user/data/flat_record.h"
+#include "oneflow/user/data/flat_record_parser.h"
+
+namespace oneflow {
+namespace data {
+namespace test {
+
+TEST(FlatRecord, build_and_view) {
+  const std::vector<int64_t> label = {7};
+  const std::vector<float> dense = {0.5, 1.5, 2.5};
+  const std::string bytes = "abcde";
+  FlatRecordBuilder builder;
+  builder.AddField("label", DataType::kInt64, label.data(), label.size());
+  builder.AddField("bytes", DataType::kInt8, bytes.data(), bytes.size());
+  builder.AddField("dense", DataType::kFloat, dense.data(), dense.size());
+  std::string record_bytes;
+  builder.Serialize(&record_bytes);
+
+  FlatRecordView record(record_bytes.data(), record_bytes.size());
+  ASSERT_EQ(record.num_fields(), 3);
+  ASSERT_EQ(record.FindField("label"), 0);
+  ASSERT_EQ(record.FindField("bytes"), 1);
+  ASSERT_EQ(record.FindField("dense"), 2);
+  ASSERT_EQ(record.FindField("missing"), -1);
+  ASSERT_EQ(record.data_type(2), DataType::kFloat);
+  ASSERT_EQ(record.elem_cnt(2), 3);
+  FOR_RANGE(size_t, i, 0, record.num_fields()) {
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(record.field_data(i)) % kFlatRecordDataAlignment,
+              reinterpret_cast<uintptr_t>(record_bytes.data()) % kFlatRecordDataAlignment);
+  }
+  ASSERT_EQ(*static_cast<const int64_t*>(record.field_data(0)), 7);
+  ASSERT_EQ(std::string(static_cast<const char*>(record.field_data(1)), 5), bytes);
+
+  std::vector<double> dense_out(4, -1);
+  DecodeFlatRecordField<double>(record, 2, dense_out.data(), 4, /*truncate=*/true);
+  ASSERT_EQ(dense_out, std::vector<double>({0.5, 1.5, 2.5, 0}));
+  std::vector<int32_t> bytes_out(3);
+  DecodeFlatRecordField<int32_t>(record, 1, bytes_out.data(), 3, /*truncate=*/true);
+  ASSERT_EQ(bytes_out, std::vector<int32_t>({'a', 'b', 'c'}));
+}
+
+}  // namespace test
+}  // namespace data
+}  // namespace oneflow
@@ -14,6 +14,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/data/gpt_dataset.h"
+#include "oneflow/core/common/env_var/env_var.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/rpc/include/global_process_ctx.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include <thread>
 
 #ifdef __linux__
 #include <fcntl.h>
@@ -21,14 +26,49 @@ limitations under the License.
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 namespace oneflow {
 
+// When enabled, index arrays of a dataset are cached into "<dir>/<basename>_<key hash>.gpt_index",
+// where dir is ONEFLOW_GPT_DATASET_INDEX_CACHE_DIR or else the directory of data_file_prefix, and
+// mapped by later runs and the other ranks using the same arguments. On a miss only the local rank
+// 0 of a node builds and saves the cache, the other ranks of the node wait for it to appear for up
+// to ONEFLOW_GPT_DATASET_INDEX_CACHE_WAIT_SECONDS and build the indices themselves after that.
+DEFINE_ENV_BOOL(ONEFLOW_GPT_DATASET_ENABLE_INDEX_CACHE, false);
+DEFINE_ENV_INTEGER(ONEFLOW_GPT_DATASET_INDEX_CACHE_WAIT_SECONDS, 3600);
+
 namespace data {
 
 namespace {
 
+constexpr char kIndexCacheMagicCode[] = "OFGPTIDX";
+constexpr size_t kIndexCacheMagicCodeLen = sizeof(kIndexCacheMagicCode) - 1;
+constexpr uint64_t kIndexCacheVersion = 2;
+constexpr size_t kIndexBuildNumChunks = 256;
+
+static_assert(sizeof(std::pair<size_t, size_t>) == 2 * sizeof(size_t), "");
+
+size_t AlignIndexCacheSize(size_t size) {
+  return (size + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+std::string GetIndexCacheFile(const std::string& data_file_prefix, const std::string& cache_key) {
+  std::string cache_dir = GetStringFromEnv("ONEFLOW_GPT_DATASET_INDEX_CACHE_DIR", "");
+  std::string basename = data_file_prefix;
+  const size_t pos = data_file_prefix.find_last_of('/');
+  if (pos != std::string::npos) {
+    if (cache_dir.empty()) { cache_dir = data_file_prefix.substr(0, pos); }
+    basename = data_file_prefix.substr(pos + 1);
+  }
+  if (cache_dir.empty()) { cache_dir = "."; }
+  std::ostringstream ss;
+  ss << cache_dir << "/" << basename << "_" << std::hex << std::hash<std::string>()(cache_key)
+     << ".gpt_index";
+  return ss.str();
+}
+
 void GetSplitDocIndices(std::vector<size_t>* doc_indices, const std::vector<int64_t>& split_sizes,
                         size_t split_index, size_t num_docs) {
   CHECK_LT(split_index, split_sizes.size());
@@ -49,6 +89,56 @@ void GetSplitDocIndices(std::vector<size_t>* doc_indices, const std::vector<int6
   std::iota(doc_indices->begin(), doc_indices->end(), split_offset);
 }
 
+// Shuffles data[0, size) uniformly and in parallel into an order which only depends on seed, not
+// on the number of threads: every chunk of the data scatters its elements to random buckets in
+// order, and then every bucket is shuffled. The generators of a chunk and of a bucket are seeded by
+// seed and their index.
+void ParallelShuffle(size_t* data, size_t size, uint64_t seed) {
+  const size_t num_chunks = std::max<size_t>(std::min(size, kIndexBuildNumChunks), 1);
+  const size_t num_buckets = num_chunks;
+  BalancedSplitter bs(size, num_chunks);
+  const auto NewGenerator = [seed](uint64_t phase, uint64_t index) {
+    std::seed_seq seed_seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                           static_cast<uint32_t>(phase), static_cast<uint32_t>(index)};
+    return std::mt19937_64(seed_seq);
+  };
+  // the bucket of an element is drawn again by the same generator when it is scattered
+  const auto ForEachBucket = [&](size_t chunk, const auto& Handle) {
+    std::mt19937_64 gen = NewGenerator(0, chunk);
+    std::uniform_int_distribution<size_t> distribution(0, num_buckets - 1);
+    FOR_RANGE(size_t, i, bs.At(chunk).begin(), bs.At(chunk).end()) { Handle(i, distribution(gen)); }
+  };
+  // chunk_bucket_offsets[chunk * num_buckets + bucket] is where the chunk writes to the bucket
+  std::vector<size_t> chunk_bucket_offsets(num_chunks * num_buckets, 0);
+  MultiThreadLoop(num_chunks, [&](size_t chunk) {
+    size_t* counts = chunk_bucket_offsets.data() + chunk * num_buckets;
+    ForEachBucket(chunk, [&](size_t, size_t bucket) { counts[bucket] += 1; });
+  });
+  std::vector<size_t> bucket_offsets(num_buckets + 1, 0);
+  size_t offset = 0;
+  FOR_RANGE(size_t, bucket, 0, num_buckets) {
+    bucket_offsets[bucket] = offset;
+    FOR_RANGE(size_t, chunk, 0, num_chunks) {
+      const size_t count = chunk_bucket_offsets[chunk * num_buckets + bucket];
+      chunk_bucket_offsets[chunk * num_buckets + bucket] = offset;
+      offset += count;
+    }
+  }
+  bucket_offsets[num_buckets] = offset;
+  std::vector<size_t> scattered(size);
+  MultiThreadLoop(num_chunks, [&](size_t chunk) {
+    size_t* offsets = chunk_bucket_offsets.data() + chunk * num_buckets;
+    ForEachBucket(chunk, [&](size_t i, size_t bucket) { scattered[offsets[bucket]++] = data[i]; });
+  });
+  MultiThreadLoop(num_buckets, [&](size_t bucket) {
+    std::mt19937_64 gen = NewGenerator(1, bucket);
+    std::shuffle(scattered.begin() + bucket_offsets[bucket],
+                 scattered.begin() + bucket_offsets[bucket + 1], gen);
+    std::copy(scattered.cbegin() + bucket_offsets[bucket],
+              scattered.cbegin() + bucket_offsets[bucket + 1], data + bucket_offsets[bucket]);
+  });
+}
+
 size_t GetNumEpochs(size_t num_samples, size_t seq_length, size_t tokens_per_epoch) {
   // num_epochs * tokens_per_epoch >= num_samples * seq_length + 1
   // +1 is because we need to retrieve seq_length + 1 token each time
@@ -151,7 +241,8 @@ MegatronGPTMMapDataset::MegatronGPTMMapDataset(const std::string& data_file_pref
       num_samples_(num_samples),
       shuffle_(shuffle),
       seed_(seed),
-      gen_(seed) {
+      gen_(seed),
+      max_num_segments_(0) {
   auto start = std::chrono::system_clock::now();
   index_ = std::make_unique<const MegatronGPTIndex>(data_file_prefix + ".idx");
   data_ = std::make_unique<const MappedBuffer>(data_file_prefix + ".bin");
@@ -161,11 +252,21 @@ MegatronGPTMMapDataset::MegatronGPTMMapDataset(const std::string& data_file_pref
   tokens_per_epoch_ = GetEpochNumTokens(epoch_doc_indices);
   num_epochs_ = GetNumEpochs(num_samples_, seq_len_, tokens_per_epoch_);
   num_complete_epochs_ = GetNumCompleteEpochs(num_samples_, seq_len_, tokens_per_epoch_);
-  InitDocIndices(epoch_doc_indices, num_epochs_, num_complete_epochs_);
-  size_t total_num_samples = static_cast<size_t>(
-      std::floor(static_cast<double>(num_epochs_ * tokens_per_epoch_ - 1) / seq_len_));
-  InitSampleIndices(total_num_samples);
-  InitShuffleIndices(sample_indices_.size());
+  const bool enable_index_cache = EnvBool<ONEFLOW_GPT_DATASET_ENABLE_INDEX_CACHE>();
+  const std::string cache_key = GetIndexCacheKey(data_file_prefix, split_sizes, split_index);
+  const std::string cache_file = GetIndexCacheFile(data_file_prefix, cache_key);
+  bool cache_hit = enable_index_cache && TryLoadIndexCache(cache_file, cache_key);
+  if (enable_index_cache && !cache_hit && GlobalProcessCtx::LocalRank() != 0) {
+    cache_hit = WaitForIndexCache(cache_file, cache_key);
+  }
+  if (!cache_hit) {
+    InitDocIndices(epoch_doc_indices, num_epochs_, num_complete_epochs_);
+    size_t total_num_samples = static_cast<size_t>(
+        std::floor(static_cast<double>(num_epochs_ * tokens_per_epoch_ - 1) / seq_len_));
+    InitSampleIndices(total_num_samples);
+    InitShuffleIndices(sample_indices_.size());
+    if (enable_index_cache) { SaveIndexCache(cache_file, cache_key); }
+  }
   std::chrono::duration<double, std::milli> elapse = std::chrono::system_clock::now() - start;
   VLOG(2) << "Create GPT Dataset successed, sequence length: " << seq_len_
           << ", number of samples: " << num_samples_
@@ -174,9 +275,142 @@ MegatronGPTMMapDataset::MegatronGPTMMapDataset(const std::string& data_file_pref
           << ", number of epochs: " << num_epochs_
           << ", number of complete epochs: " << num_complete_epochs_
           << ", shuffle: " << std::boolalpha << shuffle_ << ", random_seed: " << seed_
+          << ", index cache: " << (cache_hit ? "hit " : "miss ") << cache_file
           << ", elapsed time: " << elapse.count() << " ms";
 }
 
+std::string MegatronGPTMMapDataset::GetIndexCacheKey(const std::string& data_file_prefix,
+                                                     const std::vector<int64_t>& split_sizes,
+                                                     size_t split_index) const {
+  std::ostringstream ss;
+  ss << "version=" << kIndexCacheVersion << ";data_file_prefix=" << data_file_prefix;
+#ifdef __linux__
+  // invalidate the cache once the dataset is regenerated
+  struct stat s;
+  if (stat((data_file_prefix + ".idx").c_str(), &s) == 0) {
+    ss << ";idx_size=" << s.st_size << ";idx_mtime=" << s.st_mtime;
+  }
+#endif
+  ss << ";seq_len=" << seq_len_ << ";num_samples=" << num_samples_ << ";split_sizes=";
+  for (int64_t split_size : split_sizes) { ss << split_size << ","; }
+  ss << ";split_index=" << split_index << ";shuffle=" << shuffle_ << ";seed=" << seed_;
+  return ss.str();
+}
+
+bool MegatronGPTMMapDataset::TryLoadIndexCache(const std::string& cache_file,
+                                               const std::string& cache_key) {
+#ifdef __linux__
+  struct stat s;
+  if (stat(cache_file.c_str(), &s) != 0) { return false; }
+  auto cache = std::make_unique<const MappedBuffer>(cache_file);
+  const char* ptr = static_cast<const char*>(cache->ptr());
+  const size_t size = cache->size();
+  size_t offset = 0;
+  auto ReadU64 = [&](uint64_t* val) -> bool {
+    if (offset + sizeof(uint64_t) > size) { return false; }
+    std::memcpy(val, ptr + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    return true;
+  };
+  if (size < kIndexCacheMagicCodeLen
+      || std::memcmp(ptr, kIndexCacheMagicCode, kIndexCacheMagicCodeLen) != 0) {
+    LOG(WARNING) << "ignore invalid GPT dataset index cache " << cache_file;
+    return false;
+  }
+  offset += kIndexCacheMagicCodeLen;
+  uint64_t version = 0;
+  uint64_t key_len = 0;
+  if (!ReadU64(&version) || version != kIndexCacheVersion || !ReadU64(&key_len)
+      || offset + key_len > size || std::string(ptr + offset, key_len) != cache_key) {
+    LOG(WARNING) << "ignore mismatched GPT dataset index cache " << cache_file;
+    return false;
+  }
+  offset += AlignIndexCacheSize(key_len);
+  uint64_t num_doc_indices = 0;
+  uint64_t num_sample_indices = 0;
+  uint64_t num_shuffle_indices = 0;
+  if (!ReadU64(&num_doc_indices) || !ReadU64(&num_sample_indices)
+      || !ReadU64(&num_shuffle_indices)) {
+    LOG(WARNING) << "ignore truncated GPT dataset index cache " << cache_file;
+    return false;
+  }
+  const size_t num_elems = num_doc_indices + 2 * num_sample_indices + num_shuffle_indices;
+  if (offset + num_elems * sizeof(size_t) != size) {
+    LOG(WARNING) << "ignore truncated GPT dataset index cache " << cache_file;
+    return false;
+  }
+  const auto* data = reinterpret_cast<const size_t*>(ptr + offset);
+  doc_indices_.Map(data, num_doc_indices);
+  data += num_doc_indices;
+  sample_indices_.Map(reinterpret_cast<const std::pair<size_t, size_t>*>(data),
+                      num_sample_indices);
+  data += 2 * num_sample_indices;
+  shuffle_indices_.Map(data, num_shuffle_indices);
+  index_cache_ = std::move(cache);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool MegatronGPTMMapDataset::WaitForIndexCache(const std::string& cache_file,
+                                               const std::string& cache_key) {
+#ifdef __linux__
+  // the cache is renamed into place once it is completely written
+  const auto deadline =
+      std::chrono::steady_clock::now()
+      + std::chrono::seconds(EnvInteger<ONEFLOW_GPT_DATASET_INDEX_CACHE_WAIT_SECONDS>());
+  while (std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (TryLoadIndexCache(cache_file, cache_key)) { return true; }
+  }
+  LOG(WARNING) << "GPT dataset index cache " << cache_file
+               << " is not built by the local rank 0 in time, build the indices in this rank";
+#endif
+  return false;
+}
+
+void MegatronGPTMMapDataset::SaveIndexCache(const std::string& cache_file,
+                                            const std::string& cache_key) const {
+#ifdef __linux__
+  // Write to a process private file and rename it, so that ranks racing on the same cache never
+  // observe a partially written one. The cache dir may be shared by the nodes, whose pids collide.
+  char hostname[255];
+  if (gethostname(hostname, sizeof(hostname)) != 0) { hostname[0] = '\0'; }
+  hostname[sizeof(hostname) - 1] = '\0';
+  const std::string tmp_file =
+      cache_file + ".tmp." + std::string(hostname) + "." + std::to_string(getpid());
+  std::ofstream stream(tmp_file, std::ios::binary);
+  if (!stream.is_open()) {
+    LOG(WARNING) << "can't write GPT dataset index cache " << cache_file;
+    return;
+  }
+  auto WriteU64 = [&](uint64_t val) {
+    stream.write(reinterpret_cast<const char*>(&val), sizeof(val));
+  };
+  stream.write(kIndexCacheMagicCode, kIndexCacheMagicCodeLen);
+  WriteU64(kIndexCacheVersion);
+  WriteU64(cache_key.size());
+  const std::string padding(AlignIndexCacheSize(cache_key.size()) - cache_key.size(), '\0');
+  stream.write(cache_key.data(), cache_key.size());
+  stream.write(padding.data(), padding.size());
+  WriteU64(doc_indices_.size());
+  WriteU64(sample_indices_.size());
+  WriteU64(shuffle_indices_.size());
+  stream.write(reinterpret_cast<const char*>(doc_indices_.data()),
+               doc_indices_.size() * sizeof(size_t));
+  stream.write(reinterpret_cast<const char*>(sample_indices_.data()),
+               sample_indices_.size() * 2 * sizeof(size_t));
+  stream.write(reinterpret_cast<const char*>(shuffle_indices_.data()),
+               shuffle_indices_.size() * sizeof(size_t));
+  stream.close();
+  if (stream.fail() || rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+    LOG(WARNING) << "can't write GPT dataset index cache " << cache_file;
+    remove(tmp_file.c_str());
+  }
+#endif
+}
+
 size_t MegatronGPTMMapDataset::GetEpochNumTokens(const std::vector<size_t>& doc_indices) const {
   size_t num_tokens = 0;
   for (auto doc_index : doc_indices) { num_tokens += index_->doc_length(doc_index); }
@@ -185,7 +419,7 @@ size_t MegatronGPTMMapDataset::GetEpochNumTokens(const std::vector<size_t>& doc_
 
 void MegatronGPTMMapDataset::InitDocIndices(const std::vector<size_t>& epoch_doc_indices,
                                             size_t num_epochs, size_t num_complete_epochs) {
-  doc_indices_.reserve(epoch_doc_indices.size() * num_epochs);
+  doc_indices_.mut_vec()->reserve(epoch_doc_indices.size() * num_epochs);
   InitDocIndices(epoch_doc_indices, num_complete_epochs);
   if (num_epochs != num_complete_epochs) {
     CHECK_EQ(num_complete_epochs + 1, num_epochs);
@@ -195,53 +429,121 @@ void MegatronGPTMMapDataset::InitDocIndices(const std::vector<size_t>& epoch_doc
 
 void MegatronGPTMMapDataset::InitDocIndices(const std::vector<size_t>& epoch_doc_indices,
                                             size_t num_epochs) {
-  auto start = std::distance(doc_indices_.cbegin(), doc_indices_.cend());
-  FOR_RANGE(size_t, i, 0, num_epochs) {
-    doc_indices_.insert(doc_indices_.end(), epoch_doc_indices.cbegin(), epoch_doc_indices.cend());
+  std::vector<size_t>* doc_indices = doc_indices_.mut_vec();
+  const size_t start = doc_indices->size();
+  doc_indices->resize(start + epoch_doc_indices.size() * num_epochs);
+  MultiThreadLoop(num_epochs, [&](size_t i) {
+    std::copy(epoch_doc_indices.cbegin(), epoch_doc_indices.cend(),
+              doc_indices->begin() + start + i * epoch_doc_indices.size());
+  });
+  if (shuffle_) {
+    ParallelShuffle(doc_indices->data() + start, doc_indices->size() - start, gen_());
   }
-  if (shuffle_) { std::shuffle(doc_indices_.begin() + start, doc_indices_.end(), gen_); }
 }
 
 void MegatronGPTMMapDataset::InitSampleIndices(size_t total_num_samples) {
-  sample_indices_.reserve(total_num_samples);
-  size_t doc_indices_idx = 0;
-  size_t doc_offset = 0;
-  FOR_RANGE(size_t, i, 0, total_num_samples) {
-    if (doc_indices_idx >= doc_indices_.size()) { break; }
-    sample_indices_.emplace_back(doc_indices_idx, doc_offset);
-    int remaining_tokens = seq_len_;
-    while (remaining_tokens > 0) {
-      CHECK_LT(doc_indices_idx, doc_indices_.size());
-      size_t doc_len = index_->doc_length(doc_indices_[doc_indices_idx]);
-      CHECK_LT(doc_offset, doc_len);
-      doc_len -= doc_offset;
-      if (remaining_tokens < doc_len) {
-        // move offset inside doc
-        doc_offset += remaining_tokens;
-      } else {
-        // move to next doc
-        doc_indices_idx += 1;
-        doc_offset = 0;
-      }
-      remaining_tokens -= doc_len;
+  // doc_token_offsets[i] is the number of tokens before doc_indices_[i], so that every sample,
+  // which starts at token i * seq_len_, can be located independently by binary search.
+  const size_t num_doc_indices = doc_indices_.size();
+  std::vector<size_t> doc_token_offsets(num_doc_indices + 1, 0);
+  const size_t num_chunks = std::max<size_t>(std::min(num_doc_indices, kIndexBuildNumChunks), 1);
+  BalancedSplitter bs(num_doc_indices, num_chunks);
+  std::vector<size_t> chunk_num_tokens(num_chunks, 0);
+  MultiThreadLoop(num_chunks, [&](size_t chunk) {
+    FOR_RANGE(size_t, i, bs.At(chunk).begin(), bs.At(chunk).end()) {
+      chunk_num_tokens[chunk] += index_->doc_length(doc_indices_[i]);
     }
-  }
-  CHECK_EQ(sample_indices_.size(), total_num_samples);
-  CHECK_GE(sample_indices_.size(), num_samples_);
+  });
+  std::vector<size_t> chunk_token_offsets(num_chunks + 1, 0);
+  std::partial_sum(chunk_num_tokens.cbegin(), chunk_num_tokens.cend(),
+                   chunk_token_offsets.begin() + 1);
+  MultiThreadLoop(num_chunks, [&](size_t chunk) {
+    size_t offset = chunk_token_offsets[chunk];
+    FOR_RANGE(size_t, i, bs.At(chunk).begin(), bs.At(chunk).end()) {
+      doc_token_offsets[i] = offset;
+      offset += index_->doc_length(doc_indices_[i]);
+    }
+  });
+  doc_token_offsets[num_doc_indices] = chunk_token_offsets[num_chunks];
+  CHECK_LE(total_num_samples * seq_len_, doc_token_offsets[num_doc_indices]);
+  CHECK_GE(total_num_samples, num_samples_);
+
+  std::vector<std::pair<size_t, size_t>>* sample_indices = sample_indices_.mut_vec();
+  sample_indices->resize(total_num_samples);
+  MultiThreadLoop(total_num_samples, [&](size_t i) {
+    const size_t token_offset = i * seq_len_;
+    // the last doc starting at or before token_offset, docs ending exactly there are skipped
+    auto it = std::upper_bound(doc_token_offsets.cbegin(), doc_token_offsets.cend(), token_offset);
+    const size_t doc_indices_idx = std::distance(doc_token_offsets.cbegin(), it) - 1;
+    CHECK_LT(doc_indices_idx, num_doc_indices);
+    (*sample_indices)[i] =
+        std::make_pair(doc_indices_idx, token_offset - doc_token_offsets[doc_indices_idx]);
+  });
 }
 
 void MegatronGPTMMapDataset::InitShuffleIndices(size_t total_num_samples) {
-  shuffle_indices_.resize(total_num_samples);
-  std::iota(shuffle_indices_.begin(), shuffle_indices_.end(), 0);
+  std::vector<size_t>* shuffle_indices = shuffle_indices_.mut_vec();
+  shuffle_indices->resize(total_num_samples);
+  std::iota(shuffle_indices->begin(), shuffle_indices->end(), 0);
   if (shuffle_) {
     size_t num_samples = static_cast<size_t>(
         std::floor(static_cast<double>(num_complete_epochs_ * tokens_per_epoch_ - 1) / seq_len_));
-    CHECK_LE(num_samples, shuffle_indices_.size());
-    std::shuffle(shuffle_indices_.begin(), shuffle_indices_.begin() + num_samples, gen_);
+    CHECK_LE(num_samples, shuffle_indices->size());
+    ParallelShuffle(shuffle_indices->data(), num_samples, gen_());
     if (num_complete_epochs_ != num_epochs_) {
-      std::shuffle(shuffle_indices_.begin() + num_samples, shuffle_indices_.end(), gen_);
+      ParallelShuffle(shuffle_indices->data() + num_samples, shuffle_indices->size() - num_samples,
+                      gen_());
+    }
+  }
+}
+
+void MegatronGPTMMapDataset::InitPackedSamples(size_t max_num_segments) {
+  auto start = std::chrono::system_clock::now();
+  CHECK_GT(max_num_segments, 0);
+  max_num_segments_ = max_num_segments;
+  std::vector<std::vector<MegatronGPTPackedSegment>> packed_samples;
+  // remaining capacity -> packed samples which can still take a segment
+  std::multimap<size_t, size_t> remaining2packed_sample;
+  FOR_RANGE(size_t, i, 0, doc_indices_.size()) {
+    const size_t doc_index = doc_indices_[i];
+    const size_t doc_len = index_->doc_length(doc_index);
+    for (size_t doc_offset = 0; doc_offset < doc_len; doc_offset += sample_len_) {
+      const size_t length = std::min(sample_len_, doc_len - doc_offset);
+      size_t packed_sample_id = packed_samples.size();
+      size_t remaining = sample_len_;
+      // best fit: the packed sample with the least remaining capacity that the piece fits in
+      auto it = remaining2packed_sample.lower_bound(length);
+      if (it == remaining2packed_sample.end()) {
+        packed_samples.emplace_back();
+      } else {
+        remaining = it->first;
+        packed_sample_id = it->second;
+        remaining2packed_sample.erase(it);
+      }
+      auto& segments = packed_samples[packed_sample_id];
+      segments.push_back(MegatronGPTPackedSegment{doc_index, doc_offset, length});
+      remaining -= length;
+      if (remaining > 0 && segments.size() < max_num_segments_) {
+        remaining2packed_sample.emplace(remaining, packed_sample_id);
+      }
     }
   }
+  packed_sample_offsets_.resize(packed_samples.size() + 1);
+  packed_sample_offsets_[0] = 0;
+  FOR_RANGE(size_t, i, 0, packed_samples.size()) {
+    packed_sample_offsets_[i + 1] = packed_sample_offsets_[i] + packed_samples[i].size();
+  }
+  packed_segments_.resize(packed_sample_offsets_.back());
+  MultiThreadLoop(packed_samples.size(), [&](size_t i) {
+    std::copy(packed_samples[i].cbegin(), packed_samples[i].cend(),
+              packed_segments_.begin() + packed_sample_offsets_[i]);
+  });
+  std::chrono::duration<double, std::milli> elapse = std::chrono::system_clock::now() - start;
+  VLOG(2) << "Pack GPT Dataset successed, sample length: " << sample_len_
+          << ", max number of segments: " << max_num_segments_
+          << ", number of packed samples: " << num_packed_samples()
+          << ", number of segments: " << packed_segments_.size()
+          << ", elapsed time: " << elapse.count() << " ms";
 }
 
 const HashMap<char, size_t> MegatronGPTMMapDataset::kDTypeCode2Size = {
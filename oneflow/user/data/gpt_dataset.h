@@ -58,6 +58,42 @@ class MappedBuffer final {
   size_t size_;
 };
 
+// Index array of MegatronGPTMMapDataset, either built in memory or mapped from an index cache
+// file written by a previous run.
+template<typename T>
+class MegatronGPTIndexArray final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MegatronGPTIndexArray);
+  MegatronGPTIndexArray() : mapped_data_(nullptr), mapped_size_(0) {}
+  ~MegatronGPTIndexArray() = default;
+
+  const T* data() const { return mapped_data_ != nullptr ? mapped_data_ : vec_.data(); }
+  size_t size() const { return mapped_data_ != nullptr ? mapped_size_ : vec_.size(); }
+  const T& operator[](size_t i) const { return data()[i]; }
+
+  std::vector<T>* mut_vec() {
+    CHECK(mapped_data_ == nullptr);
+    return &vec_;
+  }
+  void Map(const T* data, size_t size) {
+    std::vector<T>().swap(vec_);
+    mapped_data_ = data;
+    mapped_size_ = size;
+  }
+
+ private:
+  std::vector<T> vec_;
+  const T* mapped_data_;
+  size_t mapped_size_;
+};
+
+// A piece of a document placed into a packed sample.
+struct MegatronGPTPackedSegment {
+  size_t doc_index;
+  size_t doc_offset;
+  size_t length;
+};
+
 class MegatronGPTMMapDataset final {
  public:
   MegatronGPTMMapDataset(const std::string& data_file_prefix, size_t seq_len, size_t label_len,
@@ -69,9 +105,27 @@ class MegatronGPTMMapDataset final {
   template<typename T>
   void GetSample(size_t index, T* data) const;
 
+  // Packs the documents of doc_indices_, split into pieces of at most sample_len_ tokens, into
+  // samples of sample_len_ tokens with best-fit, so that no document spans two samples.
+  void InitPackedSamples(size_t max_num_segments);
+  size_t num_packed_samples() const {
+    return packed_sample_offsets_.empty() ? 0 : packed_sample_offsets_.size() - 1;
+  }
+  // Writes a packed sample padded with pad_token_id, the position of every token in its document
+  // and the max_num_segments + 2 cumulative segment lengths, padded with sample_len_. Packing
+  // wastes the padding tails, so indices past the last packed sample wrap around.
+  template<typename T>
+  void GetPackedSample(size_t index, T pad_token_id, T* data, T* position_ids,
+                       int32_t* cu_seqlens) const;
+
  private:
   static const HashMap<char, size_t> kDTypeCode2Size;
 
+  std::string GetIndexCacheKey(const std::string& data_file_prefix,
+                               const std::vector<int64_t>& split_sizes, size_t split_index) const;
+  bool TryLoadIndexCache(const std::string& cache_file, const std::string& cache_key);
+  bool WaitForIndexCache(const std::string& cache_file, const std::string& cache_key);
+  void SaveIndexCache(const std::string& cache_file, const std::string& cache_key) const;
   size_t GetEpochNumTokens(const std::vector<size_t>& doc_indices) const;
   void InitDocIndices(const std::vector<size_t>& epoch_doc_indices, size_t num_epochs,
                       size_t num_complete_epochs);
@@ -96,9 +150,15 @@ class MegatronGPTMMapDataset final {
   size_t tokens_per_epoch_;
   size_t num_epochs_;
   size_t num_complete_epochs_;
-  std::vector<size_t> doc_indices_;
-  std::vector<std::pair<size_t, size_t>> sample_indices_;
-  std::vector<size_t> shuffle_indices_;
+  std::unique_ptr<const MappedBuffer> index_cache_;
+  MegatronGPTIndexArray<size_t> doc_indices_;
+  MegatronGPTIndexArray<std::pair<size_t, size_t>> sample_indices_;
+  MegatronGPTIndexArray<size_t> shuffle_indices_;
+
+  // initializing in InitPackedSamples
+  size_t max_num_segments_;
+  std::vector<MegatronGPTPackedSegment> packed_segments_;
+  std::vector<size_t> packed_sample_offsets_;
 };
 
 template<typename T>
@@ -129,6 +189,31 @@ void MegatronGPTMMapDataset::GetSample(size_t index, T* data) const {
   CHECK_EQ(remaining_tokens, 0);
 }
 
+template<typename T>
+void MegatronGPTMMapDataset::GetPackedSample(size_t index, T pad_token_id, T* data,
+                                             T* position_ids, int32_t* cu_seqlens) const {
+  CHECK_GT(num_packed_samples(), 0);
+  index %= num_packed_samples();
+  size_t num_tokens = 0;
+  size_t num_segments = 0;
+  cu_seqlens[0] = 0;
+  FOR_RANGE(size_t, i, packed_sample_offsets_[index], packed_sample_offsets_[index + 1]) {
+    const MegatronGPTPackedSegment& segment = packed_segments_[i];
+    size_t offset = index_->address(segment.doc_index) + segment.doc_offset * dtype_size_;
+    ReadTokens(data_->ptr(), offset, data + num_tokens, segment.length);
+    std::iota(position_ids + num_tokens, position_ids + num_tokens + segment.length, 0);
+    num_tokens += segment.length;
+    num_segments += 1;
+    cu_seqlens[num_segments] = num_tokens;
+  }
+  CHECK_LE(num_tokens, sample_len_);
+  CHECK_LE(num_segments, max_num_segments_);
+  std::fill(data + num_tokens, data + sample_len_, pad_token_id);
+  std::fill(position_ids + num_tokens, position_ids + sample_len_, 0);
+  // the padding tail forms a segment of its own
+  std::fill(cu_seqlens + num_segments + 1, cu_seqlens + max_num_segments_ + 2, sample_len_);
+}
+
 template<typename T>
 void MegatronGPTMMapDataset::ReadTokens(const void* src, size_t bytes_offset, T* dst,
                                         size_t size) const {
@@ -60,7 +60,7 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     // so it couldn't work in DDP for now. The If condition here could be removed when
     // OFRecordImageClassificationDataReader had supported DDP (add attr nd_sbp)
     // or been deprecated.
-    if (ctx->op_type_name() == "OFRecordReader") {
+    if (ctx->op_type_name() == "OFRecordReader" || ctx->op_type_name() == "flat_record_reader") {
       auto nd_sbp_str_vec = ctx->Attr<std::vector<std::string>>("nd_sbp");
       // NOTE(zwx): OFRecordDataset is not global since attr nd_sbp is empty,
       // we assume that it works in DDP
@@ -101,6 +101,90 @@ bool JpegPartialDecodeRandomCropImage(const unsigned char* data, size_t length,
   return true;
 }
 
+bool JpegPartialDecodeRandomCropScaledImage(const unsigned char* data, size_t length,
+                                            RandomCropGenerator* random_crop_gen, bool color,
+                                            int64_t target_height, int64_t target_width,
+                                            cv::Mat* out_mat) {
+  struct jpeg_decompress_struct compress_info {};
+  struct jpeg_error_mgr jpeg_err {};
+  compress_info.err = jpeg_std_error(&jpeg_err);
+  jpeg_create_decompress(&compress_info);
+  if (compress_info.err->msg_code != 0) { return false; }
+
+  LibjpegCtx ctx_guard(&compress_info);
+  struct jpeg_decompress_struct* info = ctx_guard.compress_info();
+
+  jpeg_mem_src(info, data, length);
+  if (info->err->msg_code != 0) { return false; }
+
+  int rc = jpeg_read_header(info, TRUE);
+  if (rc != JPEG_HEADER_OK) { return false; }
+
+  const int64_t width = info->image_width;
+  const int64_t height = info->image_height;
+  int64_t crop_x = 0, crop_y = 0, crop_w = width, crop_h = height;
+  if (random_crop_gen) {
+    CropWindow crop;
+    random_crop_gen->GenerateCropWindow({height, width}, &crop);
+    crop_y = crop.anchor.At(0);
+    crop_x = crop.anchor.At(1);
+    crop_h = crop.shape.At(0);
+    crop_w = crop.shape.At(1);
+  }
+
+  info->out_color_space = color ? JCS_RGB : JCS_GRAYSCALE;
+  unsigned int scale_num = 8;
+  if (target_height > 0 && target_width > 0) {
+    while (scale_num > 1 && crop_h * (scale_num - 1) >= target_height * 8
+           && crop_w * (scale_num - 1) >= target_width * 8) {
+      scale_num -= 1;
+    }
+  }
+  info->scale_num = scale_num;
+  info->scale_denom = 8;
+
+  jpeg_start_decompress(info);
+  const int64_t scaled_width = info->output_width;
+  const int64_t scaled_height = info->output_height;
+  const int pixel_size = info->output_components;
+
+  // map the crop window onto the downscaled image
+  const int64_t scaled_x0 = crop_x * scaled_width / width;
+  const int64_t scaled_y0 = crop_y * scaled_height / height;
+  const int64_t scaled_x1 =
+      std::min<int64_t>(scaled_width, RoundUp((crop_x + crop_w) * scaled_width, width) / width);
+  const int64_t scaled_y1 =
+      std::min<int64_t>(scaled_height, RoundUp((crop_y + crop_h) * scaled_height, height) / height);
+  unsigned int u_crop_x = scaled_x0;
+  unsigned int u_crop_y = scaled_y0;
+  unsigned int u_crop_w = std::max<int64_t>(scaled_x1 - scaled_x0, 1);
+  unsigned int u_crop_h = std::max<int64_t>(scaled_y1 - scaled_y0, 1);
+
+  unsigned int tmp_w = u_crop_w;
+  jpeg_crop_scanline(info, &u_crop_x, &tmp_w);
+  if (jpeg_skip_scanlines(info, u_crop_y) != u_crop_y) { return false; }
+
+  // jpeg_crop_scanline aligns the left edge of the window to an iMCU boundary
+  const int row_offset = (scaled_x0 - u_crop_x) * pixel_size;
+  const int out_row_stride = u_crop_w * pixel_size;
+  std::vector<unsigned char> decode_output_buf(tmp_w * pixel_size);
+  out_mat->create(u_crop_h, u_crop_w, CV_8UC(pixel_size));
+
+  while (info->output_scanline < u_crop_y + u_crop_h) {
+    unsigned char* buffer_array[1];
+    buffer_array[0] = decode_output_buf.data();
+    unsigned int read_line_index = info->output_scanline;
+    jpeg_read_scanlines(info, buffer_array, 1);
+    memcpy(out_mat->data + (read_line_index - u_crop_y) * out_row_stride,
+           decode_output_buf.data() + row_offset, out_row_stride);
+  }
+
+  jpeg_skip_scanlines(info, scaled_height - u_crop_y - u_crop_h);
+  jpeg_finish_decompress(info);
+
+  return true;
+}
+
 void OpenCvPartialDecodeRandomCropImage(const unsigned char* data, size_t length,
                                         RandomCropGenerator* random_crop_gen,
                                         const std::string& color_space, cv::Mat& out_mat) {
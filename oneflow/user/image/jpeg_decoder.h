@@ -27,6 +27,15 @@ bool JpegPartialDecodeRandomCropImage(const unsigned char* data, size_t length,
                                       unsigned char* workspace, size_t workspace_size,
                                       cv::Mat* out_mat);
 
+// Decodes the random crop window of a jpeg image into RGB (or gray when color is false). If the
+// crop window is larger than the target size, libjpeg downscales it in the DCT domain by the
+// smallest factor of n/8 that keeps it no smaller than the target, so that far fewer pixels are
+// decoded before the final resize. A non-positive target disables the downscaling.
+bool JpegPartialDecodeRandomCropScaledImage(const unsigned char* data, size_t length,
+                                            RandomCropGenerator* random_crop_gen, bool color,
+                                            int64_t target_height, int64_t target_width,
+                                            cv::Mat* out_mat);
+
 void OpenCvPartialDecodeRandomCropImage(const unsigned char* data, size_t length,
                                         RandomCropGenerator* random_crop_gen,
                                         const std::string& color_space, cv::Mat& out_mat);
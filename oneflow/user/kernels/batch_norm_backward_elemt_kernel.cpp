@@ -0,0 +1,94 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/batch_norm_cpu_kernel_util.h"
+
+namespace oneflow {
+
+template<typename T>
+class CpuBatchNormBackwardElemtKernel final : public user_op::OpKernel {
+ public:
+  CpuBatchNormBackwardElemtKernel() = default;
+  ~CpuBatchNormBackwardElemtKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* grad_out = ctx->Tensor4ArgNameAndIndex("grad_out", 0);
+    const user_op::Tensor* input = ctx->Tensor4ArgNameAndIndex("input", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* invstd = ctx->Tensor4ArgNameAndIndex("invstd", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* sum_dy = ctx->Tensor4ArgNameAndIndex("sum_dy", 0);
+    const user_op::Tensor* sum_dy_xmu = ctx->Tensor4ArgNameAndIndex("sum_dy_xmu", 0);
+    const user_op::Tensor* count = ctx->Tensor4ArgNameAndIndex("count", 0);
+
+    user_op::Tensor* grad_in = ctx->Tensor4ArgNameAndIndex("grad_in", 0);
+
+    const T* mean_ptr = mean->dptr<T>();
+    const T* invstd_ptr = invstd->dptr<T>();
+    const T* weight_ptr = weight->dptr<T>();
+    const T* sum_dy_ptr = sum_dy->dptr<T>();
+    const T* sum_dy_xmu_ptr = sum_dy_xmu->dptr<T>();
+    const int32_t* count_ptr = count->dptr<int32_t>();
+    const int32_t axis = ctx->Attr<int32_t>("axis");
+
+    int64_t total_count = 0;
+    for (int64_t i = 0; i < count->shape_view().elem_cnt(); ++i) { total_count += count_ptr[i]; }
+    const double norm_fct = 1.0 / total_count;
+
+    // NOTE: grad_in = (dy - mean_dy - (x - mean) * factor_1) * factor_2 expanded into
+    // dy * dy_scale + x * x_scale + shift
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(input->shape_view(), axis);
+    std::vector<T> dy_scale(layout.channel_size);
+    std::vector<T> x_scale(layout.channel_size);
+    std::vector<T> shift(layout.channel_size);
+    for (int64_t c = 0; c < layout.channel_size; ++c) {
+      const double invstd_c = invstd_ptr[c];
+      const double mean_dy = sum_dy_ptr[c] * norm_fct;
+      const double factor_1 = invstd_c * invstd_c * sum_dy_xmu_ptr[c] * norm_fct;
+      const double factor_2 = weight_ptr[c] * invstd_c;
+      dy_scale[c] = static_cast<T>(factor_2);
+      x_scale[c] = static_cast<T>(-factor_1 * factor_2);
+      shift[c] = static_cast<T>((mean_ptr[c] * factor_1 - mean_dy) * factor_2);
+    }
+    batch_norm_cpu::ChannelBackwardAffine(ctx->stream()->As<ep::CpuStream>(), layout,
+                                          grad_out->dptr<T>(), input->dptr<T>(), dy_scale.data(),
+                                          x_scale.data(), shift.data(), grad_in->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BATCH_NORM_BACKWARD_ELEMT_CPU_KERNEL(dtype)                                   \
+  REGISTER_USER_KERNEL("batch_norm_backward_elemt")                                            \
+      .SetCreateFn<CpuBatchNormBackwardElemtKernel<dtype>>()                                   \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                          \
+                       && (user_op::HobDataType("grad_out", 0) == GetDataType<dtype>::value)   \
+                       && (user_op::HobDataType("input", 0) == GetDataType<dtype>::value)      \
+                       && (user_op::HobDataType("mean", 0) == GetDataType<dtype>::value)       \
+                       && (user_op::HobDataType("invstd", 0) == GetDataType<dtype>::value)     \
+                       && (user_op::HobDataType("weight", 0) == GetDataType<dtype>::value)     \
+                       && (user_op::HobDataType("sum_dy", 0) == GetDataType<dtype>::value)     \
+                       && (user_op::HobDataType("sum_dy_xmu", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("count", 0) == GetDataType<int32_t>::value));
+
+REGISTER_BATCH_NORM_BACKWARD_ELEMT_CPU_KERNEL(float)
+REGISTER_BATCH_NORM_BACKWARD_ELEMT_CPU_KERNEL(double)
+
+#undef REGISTER_BATCH_NORM_BACKWARD_ELEMT_CPU_KERNEL
+
+}  // namespace oneflow
@@ -0,0 +1,79 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/batch_norm_cpu_kernel_util.h"
+
+namespace oneflow {
+
+template<typename T>
+class CpuBatchNormBackwardReduceKernel final : public user_op::OpKernel {
+ public:
+  CpuBatchNormBackwardReduceKernel() = default;
+  ~CpuBatchNormBackwardReduceKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* grad_out = ctx->Tensor4ArgNameAndIndex("grad_out", 0);
+    const user_op::Tensor* input = ctx->Tensor4ArgNameAndIndex("input", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* invstd = ctx->Tensor4ArgNameAndIndex("invstd", 0);
+
+    user_op::Tensor* sum_dy = ctx->Tensor4ArgNameAndIndex("sum_dy", 0);
+    user_op::Tensor* sum_dy_xmu = ctx->Tensor4ArgNameAndIndex("sum_dy_xmu", 0);
+    user_op::Tensor* grad_weight = ctx->Tensor4ArgNameAndIndex("grad_weight", 0);
+    user_op::Tensor* grad_bias = ctx->Tensor4ArgNameAndIndex("grad_bias", 0);
+
+    const T* invstd_ptr = invstd->dptr<T>();
+    T* sum_dy_ptr = sum_dy->mut_dptr<T>();
+    T* sum_dy_xmu_ptr = sum_dy_xmu->mut_dptr<T>();
+    T* grad_weight_ptr = grad_weight->mut_dptr<T>();
+    T* grad_bias_ptr = grad_bias->mut_dptr<T>();
+
+    const int32_t axis = ctx->Attr<int32_t>("axis");
+
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(input->shape_view(), axis);
+    std::vector<double> dy_sum(layout.channel_size);
+    std::vector<double> dy_xmu_sum(layout.channel_size);
+    batch_norm_cpu::ComputeGradSums(ctx->stream()->As<ep::CpuStream>(), layout,
+                                    grad_out->dptr<T>(), input->dptr<T>(), mean->dptr<T>(),
+                                    dy_sum.data(), dy_xmu_sum.data());
+    for (int64_t c = 0; c < layout.channel_size; ++c) {
+      sum_dy_ptr[c] = static_cast<T>(dy_sum[c]);
+      sum_dy_xmu_ptr[c] = static_cast<T>(dy_xmu_sum[c]);
+      grad_weight_ptr[c] = static_cast<T>(dy_xmu_sum[c] * invstd_ptr[c]);
+      grad_bias_ptr[c] = static_cast<T>(dy_sum[c]);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BATCH_NORM_BACKWARD_REDUCE_CPU_KERNEL(dtype)                                \
+  REGISTER_USER_KERNEL("batch_norm_backward_reduce")                                         \
+      .SetCreateFn<CpuBatchNormBackwardReduceKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                        \
+                       && (user_op::HobDataType("grad_out", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("input", 0) == GetDataType<dtype>::value)    \
+                       && (user_op::HobDataType("mean", 0) == GetDataType<dtype>::value)     \
+                       && (user_op::HobDataType("invstd", 0) == GetDataType<dtype>::value));
+
+REGISTER_BATCH_NORM_BACKWARD_REDUCE_CPU_KERNEL(float)
+REGISTER_BATCH_NORM_BACKWARD_REDUCE_CPU_KERNEL(double)
+
+#undef REGISTER_BATCH_NORM_BACKWARD_REDUCE_CPU_KERNEL
+
+}  // namespace oneflow
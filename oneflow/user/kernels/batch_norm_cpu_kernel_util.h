@@ -0,0 +1,323 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_BATCH_NORM_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_BATCH_NORM_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/cpu_device.h"
+
+namespace oneflow {
+
+namespace batch_norm_cpu {
+
+// Number of elements handled by one task of ParallelFor
+constexpr int64_t kParallelGrainSize = 32768;
+// Elements reduced at once before they are merged into the running moments, small enough to stay
+// in L1 so the two passes over a chunk read memory only once
+constexpr int64_t kChunkElemCnt = 2048;
+
+// A tensor normalized along axis viewed as [outer_size, channel_size, inner_size], NCHW has
+// inner_size = H * W and NHWC has inner_size = 1.
+struct Layout {
+  int64_t outer_size;
+  int64_t channel_size;
+  int64_t inner_size;
+};
+
+inline Layout MakeLayout(const ShapeView& shape, int32_t axis) {
+  CHECK_GE(axis, 0);
+  CHECK_LT(axis, shape.NumAxes());
+  return Layout{shape.Count(0, axis), shape.At(axis), shape.Count(axis + 1)};
+}
+
+inline int64_t GrainSize(int64_t elem_cnt_per_task) {
+  return std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(elem_cnt_per_task, 1));
+}
+
+// Mean and sum of squared deviations of count values, merged with the formula of Chan et al.
+struct Moments {
+  double mean;
+  double m2;
+  int64_t count;
+
+  void Merge(double other_mean, double other_m2, int64_t other_count) {
+    if (other_count == 0) { return; }
+    const int64_t total = count + other_count;
+    const double delta = other_mean - mean;
+    const double other_factor = static_cast<double>(other_count) / total;
+    mean += delta * other_factor;
+    m2 += other_m2 + delta * delta * count * other_factor;
+    count = total;
+  }
+};
+
+// Rows of the NHWC reduction handled by one task, every task keeps per channel partial results
+// which are merged at the end.
+inline int64_t NumRowParts(ep::CpuStream* stream, const Layout& layout) {
+  const int64_t rows_per_part = GrainSize(layout.channel_size);
+  const int64_t num_threads = stream->device()->GetNumThreads();
+  return std::max<int64_t>(1, std::min<int64_t>(num_threads, layout.outer_size / rows_per_part));
+}
+
+// Computes the mean and the biased variance of every channel with one read of x. Every chunk is
+// reduced to its mean and sum of squared deviations while it is in cache and merged Welford style,
+// which keeps the precision of the two pass algorithm.
+template<typename T>
+void ComputeMoments(ep::CpuStream* stream, const Layout& layout, const T* x, double* mean,
+                    double* var) {
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  if (inner_size > 1) {
+    stream->ParallelFor(
+        0, channel_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t c = begin; c < end; ++c) {
+            Moments moments{0, 0, 0};
+            for (int64_t o = 0; o < layout.outer_size; ++o) {
+              const T* row = x + (o * channel_size + c) * inner_size;
+              for (int64_t i = 0; i < inner_size; i += kChunkElemCnt) {
+                const int64_t n = std::min(kChunkElemCnt, inner_size - i);
+                double sum = 0;
+                for (int64_t j = 0; j < n; ++j) { sum += static_cast<double>(row[i + j]); }
+                const double chunk_mean = sum / n;
+                double m2 = 0;
+                for (int64_t j = 0; j < n; ++j) {
+                  const double d = static_cast<double>(row[i + j]) - chunk_mean;
+                  m2 += d * d;
+                }
+                moments.Merge(chunk_mean, m2, n);
+              }
+            }
+            mean[c] = moments.mean;
+            var[c] = moments.count > 0 ? moments.m2 / moments.count : 0;
+          }
+        },
+        GrainSize(layout.outer_size * inner_size));
+  } else {
+    const int64_t num_parts = NumRowParts(stream, layout);
+    const int64_t rows_per_chunk = std::max<int64_t>(1, kChunkElemCnt / channel_size);
+    std::vector<double> part_mean(num_parts * channel_size);
+    std::vector<double> part_m2(num_parts * channel_size);
+    std::vector<int64_t> part_count(num_parts);
+    stream->ParallelFor(
+        0, num_parts,
+        [&](int64_t begin, int64_t end) {
+          std::vector<double> sum(channel_size);
+          std::vector<double> m2(channel_size);
+          for (int64_t p = begin; p < end; ++p) {
+            double* moments_mean = part_mean.data() + p * channel_size;
+            double* moments_m2 = part_m2.data() + p * channel_size;
+            int64_t count = 0;
+            const int64_t row_begin = layout.outer_size * p / num_parts;
+            const int64_t row_end = layout.outer_size * (p + 1) / num_parts;
+            for (int64_t r = row_begin; r < row_end; r += rows_per_chunk) {
+              const int64_t n = std::min(rows_per_chunk, row_end - r);
+              const T* chunk = x + r * channel_size;
+              std::fill(sum.begin(), sum.end(), 0);
+              std::fill(m2.begin(), m2.end(), 0);
+              for (int64_t i = 0; i < n; ++i) {
+                for (int64_t c = 0; c < channel_size; ++c) {
+                  sum[c] += static_cast<double>(chunk[i * channel_size + c]);
+                }
+              }
+              for (int64_t c = 0; c < channel_size; ++c) { sum[c] /= n; }
+              for (int64_t i = 0; i < n; ++i) {
+                for (int64_t c = 0; c < channel_size; ++c) {
+                  const double d = static_cast<double>(chunk[i * channel_size + c]) - sum[c];
+                  m2[c] += d * d;
+                }
+              }
+              for (int64_t c = 0; c < channel_size; ++c) {
+                Moments moments{moments_mean[c], moments_m2[c], count};
+                moments.Merge(sum[c], m2[c], n);
+                moments_mean[c] = moments.mean;
+                moments_m2[c] = moments.m2;
+              }
+              count += n;
+            }
+            part_count[p] = count;
+          }
+        },
+        1);
+    for (int64_t c = 0; c < channel_size; ++c) {
+      Moments moments{0, 0, 0};
+      for (int64_t p = 0; p < num_parts; ++p) {
+        moments.Merge(part_mean[p * channel_size + c], part_m2[p * channel_size + c],
+                      part_count[p]);
+      }
+      mean[c] = moments.mean;
+      var[c] = moments.count > 0 ? moments.m2 / moments.count : 0;
+    }
+  }
+}
+
+// sum_dy[c] = sum(dy) and sum_dy_xmu[c] = sum(dy * (x - mean[c])) over every element of channel c,
+// both reduced in the same read of x and dy.
+template<typename T>
+void ComputeGradSums(ep::CpuStream* stream, const Layout& layout, const T* dy, const T* x,
+                     const T* mean, double* sum_dy, double* sum_dy_xmu) {
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  if (inner_size > 1) {
+    stream->ParallelFor(
+        0, channel_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t c = begin; c < end; ++c) {
+            const double mean_c = static_cast<double>(mean[c]);
+            double dy_sum = 0;
+            double dy_xmu_sum = 0;
+            for (int64_t o = 0; o < layout.outer_size; ++o) {
+              const int64_t offset = (o * channel_size + c) * inner_size;
+              for (int64_t i = 0; i < inner_size; ++i) {
+                const double dy_i = static_cast<double>(dy[offset + i]);
+                dy_sum += dy_i;
+                dy_xmu_sum += dy_i * (static_cast<double>(x[offset + i]) - mean_c);
+              }
+            }
+            sum_dy[c] = dy_sum;
+            sum_dy_xmu[c] = dy_xmu_sum;
+          }
+        },
+        GrainSize(layout.outer_size * inner_size));
+  } else {
+    const int64_t num_parts = NumRowParts(stream, layout);
+    std::vector<double> part_sum_dy(num_parts * channel_size, 0);
+    std::vector<double> part_sum_dy_xmu(num_parts * channel_size, 0);
+    stream->ParallelFor(
+        0, num_parts,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t p = begin; p < end; ++p) {
+            double* dy_sum = part_sum_dy.data() + p * channel_size;
+            double* dy_xmu_sum = part_sum_dy_xmu.data() + p * channel_size;
+            const int64_t row_begin = layout.outer_size * p / num_parts;
+            const int64_t row_end = layout.outer_size * (p + 1) / num_parts;
+            for (int64_t r = row_begin; r < row_end; ++r) {
+              const T* dy_row = dy + r * channel_size;
+              const T* x_row = x + r * channel_size;
+              for (int64_t c = 0; c < channel_size; ++c) {
+                const double dy_i = static_cast<double>(dy_row[c]);
+                dy_sum[c] += dy_i;
+                dy_xmu_sum[c] += dy_i * static_cast<double>(x_row[c] - mean[c]);
+              }
+            }
+          }
+        },
+        1);
+    for (int64_t c = 0; c < channel_size; ++c) {
+      double dy_sum = 0;
+      double dy_xmu_sum = 0;
+      for (int64_t p = 0; p < num_parts; ++p) {
+        dy_sum += part_sum_dy[p * channel_size + c];
+        dy_xmu_sum += part_sum_dy_xmu[p * channel_size + c];
+      }
+      sum_dy[c] = dy_sum;
+      sum_dy_xmu[c] = dy_xmu_sum;
+    }
+  }
+}
+
+// y = x * scale[c] + shift[c] (+ addend), the whole normalization folded into one multiply add per
+// element. addend may be nullptr and may alias y.
+template<typename T>
+void ChannelAffine(ep::CpuStream* stream, const Layout& layout, const T* x, const T* scale,
+                   const T* shift, const T* addend, T* y) {
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  if (inner_size > 1) {
+    stream->ParallelFor(
+        0, layout.outer_size * channel_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            const int64_t c = row % channel_size;
+            const T scale_c = scale[c];
+            const T shift_c = shift[c];
+            const int64_t offset = row * inner_size;
+            if (addend != nullptr) {
+              for (int64_t i = offset; i < offset + inner_size; ++i) {
+                y[i] = x[i] * scale_c + shift_c + addend[i];
+              }
+            } else {
+              for (int64_t i = offset; i < offset + inner_size; ++i) {
+                y[i] = x[i] * scale_c + shift_c;
+              }
+            }
+          }
+        },
+        GrainSize(inner_size));
+  } else {
+    stream->ParallelFor(
+        0, layout.outer_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            const int64_t offset = row * channel_size;
+            if (addend != nullptr) {
+              for (int64_t c = 0; c < channel_size; ++c) {
+                y[offset + c] = x[offset + c] * scale[c] + shift[c] + addend[offset + c];
+              }
+            } else {
+              for (int64_t c = 0; c < channel_size; ++c) {
+                y[offset + c] = x[offset + c] * scale[c] + shift[c];
+              }
+            }
+          }
+        },
+        GrainSize(channel_size));
+  }
+}
+
+// dx = dy * dy_scale[c] + x * x_scale[c] + shift[c], the input gradient of batch normalization
+// with its per channel terms folded into three coefficients.
+template<typename T>
+void ChannelBackwardAffine(ep::CpuStream* stream, const Layout& layout, const T* dy, const T* x,
+                           const T* dy_scale, const T* x_scale, const T* shift, T* dx) {
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  if (inner_size > 1) {
+    stream->ParallelFor(
+        0, layout.outer_size * channel_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            const int64_t c = row % channel_size;
+            const T dy_scale_c = dy_scale[c];
+            const T x_scale_c = x_scale[c];
+            const T shift_c = shift[c];
+            for (int64_t i = row * inner_size; i < (row + 1) * inner_size; ++i) {
+              dx[i] = dy[i] * dy_scale_c + x[i] * x_scale_c + shift_c;
+            }
+          }
+        },
+        GrainSize(inner_size));
+  } else {
+    stream->ParallelFor(
+        0, layout.outer_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            const int64_t offset = row * channel_size;
+            for (int64_t c = 0; c < channel_size; ++c) {
+              dx[offset + c] = dy[offset + c] * dy_scale[c] + x[offset + c] * x_scale[c] + shift[c];
+            }
+          }
+        },
+        GrainSize(channel_size));
+  }
+}
+
+}  // namespace batch_norm_cpu
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_BATCH_NORM_CPU_KERNEL_UTIL_H_
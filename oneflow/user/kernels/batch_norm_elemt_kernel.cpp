@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/batch_norm_cpu_kernel_util.h"
+
+namespace oneflow {
+
+template<typename T>
+class CpuBatchNormElemtKernel final : public user_op::OpKernel {
+ public:
+  CpuBatchNormElemtKernel() = default;
+  ~CpuBatchNormElemtKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input = ctx->Tensor4ArgNameAndIndex("input", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* invstd = ctx->Tensor4ArgNameAndIndex("invstd", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* output = ctx->Tensor4ArgNameAndIndex("output", 0);
+
+    const T* mean_ptr = mean->dptr<T>();
+    const T* invstd_ptr = invstd->dptr<T>();
+    const T* weight_ptr = weight->dptr<T>();
+    const T* bias_ptr = bias->dptr<T>();
+    const int32_t axis = ctx->Attr<int32_t>("axis");
+
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(input->shape_view(), axis);
+    std::vector<T> scale(layout.channel_size);
+    std::vector<T> shift(layout.channel_size);
+    for (int64_t c = 0; c < layout.channel_size; ++c) {
+      scale[c] = weight_ptr[c] * invstd_ptr[c];
+      shift[c] = bias_ptr[c] - mean_ptr[c] * scale[c];
+    }
+    batch_norm_cpu::ChannelAffine<T>(ctx->stream()->As<ep::CpuStream>(), layout,
+                                     input->dptr<T>(), scale.data(), shift.data(), nullptr,
+                                     output->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BATCH_NORM_ELEMT_CPU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("batch_norm_elemt")                                                 \
+      .SetCreateFn<CpuBatchNormElemtKernel<dtype>>()                                       \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                      \
+                       && (user_op::HobDataType("input", 0) == GetDataType<dtype>::value)  \
+                       && (user_op::HobDataType("mean", 0) == GetDataType<dtype>::value)   \
+                       && (user_op::HobDataType("invstd", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("weight", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("bias", 0) == GetDataType<dtype>::value));
+
+REGISTER_BATCH_NORM_ELEMT_CPU_KERNEL(float)
+REGISTER_BATCH_NORM_ELEMT_CPU_KERNEL(double)
+
+#undef REGISTER_BATCH_NORM_ELEMT_CPU_KERNEL
+
+}  // namespace oneflow
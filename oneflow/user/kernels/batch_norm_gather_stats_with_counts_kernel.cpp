@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+template<typename T>
+class CpuBatchNormGatherStatsWithCountsKernel final : public user_op::OpKernel {
+ public:
+  CpuBatchNormGatherStatsWithCountsKernel() = default;
+  ~CpuBatchNormGatherStatsWithCountsKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* invstd = ctx->Tensor4ArgNameAndIndex("invstd", 0);
+    const user_op::Tensor* counts = ctx->Tensor4ArgNameAndIndex("counts", 0);
+    user_op::Tensor* global_mean = ctx->Tensor4ArgNameAndIndex("global_mean", 0);
+    user_op::Tensor* global_invstd = ctx->Tensor4ArgNameAndIndex("global_invstd", 0);
+
+    const T* mean_ptr = mean->dptr<T>();
+    const T* invstd_ptr = invstd->dptr<T>();
+    const T* counts_ptr = counts->dptr<T>();
+    T* global_mean_ptr = global_mean->mut_dptr<T>();
+    T* global_invstd_ptr = global_invstd->mut_dptr<T>();
+    T* running_mean_ptr = nullptr;
+    T* running_var_ptr = nullptr;
+    if (ctx->has_input("running_mean", 0)) {
+      CHECK(ctx->has_input("running_var", 0));
+      running_mean_ptr = ctx->Tensor4ArgNameAndIndex("running_mean", 0)->mut_dptr<T>();
+      running_var_ptr = ctx->Tensor4ArgNameAndIndex("running_var", 0)->mut_dptr<T>();
+    }
+
+    const double eps = ctx->Attr<float>("eps");
+    const double momentum = ctx->Attr<float>("momentum");
+
+    const int64_t world_size = mean->shape_view().At(0);
+    const int64_t channel_size = mean->shape_view().At(1);
+
+    // NOTE: merge the statistics of every rank with the parallel variance formula, the same
+    // recurrence as the cuda kernel
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, channel_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            double avg = 0;
+            double var_n = 0;
+            double n = 0;
+            for (int64_t j = 0; j < world_size; ++j) {
+              const double count = counts_ptr[j];
+              const double m = mean_ptr[j * channel_size + i];
+              double v = 1.0 / invstd_ptr[j * channel_size + i];
+              v = (v * v - eps) * count;
+              const double factor = 1.0 / (n + count);
+              var_n += v + (avg - m) * (avg - m) * n * count * factor;
+              avg = n * factor * avg + count * factor * m;
+              n += count;
+            }
+            global_mean_ptr[i] = static_cast<T>(avg);
+            global_invstd_ptr[i] = static_cast<T>(1.0 / std::sqrt(var_n / n + eps));
+            if (running_mean_ptr != nullptr) {
+              running_mean_ptr[i] =
+                  static_cast<T>((1 - momentum) * running_mean_ptr[i] + momentum * avg);
+              running_var_ptr[i] =
+                  static_cast<T>((1 - momentum) * running_var_ptr[i] + momentum * var_n / (n - 1));
+            }
+          }
+        },
+        1024);
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BATCH_NORM_GATHER_STATS_WITH_COUNTS_CPU_KERNEL(dtype)                     \
+  REGISTER_USER_KERNEL("batch_norm_gather_stats_with_counts")                              \
+      .SetCreateFn<CpuBatchNormGatherStatsWithCountsKernel<dtype>>()                       \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                      \
+                       && (user_op::HobDataType("input", 0) == GetDataType<dtype>::value)  \
+                       && (user_op::HobDataType("mean", 0) == GetDataType<dtype>::value)   \
+                       && (user_op::HobDataType("invstd", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("counts", 0) == GetDataType<dtype>::value));
+
+REGISTER_BATCH_NORM_GATHER_STATS_WITH_COUNTS_CPU_KERNEL(float)
+REGISTER_BATCH_NORM_GATHER_STATS_WITH_COUNTS_CPU_KERNEL(double)
+
+#undef REGISTER_BATCH_NORM_GATHER_STATS_WITH_COUNTS_CPU_KERNEL
+
+}  // namespace oneflow
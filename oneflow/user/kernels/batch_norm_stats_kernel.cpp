@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/batch_norm_cpu_kernel_util.h"
+
+namespace oneflow {
+
+template<typename T>
+class CpuBatchNormStatsKernel final : public user_op::OpKernel {
+ public:
+  CpuBatchNormStatsKernel() = default;
+  ~CpuBatchNormStatsKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input = ctx->Tensor4ArgNameAndIndex("input", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* invstd = ctx->Tensor4ArgNameAndIndex("invstd", 0);
+
+    const int32_t axis = ctx->Attr<int32_t>("axis");
+    const float eps = ctx->Attr<float>("eps");
+
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(input->shape_view(), axis);
+    std::vector<double> batch_mean(layout.channel_size);
+    std::vector<double> batch_var(layout.channel_size);
+    batch_norm_cpu::ComputeMoments(ctx->stream()->As<ep::CpuStream>(), layout, input->dptr<T>(),
+                                   batch_mean.data(), batch_var.data());
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* invstd_ptr = invstd->mut_dptr<T>();
+    for (int64_t c = 0; c < layout.channel_size; ++c) {
+      mean_ptr[c] = static_cast<T>(batch_mean[c]);
+      // NOTE: same as the cuda kernel, a constant channel without eps gets invstd 0 instead of inf
+      invstd_ptr[c] = (batch_var[c] == 0 && eps == 0)
+                          ? static_cast<T>(0)
+                          : static_cast<T>(1.0 / std::sqrt(batch_var[c] + eps));
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BATCH_NORM_STATS_CPU_KERNEL(dtype)                   \
+  REGISTER_USER_KERNEL("batch_norm_stats")                            \
+      .SetCreateFn<CpuBatchNormStatsKernel<dtype>>()                  \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("input", 0) == GetDataType<dtype>::value));
+
+REGISTER_BATCH_NORM_STATS_CPU_KERNEL(float)
+REGISTER_BATCH_NORM_STATS_CPU_KERNEL(double)
+
+#undef REGISTER_BATCH_NORM_STATS_CPU_KERNEL
+
+}  // namespace oneflow
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/framework/transport_util.h"
+#include "oneflow/user/kernels/collective_communication/cpu/cpu_communication_context.h"
+#include "oneflow/user/kernels/collective_communication/include/all_to_all.h"
+#include "oneflow/user/kernels/collective_communication/cpu/cpu_collective_communication_util.h"
+
+namespace oneflow {
+
+namespace ccl {
+
+namespace {
+
+Maybe<void> AllToAllImpl(const void* send, const int64_t* send_counts, const int64_t* send_offsets,
+                         void* recv, const int64_t* recv_counts, const int64_t* recv_offsets,
+                         DataType dtype, Symbol<ParallelDesc> parallel_desc) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  const size_t size_of_dtype = GetSizeOfDataType(dtype);
+  const char* char_send = reinterpret_cast<const char*>(send);
+  char* char_recv = reinterpret_cast<char*>(recv);
+  const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
+  CHECK_OR_RETURN(opt_parallel_id->has_value()) << kOfBugIssueUploadPrompt;
+  const int64_t parallel_id = JUST(*opt_parallel_id);
+  CHECK_EQ_OR_RETURN(send_counts[parallel_id], recv_counts[parallel_id]);
+  std::memcpy(char_recv + recv_offsets[parallel_id] * size_of_dtype,
+              char_send + send_offsets[parallel_id] * size_of_dtype,
+              send_counts[parallel_id] * size_of_dtype);
+  if (parallel_num == 1) { return Maybe<void>::Ok(); }
+  TransportToken transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  // At step i every rank sends to the rank i after it and receives from the rank i before it,
+  // so all ranks are busy at every step and no pair of ranks waits on each other.
+  for (int64_t i = 1; i < parallel_num; ++i) {
+    const int64_t dst_id = (parallel_id + i) % parallel_num;
+    const int64_t src_id = (parallel_id - i + parallel_num) % parallel_num;
+    const void* send_ptr = char_send + send_offsets[dst_id] * size_of_dtype;
+    const size_t send_size = send_counts[dst_id] * size_of_dtype;
+    void* recv_ptr = char_recv + recv_offsets[src_id] * size_of_dtype;
+    const size_t recv_size = recv_counts[src_id] * size_of_dtype;
+    NaiveAsyncTransportCtx ctx(
+        transport_token,
+        [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
+          *buffer = const_cast<void*>(send_ptr);
+          *size = send_size;
+          *Cb = [] {};
+          return Maybe<void>::Ok();
+        },
+        [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
+          *buffer = recv_ptr;
+          *size = recv_size;
+          *Cb = [] {};
+          return Maybe<void>::Ok();
+        });
+    if (send_size > 0) {
+      JUST(TransportUtil::SendDataToRank(JUST(parallel_desc->MachineId4ParallelId(dst_id)),
+                                         transport_token, &ctx));
+    }
+    if (recv_size > 0) {
+      JUST(TransportUtil::ReceiveDataFromRank(JUST(parallel_desc->MachineId4ParallelId(src_id)),
+                                              transport_token, &ctx));
+    }
+    JUST(ctx.WaitDone());
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+class CpuAllToAll final : public AllToAll {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuAllToAll);
+  CpuAllToAll() : datatype_(kInvalidDataType) {}
+  ~CpuAllToAll() = default;
+
+  void Init(DataType datatype) override { this->datatype_ = datatype; }
+
+  void Launch(ep::Stream* stream, const void* send, const int64_t* send_counts,
+              const int64_t* send_offsets, void* recv, const int64_t* recv_counts,
+              const int64_t* recv_offsets,
+              const std::shared_ptr<CommunicationContext>& communication_ctx) const override {
+    const auto& cpu_communication_ctx =
+        std::dynamic_pointer_cast<CpuCommunicationContext>(communication_ctx);
+    CHECK(cpu_communication_ctx);
+    CHECK_JUST(AllToAllImpl(send, send_counts, send_offsets, recv, recv_counts, recv_offsets,
+                            datatype_, cpu_communication_ctx->parallel_desc()));
+  }
+
+ private:
+  DataType datatype_;
+};
+
+REGISTER_COLLECTIVE_COMMUNICATION(DeviceType::kCPU, AllToAll, CpuAllToAll);
+
+}  // namespace ccl
+
+}  // namespace oneflow
@@ -0,0 +1,471 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+
+#include <complex>
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/batch_matmul.h"
+#include "oneflow/user/kernels/pocketfft_hdronly.h"
+
+namespace oneflow {
+
+namespace conv_cpu {
+
+// Bytes of the transformed tiles of a Winograd convolution alive at once
+constexpr int64_t kWinogradWorkspaceSize = 16 * 1024 * 1024;
+// Largest size of the filter spectra an FFT convolution keeps plus the spectra of one sample
+constexpr int64_t kFftWorkspaceLimit = 256 * 1024 * 1024;
+
+// A 2d convolution whose tensors are addressed through the strides of the channel, row and column
+// of an image, so one implementation serves NCHW and NHWC. The samples of in and out are dense.
+struct Conv2dParams {
+  int64_t batch_size;
+  int64_t channels;
+  int64_t filters;
+  int64_t in_height;
+  int64_t in_width;
+  int64_t out_height;
+  int64_t out_width;
+  int64_t kernel_height;
+  int64_t kernel_width;
+  int64_t stride_h;
+  int64_t stride_w;
+  int64_t dilation_h;
+  int64_t dilation_w;
+  int64_t padding_h;
+  int64_t padding_w;
+  int64_t in_c_stride;
+  int64_t in_h_stride;
+  int64_t in_w_stride;
+  int64_t weight_c_stride;
+  int64_t weight_h_stride;
+  int64_t weight_w_stride;
+  int64_t out_c_stride;
+  int64_t out_h_stride;
+  int64_t out_w_stride;
+};
+
+inline Conv2dParams MakeConv2dParams(const ShapeView& in_shape, const ShapeView& weight_shape,
+                                     const ShapeView& out_shape,
+                                     const std::vector<int32_t>& strides,
+                                     const std::vector<int32_t>& dilation_rate,
+                                     const std::vector<int32_t>& padding_before,
+                                     bool channels_last) {
+  CHECK_EQ(in_shape.NumAxes(), 4);
+  const int64_t spatial_offset = channels_last ? 1 : 2;
+  const int64_t channel_axis = channels_last ? 3 : 1;
+  Conv2dParams params{};
+  params.batch_size = in_shape.At(0);
+  params.channels = in_shape.At(channel_axis);
+  params.filters = weight_shape.At(0);
+  params.in_height = in_shape.At(spatial_offset);
+  params.in_width = in_shape.At(spatial_offset + 1);
+  params.out_height = out_shape.At(spatial_offset);
+  params.out_width = out_shape.At(spatial_offset + 1);
+  params.kernel_height = weight_shape.At(spatial_offset);
+  params.kernel_width = weight_shape.At(spatial_offset + 1);
+  params.stride_h = strides.at(0);
+  params.stride_w = strides.at(1);
+  params.dilation_h = dilation_rate.at(0);
+  params.dilation_w = dilation_rate.at(1);
+  params.padding_h = padding_before.at(0);
+  params.padding_w = padding_before.at(1);
+  const auto SetStrides = [&](int64_t channels, int64_t height, int64_t width, int64_t* c_stride,
+                              int64_t* h_stride, int64_t* w_stride) {
+    if (channels_last) {
+      *c_stride = 1;
+      *h_stride = width * channels;
+      *w_stride = channels;
+    } else {
+      *c_stride = height * width;
+      *h_stride = width;
+      *w_stride = 1;
+    }
+  };
+  SetStrides(params.channels, params.in_height, params.in_width, &params.in_c_stride,
+             &params.in_h_stride, &params.in_w_stride);
+  SetStrides(params.channels, params.kernel_height, params.kernel_width, &params.weight_c_stride,
+             &params.weight_h_stride, &params.weight_w_stride);
+  SetStrides(params.filters, params.out_height, params.out_width, &params.out_c_stride,
+             &params.out_h_stride, &params.out_w_stride);
+  return params;
+}
+
+// Transforms of Winograd F(m x m, 3 x 3) from Lavin and Gray, "Fast Algorithms for Convolutional
+// Neural Networks": Y = AT * [(G * g * GT) .* (BT * d * B)] * A
+struct WinogradF2x3 {
+  static constexpr int64_t kTile = 2;
+  static constexpr int64_t kAlpha = 4;
+  static constexpr double kBT[kAlpha][kAlpha] = {
+      {1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}};
+  static constexpr double kG[kAlpha][3] = {
+      {1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}};
+  static constexpr double kAT[kTile][kAlpha] = {{1, 1, 1, 0}, {0, 1, -1, -1}};
+};
+
+struct WinogradF4x3 {
+  static constexpr int64_t kTile = 4;
+  static constexpr int64_t kAlpha = 6;
+  static constexpr double kBT[kAlpha][kAlpha] = {
+      {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+      {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+  static constexpr double kG[kAlpha][3] = {
+      {1.0 / 4, 0, 0},
+      {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+      {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+      {1.0 / 24, 1.0 / 12, 1.0 / 6},
+      {1.0 / 24, -1.0 / 12, 1.0 / 6},
+      {0, 0, 1}};
+  static constexpr double kAT[kTile][kAlpha] = {
+      {1, 1, 1, 1, 1, 0}, {0, 1, -1, 2, -2, 0}, {0, 1, 1, 4, 4, 0}, {0, 1, -1, 8, -8, 1}};
+};
+
+// out = l * x * lT
+template<typename T, int64_t R, int64_t K>
+void WinogradTransform(const double (&l)[R][K], const T (&x)[K][K], T (&out)[R][R]) {
+  T tmp[R][K];
+  for (int64_t i = 0; i < R; ++i) {
+    for (int64_t j = 0; j < K; ++j) {
+      T sum = 0;
+      for (int64_t k = 0; k < K; ++k) { sum += static_cast<T>(l[i][k]) * x[k][j]; }
+      tmp[i][j] = sum;
+    }
+  }
+  for (int64_t i = 0; i < R; ++i) {
+    for (int64_t j = 0; j < R; ++j) {
+      T sum = 0;
+      for (int64_t k = 0; k < K; ++k) { sum += tmp[i][k] * static_cast<T>(l[j][k]); }
+      out[i][j] = sum;
+    }
+  }
+}
+
+inline bool IsWinogradApplicable(const Conv2dParams& params) {
+  return params.kernel_height == 3 && params.kernel_width == 3 && params.stride_h == 1
+         && params.stride_w == 1 && params.dilation_h == 1 && params.dilation_w == 1;
+}
+
+// The filters are transformed to U[alpha * alpha][C][F] and the input tiles of a block of tiles to
+// V[alpha * alpha][tiles][C], so the element-wise products summed over the channels are
+// alpha * alpha independent GEMMs M[t] = V[t] * U[t]. U only depends on the weight, the caller
+// computes it with WinogradTransformWeight and may keep it while the weight is unchanged.
+template<typename Winograd>
+int64_t WinogradTransformedWeightSize(const Conv2dParams& p) {
+  return Winograd::kAlpha * Winograd::kAlpha * p.channels * p.filters;
+}
+
+template<typename T, typename Winograd>
+void WinogradTransformWeight(ep::CpuStream* stream, const Conv2dParams& p, const T* weight,
+                             T* transformed_weight) {
+  CHECK(IsWinogradApplicable(p));
+  constexpr int64_t kAlpha = Winograd::kAlpha;
+  constexpr int64_t kNumPoints = kAlpha * kAlpha;
+  stream->ParallelFor(0, p.filters, [&](int64_t begin, int64_t end) {
+    T g[3][3];
+    T u[kAlpha][kAlpha];
+    for (int64_t f = begin; f < end; ++f) {
+      const T* filter = weight + f * p.channels * 9;
+      for (int64_t c = 0; c < p.channels; ++c) {
+        for (int64_t kh = 0; kh < 3; ++kh) {
+          for (int64_t kw = 0; kw < 3; ++kw) {
+            g[kh][kw] = filter[c * p.weight_c_stride + kh * p.weight_h_stride
+                               + kw * p.weight_w_stride];
+          }
+        }
+        WinogradTransform(Winograd::kG, g, u);
+        for (int64_t t = 0; t < kNumPoints; ++t) {
+          transformed_weight[(t * p.channels + c) * p.filters + f] = u[t / kAlpha][t % kAlpha];
+        }
+      }
+    }
+  });
+}
+
+// Tiles transformed at once, V and M of a block take at most kWinogradWorkspaceSize bytes
+template<typename T, typename Winograd>
+int64_t WinogradBlockSize(const Conv2dParams& p) {
+  constexpr int64_t kTile = Winograd::kTile;
+  constexpr int64_t kNumPoints = Winograd::kAlpha * Winograd::kAlpha;
+  const int64_t num_tiles = p.batch_size * ((p.out_height + kTile - 1) / kTile)
+                            * ((p.out_width + kTile - 1) / kTile);
+  return std::min(num_tiles,
+                  std::max<int64_t>(1, kWinogradWorkspaceSize
+                                           / (kNumPoints * (p.channels + p.filters) * sizeof(T))));
+}
+
+template<typename T, typename Winograd>
+size_t WinogradConv2dWorkspaceSize(const Conv2dParams& p) {
+  constexpr int64_t kNumPoints = Winograd::kAlpha * Winograd::kAlpha;
+  return kNumPoints * WinogradBlockSize<T, Winograd>(p) * (p.channels + p.filters) * sizeof(T);
+}
+
+template<typename T, typename Winograd>
+void WinogradConv2d(ep::CpuStream* stream, const Conv2dParams& p, const T* in,
+                    const T* transformed_weight, const T* bias, bool accumulate, T* out,
+                    void* workspace) {
+  CHECK(IsWinogradApplicable(p));
+  constexpr int64_t kTile = Winograd::kTile;
+  constexpr int64_t kAlpha = Winograd::kAlpha;
+  constexpr int64_t kNumPoints = kAlpha * kAlpha;
+  const int64_t tiles_h = (p.out_height + kTile - 1) / kTile;
+  const int64_t tiles_w = (p.out_width + kTile - 1) / kTile;
+  const int64_t tiles_per_image = tiles_h * tiles_w;
+  const int64_t num_tiles = p.batch_size * tiles_per_image;
+  const int64_t in_image_size = p.channels * p.in_height * p.in_width;
+  const int64_t out_image_size = p.filters * p.out_height * p.out_width;
+
+  const int64_t block_size = WinogradBlockSize<T, Winograd>(p);
+  T* transformed_in = static_cast<T*>(workspace);
+  T* transformed_out = transformed_in + kNumPoints * block_size * p.channels;
+  auto batch_matmul = ep::primitive::NewPrimitive<ep::primitive::BatchMatmulFactory>(
+      DeviceType::kCPU, GetDataType<T>::value, ep::primitive::BlasTransposeType::N,
+      ep::primitive::BlasTransposeType::N);
+  CHECK(batch_matmul);
+  for (int64_t block_begin = 0; block_begin < num_tiles; block_begin += block_size) {
+    // the GEMMs of a block are packed densely, so the last block has a shorter batch stride
+    const int64_t num_block_tiles = std::min(block_size, num_tiles - block_begin);
+    const auto TileOrigin = [&](int64_t b, int64_t* n, int64_t* h, int64_t* w) {
+      const int64_t tile = block_begin + b;
+      *n = tile / tiles_per_image;
+      *h = (tile % tiles_per_image) / tiles_w * kTile;
+      *w = tile % tiles_w * kTile;
+    };
+    stream->ParallelFor(0, num_block_tiles, [&](int64_t begin, int64_t end) {
+      T d[kAlpha][kAlpha];
+      T v[kAlpha][kAlpha];
+      for (int64_t b = begin; b < end; ++b) {
+        int64_t n = 0;
+        int64_t oh = 0;
+        int64_t ow = 0;
+        TileOrigin(b, &n, &oh, &ow);
+        const T* image = in + n * in_image_size;
+        for (int64_t c = 0; c < p.channels; ++c) {
+          for (int64_t i = 0; i < kAlpha; ++i) {
+            const int64_t ih = oh - p.padding_h + i;
+            for (int64_t j = 0; j < kAlpha; ++j) {
+              const int64_t iw = ow - p.padding_w + j;
+              d[i][j] = (ih < 0 || ih >= p.in_height || iw < 0 || iw >= p.in_width)
+                            ? static_cast<T>(0)
+                            : image[c * p.in_c_stride + ih * p.in_h_stride + iw * p.in_w_stride];
+            }
+          }
+          WinogradTransform(Winograd::kBT, d, v);
+          for (int64_t t = 0; t < kNumPoints; ++t) {
+            transformed_in[(t * num_block_tiles + b) * p.channels + c] = v[t / kAlpha][t % kAlpha];
+          }
+        }
+      }
+    });
+    batch_matmul->Launch(stream, kNumPoints, num_block_tiles, p.filters, p.channels,
+                         static_cast<T>(1), transformed_in, transformed_weight, static_cast<T>(0),
+                         transformed_out);
+    stream->ParallelFor(0, num_block_tiles, [&](int64_t begin, int64_t end) {
+      T m[kAlpha][kAlpha];
+      T y[kTile][kTile];
+      for (int64_t b = begin; b < end; ++b) {
+        int64_t n = 0;
+        int64_t oh = 0;
+        int64_t ow = 0;
+        TileOrigin(b, &n, &oh, &ow);
+        T* image = out + n * out_image_size;
+        const int64_t valid_h = std::min(kTile, p.out_height - oh);
+        const int64_t valid_w = std::min(kTile, p.out_width - ow);
+        for (int64_t f = 0; f < p.filters; ++f) {
+          for (int64_t t = 0; t < kNumPoints; ++t) {
+            m[t / kAlpha][t % kAlpha] = transformed_out[(t * num_block_tiles + b) * p.filters + f];
+          }
+          WinogradTransform(Winograd::kAT, m, y);
+          const T bias_value = bias != nullptr ? bias[f] : static_cast<T>(0);
+          for (int64_t i = 0; i < valid_h; ++i) {
+            for (int64_t j = 0; j < valid_w; ++j) {
+              T* dst = image + f * p.out_c_stride + (oh + i) * p.out_h_stride
+                       + (ow + j) * p.out_w_stride;
+              const T value = y[i][j] + bias_value;
+              *dst = accumulate ? *dst + value : value;
+            }
+          }
+        }
+      }
+    });
+  }
+}
+
+// Length of the FFT along an axis, no output reads an input wrapped around by the circular
+// correlation and the length is rounded up to one pocketfft transforms fast
+inline int64_t FftLength(int64_t out_size, int64_t stride, int64_t kernel_size, int64_t dilation) {
+  return pocketfft::detail::util::good_size_real((out_size - 1) * stride
+                                                 + (kernel_size - 1) * dilation + 1);
+}
+
+// Points of the half spectrum of a plane
+inline int64_t FftSpectrumSize(const Conv2dParams& p) {
+  const int64_t length_h = FftLength(p.out_height, p.stride_h, p.kernel_height, p.dilation_h);
+  const int64_t length_w = FftLength(p.out_width, p.stride_w, p.kernel_width, p.dilation_w);
+  return length_h * (length_w / 2 + 1);
+}
+
+// The filter spectra W[F][C] as interleaved real and imaginary parts
+inline int64_t FftTransformedWeightSize(const Conv2dParams& p) {
+  return 2 * p.filters * p.channels * FftSpectrumSize(p);
+}
+
+// The input spectra X[C] of a sample
+template<typename T>
+size_t FftConv2dWorkspaceSize(const Conv2dParams& p) {
+  return p.channels * FftSpectrumSize(p) * sizeof(std::complex<T>);
+}
+
+template<typename T>
+bool IsFftApplicable(const Conv2dParams& p) {
+  return p.kernel_height * p.kernel_width > 1
+         && FftTransformedWeightSize(p) * sizeof(T) + FftConv2dWorkspaceSize<T>(p)
+                <= kFftWorkspaceLimit;
+}
+
+// Every dilated filter is zero padded to length_h x length_w and transformed to its spectrum W
+template<typename T>
+void FftTransformWeight(ep::CpuStream* stream, const Conv2dParams& p, const T* weight,
+                        T* transformed_weight) {
+  using Complex = std::complex<T>;
+  const int64_t length_h = FftLength(p.out_height, p.stride_h, p.kernel_height, p.dilation_h);
+  const int64_t length_w = FftLength(p.out_width, p.stride_w, p.kernel_width, p.dilation_w);
+  const int64_t plane_size = length_h * length_w;
+  const int64_t spectrum_width = length_w / 2 + 1;
+  const int64_t spectrum_size = length_h * spectrum_width;
+  const pocketfft::shape_t shape{static_cast<size_t>(length_h), static_cast<size_t>(length_w)};
+  const pocketfft::stride_t plane_stride{static_cast<ptrdiff_t>(length_w * sizeof(T)),
+                                         static_cast<ptrdiff_t>(sizeof(T))};
+  const pocketfft::stride_t spectrum_stride{
+      static_cast<ptrdiff_t>(spectrum_width * sizeof(Complex)),
+      static_cast<ptrdiff_t>(sizeof(Complex))};
+  const pocketfft::shape_t axes{0, 1};
+  const int64_t filter_size = p.channels * p.kernel_height * p.kernel_width;
+  Complex* weight_spectra = reinterpret_cast<Complex*>(transformed_weight);
+  stream->ParallelFor(
+      0, p.filters * p.channels,
+      [&](int64_t begin, int64_t end) {
+        std::vector<T> plane(plane_size);
+        for (int64_t i = begin; i < end; ++i) {
+          const T* filter =
+              weight + (i / p.channels) * filter_size + (i % p.channels) * p.weight_c_stride;
+          std::fill(plane.begin(), plane.end(), static_cast<T>(0));
+          for (int64_t kh = 0; kh < p.kernel_height; ++kh) {
+            for (int64_t kw = 0; kw < p.kernel_width; ++kw) {
+              plane[kh * p.dilation_h * length_w + kw * p.dilation_w] =
+                  filter[kh * p.weight_h_stride + kw * p.weight_w_stride];
+            }
+          }
+          pocketfft::r2c(shape, plane_stride, spectrum_stride, axes, pocketfft::FORWARD,
+                         plane.data(), weight_spectra + i * spectrum_size, static_cast<T>(1));
+        }
+      },
+      1);
+}
+
+// Every input plane is zero padded to length_h x length_w and transformed once, the correlation of
+// a filter with the input is the inverse transform of sum_c X[c] .* conj(W[c]) whose samples at the
+// strides are the output. W is computed by FftTransformWeight. The workspace holds X, a task of
+// ParallelFor still allocates the planes of the length_h x length_w transforms it runs.
+template<typename T>
+void FftConv2d(ep::CpuStream* stream, const Conv2dParams& p, const T* in,
+               const T* transformed_weight, const T* bias, bool accumulate, T* out,
+               void* workspace) {
+  using Complex = std::complex<T>;
+  const int64_t length_h = FftLength(p.out_height, p.stride_h, p.kernel_height, p.dilation_h);
+  const int64_t length_w = FftLength(p.out_width, p.stride_w, p.kernel_width, p.dilation_w);
+  const int64_t plane_size = length_h * length_w;
+  const int64_t spectrum_width = length_w / 2 + 1;
+  const int64_t spectrum_size = length_h * spectrum_width;
+  const pocketfft::shape_t shape{static_cast<size_t>(length_h), static_cast<size_t>(length_w)};
+  const pocketfft::stride_t plane_stride{static_cast<ptrdiff_t>(length_w * sizeof(T)),
+                                         static_cast<ptrdiff_t>(sizeof(T))};
+  const pocketfft::stride_t spectrum_stride{
+      static_cast<ptrdiff_t>(spectrum_width * sizeof(Complex)),
+      static_cast<ptrdiff_t>(sizeof(Complex))};
+  const pocketfft::shape_t axes{0, 1};
+  const int64_t in_image_size = p.channels * p.in_height * p.in_width;
+  const int64_t out_image_size = p.filters * p.out_height * p.out_width;
+  const Complex* weight_spectra = reinterpret_cast<const Complex*>(transformed_weight);
+  Complex* in_spectra = static_cast<Complex*>(workspace);
+
+  for (int64_t n = 0; n < p.batch_size; ++n) {
+    const T* in_image = in + n * in_image_size;
+    T* out_image = out + n * out_image_size;
+    stream->ParallelFor(
+        0, p.channels,
+        [&](int64_t begin, int64_t end) {
+          std::vector<T> plane(plane_size);
+          for (int64_t c = begin; c < end; ++c) {
+            std::fill(plane.begin(), plane.end(), static_cast<T>(0));
+            // rows and columns past the FFT length are never read by an output
+            const int64_t num_rows = std::min(p.in_height, length_h - p.padding_h);
+            const int64_t num_cols = std::min(p.in_width, length_w - p.padding_w);
+            for (int64_t ih = 0; ih < num_rows; ++ih) {
+              const T* src = in_image + c * p.in_c_stride + ih * p.in_h_stride;
+              T* dst = plane.data() + (ih + p.padding_h) * length_w + p.padding_w;
+              for (int64_t iw = 0; iw < num_cols; ++iw) { dst[iw] = src[iw * p.in_w_stride]; }
+            }
+            pocketfft::r2c(shape, plane_stride, spectrum_stride, axes, pocketfft::FORWARD,
+                           plane.data(), in_spectra + c * spectrum_size, static_cast<T>(1));
+          }
+        },
+        1);
+    stream->ParallelFor(
+        0, p.filters,
+        [&](int64_t begin, int64_t end) {
+          std::vector<T> real(spectrum_size);
+          std::vector<T> imag(spectrum_size);
+          std::vector<Complex> spectrum(spectrum_size);
+          std::vector<T> plane(plane_size);
+          for (int64_t f = begin; f < end; ++f) {
+            std::fill(real.begin(), real.end(), static_cast<T>(0));
+            std::fill(imag.begin(), imag.end(), static_cast<T>(0));
+            for (int64_t c = 0; c < p.channels; ++c) {
+              const T* x = reinterpret_cast<const T*>(in_spectra + c * spectrum_size);
+              const T* w =
+                  reinterpret_cast<const T*>(weight_spectra + (f * p.channels + c) * spectrum_size);
+              // x * conj(w) on the interleaved real and imaginary parts
+              for (int64_t q = 0; q < spectrum_size; ++q) {
+                real[q] += x[2 * q] * w[2 * q] + x[2 * q + 1] * w[2 * q + 1];
+                imag[q] += x[2 * q + 1] * w[2 * q] - x[2 * q] * w[2 * q + 1];
+              }
+            }
+            for (int64_t q = 0; q < spectrum_size; ++q) { spectrum[q] = Complex(real[q], imag[q]); }
+            pocketfft::c2r(shape, spectrum_stride, plane_stride, axes, pocketfft::BACKWARD,
+                           spectrum.data(), plane.data(), static_cast<T>(1.0 / plane_size));
+            const T bias_value = bias != nullptr ? bias[f] : static_cast<T>(0);
+            for (int64_t oh = 0; oh < p.out_height; ++oh) {
+              const T* src = plane.data() + oh * p.stride_h * length_w;
+              T* dst = out_image + f * p.out_c_stride + oh * p.out_h_stride;
+              for (int64_t ow = 0; ow < p.out_width; ++ow) {
+                const T value = src[ow * p.stride_w] + bias_value;
+                T* y = dst + ow * p.out_w_stride;
+                *y = accumulate ? *y + value : value;
+              }
+            }
+          }
+        },
+        1);
+  }
+}
+
+}  // namespace conv_cpu
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
@@ -13,11 +13,17 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <chrono>
+#include <cstring>
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/optional.h"
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/core/ep/include/primitive/add.h"
 #include "oneflow/core/ep/include/primitive/matmul.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
+#include "oneflow/user/kernels/cpu_conv_tuner.h"
 
 namespace oneflow {
 
@@ -418,6 +424,19 @@ struct ConvOpKernelCache final : public user_op::OpKernelCache {
 
   int32_t idx_offset_{};
   bool is_dynamic_{};
+
+  // Only set for the forward 2d convolution, whose algorithm is chosen by CpuConvTuner
+  conv_cpu::Conv2dParams conv2d_params_{};
+  std::string tuning_key_;
+  std::vector<CpuConvAlgorithm> algorithm_candidates_;
+  // Resolved by CpuConvTuner at the first compute, which may benchmark the candidates with the
+  // tensors, and reused until the cache is rebuilt for another shape
+  mutable Optional<CpuConvAlgorithm> algorithm_;
+  // The weight as the algorithm reads it, computed from a copy of the weight kept alongside since a
+  // kernel sees no version of its weight. See GetOrTransformWeight.
+  mutable CpuConvAlgorithm transformed_algorithm_ = CpuConvAlgorithm::kGemm;
+  mutable std::vector<T> transformed_from_weight_;
+  mutable std::vector<T> transformed_weight_;
 };
 
 template<typename T>
@@ -480,6 +499,384 @@ void InitBiasMulBuf(T* dptr, int64_t num) {
   for (int64_t i = 0; i < num; ++i) { dptr[i] = 1; }
 }
 
+// Relative difference from the GEMM path above which the tuner rejects an algorithm
+constexpr double kCpuConvTuningTolerance = 1e-3;
+constexpr int32_t kCpuConvTuningIters = 3;
+
+// Output pixels and filters of the register tile of the NHWC convolution
+constexpr int64_t kNhwcConvTilePixels = 8;
+constexpr int64_t kNhwcConvTileFilters = 64;
+// Multiply adds handled by one task of ParallelFor
+constexpr int64_t kNhwcConvParallelGrainSize = 1 << 20;
+
+bool IsNhwcConv2d(size_t ndims, const std::string& data_format) {
+  return ndims == 2 && data_format == "channels_last";
+}
+
+bool IsNhwcConv2dOneGemm(int64_t kernel_height, int64_t kernel_width, int32_t stride_h,
+                         int32_t stride_w, int32_t padding_h, int32_t padding_w) {
+  return kernel_height == 1 && kernel_width == 1 && stride_h == 1 && stride_w == 1
+         && padding_h == 0 && padding_w == 0;
+}
+
+// Returns the weight transformed for algorithm, which Transform writes to transformed_size
+// elements. The transform is kept in the cache and only computed again for another algorithm or
+// when the weight differs from the one it was computed from, so an inference job transforms its
+// weights once while a trained weight is transformed at every step.
+template<typename T>
+const T* GetOrTransformWeight(const ConvOpKernelCache<T>& cache, CpuConvAlgorithm algorithm,
+                              const T* weight, int64_t transformed_size,
+                              const std::function<void(T*)>& Transform) {
+  const int64_t weight_size = cache.weight_5d_shape_.elem_cnt();
+  const T* from_weight = cache.transformed_from_weight_.data();
+  if (cache.transformed_from_weight_.empty() || cache.transformed_algorithm_ != algorithm
+      || std::memcmp(from_weight, weight, weight_size * sizeof(T)) != 0) {
+    cache.transformed_algorithm_ = algorithm;
+    cache.transformed_from_weight_.assign(weight, weight + weight_size);
+    cache.transformed_weight_.resize(transformed_size);
+    Transform(cache.transformed_weight_.data());
+  }
+  return cache.transformed_weight_.data();
+}
+
+// out[n, oh, ow, :] (+)= bias + sum(in[n, ih, iw, :] * weight[:, kh, kw, :]) without a column
+// buffer. A 1x1 convolution with unit stride and no padding is one GEMM over all the samples, the
+// others are an implicit GEMM: every tile of kNhwcConvTilePixels x kNhwcConvTileFilters outputs
+// stays in registers while the input pixels are read directly from the NHWC input.
+template<typename T>
+void NhwcConv2d(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache, const T* in,
+                const T* weight, const T* bias, bool accumulate, T* out) {
+  const ShapeView in_shape(cache.in_5d_shape_);
+  const ShapeView weight_shape(cache.weight_5d_shape_);
+  const ShapeView out_shape(cache.out_5d_shape_);
+  const int64_t batch_size = in_shape.At(0);
+  const int64_t in_height = in_shape.At(2);
+  const int64_t in_width = in_shape.At(3);
+  const int64_t channels = in_shape.At(4);
+  const int64_t filters = weight_shape.At(0);
+  const int64_t kernel_height = weight_shape.At(2);
+  const int64_t kernel_width = weight_shape.At(3);
+  const int64_t out_height = out_shape.At(2);
+  const int64_t out_width = out_shape.At(3);
+  const int32_t stride_h = cache.strides_3d_.at(1);
+  const int32_t stride_w = cache.strides_3d_.at(2);
+  const int32_t dilation_h = cache.dilation_rate_3d_.at(1);
+  const int32_t dilation_w = cache.dilation_rate_3d_.at(2);
+  const int32_t padding_h = cache.padding_before_3d_.at(1);
+  const int32_t padding_w = cache.padding_before_3d_.at(2);
+  auto* stream = ctx->stream()->As<ep::CpuStream>();
+
+  if (IsNhwcConv2dOneGemm(kernel_height, kernel_width, stride_h, stride_w, padding_h, padding_w)) {
+    // out[N * H * W, F] = in[N * H * W, C] * weight[F, C]^T
+    const int64_t rows = batch_size * out_height * out_width;
+    auto matmul = NewMatmulPrimitive(DeviceType::kCPU, GetDataType<T>::value,
+                                     /*transpose_a=*/false, /*transpose_b=*/true);
+    CHECK(matmul);
+    matmul->Launch(stream, rows, filters, channels, static_cast<T>(1), in, weight,
+                   static_cast<T>(accumulate ? 1 : 0), out);
+    if (bias != nullptr) {
+      stream->ParallelFor(0, rows, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          T* out_row = out + row * filters;
+          for (int64_t f = 0; f < filters; ++f) { out_row[f] += bias[f]; }
+        }
+      });
+    }
+    return;
+  }
+
+  // weight [F, KH * KW * C] packed to [KH * KW * C, F] so the filters of a tile are contiguous
+  const int64_t reduce_size = kernel_height * kernel_width * channels;
+  const T* packed_weight = GetOrTransformWeight<T>(
+      cache, CpuConvAlgorithm::kGemm, weight, reduce_size * filters, [&](T* packed) {
+        stream->ParallelFor(0, filters, [&](int64_t begin, int64_t end) {
+          for (int64_t f = begin; f < end; ++f) {
+            for (int64_t k = 0; k < reduce_size; ++k) {
+              packed[k * filters + f] = weight[f * reduce_size + k];
+            }
+          }
+        });
+      });
+
+  const int64_t macs_per_row = out_width * filters * reduce_size;
+  const int64_t grain = std::max<int64_t>(1, kNhwcConvParallelGrainSize / macs_per_row);
+  stream->ParallelFor(
+      0, batch_size * out_height,
+      [&](int64_t begin, int64_t end) {
+        T acc[kNhwcConvTilePixels][kNhwcConvTileFilters];
+        const T* pixel_ptrs[kNhwcConvTilePixels];
+        int64_t pixel_idx[kNhwcConvTilePixels];
+        for (int64_t row = begin; row < end; ++row) {
+          const int64_t n = row / out_height;
+          const int64_t oh = row % out_height;
+          const T* in_img = in + n * in_height * in_width * channels;
+          T* out_row = out + row * out_width * filters;
+          for (int64_t ow0 = 0; ow0 < out_width; ow0 += kNhwcConvTilePixels) {
+            const int64_t num_pixels = std::min(kNhwcConvTilePixels, out_width - ow0);
+            for (int64_t f0 = 0; f0 < filters; f0 += kNhwcConvTileFilters) {
+              const int64_t num_filters = std::min(kNhwcConvTileFilters, filters - f0);
+              for (int64_t p = 0; p < num_pixels; ++p) {
+                std::fill(acc[p], acc[p] + num_filters, static_cast<T>(0));
+              }
+              for (int64_t kh = 0; kh < kernel_height; ++kh) {
+                const int64_t ih = oh * stride_h - padding_h + kh * dilation_h;
+                if (ih < 0 || ih >= in_height) { continue; }
+                for (int64_t kw = 0; kw < kernel_width; ++kw) {
+                  // pixels of the tile which read padding contribute nothing and are skipped
+                  int64_t num_valid = 0;
+                  for (int64_t p = 0; p < num_pixels; ++p) {
+                    const int64_t iw = (ow0 + p) * stride_w - padding_w + kw * dilation_w;
+                    if (iw < 0 || iw >= in_width) { continue; }
+                    pixel_ptrs[num_valid] = in_img + (ih * in_width + iw) * channels;
+                    pixel_idx[num_valid] = p;
+                    num_valid += 1;
+                  }
+                  const T* weight_tap =
+                      packed_weight + (kh * kernel_width + kw) * channels * filters + f0;
+                  for (int64_t c = 0; c < channels; ++c) {
+                    const T* weight_row = weight_tap + c * filters;
+                    for (int64_t v = 0; v < num_valid; ++v) {
+                      const T x = pixel_ptrs[v][c];
+                      T* acc_row = acc[pixel_idx[v]];
+                      for (int64_t f = 0; f < num_filters; ++f) { acc_row[f] += x * weight_row[f]; }
+                    }
+                  }
+                }
+              }
+              for (int64_t p = 0; p < num_pixels; ++p) {
+                T* out_tile = out_row + (ow0 + p) * filters + f0;
+                for (int64_t f = 0; f < num_filters; ++f) {
+                  T value = acc[p][f];
+                  if (bias != nullptr) { value += bias[f0 + f]; }
+                  out_tile[f] = accumulate ? out_tile[f] + value : value;
+                }
+              }
+            }
+          }
+        }
+      },
+      grain);
+}
+
+// im2col of every sample followed by a GEMM with the weight, the path of every layout and
+// dimension, whose column buffer is the tmp_buffer
+template<typename T>
+void Im2ColConv(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache, const T* in,
+                const T* weight, const T* bias, bool accumulate, T* out) {
+  user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+  T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
+
+  bool is_bias_mul_inited = false;
+
+  std::unique_ptr<ep::primitive::Matmul> matmul;
+  if (ctx->Attr<std::string>("data_format") == "channels_first") {
+    matmul = NewChannelsFirstMatmulPrimitive(ctx);
+  } else {
+    matmul = NewChannelsLastMatmulPrimitive(ctx);
+  }
+  CHECK(matmul);
+
+  const int64_t in_image_size = cache.in_5d_shape_.Count(1);
+  const int64_t out_image_size = cache.out_5d_shape_.Count(1);
+  for (int64_t i = 0; i < cache.in_5d_shape_.At(0); ++i) {
+    cache.im2col_func_(in + i * in_image_size, ShapeView(cache.in_5d_shape_),
+                       ShapeView(cache.weight_5d_shape_), ShapeView(cache.out_5d_shape_),
+                       cache.strides_3d_.data(), cache.dilation_rate_3d_.data(),
+                       cache.padding_before_3d_.data(), col_buf_dptr);
+
+    // channels first: out = weight * col_buf
+    // channels last:  out = (weight * col_buf)(T)
+    int32_t idx_offset = cache.idx_offset_;
+    matmul->Launch(ctx->stream(),
+                   cache.weight_5d_shape_.At(0),                           // filter
+                   cache.out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
+                   cache.weight_5d_shape_.Count(1),                        // ci * kd * kh * kw
+                   static_cast<T>(1), weight, col_buf_dptr, static_cast<T>(accumulate ? 1 : 0),
+                   out + i * out_image_size);
+
+    if (bias != nullptr) {
+      int64_t num_of_col_buf =
+          CalcElemNumOfColBuf(ctx->Tensor4ArgNameAndIndex("out", 0)->shape_view(),
+                              ctx->Tensor4ArgNameAndIndex("weight", 0)->shape_view(), idx_offset);
+      // the tmp_buffer may be larger for the other algorithms of a 2d convolution
+      const int64_t num_of_bias_mul = cache.out_5d_shape_.Count(idx_offset, idx_offset + 3);
+      CHECK_GE(static_cast<size_t>(tmp_buffer->shape_view().elem_cnt()),
+               (num_of_col_buf + num_of_bias_mul) * sizeof(T));
+      T* bias_mul_dptr = col_buf_dptr + num_of_col_buf;
+      if (!is_bias_mul_inited) {
+        InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
+        is_bias_mul_inited = true;
+      }
+
+      // channels first:  out += bias * bias_mul
+      // channels last:   out += (bias * bias_mul)(T)
+      matmul->Launch(ctx->stream(),
+                     cache.weight_5d_shape_.At(0),                           // filter
+                     cache.out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
+                     1,                                                      // 1
+                     static_cast<T>(1), bias, bias_mul_dptr, static_cast<T>(1),
+                     out + i * out_image_size);
+    }
+  }
+}
+
+// The Winograd and FFT algorithms keep the transformed inputs and outputs in the tmp_buffer, a 2d
+// convolution reserves the largest workspace of the algorithms it may be tuned to
+template<typename T>
+size_t InferConv2dAlgorithmsTmpSize(user_op::InferContext* ctx) {
+  const auto& in = ctx->InputTensorDesc("in", 0);
+  if (in.shape().NumAxes() != 4 || in.is_dynamic()) { return 0; }
+  const auto params = conv_cpu::MakeConv2dParams(
+      ShapeView(in.shape()), ShapeView(ctx->InputTensorDesc("weight", 0).shape()),
+      ShapeView(ctx->OutputTensorDesc("out", 0).shape()),
+      ctx->Attr<std::vector<int32_t>>("strides"), ctx->Attr<std::vector<int32_t>>("dilation_rate"),
+      ctx->Attr<std::vector<int32_t>>("padding_before"),
+      ctx->Attr<std::string>("data_format") == "channels_last");
+  size_t tmp_size = 0;
+  if (conv_cpu::IsWinogradApplicable(params)) {
+    tmp_size = std::max(conv_cpu::WinogradConv2dWorkspaceSize<T, conv_cpu::WinogradF2x3>(params),
+                        conv_cpu::WinogradConv2dWorkspaceSize<T, conv_cpu::WinogradF4x3>(params));
+  }
+  if (conv_cpu::IsFftApplicable<T>(params)) {
+    tmp_size = std::max(tmp_size, conv_cpu::FftConv2dWorkspaceSize<T>(params));
+  }
+  return tmp_size;
+}
+
+template<typename T, typename Winograd>
+void LaunchWinogradConv2d(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache,
+                          CpuConvAlgorithm algorithm, const T* in, const T* weight, const T* bias,
+                          bool accumulate, T* out) {
+  auto* stream = ctx->stream()->As<ep::CpuStream>();
+  const auto& params = cache.conv2d_params_;
+  user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+  const size_t workspace_size = conv_cpu::WinogradConv2dWorkspaceSize<T, Winograd>(params);
+  CHECK_GE(static_cast<size_t>(tmp_buffer->shape_view().elem_cnt()), workspace_size);
+  const T* transformed_weight = GetOrTransformWeight<T>(
+      cache, algorithm, weight, conv_cpu::WinogradTransformedWeightSize<Winograd>(params),
+      [&](T* transformed) {
+        conv_cpu::WinogradTransformWeight<T, Winograd>(stream, params, weight, transformed);
+      });
+  conv_cpu::WinogradConv2d<T, Winograd>(stream, params, in, transformed_weight, bias, accumulate,
+                                        out, tmp_buffer->mut_dptr());
+}
+
+template<typename T>
+void LaunchFftConv2d(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache,
+                     const T* in, const T* weight, const T* bias, bool accumulate, T* out) {
+  auto* stream = ctx->stream()->As<ep::CpuStream>();
+  const auto& params = cache.conv2d_params_;
+  user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+  CHECK_GE(static_cast<size_t>(tmp_buffer->shape_view().elem_cnt()),
+           conv_cpu::FftConv2dWorkspaceSize<T>(params));
+  const T* transformed_weight = GetOrTransformWeight<T>(
+      cache, CpuConvAlgorithm::kFft, weight, conv_cpu::FftTransformedWeightSize(params),
+      [&](T* transformed) {
+        conv_cpu::FftTransformWeight<T>(stream, params, weight, transformed);
+      });
+  conv_cpu::FftConv2d<T>(stream, params, in, transformed_weight, bias, accumulate, out,
+                         tmp_buffer->mut_dptr());
+}
+
+template<typename T>
+void LaunchConv(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache,
+                CpuConvAlgorithm algorithm, const T* in, const T* weight, const T* bias,
+                bool accumulate, T* out) {
+  switch (algorithm) {
+    case CpuConvAlgorithm::kGemm:
+      if (IsNhwcConv2d(ctx->Tensor4ArgNameAndIndex("in", 0)->shape_view().NumAxes() - 2,
+                       ctx->Attr<std::string>("data_format"))) {
+        NhwcConv2d<T>(ctx, cache, in, weight, bias, accumulate, out);
+      } else {
+        Im2ColConv<T>(ctx, cache, in, weight, bias, accumulate, out);
+      }
+      break;
+    case CpuConvAlgorithm::kWinogradF2x3:
+      LaunchWinogradConv2d<T, conv_cpu::WinogradF2x3>(ctx, cache, algorithm, in, weight, bias,
+                                                       accumulate, out);
+      break;
+    case CpuConvAlgorithm::kWinogradF4x3:
+      LaunchWinogradConv2d<T, conv_cpu::WinogradF4x3>(ctx, cache, algorithm, in, weight, bias,
+                                                       accumulate, out);
+      break;
+    case CpuConvAlgorithm::kFft:
+      LaunchFftConv2d<T>(ctx, cache, in, weight, bias, accumulate, out);
+      break;
+    default: UNIMPLEMENTED();
+  }
+}
+
+// Runs a candidate into result once to compare it with the reference, the output of the first
+// candidate, and then times it. The first run also transforms the weight, so the timed runs see
+// the unchanged weight of an inference job.
+template<typename T>
+double BenchmarkConv(user_op::KernelComputeContext* ctx, const ConvOpKernelCache<T>& cache,
+                     CpuConvAlgorithm algorithm, const T* in, const T* weight, const T* bias,
+                     std::vector<T>* reference, T* result) {
+  const int64_t elem_cnt = cache.out_5d_shape_.elem_cnt();
+  LaunchConv<T>(ctx, cache, algorithm, in, weight, bias, false, result);
+  CHECK_JUST(ctx->stream()->Sync());
+  if (reference->empty()) {
+    reference->assign(result, result + elem_cnt);
+  } else {
+    double max_abs = 1;
+    double max_diff = 0;
+    FOR_RANGE(int64_t, i, 0, elem_cnt) {
+      max_abs = std::max<double>(max_abs, std::abs(reference->at(i)));
+      max_diff = std::max<double>(max_diff, std::abs(reference->at(i) - result[i]));
+    }
+    if (max_diff > kCpuConvTuningTolerance * max_abs) {
+      LOG(WARNING) << CpuConvAlgorithmName(algorithm) << " is skipped for " << cache.tuning_key_
+                   << ", its max difference from the reference is " << max_diff;
+      return std::numeric_limits<double>::infinity();
+    }
+  }
+  double fastest_time = std::numeric_limits<double>::infinity();
+  FOR_RANGE(int32_t, i, 0, kCpuConvTuningIters) {
+    const auto start = std::chrono::steady_clock::now();
+    LaunchConv<T>(ctx, cache, algorithm, in, weight, bias, false, result);
+    CHECK_JUST(ctx->stream()->Sync());
+    fastest_time = std::min(
+        fastest_time,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return fastest_time;
+}
+
+// Sets the algorithms a 2d convolution may run with, the GEMM path comes first
+template<typename T>
+void InitConvTuning(user_op::KernelCacheContext* ctx, ConvOpKernelCache<T>* cache) {
+  const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();
+  const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+  const auto& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();
+  const auto& data_format = ctx->Attr<std::string>("data_format");
+  const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+  const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+  const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+  cache->algorithm_candidates_.emplace_back(CpuConvAlgorithm::kGemm);
+  if (in_shape.NumAxes() != 4 || cache->is_dynamic_) { return; }
+  cache->conv2d_params_ =
+      conv_cpu::MakeConv2dParams(ShapeView(in_shape), ShapeView(weight_shape), ShapeView(out_shape),
+                                 strides, dilation_rate, padding_before,
+                                 data_format == "channels_last");
+  if (conv_cpu::IsWinogradApplicable(cache->conv2d_params_)) {
+    cache->algorithm_candidates_.emplace_back(CpuConvAlgorithm::kWinogradF2x3);
+    cache->algorithm_candidates_.emplace_back(CpuConvAlgorithm::kWinogradF4x3);
+  }
+  if (conv_cpu::IsFftApplicable<T>(cache->conv2d_params_)) {
+    cache->algorithm_candidates_.emplace_back(CpuConvAlgorithm::kFft);
+  }
+  const auto ToString = [](const std::vector<int32_t>& vec) {
+    return Shape(DimVector(vec.begin(), vec.end())).ToString();
+  };
+  std::ostringstream key;
+  key << DataType_Name(GetDataType<T>::value) << ":" << data_format
+      << ":in=" << in_shape.ToString() << ":weight=" << weight_shape.ToString()
+      << ":strides=" << ToString(strides) << ":dilation_rate=" << ToString(dilation_rate)
+      << ":padding_before=" << ToString(padding_before);
+  cache->tuning_key_ = key.str();
+}
+
 template<typename T, size_t NDims>
 class ConvCpuKernel final : public user_op::OpKernel {
  public:
@@ -490,7 +887,9 @@ class ConvCpuKernel final : public user_op::OpKernel {
 
   std::shared_ptr<user_op::OpKernelCache> InitOpKernelCache(
       user_op::KernelCacheContext* ctx) const override {
-    return CreateConvOpKernelCache<T>(ctx, "in", "out", "weight");
+    auto cache = CreateConvOpKernelCache<T>(ctx, "in", "out", "weight");
+    InitConvTuning<T>(ctx, cache.get());
+    return cache;
   }
 
  private:
@@ -501,22 +900,8 @@ class ConvCpuKernel final : public user_op::OpKernel {
 
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
-    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
-    T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
-
-    bool is_bias_mul_inited = false;
-
-    const auto& data_format = ctx->Attr<std::string>("data_format");
-    std::unique_ptr<ep::primitive::Matmul> matmul;
-    if (data_format == "channels_first") {
-      matmul = NewChannelsFirstMatmulPrimitive(ctx);
-    } else {
-      matmul = NewChannelsLastMatmulPrimitive(ctx);
-    }
-    CHECK(matmul);
-
     float beta = 0;
     if (ctx->has_input("_add_to_output", 0)) {
       const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
@@ -528,46 +913,26 @@ class ConvCpuKernel final : public user_op::OpKernel {
       beta = 1;
     }
 
-    for (int64_t i = 0; i < in->shape_view().At(0); ++i) {
-      conv_cache->im2col_func_(GetImgDptr<T>(in, i), ShapeView(conv_cache->in_5d_shape_),
-                               ShapeView(conv_cache->weight_5d_shape_),
-                               ShapeView(conv_cache->out_5d_shape_), conv_cache->strides_3d_.data(),
-                               conv_cache->dilation_rate_3d_.data(),
-                               conv_cache->padding_before_3d_.data(), col_buf_dptr);
-
-      // channels first: out = weight * col_buf
-      // channels last:  out = (weight * col_buf)(T)
-      int32_t idx_offset = conv_cache->idx_offset_;
-      matmul->Launch(ctx->stream(),
-                     conv_cache->weight_5d_shape_.At(0),                           // filter
-                     conv_cache->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-                     conv_cache->weight_5d_shape_.Count(1),  // ci * kd * kh * kw
-                     static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, beta,
-                     GetImgMutDptr<T>(out, i));
-
-      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
-      if (bias != nullptr) {
-        int64_t num_of_col_buf =
-            CalcElemNumOfColBuf(out->shape_view(), weight->shape_view(), idx_offset);
-        int64_t num_of_bias_mul =
-            (tmp_buffer->shape_view().elem_cnt() - num_of_col_buf * sizeof(T)) / sizeof(T);
-        CHECK_GT(num_of_bias_mul, 0);
-        T* bias_mul_dptr = col_buf_dptr + num_of_col_buf;
-        if (!is_bias_mul_inited) {
-          InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
-          is_bias_mul_inited = true;
-        }
-
-        // channels first:  out += bias * bias_mul
-        // channels last:   out += (bias * bias_mul)(T)
-        matmul->Launch(ctx->stream(),
-                       conv_cache->weight_5d_shape_.At(0),                           // filter
-                       conv_cache->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-                       1,                                                            // 1
-                       static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr, static_cast<T>(1),
-                       GetImgMutDptr<T>(out, i));
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    const T* bias_dptr = bias != nullptr ? bias->dptr<T>() : nullptr;
+    if (!conv_cache->algorithm_.has_value()) {
+      CpuConvAlgorithm algorithm = CpuConvAlgorithm::kGemm;
+      if (conv_cache->algorithm_candidates_.size() > 1) {
+        // candidates write to a scratch output, so _add_to_output is not accumulated repeatedly
+        std::vector<T> reference;
+        std::vector<T> result;
+        const auto Benchmark = [&](CpuConvAlgorithm candidate) -> double {
+          result.resize(out->shape_view().elem_cnt());
+          return BenchmarkConv<T>(ctx, *conv_cache, candidate, in->dptr<T>(), weight->dptr<T>(),
+                                  bias_dptr, &reference, result.data());
+        };
+        algorithm = CpuConvTuner::Get().FindAlgorithm(
+            conv_cache->tuning_key_, conv_cache->algorithm_candidates_, Benchmark);
       }
+      conv_cache->algorithm_ = algorithm;
     }
+    LaunchConv<T>(ctx, *conv_cache, CHECK_JUST(conv_cache->algorithm_), in->dptr<T>(),
+                  weight->dptr<T>(), bias_dptr, beta != 0, out->mut_dptr<T>());
   }
 };
 
@@ -583,8 +948,11 @@ class ConvCpuKernel final : public user_op::OpKernel {
         size_t tmp_buffer_size = 0;                                                         \
         const auto& out_shape = ctx->OutputTensorDesc("out", 0).shape();                    \
         const auto& weight_shape = ctx->InputTensorDesc("weight", 0).shape();               \
-                                                                                            \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));              \
+        const auto& data_format = ctx->Attr<std::string>("data_format");                    \
+        if (IsNhwcConv2d(ndims, data_format)) {                                             \
+          return InferConv2dAlgorithmsTmpSize<dtype>(ctx);                                  \
+        }                                                                                   \
+        int64_t idx_offset = IdxOffset(data_format);                                        \
         tmp_buffer_size +=                                                                  \
             CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(dtype);       \
         bool has_bias = ctx->has_input("bias", 0);                                          \
@@ -593,7 +961,7 @@ class ConvCpuKernel final : public user_op::OpKernel {
           for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_shape.At(idx_offset + i); } \
           tmp_buffer_size += bias_mul_cnt * sizeof(dtype);                                  \
         }                                                                                   \
-        return tmp_buffer_size;                                                             \
+        return std::max(tmp_buffer_size, InferConv2dAlgorithmsTmpSize<dtype>(ctx));         \
       })                                                                                    \
       .SetInplaceProposalFn(                                                                \
           [](const user_op::InferContext& ctx,                                              \
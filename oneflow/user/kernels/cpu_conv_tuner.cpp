@@ -0,0 +1,142 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/cpu_conv_tuner.h"
+#include <fstream>
+
+namespace oneflow {
+
+namespace {
+
+constexpr CpuConvAlgorithm kCpuConvAlgorithms[] = {
+    CpuConvAlgorithm::kGemm, CpuConvAlgorithm::kWinogradF2x3, CpuConvAlgorithm::kWinogradF4x3,
+    CpuConvAlgorithm::kFft};
+
+}  // namespace
+
+const char* CpuConvAlgorithmName(CpuConvAlgorithm algorithm) {
+  switch (algorithm) {
+    case CpuConvAlgorithm::kGemm: return "gemm";
+    case CpuConvAlgorithm::kWinogradF2x3: return "winograd_f2x3";
+    case CpuConvAlgorithm::kWinogradF4x3: return "winograd_f4x3";
+    case CpuConvAlgorithm::kFft: return "fft";
+    default: UNIMPLEMENTED();
+  }
+  return nullptr;
+}
+
+struct CpuConvTuner::Impl {
+  std::mutex mutex;
+  HashMap<std::string, CpuConvAlgorithm> cache;
+  HashMap<std::string, CpuConvAlgorithm> resolved;
+  std::string cache_file;
+  bool enable_tuning;
+
+  void LoadCacheFile();
+  CpuConvAlgorithm FindAlgorithm(const std::string& key,
+                                 const std::vector<CpuConvAlgorithm>& candidates,
+                                 const std::function<double(CpuConvAlgorithm)>& Benchmark);
+  CpuConvAlgorithm FindAlgorithmWithoutRecord(
+      const std::string& key, const std::vector<CpuConvAlgorithm>& candidates,
+      const std::function<double(CpuConvAlgorithm)>& Benchmark);
+};
+
+void CpuConvTuner::Impl::LoadCacheFile() {
+  std::ifstream stream(cache_file);
+  if (!stream.is_open()) { return; }
+  std::string key;
+  std::string name;
+  while (stream >> key >> name) {
+    const auto* it = std::find_if(
+        std::begin(kCpuConvAlgorithms), std::end(kCpuConvAlgorithms),
+        [&](CpuConvAlgorithm algorithm) { return name == CpuConvAlgorithmName(algorithm); });
+    if (it == std::end(kCpuConvAlgorithms)) {
+      LOG(WARNING) << "unknown cpu conv algorithm " << name << " in " << cache_file;
+      continue;
+    }
+    // later lines override earlier ones
+    cache[key] = *it;
+  }
+}
+
+CpuConvAlgorithm CpuConvTuner::Impl::FindAlgorithm(
+    const std::string& key, const std::vector<CpuConvAlgorithm>& candidates,
+    const std::function<double(CpuConvAlgorithm)>& Benchmark) {
+  // benchmarks of concurrent kernels would disturb each other, so they run under the lock too
+  std::lock_guard<std::mutex> lock(mutex);
+  const CpuConvAlgorithm algorithm = FindAlgorithmWithoutRecord(key, candidates, Benchmark);
+  resolved[key] = algorithm;
+  return algorithm;
+}
+
+CpuConvAlgorithm CpuConvTuner::Impl::FindAlgorithmWithoutRecord(
+    const std::string& key, const std::vector<CpuConvAlgorithm>& candidates,
+    const std::function<double(CpuConvAlgorithm)>& Benchmark) {
+  CHECK(!candidates.empty());
+  const auto it = cache.find(key);
+  if (it != cache.end()
+      && std::find(candidates.begin(), candidates.end(), it->second) != candidates.end()) {
+    return it->second;
+  }
+  if (!enable_tuning || candidates.size() == 1) { return candidates.front(); }
+  CpuConvAlgorithm fastest = candidates.front();
+  double fastest_time = std::numeric_limits<double>::infinity();
+  for (CpuConvAlgorithm candidate : candidates) {
+    const double time = Benchmark(candidate);
+    VLOG(3) << key << " " << CpuConvAlgorithmName(candidate) << " " << time;
+    if (time < fastest_time) {
+      fastest = candidate;
+      fastest_time = time;
+    }
+  }
+  VLOG(3) << "Fastest: " << CpuConvAlgorithmName(fastest) << " " << fastest_time;
+  cache[key] = fastest;
+  if (!cache_file.empty()) {
+    std::ofstream stream(cache_file, std::ios::app);
+    if (stream.is_open()) {
+      stream << key << " " << CpuConvAlgorithmName(fastest) << "\n";
+    } else {
+      LOG(WARNING) << "failed to write cpu conv tuning cache file " << cache_file;
+    }
+  }
+  return fastest;
+}
+
+CpuConvTuner::CpuConvTuner() {
+  impl_.reset(new Impl());
+  impl_->cache_file = GetStringFromEnv("ONEFLOW_CPU_CONV_TUNING_CACHE_FILE", "");
+  impl_->enable_tuning = ParseBooleanFromEnv("ONEFLOW_CPU_CONV_ENABLE_TUNING", false);
+  if (!impl_->cache_file.empty()) { impl_->LoadCacheFile(); }
+}
+
+CpuConvAlgorithm CpuConvTuner::FindAlgorithm(
+    const std::string& key, const std::vector<CpuConvAlgorithm>& candidates,
+    const std::function<double(CpuConvAlgorithm)>& Benchmark) const {
+  return impl_->FindAlgorithm(key, candidates, Benchmark);
+}
+
+std::string CpuConvTuner::ResolvedAlgorithmName(const std::string& key) const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  const auto it = impl_->resolved.find(key);
+  if (it == impl_->resolved.end()) { return ""; }
+  return CpuConvAlgorithmName(it->second);
+}
+
+const CpuConvTuner& CpuConvTuner::Get() {
+  static CpuConvTuner instance;
+  return instance;
+}
+
+}  // namespace oneflow
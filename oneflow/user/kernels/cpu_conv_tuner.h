@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_CONV_TUNER_H_
+#define ONEFLOW_USER_KERNELS_CPU_CONV_TUNER_H_
+
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+enum class CpuConvAlgorithm {
+  kGemm = 0,
+  kWinogradF2x3 = 1,
+  kWinogradF4x3 = 2,
+  kFft = 3,
+};
+
+const char* CpuConvAlgorithmName(CpuConvAlgorithm algorithm);
+
+// Chooses the algorithm of a CPU convolution per problem. The choice of a key is taken from the
+// file ONEFLOW_CPU_CONV_TUNING_CACHE_FILE when it is there, so an algorithm can also be pinned by
+// writing "<key> <algorithm name>" lines to it. Otherwise the candidates are benchmarked once when
+// ONEFLOW_CPU_CONV_ENABLE_TUNING is set and the fastest is appended to the file, or the first
+// candidate is used.
+class CpuConvTuner {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuConvTuner);
+  ~CpuConvTuner() = default;
+
+  // Benchmark returns the seconds a candidate takes, or infinity to reject it. The candidates are
+  // benchmarked in order, so the first one may serve as the reference of the others.
+  CpuConvAlgorithm FindAlgorithm(const std::string& key,
+                                 const std::vector<CpuConvAlgorithm>& candidates,
+                                 const std::function<double(CpuConvAlgorithm)>& Benchmark) const;
+
+  // Name of the algorithm FindAlgorithm returned for the key, or "" if it has not been asked for
+  // the key, so that tests can check the choice without timing
+  std::string ResolvedAlgorithmName(const std::string& key) const;
+
+  static const CpuConvTuner& Get();
+
+ private:
+  CpuConvTuner();
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_CONV_TUNER_H_
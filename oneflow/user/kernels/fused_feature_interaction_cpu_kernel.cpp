@@ -0,0 +1,605 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/matmul.h"
+
+namespace oneflow {
+
+namespace {
+
+// Number of elements handled by one task of ParallelFor
+constexpr int64_t kParallelGrainSize = 32768;
+// Independent partial sums of a dot product, enough for one AVX-512 register of float
+constexpr int kDotLanes = 16;
+// Dot products of one row of the lower triangle computed together, the left operand is loaded
+// once for the whole block
+constexpr int kDotBlock = 4;
+// Rows of a tile of the cross interaction, the epilogue runs while the GEMM output is in cache
+constexpr int64_t kTileElemCnt = 128 * 1024;
+
+int64_t GrainSize(int64_t elem_cnt_per_task) {
+  return std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(elem_cnt_per_task, 1));
+}
+
+std::unique_ptr<ep::primitive::Matmul> NewMatmulPrimitive(DataType data_type, bool transpose_a,
+                                                          bool transpose_b) {
+  const auto trans_a =
+      transpose_a ? ep::primitive::BlasTransposeType::T : ep::primitive::BlasTransposeType::N;
+  const auto trans_b =
+      transpose_b ? ep::primitive::BlasTransposeType::T : ep::primitive::BlasTransposeType::N;
+  return ep::primitive::NewPrimitive<ep::primitive::MatmulFactory>(DeviceType::kCPU, data_type,
+                                                                   trans_a, trans_b);
+}
+
+// out[r] = dot(a, b[r]) for r < block. Every product goes to one of kDotLanes partial sums, so the
+// compiler vectorizes the loop without reassociating floating point additions.
+template<typename T, int block>
+void BlockDot(int64_t size, const T* a, const T* const* b, T* out) {
+  T acc[block][kDotLanes] = {};
+  int64_t k = 0;
+  for (; k + kDotLanes <= size; k += kDotLanes) {
+    for (int r = 0; r < block; ++r) {
+      for (int l = 0; l < kDotLanes; ++l) { acc[r][l] += a[k + l] * b[r][k + l]; }
+    }
+  }
+  for (int r = 0; r < block; ++r) {
+    T sum = 0;
+    for (int l = 0; l < kDotLanes; ++l) { sum += acc[r][l]; }
+    for (int64_t t = k; t < size; ++t) { sum += a[t] * b[r][t]; }
+    out[r] = sum;
+  }
+}
+
+// Offset of row i of the packed lower triangle, whose row i has i + offset elements
+inline int64_t TriangleRowOffset(int64_t i, int64_t offset) { return i * (i - 1 + 2 * offset) / 2; }
+
+inline const void* RawDptr(const user_op::Tensor* tensor) { return tensor->raw_dptr(); }
+inline void* RawDptr(user_op::Tensor* tensor) { return tensor->mut_raw_dptr(); }
+
+// Collects the pointers of the vectors of sample b from the (B, num_rows, vector_size) tensors
+template<typename T, typename Tensor>
+void GetSampleRows(const std::vector<Tensor*>& tensors, int64_t b, int64_t vector_size,
+                   std::vector<T*>* rows) {
+  rows->clear();
+  for (Tensor* tensor : tensors) {
+    const int64_t num_rows = tensor->shape_view().At(1);
+    T* base = reinterpret_cast<T*>(RawDptr(tensor)) + b * num_rows * vector_size;
+    for (int64_t f = 0; f < num_rows; ++f) { rows->push_back(base + f * vector_size); }
+  }
+}
+
+template<typename Tensor>
+std::vector<Tensor*> GetTensors(user_op::KernelComputeContext* ctx, const std::string& name,
+                                int32_t size) {
+  std::vector<Tensor*> tensors(size);
+  for (int32_t i = 0; i < size; ++i) { tensors[i] = ctx->Tensor4ArgNameAndIndex(name, i); }
+  return tensors;
+}
+
+int64_t GetFeaturesConcatedDim(user_op::KernelComputeContext* ctx) {
+  int64_t features_concated_dim = 0;
+  for (int32_t i = 0; i < ctx->input_size("features"); ++i) {
+    features_concated_dim += ctx->Tensor4ArgNameAndIndex("features", i)->shape_view().At(1);
+  }
+  return features_concated_dim;
+}
+
+/*
+The dot interaction computes only the packed lower triangle of the [F, F] matrix of every sample,
+writing it right after output_concat, so neither the full matrix nor the concatenated features
+are materialized.
+*/
+template<typename T>
+class FusedDotFeatureInteractionCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedDotFeatureInteractionCpuKernel() = default;
+  ~FusedDotFeatureInteractionCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->has_input("sparse_feature", 0)) << "sparse_feature is not supported. ";
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto features =
+        GetTensors<user_op::Tensor>(ctx, "features", ctx->input_size("features"));
+    const int64_t batch_size = out->shape_view().At(0);
+    const int64_t out_dim = out->shape_view().At(1);
+    const int64_t vector_size = features.at(0)->shape_view().At(2);
+    const int64_t num_rows = GetFeaturesConcatedDim(ctx);
+    const int64_t offset = ctx->Attr<bool>("self_interaction") ? 1 : 0;
+    const int64_t interaction_dim = TriangleRowOffset(num_rows, offset);
+    int64_t output_concat_dim = 0;
+    const T* output_concat_ptr = nullptr;
+    if (ctx->has_input("output_concat", 0)) {
+      const user_op::Tensor* output_concat = ctx->Tensor4ArgNameAndIndex("output_concat", 0);
+      output_concat_dim = output_concat->shape_view().At(1);
+      output_concat_ptr = output_concat->dptr<T>();
+    }
+    CHECK_EQ(out_dim - ctx->Attr<int32_t>("output_padding"), output_concat_dim + interaction_dim);
+    T* out_ptr = out->mut_dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          std::vector<T*> rows;
+          for (int64_t b = begin; b < end; ++b) {
+            GetSampleRows<T>(features, b, vector_size, &rows);
+            T* out_row = out_ptr + b * out_dim;
+            std::copy(output_concat_ptr + b * output_concat_dim,
+                      output_concat_ptr + (b + 1) * output_concat_dim, out_row);
+            T* interaction = out_row + output_concat_dim;
+            for (int64_t i = 0; i < num_rows; ++i) {
+              T* dst = interaction + TriangleRowOffset(i, offset);
+              const int64_t row_size = i + offset;
+              int64_t j = 0;
+              for (; j + kDotBlock <= row_size; j += kDotBlock) {
+                BlockDot<T, kDotBlock>(vector_size, rows[i], rows.data() + j, dst + j);
+              }
+              for (; j < row_size; ++j) {
+                BlockDot<T, 1>(vector_size, rows[i], rows.data() + j, dst + j);
+              }
+            }
+            std::fill(interaction + interaction_dim, out_row + out_dim, static_cast<T>(0));
+          }
+        },
+        GrainSize(interaction_dim * vector_size));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_DOT_FEATURE_INTERACTION_CPU_KERNEL(dtype)                        \
+  REGISTER_USER_KERNEL("fused_dot_feature_interaction")                                 \
+      .SetCreateFn<FusedDotFeatureInteractionCpuKernel<dtype>>()                        \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<std::string>("pooling") == "none"));
+
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_CPU_KERNEL(float)
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_CPU_KERNEL(double)
+
+// grad_i = sum_j dy(i, j) * f_j over the symmetric matrix whose lower triangle is dy, so every
+// element of the triangle contributes to the rows of both of its features.
+template<typename T>
+class FusedDotFeatureInteractionGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedDotFeatureInteractionGradCpuKernel() = default;
+  ~FusedDotFeatureInteractionGradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->has_input("sparse_feature", 0)) << "sparse_feature is not supported. ";
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto features =
+        GetTensors<const user_op::Tensor>(ctx, "features", ctx->input_size("features"));
+    const auto features_grad =
+        GetTensors<user_op::Tensor>(ctx, "features_grad", ctx->output_size("features_grad"));
+    const int64_t batch_size = dy->shape_view().At(0);
+    const int64_t dy_dim = dy->shape_view().At(1);
+    const int64_t vector_size = features.at(0)->shape_view().At(2);
+    const int64_t num_rows = GetFeaturesConcatedDim(ctx);
+    const int64_t offset = ctx->Attr<bool>("self_interaction") ? 1 : 0;
+    const int64_t interaction_dim = TriangleRowOffset(num_rows, offset);
+    int64_t output_concat_dim = 0;
+    T* output_concat_grad_ptr = nullptr;
+    if (ctx->has_output("output_concat_grad", 0)) {
+      user_op::Tensor* output_concat_grad = ctx->Tensor4ArgNameAndIndex("output_concat_grad", 0);
+      output_concat_dim = output_concat_grad->shape_view().At(1);
+      output_concat_grad_ptr = output_concat_grad->mut_dptr<T>();
+    }
+    const T* dy_ptr = dy->dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          std::vector<const T*> rows;
+          std::vector<T*> grad_rows;
+          for (int64_t b = begin; b < end; ++b) {
+            GetSampleRows<const T>(features, b, vector_size, &rows);
+            GetSampleRows<T>(features_grad, b, vector_size, &grad_rows);
+            const T* dy_row = dy_ptr + b * dy_dim;
+            std::copy(dy_row, dy_row + output_concat_dim,
+                      output_concat_grad_ptr + b * output_concat_dim);
+            const T* dy_interaction = dy_row + output_concat_dim;
+            for (T* grad_row : grad_rows) {
+              std::fill(grad_row, grad_row + vector_size, static_cast<T>(0));
+            }
+            for (int64_t i = 0; i < num_rows; ++i) {
+              const T* dy_i = dy_interaction + TriangleRowOffset(i, offset);
+              const T* f_i = rows[i];
+              T* grad_i = grad_rows[i];
+              for (int64_t j = 0; j < i; ++j) {
+                const T coef = dy_i[j];
+                const T* f_j = rows[j];
+                T* grad_j = grad_rows[j];
+                for (int64_t k = 0; k < vector_size; ++k) {
+                  grad_i[k] += coef * f_j[k];
+                  grad_j[k] += coef * f_i[k];
+                }
+              }
+              if (offset == 1) {
+                const T coef = static_cast<T>(2) * dy_i[i];
+                for (int64_t k = 0; k < vector_size; ++k) { grad_i[k] += coef * f_i[k]; }
+              }
+            }
+          }
+        },
+        GrainSize(interaction_dim * vector_size));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_DOT_FEATURE_INTERACTION_GRAD_CPU_KERNEL(dtype)                  \
+  REGISTER_USER_KERNEL("fused_dot_feature_interaction_grad")                           \
+      .SetCreateFn<FusedDotFeatureInteractionGradCpuKernel<dtype>>()                   \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                  \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<std::string>("pooling") == "none"));
+
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_GRAD_CPU_KERNEL(double)
+
+// out = 0.5 * ((sum_f x_f)^2 - sum_f x_f^2), the sum of all pairwise products of one element
+template<typename T>
+class FusedDotFeatureInteractionPoolingSumCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedDotFeatureInteractionPoolingSumCpuKernel() = default;
+  ~FusedDotFeatureInteractionPoolingSumCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->has_input("sparse_feature", 0)) << "pooling sum, sparse_feature is not supported. ";
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto features =
+        GetTensors<const user_op::Tensor>(ctx, "features", ctx->input_size("features"));
+    const int64_t batch_size = out->shape_view().At(0);
+    const int64_t vector_size = out->shape_view().At(1);
+    const int64_t num_rows = GetFeaturesConcatedDim(ctx);
+    T* out_ptr = out->mut_dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          std::vector<const T*> rows;
+          std::vector<T> square_sum(vector_size);
+          for (int64_t b = begin; b < end; ++b) {
+            GetSampleRows<const T>(features, b, vector_size, &rows);
+            T* sum = out_ptr + b * vector_size;
+            std::fill(sum, sum + vector_size, static_cast<T>(0));
+            std::fill(square_sum.begin(), square_sum.end(), static_cast<T>(0));
+            for (const T* row : rows) {
+              for (int64_t k = 0; k < vector_size; ++k) {
+                sum[k] += row[k];
+                square_sum[k] += row[k] * row[k];
+              }
+            }
+            for (int64_t k = 0; k < vector_size; ++k) {
+              sum[k] = (sum[k] * sum[k] - square_sum[k]) * static_cast<T>(0.5);
+            }
+          }
+        },
+        GrainSize(num_rows * vector_size));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_CPU_KERNEL(dtype)            \
+  REGISTER_USER_KERNEL("fused_dot_feature_interaction")                                 \
+      .SetCreateFn<FusedDotFeatureInteractionPoolingSumCpuKernel<dtype>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<std::string>("pooling") == "sum"));
+
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_CPU_KERNEL(float)
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_CPU_KERNEL(double)
+
+template<typename T>
+class FusedDotFeatureInteractionPoolingSumGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedDotFeatureInteractionPoolingSumGradCpuKernel() = default;
+  ~FusedDotFeatureInteractionPoolingSumGradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto features =
+        GetTensors<const user_op::Tensor>(ctx, "features", ctx->input_size("features"));
+    const auto features_grad =
+        GetTensors<user_op::Tensor>(ctx, "features_grad", ctx->output_size("features_grad"));
+    const int64_t batch_size = dy->shape_view().At(0);
+    const int64_t vector_size = dy->shape_view().At(1);
+    const int64_t num_rows = GetFeaturesConcatedDim(ctx);
+    const T* dy_ptr = dy->dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          std::vector<const T*> rows;
+          std::vector<T*> grad_rows;
+          std::vector<T> sum(vector_size);
+          for (int64_t b = begin; b < end; ++b) {
+            GetSampleRows<const T>(features, b, vector_size, &rows);
+            GetSampleRows<T>(features_grad, b, vector_size, &grad_rows);
+            const T* dy_row = dy_ptr + b * vector_size;
+            std::fill(sum.begin(), sum.end(), static_cast<T>(0));
+            for (const T* row : rows) {
+              for (int64_t k = 0; k < vector_size; ++k) { sum[k] += row[k]; }
+            }
+            for (int64_t f = 0; f < num_rows; ++f) {
+              for (int64_t k = 0; k < vector_size; ++k) {
+                grad_rows[f][k] = dy_row[k] * (sum[k] - rows[f][k]);
+              }
+            }
+          }
+        },
+        GrainSize(num_rows * vector_size));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_GRAD_CPU_KERNEL(dtype)      \
+  REGISTER_USER_KERNEL("fused_dot_feature_interaction_grad")                           \
+      .SetCreateFn<FusedDotFeatureInteractionPoolingSumGradCpuKernel<dtype>>()         \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                  \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<std::string>("pooling") == "sum"));
+
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_DOT_FEATURE_INTERACTION_POOLING_SUM_GRAD_CPU_KERNEL(double)
+
+// dst[j] = sum_i src[i, j] (* scale[i] when scale is not null), the columns are split between
+// threads so that every thread owns a slice of dst.
+template<typename T>
+void ColumnSum(ep::CpuStream* stream, int64_t rows, int64_t cols, const T* src, const T* scale,
+               T* dst) {
+  stream->ParallelFor(
+      0, cols,
+      [&](int64_t begin, int64_t end) {
+        std::fill(dst + begin, dst + end, static_cast<T>(0));
+        for (int64_t i = 0; i < rows; ++i) {
+          const T* src_row = src + i * cols;
+          const T s = scale == nullptr ? static_cast<T>(1) : scale[i];
+          for (int64_t j = begin; j < end; ++j) { dst[j] += s * src_row[j]; }
+        }
+      },
+      GrainSize(rows));
+}
+
+/*
+Cross interaction, x0 and x are (B, E):
+  vector: weight is (1, E), out = x0 * (x matmul weight^T) + bias + x
+  matrix: weight is (E, E), out = x0 * (x matmul weight^T + bias) + x
+The GEMM runs on tiles of rows and the elementwise part right after it on the same tile.
+*/
+template<typename T>
+class FusedCrossFeatureInteractionCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedCrossFeatureInteractionCpuKernel() = default;
+  ~FusedCrossFeatureInteractionCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* x0 = ctx->Tensor4ArgNameAndIndex("x0", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* matmul_result = ctx->Tensor4ArgNameAndIndex("matmul_result", 0);
+    const bool vector_mode = ctx->Attr<std::string>("interaction_mode") == "vector";
+    CHECK_EQ(out->shape_view().NumAxes(), 2);
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+
+    const int64_t batch_size = x->shape_view().At(0);
+    const int64_t k = x->shape_view().At(1);
+    const int64_t n = weight->shape_view().At(0);
+    const int64_t cols = out->shape_view().At(1);
+    CHECK_EQ(n, vector_mode ? 1 : cols);
+    const auto matmul = NewMatmulPrimitive(x->data_type(), /*transpose_a=*/false,
+                                           /*transpose_b=*/true);
+    CHECK(matmul);
+    const int64_t tile_rows = std::max<int64_t>(1, kTileElemCnt / std::max<int64_t>(cols, 1));
+    for (int64_t row_begin = 0; row_begin < batch_size; row_begin += tile_rows) {
+      const int64_t rows = std::min(tile_rows, batch_size - row_begin);
+      const T* x_ptr = x->dptr<T>() + row_begin * k;
+      const T* x0_ptr = x0->dptr<T>() + row_begin * cols;
+      const T* bias_ptr = bias->dptr<T>();
+      T* matmul_result_ptr = matmul_result->mut_dptr<T>() + row_begin * n;
+      T* out_ptr = out->mut_dptr<T>() + row_begin * cols;
+      matmul->Launch(stream, rows, n, k, 1.0, x_ptr, weight->dptr(), 0.0, matmul_result_ptr);
+      stream->ParallelFor(
+          0, rows,
+          [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              const T* x_row = x_ptr + i * cols;
+              const T* x0_row = x0_ptr + i * cols;
+              const T* mm_row = matmul_result_ptr + i * n;
+              T* out_row = out_ptr + i * cols;
+              if (vector_mode) {
+                const T mm = mm_row[0];
+                for (int64_t j = 0; j < cols; ++j) {
+                  out_row[j] = x0_row[j] * mm + bias_ptr[j] + x_row[j];
+                }
+              } else {
+                for (int64_t j = 0; j < cols; ++j) {
+                  out_row[j] = (mm_row[j] + bias_ptr[j]) * x0_row[j] + x_row[j];
+                }
+              }
+            }
+          },
+          GrainSize(cols));
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_CROSS_FEATURE_INTERACTION_CPU_KERNEL(dtype)    \
+  REGISTER_USER_KERNEL("fused_cross_feature_interaction")             \
+      .SetCreateFn<FusedCrossFeatureInteractionCpuKernel<dtype>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("x", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_CPU_KERNEL(float)
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_CPU_KERNEL(double)
+
+/*
+Vector mode grad, with dmm = rowsum(dy * x0) of shape (B, 1):
+  dx = dmm * weight + dy, dx0 = dy * matmul_result, dw = dmm^T matmul x, dbias = colsum(dy)
+*/
+template<typename T>
+class FusedCrossFeatureInteractionV1GradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedCrossFeatureInteractionV1GradCpuKernel() = default;
+  ~FusedCrossFeatureInteractionV1GradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* x0 = ctx->Tensor4ArgNameAndIndex("x0", 0);
+    const user_op::Tensor* matmul_result = ctx->Tensor4ArgNameAndIndex("matmul_result", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    user_op::Tensor* dw = ctx->Tensor4ArgNameAndIndex("dw", 0);
+    user_op::Tensor* dx0 = ctx->Tensor4ArgNameAndIndex("dx0", 0);
+    user_op::Tensor* dbias = ctx->Tensor4ArgNameAndIndex("dbias", 0);
+    T* dmm = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0)->mut_dptr<T>();
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+
+    const int64_t batch_size = dy->shape_view().At(0);
+    const int64_t cols = dy->shape_view().At(1);
+    const T* dy_ptr = dy->dptr<T>();
+    const T* weight_ptr = weight->dptr<T>();
+    const T* x0_ptr = x0->dptr<T>();
+    const T* mm_ptr = matmul_result->dptr<T>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    T* dx0_ptr = dx0->mut_dptr<T>();
+    stream->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            const T* dy_row = dy_ptr + i * cols;
+            const T* x0_row = x0_ptr + i * cols;
+            T sum = 0;
+            for (int64_t j = 0; j < cols; ++j) { sum += dy_row[j] * x0_row[j]; }
+            dmm[i] = sum;
+            const T mm = mm_ptr[i];
+            T* dx_row = dx_ptr + i * cols;
+            T* dx0_row = dx0_ptr + i * cols;
+            for (int64_t j = 0; j < cols; ++j) {
+              dx_row[j] = sum * weight_ptr[j] + dy_row[j];
+              dx0_row[j] = dy_row[j] * mm;
+            }
+          }
+        },
+        GrainSize(cols));
+    ColumnSum<T>(stream, batch_size, cols, dy_ptr, nullptr, dbias->mut_dptr<T>());
+    ColumnSum<T>(stream, batch_size, cols, x->dptr<T>(), dmm, dw->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V1_GRAD_CPU_KERNEL(dtype)              \
+  REGISTER_USER_KERNEL("fused_cross_feature_interaction_v1_grad")                       \
+      .SetCreateFn<FusedCrossFeatureInteractionV1GradCpuKernel<dtype>>()                \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                               \
+        return ctx->InputTensorDesc("dy", 0).shape().At(0) * sizeof(dtype);             \
+      });
+
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V1_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V1_GRAD_CPU_KERNEL(double)
+
+/*
+Matrix mode grad, with dmm = dy * x0 of shape (B, E):
+  dx = dmm matmul weight + dy, dx0 = (matmul_result + bias) * dy, dw = dmm^T matmul x,
+  dbias = colsum(dmm)
+*/
+template<typename T>
+class FusedCrossFeatureInteractionV2GradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedCrossFeatureInteractionV2GradCpuKernel() = default;
+  ~FusedCrossFeatureInteractionV2GradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* x0 = ctx->Tensor4ArgNameAndIndex("x0", 0);
+    const user_op::Tensor* matmul_result = ctx->Tensor4ArgNameAndIndex("matmul_result", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    user_op::Tensor* dw = ctx->Tensor4ArgNameAndIndex("dw", 0);
+    user_op::Tensor* dx0 = ctx->Tensor4ArgNameAndIndex("dx0", 0);
+    user_op::Tensor* dbias = ctx->Tensor4ArgNameAndIndex("dbias", 0);
+    T* dmm = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0)->mut_dptr<T>();
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+
+    const int64_t batch_size = dy->shape_view().At(0);
+    const int64_t cols = dy->shape_view().At(1);
+    const int64_t in_size = weight->shape_view().At(1);
+    const T* dy_ptr = dy->dptr<T>();
+    const T* bias_ptr = bias->dptr<T>();
+    const T* x0_ptr = x0->dptr<T>();
+    const T* mm_ptr = matmul_result->dptr<T>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    T* dx0_ptr = dx0->mut_dptr<T>();
+    stream->ParallelFor(
+        0, batch_size,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            const int64_t offset = i * cols;
+            for (int64_t j = 0; j < cols; ++j) {
+              const T dy_val = dy_ptr[offset + j];
+              dmm[offset + j] = dy_val * x0_ptr[offset + j];
+              dx0_ptr[offset + j] = (mm_ptr[offset + j] + bias_ptr[j]) * dy_val;
+              dx_ptr[offset + j] = dy_val;
+            }
+          }
+        },
+        GrainSize(cols));
+    const auto dx_matmul = NewMatmulPrimitive(dy->data_type(), /*transpose_a=*/false,
+                                              /*transpose_b=*/false);
+    CHECK(dx_matmul);
+    dx_matmul->Launch(stream, batch_size, in_size, cols, 1.0, dmm, weight->dptr(), 1.0, dx_ptr);
+    const auto dw_matmul = NewMatmulPrimitive(dy->data_type(), /*transpose_a=*/true,
+                                              /*transpose_b=*/false);
+    CHECK(dw_matmul);
+    dw_matmul->Launch(stream, cols, in_size, batch_size, 1.0, dmm, x->dptr(), 0.0,
+                      dw->mut_dptr());
+    ColumnSum<T>(stream, batch_size, cols, dmm, nullptr, dbias->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V2_GRAD_CPU_KERNEL(dtype)              \
+  REGISTER_USER_KERNEL("fused_cross_feature_interaction_v2_grad")                       \
+      .SetCreateFn<FusedCrossFeatureInteractionV2GradCpuKernel<dtype>>()                \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                               \
+        return ctx->InputTensorDesc("dy", 0).shape().elem_cnt() * sizeof(dtype);        \
+      });
+
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V2_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_CROSS_FEATURE_INTERACTION_V2_GRAD_CPU_KERNEL(double)
+
+}  // namespace
+
+}  // namespace oneflow
@@ -0,0 +1,248 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// Number of gate elements handled by one task of ParallelFor
+constexpr int64_t kParallelGrainSize = 32768;
+
+template<typename T>
+inline T Sigmoid(T x) {
+  return static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x));
+}
+
+// The rows of the gates are independent, so the batch is split between threads. The loops over
+// the hidden axis are branch free and walk contiguous memory so that the compiler vectorizes them.
+template<typename T, bool has_bias>
+void GruCellForwardRow(const int64_t hidden_size, const T* input_gates, const T* hidden_gates,
+                       const T* hx, const T* input_bias, const T* hidden_bias, T* hy,
+                       T* workspace) {
+  const int64_t h = hidden_size;
+  for (int64_t j = 0; j < h; ++j) {
+    T r = input_gates[j] + hidden_gates[j];
+    T i = input_gates[h + j] + hidden_gates[h + j];
+    T in = input_gates[2 * h + j];
+    T hn = hidden_gates[2 * h + j];
+    if (has_bias) {
+      r += input_bias[j] + hidden_bias[j];
+      i += input_bias[h + j] + hidden_bias[h + j];
+      in += input_bias[2 * h + j];
+      hn += hidden_bias[2 * h + j];
+    }
+    const T rg = Sigmoid(r);
+    const T ig = Sigmoid(i);
+    const T ng = std::tanh(in + rg * hn);
+    hy[j] = ng + ig * (hx[j] - ng);
+    // saved for backward
+    workspace[j] = rg;
+    workspace[h + j] = ig;
+    workspace[2 * h + j] = ng;
+    workspace[3 * h + j] = hx[j];
+    workspace[4 * h + j] = hn;
+  }
+}
+
+template<typename T, bool has_grad_hx>
+void GruCellBackwardRow(const int64_t hidden_size, const T* grad_hy, const T* workspace,
+                        T* grad_input_gates, T* grad_hidden_gates, T* grad_hx) {
+  const int64_t h = hidden_size;
+  const T one = static_cast<T>(1);
+  for (int64_t j = 0; j < h; ++j) {
+    const T rg = workspace[j];
+    const T ig = workspace[h + j];
+    const T ng = workspace[2 * h + j];
+    const T hx = workspace[3 * h + j];
+    const T hn = workspace[4 * h + j];
+    const T go = grad_hy[j];
+    const T gig = go * (hx - ng) * (one - ig) * ig;
+    const T gin = go * (one - ig) * (one - ng * ng);
+    const T grg = gin * hn * (one - rg) * rg;
+    grad_input_gates[j] = grg;
+    grad_input_gates[h + j] = gig;
+    grad_input_gates[2 * h + j] = gin;
+    grad_hidden_gates[j] = grg;
+    grad_hidden_gates[h + j] = gig;
+    grad_hidden_gates[2 * h + j] = gin * rg;
+    if (has_grad_hx) { grad_hx[j] = go * ig; }
+  }
+}
+
+template<typename T>
+void SumRows(ep::Stream* stream, const int64_t num_rows, const int64_t num_cols, const T* in,
+             T* out) {
+  // split the columns between threads, every thread accumulates its columns row by row
+  const int64_t grain_size =
+      std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(1, num_rows));
+  stream->As<ep::CpuStream>()->ParallelFor(
+      0, num_cols,
+      [&](int64_t begin, int64_t end) {
+        std::fill(out + begin, out + end, static_cast<T>(0));
+        for (int64_t row = 0; row < num_rows; ++row) {
+          const T* in_row = in + row * num_cols;
+          for (int64_t col = begin; col < end; ++col) { out[col] += in_row[col]; }
+        }
+      },
+      grain_size);
+}
+
+int64_t RowGrainSize(const int64_t hidden_size) {
+  return std::max<int64_t>(1, kParallelGrainSize / (5 * hidden_size));
+}
+
+}  // namespace
+
+template<typename T>
+class CpuFusedGruCellKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedGruCellKernel() = default;
+  ~CpuFusedGruCellKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input_gates = ctx->Tensor4ArgNameAndIndex("input_gates", 0);
+    const user_op::Tensor* hidden_gates = ctx->Tensor4ArgNameAndIndex("hidden_gates", 0);
+    const user_op::Tensor* hx = ctx->Tensor4ArgNameAndIndex("hx", 0);
+    user_op::Tensor* hy = ctx->Tensor4ArgNameAndIndex("hy", 0);
+    user_op::Tensor* workspace = ctx->Tensor4ArgNameAndIndex("workspace", 0);
+
+    const T* input_bias_ptr = nullptr;
+    const T* hidden_bias_ptr = nullptr;
+    if (ctx->has_input("input_bias", 0)) {
+      CHECK(ctx->has_input("hidden_bias", 0));
+      input_bias_ptr = ctx->Tensor4ArgNameAndIndex("input_bias", 0)->dptr<T>();
+      hidden_bias_ptr = ctx->Tensor4ArgNameAndIndex("hidden_bias", 0)->dptr<T>();
+    }
+    const T* input_gates_ptr = input_gates->dptr<T>();
+    const T* hidden_gates_ptr = hidden_gates->dptr<T>();
+    const T* hx_ptr = hx->dptr<T>();
+    T* hy_ptr = hy->mut_dptr<T>();
+    T* workspace_ptr = workspace->mut_dptr<T>();
+
+    const int64_t hidden_size = hx->shape_view().At(hx->shape_view().NumAxes() - 1);
+    if (hidden_size == 0) { return; }
+    const int64_t batch_size = hx->shape_view().elem_cnt() / hidden_size;
+    const int64_t gates_size = 3 * hidden_size;
+    const int64_t workspace_size = 5 * hidden_size;
+    const auto ForwardRows = [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; ++row) {
+        const int64_t gates_offset = row * gates_size;
+        const int64_t offset = row * hidden_size;
+        if (input_bias_ptr != nullptr) {
+          GruCellForwardRow<T, true>(hidden_size, input_gates_ptr + gates_offset,
+                                     hidden_gates_ptr + gates_offset, hx_ptr + offset,
+                                     input_bias_ptr, hidden_bias_ptr, hy_ptr + offset,
+                                     workspace_ptr + row * workspace_size);
+        } else {
+          GruCellForwardRow<T, false>(hidden_size, input_gates_ptr + gates_offset,
+                                      hidden_gates_ptr + gates_offset, hx_ptr + offset, nullptr,
+                                      nullptr, hy_ptr + offset,
+                                      workspace_ptr + row * workspace_size);
+        }
+      }
+    };
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(0, batch_size, ForwardRows,
+                                                    RowGrainSize(hidden_size));
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_GRU_CELL_KERNEL(dtype)                                               \
+  REGISTER_USER_KERNEL("fused_gru_cell")                                                        \
+      .SetCreateFn<CpuFusedGruCellKernel<dtype>>()                                              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                           \
+                       && (user_op::HobDataType("hx", 0) == GetDataType<dtype>::value)          \
+                       && (user_op::HobDataType("input_gates", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("hidden_gates", 0) == GetDataType<dtype>::value))
+
+REGISTER_CPU_FUSED_GRU_CELL_KERNEL(float);
+REGISTER_CPU_FUSED_GRU_CELL_KERNEL(double);
+
+template<typename T>
+class CpuFusedGruCellGradKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedGruCellGradKernel() = default;
+  ~CpuFusedGruCellGradKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* grad_hy = ctx->Tensor4ArgNameAndIndex("grad_hy", 0);
+    const user_op::Tensor* workspace = ctx->Tensor4ArgNameAndIndex("workspace", 0);
+    user_op::Tensor* grad_input_gates = ctx->Tensor4ArgNameAndIndex("grad_input_gates", 0);
+    user_op::Tensor* grad_hidden_gates = ctx->Tensor4ArgNameAndIndex("grad_hidden_gates", 0);
+
+    const T* grad_hy_ptr = grad_hy->dptr<T>();
+    const T* workspace_ptr = workspace->dptr<T>();
+    T* grad_input_gates_ptr = grad_input_gates->mut_dptr<T>();
+    T* grad_hidden_gates_ptr = grad_hidden_gates->mut_dptr<T>();
+    T* grad_hx_ptr = nullptr;
+    if (ctx->has_output("grad_hx", 0)) {
+      grad_hx_ptr = ctx->Tensor4ArgNameAndIndex("grad_hx", 0)->mut_dptr<T>();
+    }
+
+    const int64_t hidden_size = grad_hy->shape_view().At(grad_hy->shape_view().NumAxes() - 1);
+    if (hidden_size == 0) { return; }
+    const int64_t batch_size = grad_hy->shape_view().elem_cnt() / hidden_size;
+    const int64_t gates_size = 3 * hidden_size;
+    const int64_t workspace_size = 5 * hidden_size;
+    const auto BackwardRows = [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; ++row) {
+        const int64_t gates_offset = row * gates_size;
+        const int64_t offset = row * hidden_size;
+        if (grad_hx_ptr != nullptr) {
+          GruCellBackwardRow<T, true>(hidden_size, grad_hy_ptr + offset,
+                                      workspace_ptr + row * workspace_size,
+                                      grad_input_gates_ptr + gates_offset,
+                                      grad_hidden_gates_ptr + gates_offset, grad_hx_ptr + offset);
+        } else {
+          GruCellBackwardRow<T, false>(hidden_size, grad_hy_ptr + offset,
+                                       workspace_ptr + row * workspace_size,
+                                       grad_input_gates_ptr + gates_offset,
+                                       grad_hidden_gates_ptr + gates_offset, nullptr);
+        }
+      }
+    };
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(0, batch_size, BackwardRows,
+                                                    RowGrainSize(hidden_size));
+
+    if (ctx->has_output("grad_input_bias", 0) && ctx->has_output("grad_hidden_bias", 0)) {
+      SumRows<T>(ctx->stream(), batch_size, gates_size, grad_input_gates_ptr,
+                 ctx->Tensor4ArgNameAndIndex("grad_input_bias", 0)->mut_dptr<T>());
+      SumRows<T>(ctx->stream(), batch_size, gates_size, grad_hidden_gates_ptr,
+                 ctx->Tensor4ArgNameAndIndex("grad_hidden_bias", 0)->mut_dptr<T>());
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_GRU_CELL_GRAD_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("fused_gru_cell_grad")                                               \
+      .SetCreateFn<CpuFusedGruCellGradKernel<dtype>>()                                      \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                       \
+                       && (user_op::HobDataType("grad_hy", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("workspace", 0) == GetDataType<dtype>::value))
+
+REGISTER_CPU_FUSED_GRU_CELL_GRAD_KERNEL(float);
+REGISTER_CPU_FUSED_GRU_CELL_GRAD_KERNEL(double);
+
+}  // namespace oneflow
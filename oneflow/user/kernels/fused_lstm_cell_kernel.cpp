@@ -0,0 +1,250 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// Number of gate elements handled by one task of ParallelFor
+constexpr int64_t kParallelGrainSize = 32768;
+
+template<typename T>
+inline T Sigmoid(T x) {
+  return static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x));
+}
+
+// The rows of the gates are independent, so the batch is split between threads. The loops over
+// the hidden axis are branch free and walk contiguous memory so that the compiler vectorizes them.
+template<typename T, bool has_bias>
+void LstmCellForwardRow(const int64_t hidden_size, const T* input_gates, const T* hidden_gates,
+                        const T* cx, const T* input_bias, const T* hidden_bias, T* hy, T* cy,
+                        T* workspace) {
+  const int64_t h = hidden_size;
+  for (int64_t j = 0; j < h; ++j) {
+    T i = input_gates[j] + hidden_gates[j];
+    T f = input_gates[h + j] + hidden_gates[h + j];
+    T c = input_gates[2 * h + j] + hidden_gates[2 * h + j];
+    T o = input_gates[3 * h + j] + hidden_gates[3 * h + j];
+    if (has_bias) {
+      i += input_bias[j] + hidden_bias[j];
+      f += input_bias[h + j] + hidden_bias[h + j];
+      c += input_bias[2 * h + j] + hidden_bias[2 * h + j];
+      o += input_bias[3 * h + j] + hidden_bias[3 * h + j];
+    }
+    const T ig = Sigmoid(i);
+    const T fg = Sigmoid(f);
+    const T cg = std::tanh(c);
+    const T og = Sigmoid(o);
+    const T cy_j = fg * cx[j] + ig * cg;
+    cy[j] = cy_j;
+    hy[j] = og * std::tanh(cy_j);
+    // saved for backward
+    workspace[j] = ig;
+    workspace[h + j] = fg;
+    workspace[2 * h + j] = cg;
+    workspace[3 * h + j] = og;
+  }
+}
+
+template<typename T, bool has_grad_cx>
+void LstmCellBackwardRow(const int64_t hidden_size, const T* grad_hy, const T* grad_cy,
+                         const T* cx, const T* cy, const T* workspace, T* grad_gates, T* grad_cx) {
+  const int64_t h = hidden_size;
+  const T one = static_cast<T>(1);
+  for (int64_t j = 0; j < h; ++j) {
+    const T ig = workspace[j];
+    const T fg = workspace[h + j];
+    const T cg = workspace[2 * h + j];
+    const T og = workspace[3 * h + j];
+    const T tanh_cy = std::tanh(cy[j]);
+    const T gcx = grad_hy[j] * og * (one - tanh_cy * tanh_cy) + grad_cy[j];
+    grad_gates[j] = gcx * cg * (one - ig) * ig;
+    grad_gates[h + j] = gcx * cx[j] * (one - fg) * fg;
+    grad_gates[2 * h + j] = gcx * ig * (one - cg * cg);
+    grad_gates[3 * h + j] = grad_hy[j] * tanh_cy * (one - og) * og;
+    if (has_grad_cx) { grad_cx[j] = gcx * fg; }
+  }
+}
+
+template<typename T>
+void SumRows(ep::Stream* stream, const int64_t num_rows, const int64_t num_cols, const T* in,
+             T* out) {
+  // split the columns between threads, every thread accumulates its columns row by row
+  const int64_t grain_size =
+      std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(1, num_rows));
+  stream->As<ep::CpuStream>()->ParallelFor(
+      0, num_cols,
+      [&](int64_t begin, int64_t end) {
+        std::fill(out + begin, out + end, static_cast<T>(0));
+        for (int64_t row = 0; row < num_rows; ++row) {
+          const T* in_row = in + row * num_cols;
+          for (int64_t col = begin; col < end; ++col) { out[col] += in_row[col]; }
+        }
+      },
+      grain_size);
+}
+
+int64_t RowGrainSize(const int64_t hidden_size) {
+  return std::max<int64_t>(1, kParallelGrainSize / (4 * hidden_size));
+}
+
+}  // namespace
+
+template<typename T>
+class CpuFusedLstmCellKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedLstmCellKernel() = default;
+  ~CpuFusedLstmCellKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input_gates = ctx->Tensor4ArgNameAndIndex("input_gates", 0);
+    const user_op::Tensor* hidden_gates = ctx->Tensor4ArgNameAndIndex("hidden_gates", 0);
+    const user_op::Tensor* cx = ctx->Tensor4ArgNameAndIndex("cx", 0);
+    user_op::Tensor* hy = ctx->Tensor4ArgNameAndIndex("hy", 0);
+    user_op::Tensor* cy = ctx->Tensor4ArgNameAndIndex("cy", 0);
+    user_op::Tensor* workspace = ctx->Tensor4ArgNameAndIndex("workspace", 0);
+
+    const T* input_bias_ptr = nullptr;
+    const T* hidden_bias_ptr = nullptr;
+    if (ctx->has_input("input_bias", 0)) {
+      CHECK(ctx->has_input("hidden_bias", 0));
+      input_bias_ptr = ctx->Tensor4ArgNameAndIndex("input_bias", 0)->dptr<T>();
+      hidden_bias_ptr = ctx->Tensor4ArgNameAndIndex("hidden_bias", 0)->dptr<T>();
+    }
+    const T* input_gates_ptr = input_gates->dptr<T>();
+    const T* hidden_gates_ptr = hidden_gates->dptr<T>();
+    const T* cx_ptr = cx->dptr<T>();
+    T* hy_ptr = hy->mut_dptr<T>();
+    T* cy_ptr = cy->mut_dptr<T>();
+    T* workspace_ptr = workspace->mut_dptr<T>();
+
+    const int64_t hidden_size = cx->shape_view().At(cx->shape_view().NumAxes() - 1);
+    if (hidden_size == 0) { return; }
+    const int64_t batch_size = cx->shape_view().elem_cnt() / hidden_size;
+    const int64_t gates_size = 4 * hidden_size;
+    const auto ForwardRows = [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; ++row) {
+        const int64_t gates_offset = row * gates_size;
+        const int64_t offset = row * hidden_size;
+        if (input_bias_ptr != nullptr) {
+          LstmCellForwardRow<T, true>(hidden_size, input_gates_ptr + gates_offset,
+                                      hidden_gates_ptr + gates_offset, cx_ptr + offset,
+                                      input_bias_ptr, hidden_bias_ptr, hy_ptr + offset,
+                                      cy_ptr + offset, workspace_ptr + gates_offset);
+        } else {
+          LstmCellForwardRow<T, false>(hidden_size, input_gates_ptr + gates_offset,
+                                       hidden_gates_ptr + gates_offset, cx_ptr + offset, nullptr,
+                                       nullptr, hy_ptr + offset, cy_ptr + offset,
+                                       workspace_ptr + gates_offset);
+        }
+      }
+    };
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(0, batch_size, ForwardRows,
+                                                    RowGrainSize(hidden_size));
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_LSTM_CELL_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("fused_lstm_cell")                                                       \
+      .SetCreateFn<CpuFusedLstmCellKernel<dtype>>()                                             \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                           \
+                       && (user_op::HobDataType("cx", 0) == GetDataType<dtype>::value)          \
+                       && (user_op::HobDataType("input_gates", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("hidden_gates", 0) == GetDataType<dtype>::value))
+
+REGISTER_CPU_FUSED_LSTM_CELL_KERNEL(float);
+REGISTER_CPU_FUSED_LSTM_CELL_KERNEL(double);
+
+template<typename T>
+class CpuFusedLstmCellGradKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedLstmCellGradKernel() = default;
+  ~CpuFusedLstmCellGradKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* grad_hy = ctx->Tensor4ArgNameAndIndex("grad_hy", 0);
+    const user_op::Tensor* grad_cy = ctx->Tensor4ArgNameAndIndex("grad_cy", 0);
+    const user_op::Tensor* cx = ctx->Tensor4ArgNameAndIndex("cx", 0);
+    const user_op::Tensor* cy = ctx->Tensor4ArgNameAndIndex("cy", 0);
+    const user_op::Tensor* workspace = ctx->Tensor4ArgNameAndIndex("workspace", 0);
+    user_op::Tensor* grad_gates = ctx->Tensor4ArgNameAndIndex("grad_gates", 0);
+
+    const T* grad_hy_ptr = grad_hy->dptr<T>();
+    const T* grad_cy_ptr = grad_cy->dptr<T>();
+    const T* cx_ptr = cx->dptr<T>();
+    const T* cy_ptr = cy->dptr<T>();
+    const T* workspace_ptr = workspace->dptr<T>();
+    T* grad_gates_ptr = grad_gates->mut_dptr<T>();
+    T* grad_cx_ptr = nullptr;
+    if (ctx->has_output("grad_cx", 0)) {
+      grad_cx_ptr = ctx->Tensor4ArgNameAndIndex("grad_cx", 0)->mut_dptr<T>();
+    }
+
+    const int64_t hidden_size = cx->shape_view().At(cx->shape_view().NumAxes() - 1);
+    if (hidden_size == 0) { return; }
+    const int64_t batch_size = cx->shape_view().elem_cnt() / hidden_size;
+    const int64_t gates_size = 4 * hidden_size;
+    const auto BackwardRows = [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; ++row) {
+        const int64_t gates_offset = row * gates_size;
+        const int64_t offset = row * hidden_size;
+        if (grad_cx_ptr != nullptr) {
+          LstmCellBackwardRow<T, true>(hidden_size, grad_hy_ptr + offset, grad_cy_ptr + offset,
+                                       cx_ptr + offset, cy_ptr + offset,
+                                       workspace_ptr + gates_offset, grad_gates_ptr + gates_offset,
+                                       grad_cx_ptr + offset);
+        } else {
+          LstmCellBackwardRow<T, false>(hidden_size, grad_hy_ptr + offset, grad_cy_ptr + offset,
+                                        cx_ptr + offset, cy_ptr + offset,
+                                        workspace_ptr + gates_offset,
+                                        grad_gates_ptr + gates_offset, nullptr);
+        }
+      }
+    };
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(0, batch_size, BackwardRows,
+                                                    RowGrainSize(hidden_size));
+
+    if (ctx->has_output("grad_bias", 0)) {
+      SumRows<T>(ctx->stream(), batch_size, gates_size, grad_gates_ptr,
+                 ctx->Tensor4ArgNameAndIndex("grad_bias", 0)->mut_dptr<T>());
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_LSTM_CELL_GRAD_KERNEL(dtype)                                     \
+  REGISTER_USER_KERNEL("fused_lstm_cell_grad")                                              \
+      .SetCreateFn<CpuFusedLstmCellGradKernel<dtype>>()                                     \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                       \
+                       && (user_op::HobDataType("grad_hy", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("grad_cy", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("cx", 0) == GetDataType<dtype>::value)      \
+                       && (user_op::HobDataType("cy", 0) == GetDataType<dtype>::value)      \
+                       && (user_op::HobDataType("workspace", 0) == GetDataType<dtype>::value))
+
+REGISTER_CPU_FUSED_LSTM_CELL_GRAD_KERNEL(float);
+REGISTER_CPU_FUSED_LSTM_CELL_GRAD_KERNEL(double);
+
+}  // namespace oneflow
@@ -0,0 +1,412 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/matmul.h"
+#include "oneflow/user/kernels/dropout_kernel.h"
+#include "oneflow/user/kernels/random_seed_util.h"
+
+namespace oneflow {
+
+namespace {
+
+/*
+The activations are processed in tiles of rows. For every tile the bias is written first, the GEMM
+accumulates into it and the relu/dropout epilogue runs right after, while the tile is still in
+cache. The layers of a MLP are chained per tile, so the next layer reads its input from cache too.
+*/
+constexpr int64_t kTileElemCnt = 128 * 1024;
+constexpr int64_t kMinTileRows = 32;
+// Number of elements handled by one task of ParallelFor
+constexpr int64_t kParallelGrainSize = 32768;
+// The relu/dropout mask uses the cublasLt bit layout, one bit per element packed in int32.
+constexpr int64_t kMaskBits = 32;
+
+int64_t TileRows(int64_t max_cols) {
+  return std::max<int64_t>(kMinTileRows, kTileElemCnt / std::max<int64_t>(max_cols, 1));
+}
+
+int64_t GrainSize(int64_t elem_cnt_per_task) {
+  return std::max<int64_t>(1, kParallelGrainSize / std::max<int64_t>(elem_cnt_per_task, 1));
+}
+
+// a is (m, k) and b is (n, k) when transposed or (k, n) otherwise
+std::unique_ptr<ep::primitive::Matmul> NewMatmulPrimitive(
+    DataType data_type, ep::primitive::BlasTransposeType trans_b) {
+  return ep::primitive::NewPrimitive<ep::primitive::MatmulFactory>(
+      DeviceType::kCPU, data_type, ep::primitive::BlasTransposeType::N, trans_b);
+}
+
+// Counter based uniform random number in [0, 1), so the dropout mask does not depend on how the
+// rows are split between threads.
+inline float UniformAt(uint64_t seed, uint64_t index) {
+  uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return static_cast<float>(z >> 40) * (1.0f / 16777216.0f);
+}
+
+// y[i, :] = bias + beta * add_to_output[i, :], the GEMM then accumulates into y.
+template<typename T>
+void InitRowsWithBias(ep::CpuStream* stream, int64_t rows, int64_t cols, const T* bias, T beta,
+                      const T* add_to_output, T* y) {
+  stream->ParallelFor(
+      0, rows,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          T* y_row = y + i * cols;
+          if (add_to_output == nullptr) {
+            std::copy(bias, bias + cols, y_row);
+          } else {
+            const T* add_row = add_to_output + i * cols;
+            for (int64_t j = 0; j < cols; ++j) { y_row[j] = bias[j] + beta * add_row[j]; }
+          }
+        }
+      },
+      GrainSize(cols));
+}
+
+template<typename T, bool relu, bool dropout>
+void ReluDropoutRow(int64_t cols, int64_t mask_cols, float rate, T scale, uint64_t seed,
+                    uint64_t row, T* y, int32_t* mask) {
+  for (int64_t word = 0; word < mask_cols; ++word) {
+    const int64_t col_begin = word * kMaskBits;
+    const int64_t col_end = std::min(cols, col_begin + kMaskBits);
+    uint32_t bits = 0;
+    for (int64_t j = col_begin; j < col_end; ++j) {
+      bool keep = true;
+      if (relu) { keep = y[j] >= static_cast<T>(0); }
+      if (dropout) { keep = keep && UniformAt(seed, row * cols + j) >= rate; }
+      bits |= static_cast<uint32_t>(keep) << (j - col_begin);
+      y[j] = keep ? y[j] * scale : static_cast<T>(0);
+    }
+    mask[word] = static_cast<int32_t>(bits);
+  }
+}
+
+// Applies relu and/or dropout in place and writes the keep mask of every element, row_offset is
+// the index of the first row in the whole tensor.
+template<typename T>
+void ReluDropoutRows(ep::CpuStream* stream, int64_t rows, int64_t cols, int64_t mask_cols,
+                     bool relu, float rate, uint64_t seed, int64_t row_offset, T* y,
+                     int32_t* mask) {
+  T scale = static_cast<T>(1);
+  if (rate != 0.0f) { scale = rate < 1.0f ? static_cast<T>(1.0f / (1.0f - rate)) : 0; }
+  stream->ParallelFor(
+      0, rows,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const uint64_t row = row_offset + i;
+          if (rate == 0.0f) {
+            ReluDropoutRow<T, true, false>(cols, mask_cols, rate, scale, seed, row, y + i * cols,
+                                           mask + i * mask_cols);
+          } else if (relu) {
+            ReluDropoutRow<T, true, true>(cols, mask_cols, rate, scale, seed, row, y + i * cols,
+                                          mask + i * mask_cols);
+          } else {
+            ReluDropoutRow<T, false, true>(cols, mask_cols, rate, scale, seed, row, y + i * cols,
+                                           mask + i * mask_cols);
+          }
+        }
+      },
+      GrainSize(cols));
+}
+
+// Forward of cublas_fused_mlp and fused_matmul_bias_add_relu_dropout, rates is empty for the
+// former. The output of the last layer goes to out, the others to hidden.
+template<typename T>
+void FusedMLPForward(user_op::KernelComputeContext* ctx, const std::vector<float>& rates,
+                     const std::vector<uint64_t>& seeds) {
+  auto* stream = ctx->stream()->As<ep::CpuStream>();
+  const int32_t weight_size = ctx->input_size("weights");
+  const bool skip_final_activation = ctx->Attr<bool>("skip_final_activation");
+  const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+  const int64_t m = x->shape_view().At(0);
+  const int64_t in_cols = x->shape_view().At(1);
+  int64_t max_cols = in_cols;
+  for (int32_t idx = 0; idx < weight_size; ++idx) {
+    max_cols = std::max(max_cols, ctx->Tensor4ArgNameAndIndex("weights", idx)->shape_view().At(0));
+  }
+  const auto matmul = NewMatmulPrimitive(x->data_type(), ep::primitive::BlasTransposeType::T);
+  CHECK(matmul);
+  const int64_t tile_rows = TileRows(max_cols);
+  for (int64_t row_begin = 0; row_begin < m; row_begin += tile_rows) {
+    const int64_t rows = std::min(tile_rows, m - row_begin);
+    const T* in = x->dptr<T>() + row_begin * in_cols;
+    int64_t k = in_cols;
+    for (int32_t idx = 0; idx < weight_size; ++idx) {
+      const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weights", idx);
+      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("biases", idx);
+      user_op::Tensor* aux = ctx->Tensor4ArgNameAndIndex("cublas_aux", idx);
+      user_op::Tensor* y_tensor = idx == weight_size - 1
+                                      ? ctx->Tensor4ArgNameAndIndex("out", 0)
+                                      : ctx->Tensor4ArgNameAndIndex("hidden", idx);
+      const int64_t n = weight->shape_view().At(0);
+      const int64_t mask_cols = aux->shape_view().At(1);
+      T* y = y_tensor->mut_dptr<T>() + row_begin * n;
+      InitRowsWithBias<T>(stream, rows, n, bias->dptr<T>(), static_cast<T>(0), nullptr, y);
+      if (k > 0) { matmul->Launch(stream, rows, n, k, 1.0, in, weight->dptr(), 1.0, y); }
+      const bool relu = idx != weight_size - 1 || !skip_final_activation;
+      const float rate = rates.empty() ? 0.0f : rates.at(idx);
+      const uint64_t seed = rates.empty() ? 0 : seeds.at(idx);
+      if (relu || rate != 0.0f) {
+        ReluDropoutRows<T>(stream, rows, n, mask_cols, relu, rate, seed, row_begin, y,
+                           aux->mut_dptr<int32_t>() + row_begin * mask_cols);
+      }
+      in = y;
+      k = n;
+    }
+  }
+}
+
+template<typename T>
+class CublasFusedMLPCpuKernel final : public user_op::OpKernel {
+ public:
+  CublasFusedMLPCpuKernel() = default;
+  ~CublasFusedMLPCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    FusedMLPForward<T>(ctx, /*rates=*/{}, /*seeds=*/{});
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CUBLAS_FUSED_MLP_CPU_KERNEL(dtype)                   \
+  REGISTER_USER_KERNEL("cublas_fused_mlp")                            \
+      .SetCreateFn<CublasFusedMLPCpuKernel<dtype>>()                  \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_CUBLAS_FUSED_MLP_CPU_KERNEL(float)
+REGISTER_CUBLAS_FUSED_MLP_CPU_KERNEL(double)
+
+template<typename T>
+class FusedMatmulBiasAddReluDropoutCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedMatmulBiasAddReluDropoutCpuKernel() = default;
+  ~FusedMatmulBiasAddReluDropoutCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    const auto& generator = CHECK_JUST(one::MakeGenerator(DeviceType::kCPU));
+    generator->set_current_seed(
+        CHECK_JUST(GetOpKernelRandomSeedInCurrentRank(ctx, ctx->Attr<int64_t>("seed"))));
+    return std::make_shared<FusedDropoutKernelState>(generator);
+  }
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    auto* fused_dropout_kernel_state = dynamic_cast<FusedDropoutKernelState*>(state);
+    CHECK_NOTNULL(fused_dropout_kernel_state);
+    const auto& generator = fused_dropout_kernel_state->generator();
+    CHECK_NOTNULL(generator);
+    std::shared_ptr<ep::CPUGenerator> cpu_generator =
+        CHECK_JUST(generator->Get<ep::CPUGenerator>());
+    const std::vector<float> rates = ctx->Attr<std::vector<float>>("dropout_rate_list");
+    // Every call draws one seed per layer from the generator, the mask elements are then
+    // generated independently of each other.
+    std::vector<uint64_t> seeds(rates.size());
+    for (auto& seed : seeds) {
+      seed = (static_cast<uint64_t>(cpu_generator->engine()()) << 32) | cpu_generator->engine()();
+    }
+    FusedMLPForward<T>(ctx, rates, seeds);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_MATMUL_BIAS_ADD_RELU_DROPOUT_CPU_KERNEL(dtype) \
+  REGISTER_USER_KERNEL("fused_matmul_bias_add_relu_dropout")          \
+      .SetCreateFn<FusedMatmulBiasAddReluDropoutCpuKernel<dtype>>()   \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_MATMUL_BIAS_ADD_RELU_DROPOUT_CPU_KERNEL(float)
+REGISTER_FUSED_MATMUL_BIAS_ADD_RELU_DROPOUT_CPU_KERNEL(double)
+
+template<typename T>
+class FusedMatmulBiasCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedMatmulBiasCpuKernel() = default;
+  ~FusedMatmulBiasCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const user_op::Tensor* add_to_output = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+    }
+    const double alpha = ctx->Attr<double>("alpha");
+    const double beta = add_to_output != nullptr ? ctx->Attr<double>("beta") : 0.0;
+
+    const int64_t k = x->shape_view().At(x->shape_view().NumAxes() - 1);
+    const int64_t n = weight->shape_view().At(0);
+    const int64_t m = out->shape_view().elem_cnt() / n;
+    const auto matmul = NewMatmulPrimitive(x->data_type(), ep::primitive::BlasTransposeType::T);
+    CHECK(matmul);
+    const int64_t tile_rows = TileRows(std::max(n, k));
+    for (int64_t row_begin = 0; row_begin < m; row_begin += tile_rows) {
+      const int64_t rows = std::min(tile_rows, m - row_begin);
+      T* y = out->mut_dptr<T>() + row_begin * n;
+      InitRowsWithBias<T>(stream, rows, n, bias->dptr<T>(), static_cast<T>(beta),
+                          add_to_output != nullptr ? add_to_output->dptr<T>() + row_begin * n
+                                                   : nullptr,
+                          y);
+      if (k > 0) {
+        matmul->Launch(stream, rows, n, k, alpha, x->dptr<T>() + row_begin * k, weight->dptr(),
+                       1.0, y);
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_MATMUL_BIAS_CPU_KERNEL(dtype)                  \
+  REGISTER_USER_KERNEL("fused_matmul_bias")                           \
+      .SetCreateFn<FusedMatmulBiasCpuKernel<dtype>>()                 \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_MATMUL_BIAS_CPU_KERNEL(float)
+REGISTER_FUSED_MATMUL_BIAS_CPU_KERNEL(double)
+
+inline bool MaskBit(const int32_t* mask, int64_t col) {
+  return (static_cast<uint32_t>(mask[col / kMaskBits]) >> (col % kMaskBits)) & 1U;
+}
+
+template<typename T>
+class CublasBiasAddReluMatmulGradCpuKernel final : public user_op::OpKernel {
+ public:
+  CublasBiasAddReluMatmulGradCpuKernel() = default;
+  ~CublasBiasAddReluMatmulGradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* aux = ctx->Tensor4ArgNameAndIndex("aux", 0);
+    user_op::Tensor* d_grad = ctx->Tensor4ArgNameAndIndex("d_grad", 0);
+    user_op::Tensor* d_bias = ctx->Tensor4ArgNameAndIndex("d_bias", 0);
+    const double alpha = ctx->Attr<double>("alpha");
+
+    const int64_t m = dy->shape_view().At(0);
+    const int64_t k = dy->shape_view().At(1);
+    const int64_t n = weight->shape_view().At(1);
+    const int64_t mask_cols = aux->shape_view().At(1);
+    T* d_bias_ptr = d_bias->mut_dptr<T>();
+    std::fill(d_bias_ptr, d_bias_ptr + n, static_cast<T>(0));
+    const auto matmul = NewMatmulPrimitive(dy->data_type(), ep::primitive::BlasTransposeType::N);
+    CHECK(matmul);
+    const int64_t tile_rows = TileRows(std::max(n, k));
+    for (int64_t row_begin = 0; row_begin < m; row_begin += tile_rows) {
+      const int64_t rows = std::min(tile_rows, m - row_begin);
+      T* d_grad_tile = d_grad->mut_dptr<T>() + row_begin * n;
+      const int32_t* mask_tile = aux->dptr<int32_t>() + row_begin * mask_cols;
+      if (k > 0) {
+        matmul->Launch(stream, rows, n, k, alpha, dy->dptr<T>() + row_begin * k, weight->dptr(),
+                       0.0, d_grad_tile);
+      } else {
+        std::fill(d_grad_tile, d_grad_tile + rows * n, static_cast<T>(0));
+      }
+      // The columns are split between threads, so every thread owns a slice of d_bias.
+      stream->ParallelFor(
+          0, n,
+          [&](int64_t begin, int64_t end) {
+            for (int64_t i = 0; i < rows; ++i) {
+              T* d_grad_row = d_grad_tile + i * n;
+              const int32_t* mask_row = mask_tile + i * mask_cols;
+              for (int64_t j = begin; j < end; ++j) {
+                const T grad = MaskBit(mask_row, j) ? d_grad_row[j] : static_cast<T>(0);
+                d_grad_row[j] = grad;
+                d_bias_ptr[j] += grad;
+              }
+            }
+          },
+          GrainSize(rows));
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CUBLAS_BIAS_ADD_RELU_MATMUL_GRAD_CPU_KERNEL(dtype)   \
+  REGISTER_USER_KERNEL("cublas_bias_add_relu_matmul_grad")            \
+      .SetCreateFn<CublasBiasAddReluMatmulGradCpuKernel<dtype>>()     \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("d_grad", 0) == GetDataType<dtype>::value));
+
+REGISTER_CUBLAS_BIAS_ADD_RELU_MATMUL_GRAD_CPU_KERNEL(float)
+REGISTER_CUBLAS_BIAS_ADD_RELU_MATMUL_GRAD_CPU_KERNEL(double)
+
+template<typename T>
+class FusedReluDropoutGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedReluDropoutGradCpuKernel() = default;
+  ~FusedReluDropoutGradCpuKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* mask = ctx->Tensor4ArgNameAndIndex("mask", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const T scale = static_cast<T>(ctx->Attr<float>("scale"));
+
+    const int64_t rows = dy->shape_view().At(0);
+    const int64_t cols = dy->shape_view().At(1);
+    const int64_t mask_cols = mask->shape_view().At(1);
+    const T* dy_ptr = dy->dptr<T>();
+    const int32_t* mask_ptr = mask->dptr<int32_t>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    ctx->stream()->As<ep::CpuStream>()->ParallelFor(
+        0, rows,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            for (int64_t j = 0; j < cols; ++j) {
+              dx_ptr[i * cols + j] = MaskBit(mask_ptr + i * mask_cols, j)
+                                         ? dy_ptr[i * cols + j] * scale
+                                         : static_cast<T>(0);
+            }
+          }
+        },
+        GrainSize(cols));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_RELU_DROPOUT_GRAD_CPU_KERNEL(dtype)            \
+  REGISTER_USER_KERNEL("fused_relu_dropout_grad")                     \
+      .SetCreateFn<FusedReluDropoutGradCpuKernel<dtype>>()            \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_RELU_DROPOUT_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_RELU_DROPOUT_GRAD_CPU_KERNEL(double)
+
+}  // namespace
+
+}  // namespace oneflow
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/user/data/distributed_util.h"
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/rpc/include/global_process_ctx.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -58,15 +59,23 @@ size_t GetShardIndex(const Shape& hierarchy, const NdSbp& nd_sbp, size_t rank) {
 
 class GPTDataLoader final : public OpKernelState {
  public:
-  GPTDataLoader(KernelInitContext* ctx) : batch_cnt_(0) {
+  GPTDataLoader(KernelInitContext* ctx, bool packing)
+      : max_num_segments_(0), pad_token_id_(0), batch_cnt_(0) {
     seq_len_ = ctx->Attr<int64_t>("seq_length");
     label_len_ = 1;
     int64_t num_samples = ctx->Attr<int64_t>("num_samples");
 
-    dataset_ = std::make_unique<const MegatronGPTMMapDataset>(
+    auto dataset = std::make_unique<MegatronGPTMMapDataset>(
         ctx->Attr<std::string>("data_file_prefix"), seq_len_, label_len_, num_samples,
         ctx->Attr<std::vector<int64_t>>("split_sizes"), ctx->Attr<int64_t>("split_index"),
         ctx->Attr<bool>("shuffle"), ctx->Attr<int64_t>("random_seed"));
+    if (packing) {
+      // cu_seqlens holds max_num_segments + 2 boundaries, see MegatronGPTMMapDataset
+      max_num_segments_ = ctx->TensorDesc4ArgNameAndIndex("cu_seqlens", 0)->shape().At(1) - 2;
+      pad_token_id_ = ctx->Attr<int64_t>("pad_token_id");
+      dataset->InitPackedSamples(max_num_segments_);
+    }
+    dataset_ = std::move(dataset);
 
     batch_size_ = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().At(0);
     CHECK_JUST(InitDataSourceDistributedInfo(ctx, num_shards_, shard_index_));
@@ -92,10 +101,41 @@ class GPTDataLoader final : public OpKernelState {
     batch_cnt_ += 1;
   }
 
+  template<typename T>
+  void GetPackedBatch(size_t iter, user_op::Tensor* tokens, user_op::Tensor* position_ids,
+                      user_op::Tensor* cu_seqlens) const {
+    const size_t sample_len = seq_len_ + label_len_;
+    CHECK_EQ(tokens->shape_view().NumAxes(), 2);
+    CHECK_EQ(tokens->shape_view().At(0), batch_size_);
+    CHECK_EQ(tokens->shape_view().At(1), sample_len);
+    CHECK(position_ids->shape_view() == tokens->shape_view());
+    CHECK_EQ(cu_seqlens->shape_view().At(0), batch_size_);
+    CHECK_EQ(cu_seqlens->shape_view().At(1), max_num_segments_ + 2);
+    T* dptr = tokens->mut_dptr<T>();
+    T* position_ids_ptr = position_ids->mut_dptr<T>();
+    int32_t* cu_seqlens_ptr = cu_seqlens->mut_dptr<int32_t>();
+    const T pad_token_id = static_cast<T>(pad_token_id_);
+    MultiThreadLoop(batch_size_, [&](size_t i) {
+      size_t sample_iter = iter * batch_size_ * num_shards_ + shard_index_ * batch_size_ + i;
+      dataset_->GetPackedSample(sample_iter, pad_token_id, dptr + i * sample_len,
+                                position_ids_ptr + i * sample_len,
+                                cu_seqlens_ptr + i * (max_num_segments_ + 2));
+    });
+  }
+
+  template<typename T>
+  void NextPackedBatch(user_op::Tensor* tokens, user_op::Tensor* position_ids,
+                       user_op::Tensor* cu_seqlens) {
+    GetPackedBatch<T>(batch_cnt_, tokens, position_ids, cu_seqlens);
+    batch_cnt_ += 1;
+  }
+
  private:
   std::unique_ptr<const MegatronGPTMMapDataset> dataset_;
   size_t seq_len_;
   size_t label_len_;
+  size_t max_num_segments_;
+  int64_t pad_token_id_;
   size_t batch_size_;
   size_t num_shards_;
   int64_t shard_index_;
@@ -109,7 +149,7 @@ class GPTDataLoaderKernel final : public OpKernel {
   ~GPTDataLoaderKernel() = default;
 
   std::shared_ptr<OpKernelState> CreateOpKernelState(KernelInitContext* ctx) const override {
-    std::shared_ptr<OpKernelState> reader(new GPTDataLoader(ctx));
+    std::shared_ptr<OpKernelState> reader(new GPTDataLoader(ctx, /*packing=*/false));
     return reader;
   }
 
@@ -132,6 +172,38 @@ class GPTDataLoaderKernel final : public OpKernel {
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
+template<typename T>
+class GPTPackedDataLoaderKernel final : public OpKernel {
+ public:
+  GPTPackedDataLoaderKernel() = default;
+  ~GPTPackedDataLoaderKernel() = default;
+
+  std::shared_ptr<OpKernelState> CreateOpKernelState(KernelInitContext* ctx) const override {
+    std::shared_ptr<OpKernelState> reader(new GPTDataLoader(ctx, /*packing=*/true));
+    return reader;
+  }
+
+ private:
+  void Compute(KernelComputeContext* ctx, OpKernelState* state,
+               const OpKernelCache*) const override {
+    auto* loader = dynamic_cast<GPTDataLoader*>(state);
+    user_op::Tensor* iteration_tensor = ctx->Tensor4ArgNameAndIndex("iteration", 0);
+    user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* position_ids_tensor = ctx->Tensor4ArgNameAndIndex("position_ids", 0);
+    user_op::Tensor* cu_seqlens_tensor = ctx->Tensor4ArgNameAndIndex("cu_seqlens", 0);
+    if (iteration_tensor) {
+      CHECK_EQ(iteration_tensor->shape_view().elem_cnt(), 1);
+      CHECK_EQ(iteration_tensor->data_type(), DataType::kInt64);
+      int64_t* iter_ptr = iteration_tensor->mut_dptr<int64_t>();
+      loader->GetPackedBatch<T>(*iter_ptr, out_tensor, position_ids_tensor, cu_seqlens_tensor);
+      *iter_ptr += 1;
+    } else {
+      loader->NextPackedBatch<T>(out_tensor, position_ids_tensor, cu_seqlens_tensor);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
 }  // namespace
 
 #define REGISTER_GPT_DATA_LOADER_KERNEL(dtype)                        \
@@ -143,4 +215,13 @@ class GPTDataLoaderKernel final : public OpKernel {
 REGISTER_GPT_DATA_LOADER_KERNEL(int32_t);
 REGISTER_GPT_DATA_LOADER_KERNEL(int64_t);
 
+#define REGISTER_GPT_PACKED_DATA_LOADER_KERNEL(dtype)                 \
+  REGISTER_USER_KERNEL("megatron_gpt_mmap_packed_data_loader")        \
+      .SetCreateFn<GPTPackedDataLoaderKernel<dtype>>()                \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("out", 0) == GetDataType<dtype>::value))
+
+REGISTER_GPT_PACKED_DATA_LOADER_KERNEL(int32_t);
+REGISTER_GPT_PACKED_DATA_LOADER_KERNEL(int64_t);
+
 }  // namespace oneflow
@@ -0,0 +1,219 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/memory_format.pb.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
+#include "oneflow/user/kernels/random_crop_kernel_state.h"
+#include "oneflow/user/kernels/random_seed_util.h"
+
+#include <opencv2/opencv.hpp>
+
+namespace oneflow {
+
+namespace {
+
+class DecodeCropResizeNormalizeKernelState final : public user_op::OpKernelState {
+ public:
+  explicit DecodeCropResizeNormalizeKernelState(user_op::KernelInitContext* ctx) {
+    const std::string& color_space = ctx->Attr<std::string>("color_space");
+    const int64_t C = ImageUtil::IsColor(color_space) ? 3 : 1;
+    mean_vec_ = ctx->Attr<std::vector<float>>("mean");
+    for (float elem : ctx->Attr<std::vector<float>>("std")) {
+      inv_std_vec_.emplace_back(1.0f / elem);
+    }
+    if (mean_vec_.size() == 1) { mean_vec_.resize(C, mean_vec_.at(0)); }
+    if (inv_std_vec_.size() == 1) { inv_std_vec_.resize(C, inv_std_vec_.at(0)); }
+    if (ctx->Attr<bool>("random_crop")) {
+      const int32_t num_attempts = ctx->Attr<int32_t>("num_attempts");
+      CHECK_GE(num_attempts, 1);
+      const auto& aspect_ratio = ctx->Attr<std::vector<float>>("random_aspect_ratio");
+      CHECK(aspect_ratio.size() == 2 && 0 < aspect_ratio.at(0)
+            && aspect_ratio.at(0) <= aspect_ratio.at(1));
+      const auto& area = ctx->Attr<std::vector<float>>("random_area");
+      CHECK(area.size() == 2 && 0 < area.at(0) && area.at(0) <= area.at(1));
+      // one generator per image of the batch, like the ofrecord random crop decoder
+      const int64_t batch_size = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt();
+      crop_state_.reset(new RandomCropKernelState(
+          batch_size, CHECK_JUST(GetOpKernelRandomSeed(ctx)),
+          {aspect_ratio.at(0), aspect_ratio.at(1)}, {area.at(0), area.at(1)}, num_attempts));
+    }
+  }
+  ~DecodeCropResizeNormalizeKernelState() override = default;
+
+  const std::vector<float>& mean_vec() const { return mean_vec_; }
+  const std::vector<float>& inv_std_vec() const { return inv_std_vec_; }
+  RandomCropGenerator* GetGenerator(int32_t idx) {
+    return crop_state_ ? crop_state_->GetGenerator(idx) : nullptr;
+  }
+
+ private:
+  std::vector<float> mean_vec_;
+  std::vector<float> inv_std_vec_;
+  std::unique_ptr<RandomCropKernelState> crop_state_;
+};
+
+struct DecodeCropResizeNormalizeParam {
+  std::string color_space;
+  std::string interpolation_type;
+  int64_t target_height;
+  int64_t target_width;
+  bool dct_scaling;
+  const std::vector<float>* mean_vec;
+  const std::vector<float>* inv_std_vec;
+};
+
+// Decodes the crop window of one image, in RGB/GRAY for libjpeg and BGR/GRAY for OpenCV, and
+// returns the color space of the decoded image.
+std::string DecodeRandomCropImage(const TensorBuffer& raw_bytes, RandomCropGenerator* gen,
+                                  const DecodeCropResizeNormalizeParam& param, cv::Mat* image) {
+  CHECK(raw_bytes.data_type() == DataType::kChar || raw_bytes.data_type() == DataType::kInt8
+        || raw_bytes.data_type() == DataType::kUInt8);
+  const auto* data = raw_bytes.data<unsigned char>();
+  const size_t length = raw_bytes.nbytes();
+  const bool color = ImageUtil::IsColor(param.color_space);
+  const int64_t scaled_height = param.dct_scaling ? param.target_height : 0;
+  const int64_t scaled_width = param.dct_scaling ? param.target_width : 0;
+  if (JpegPartialDecodeRandomCropScaledImage(data, length, gen, color, scaled_height,
+                                             scaled_width, image)) {
+    return color ? "RGB" : "GRAY";
+  }
+  OpenCvPartialDecodeRandomCropImage(data, length, gen, param.color_space, *image);
+  return color ? "BGR" : "GRAY";
+}
+
+template<MemoryFormat output_layout, bool mirror>
+void Normalize1Sample(const cv::Mat& image, bool swap_rb, const std::vector<float>& mean_vec,
+                      const std::vector<float>& inv_std_vec, float* out_dptr) {
+  const int64_t H = image.rows;
+  const int64_t W = image.cols;
+  const int64_t C = image.channels();
+  FOR_RANGE(int64_t, h, 0, H) {
+    const uint8_t* in_row = image.ptr<uint8_t>(h);
+    FOR_RANGE(int64_t, c, 0, C) {
+      const int64_t in_c = swap_rb ? C - 1 - c : c;
+      const float mean = mean_vec.at(c);
+      const float inv_std = inv_std_vec.at(c);
+      FOR_RANGE(int64_t, w, 0, W) {
+        const int64_t in_w = mirror ? W - 1 - w : w;
+        const float value = (static_cast<float>(in_row[in_w * C + in_c]) - mean) * inv_std;
+        if (output_layout == MemoryFormat::kContiguous) {
+          out_dptr[(c * H + h) * W + w] = value;
+        } else {
+          out_dptr[(h * W + w) * C + c] = value;
+        }
+      }
+    }
+  }
+}
+
+void DecodeCropResizeNormalize1Sample(const TensorBuffer& raw_bytes, RandomCropGenerator* gen,
+                                      const DecodeCropResizeNormalizeParam& param, bool mirror,
+                                      bool channels_last, float* out_dptr) {
+  cv::Mat image;
+  const std::string decoded_color_space = DecodeRandomCropImage(raw_bytes, gen, param, &image);
+  CHECK(image.data != nullptr);
+  CHECK_EQ(image.channels(), ImageUtil::IsColor(param.color_space) ? 3 : 1);
+  if (image.rows != param.target_height || image.cols != param.target_width) {
+    const int flag = GetCvInterpolationFlag(param.interpolation_type, image.cols, image.rows,
+                                            param.target_width, param.target_height);
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(param.target_width, param.target_height), 0, 0, flag);
+    image = resized;
+  }
+  const bool swap_rb = decoded_color_space != param.color_space;
+  const auto& mean_vec = *param.mean_vec;
+  const auto& inv_std_vec = *param.inv_std_vec;
+  if (channels_last) {
+    if (mirror) {
+      Normalize1Sample<MemoryFormat::kChannelsLast, true>(image, swap_rb, mean_vec, inv_std_vec,
+                                                          out_dptr);
+    } else {
+      Normalize1Sample<MemoryFormat::kChannelsLast, false>(image, swap_rb, mean_vec, inv_std_vec,
+                                                           out_dptr);
+    }
+  } else {
+    if (mirror) {
+      Normalize1Sample<MemoryFormat::kContiguous, true>(image, swap_rb, mean_vec, inv_std_vec,
+                                                        out_dptr);
+    } else {
+      Normalize1Sample<MemoryFormat::kContiguous, false>(image, swap_rb, mean_vec, inv_std_vec,
+                                                         out_dptr);
+    }
+  }
+}
+
+}  // namespace
+
+class ImageDecodeRandomCropResizeNormalizeKernel final : public user_op::OpKernel {
+ public:
+  ImageDecodeRandomCropResizeNormalizeKernel() = default;
+  ~ImageDecodeRandomCropResizeNormalizeKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<DecodeCropResizeNormalizeKernelState>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    auto* kernel_state = dynamic_cast<DecodeCropResizeNormalizeKernelState*>(state);
+    CHECK_NOTNULL(kernel_state);
+    const user_op::Tensor* in_tensor = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t batch_size = in_tensor->shape_view().elem_cnt();
+    CHECK_GT(batch_size, 0);
+    CHECK_EQ(out_tensor->shape_view().At(0), batch_size);
+    const int8_t* mirror_dptr = nullptr;
+    if (ctx->has_input("mirror", 0)) {
+      const user_op::Tensor* mirror_tensor = ctx->Tensor4ArgNameAndIndex("mirror", 0);
+      CHECK_EQ(mirror_tensor->shape_view().elem_cnt(), batch_size);
+      mirror_dptr = mirror_tensor->dptr<int8_t>();
+    }
+
+    DecodeCropResizeNormalizeParam param;
+    param.color_space = ctx->Attr<std::string>("color_space");
+    param.interpolation_type = ctx->Attr<std::string>("interpolation_type");
+    param.target_height = ctx->Attr<int64_t>("target_height");
+    param.target_width = ctx->Attr<int64_t>("target_width");
+    param.dct_scaling = ctx->Attr<bool>("dct_scaling");
+    param.mean_vec = &kernel_state->mean_vec();
+    param.inv_std_vec = &kernel_state->inv_std_vec();
+    const bool channels_last = ctx->Attr<std::string>("output_layout") == "NHWC";
+
+    const TensorBuffer* in_buffers = in_tensor->dptr<TensorBuffer>();
+    float* out_dptr = out_tensor->mut_dptr<float>();
+    const int64_t out_image_elem_cnt = out_tensor->shape_view().Count(1);
+    // every image is decoded, resized and normalized by one thread straight into the output
+    MultiThreadLoop(batch_size, [&](size_t i) {
+      const bool mirror = mirror_dptr != nullptr && mirror_dptr[i] != 0;
+      DecodeCropResizeNormalize1Sample(in_buffers[i], kernel_state->GetGenerator(i), param,
+                                       mirror, channels_last, out_dptr + i * out_image_elem_cnt);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("image_decode_random_crop_resize_normalize")
+    .SetCreateFn<ImageDecodeRandomCropResizeNormalizeKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     && (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)
+                     && (user_op::HobDataType("out", 0) == DataType::kFloat));
+
+}  // namespace oneflow
@@ -0,0 +1,278 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/user/kernels/multi_tensor_model_update_kernel_util.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// Runs range_fn(tensor_idx, begin, end) over all elements of the tensor tuple with a single
+// parallel loop on the flattened elements, so a task may cover many small tensors and a large
+// tensor is split across threads.
+template<int N, typename F>
+void ForEachTensorRange(ep::Stream* stream, const int64_t n_tensor,
+                        const TensorTupleParams<N>& tensor_tuple_params, const F& range_fn) {
+  int64_t offsets[kMaxTuples + 1];
+  offsets[0] = 0;
+  for (int64_t i = 0; i < n_tensor; ++i) {
+    offsets[i + 1] = offsets[i] + tensor_tuple_params.sizes[i];
+  }
+  stream->As<ep::CpuStream>()->ParallelFor(0, offsets[n_tensor], [&](int64_t begin, int64_t end) {
+    int64_t tensor_idx =
+        std::upper_bound(offsets + 1, offsets + n_tensor + 1, begin) - (offsets + 1);
+    while (begin < end) {
+      const int64_t tensor_end = std::min(end, offsets[tensor_idx + 1]);
+      if (tensor_end > begin) {
+        range_fn(tensor_idx, begin - offsets[tensor_idx], tensor_end - offsets[tensor_idx]);
+      }
+      begin = tensor_end;
+      tensor_idx += 1;
+    }
+  });
+}
+
+template<typename T, int N>
+void UpdateModelCopy(const TensorTupleParams<N>& tensor_tuple_params, int64_t tensor_idx,
+                     int64_t begin, int64_t end) {
+  const T* model_ptr = (const T*)tensor_tuple_params.ptr[0][tensor_idx];
+  float16* model_copy_ptr = (float16*)tensor_tuple_params.ptr[N - 1][tensor_idx];
+  for (int64_t i = begin; i < end; ++i) { model_copy_ptr[i] = static_cast<float16>(model_ptr[i]); }
+}
+
+// The per element loops below have no branches so that the compiler vectorizes them.
+template<typename T, typename G, int N>
+void MultiTensorSGDUpdateCpu(ep::Stream* stream, const int64_t n_tensor, T scale, const float l1,
+                             const float l2, const float weight_decay, float learning_rate_val,
+                             float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                             const int64_t* skip_if,
+                             const TensorTupleParams<N>& tensor_tuple_params) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  learning_rate_val *= lr_scale;
+  const auto UpdateRange = [&](int64_t tensor_idx, int64_t begin, int64_t end) {
+    T* model_ptr = (T*)tensor_tuple_params.ptr[0][tensor_idx];
+    const G* model_diff_ptr = (const G*)tensor_tuple_params.ptr[1][tensor_idx];
+    for (int64_t i = begin; i < end; ++i) {
+      const T model_val = model_ptr[i];
+      const T model_diff_t = CastScaleRegularizeGradientFunctor<T, G>()(model_diff_ptr[i],
+                                                                         model_val, scale, l1, l2);
+      model_ptr[i] = model_val - learning_rate_val * (model_diff_t + weight_decay * model_val);
+    }
+    if (N == 3) { UpdateModelCopy<T, N>(tensor_tuple_params, tensor_idx, begin, end); }
+  };
+  ForEachTensorRange(stream, n_tensor, tensor_tuple_params, UpdateRange);
+}
+
+template<typename T, typename G, int N>
+void MultiTensorMomentumUpdateCpu(ep::Stream* stream, const int64_t n_tensor, T scale,
+                                  const float l1, const float l2, const float weight_decay,
+                                  float learning_rate_val, float lr_scale,
+                                  const float* learning_rate, const T* scale_by_ptr,
+                                  const int64_t* skip_if, const float momentum,
+                                  const float dampening, const bool nesterov, const bool maximize,
+                                  const TensorTupleParams<N>& tensor_tuple_params) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  learning_rate_val *= lr_scale;
+  const T alpha = maximize ? learning_rate_val : -learning_rate_val;
+  // nesterov: update = diff + momentum * buf, otherwise update = buf
+  const T diff_coeff = nesterov ? 1 : 0;
+  const T buf_coeff = nesterov ? momentum : 1;
+  const auto UpdateRange = [&](int64_t tensor_idx, int64_t begin, int64_t end) {
+    T* model_ptr = (T*)tensor_tuple_params.ptr[0][tensor_idx];
+    const G* model_diff_ptr = (const G*)tensor_tuple_params.ptr[1][tensor_idx];
+    T* momentum_buf_ptr = (T*)tensor_tuple_params.ptr[2][tensor_idx];
+    for (int64_t i = begin; i < end; ++i) {
+      const T model_val = model_ptr[i];
+      const T model_diff_t = CastScaleRegularizeGradientFunctor<T, G>()(
+                                 model_diff_ptr[i], model_val, scale, l1, l2)
+                             + weight_decay * model_val;
+      const T momentum_buf = momentum * momentum_buf_ptr[i] + (1.f - dampening) * model_diff_t;
+      momentum_buf_ptr[i] = momentum_buf;
+      model_ptr[i] = model_val + alpha * (diff_coeff * model_diff_t + buf_coeff * momentum_buf);
+    }
+    if (N == 4) { UpdateModelCopy<T, N>(tensor_tuple_params, tensor_idx, begin, end); }
+  };
+  ForEachTensorRange(stream, n_tensor, tensor_tuple_params, UpdateRange);
+}
+
+template<typename T, typename G, int N>
+void MultiTensorAdamUpdateCpu(ep::Stream* stream, const int64_t n_tensor, T scale, float l1,
+                              float l2, float beta1, float beta2, float epsilon,
+                              float weight_decay, float learning_rate_val,
+                              float bias_correction1_val, float bias_correction2_val,
+                              float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                              const int64_t* skip_if, const float* bias_correction1_ptr,
+                              const float* bias_correction2_ptr,
+                              const TensorTupleParams<N>& tensor_tuple_params) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  if (bias_correction1_ptr != nullptr) { bias_correction1_val = *bias_correction1_ptr; }
+  if (bias_correction2_ptr != nullptr) { bias_correction2_val = *bias_correction2_ptr; }
+  learning_rate_val *= lr_scale;
+  const T step_size = learning_rate_val / bias_correction1_val;
+  const T sqrt_bias_correction2 = std::sqrt(static_cast<T>(bias_correction2_val));
+  const auto UpdateRange = [&](int64_t tensor_idx, int64_t begin, int64_t end) {
+    T* model_ptr = (T*)tensor_tuple_params.ptr[0][tensor_idx];
+    const G* model_diff_ptr = (const G*)tensor_tuple_params.ptr[1][tensor_idx];
+    T* m_ptr = (T*)tensor_tuple_params.ptr[2][tensor_idx];
+    T* v_ptr = (T*)tensor_tuple_params.ptr[3][tensor_idx];
+    for (int64_t i = begin; i < end; ++i) {
+      const T model_val = model_ptr[i];
+      const T model_diff_t = CastScaleRegularizeGradientFunctor<T, G>()(model_diff_ptr[i],
+                                                                         model_val, scale, l1, l2);
+      const T m_val = beta1 * m_ptr[i] + (1 - beta1) * model_diff_t;
+      const T v_val = beta2 * v_ptr[i] + (1 - beta2) * model_diff_t * model_diff_t;
+      const T denom = std::sqrt(v_val) / sqrt_bias_correction2 + epsilon;
+      m_ptr[i] = m_val;
+      v_ptr[i] = v_val;
+      model_ptr[i] = model_val - step_size * (m_val / denom)
+                     - learning_rate_val * weight_decay * model_val;
+    }
+    if (N == 5) { UpdateModelCopy<T, N>(tensor_tuple_params, tensor_idx, begin, end); }
+  };
+  ForEachTensorRange(stream, n_tensor, tensor_tuple_params, UpdateRange);
+}
+
+}  // namespace
+
+template<typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float weight_decay, float learning_rate_val,
+                     float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, TensorTupleParams<2> tensor_tuple_params) {
+    MultiTensorSGDUpdateCpu<T, G, 2>(stream, n_tensor, scale, l1, l2, weight_decay,
+                                     learning_rate_val, lr_scale, learning_rate, scale_by_ptr,
+                                     skip_if, tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, double, double>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float weight_decay, float learning_rate_val,
+                     float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float momentum, const float dampening,
+                     const bool nesterov, const bool maximize,
+                     TensorTupleParams<3> tensor_tuple_params) {
+    MultiTensorMomentumUpdateCpu<T, G, 3>(stream, n_tensor, scale, l1, l2, weight_decay,
+                                          learning_rate_val, lr_scale, learning_rate,
+                                          scale_by_ptr, skip_if, momentum, dampening, nesterov,
+                                          maximize, tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, double, double>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, bool amsgrad, bool do_bias_correction,
+                     float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, float lr_scale, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2, TensorTupleParams<4> tensor_tuple_params) {
+    MultiTensorAdamUpdateCpu<T, G, 4>(stream, n_tensor, scale, l1, l2, beta1, beta2, epsilon,
+                                      weight_decay, learning_rate_val, bias_correction1_val,
+                                      bias_correction2_val, lr_scale, learning_rate, scale_by_ptr,
+                                      skip_if, bias_correction1, bias_correction2,
+                                      tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, double, double>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T, typename G>
+struct MultiTensorSGDUpdateWithCastKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float weight_decay, float learning_rate_val,
+                     float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, TensorTupleParams<3> tensor_tuple_params) {
+    MultiTensorSGDUpdateCpu<T, G, 3>(stream, n_tensor, scale, l1, l2, weight_decay,
+                                     learning_rate_val, lr_scale, learning_rate, scale_by_ptr,
+                                     skip_if, tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorSGDUpdateWithCastKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateWithCastKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float weight_decay, float learning_rate_val,
+                     float lr_scale, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float momentum, const float dampening,
+                     const bool nesterov, const bool maximize,
+                     TensorTupleParams<4> tensor_tuple_params) {
+    MultiTensorMomentumUpdateCpu<T, G, 4>(stream, n_tensor, scale, l1, l2, weight_decay,
+                                          learning_rate_val, lr_scale, learning_rate,
+                                          scale_by_ptr, skip_if, momentum, dampening, nesterov,
+                                          maximize, tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorMomentumUpdateWithCastKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateWithCastKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, T scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, bool amsgrad, bool do_bias_correction,
+                     float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, float lr_scale, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2, TensorTupleParams<5> tensor_tuple_params) {
+    MultiTensorAdamUpdateCpu<T, G, 5>(stream, n_tensor, scale, l1, l2, beta1, beta2, epsilon,
+                                      weight_decay, learning_rate_val, bias_correction1_val,
+                                      bias_correction2_val, lr_scale, learning_rate, scale_by_ptr,
+                                      skip_if, bias_correction1, bias_correction2,
+                                      tensor_tuple_params);
+  }
+};
+
+template struct MultiTensorAdamUpdateWithCastKernelUtil<DeviceType::kCPU, float, float>;
+
+template<typename T>
+struct MultiTensorYoloV5WeightUpdateKernelUtil<DeviceType::kCPU, T> {
+  static void Update(ep::Stream* stream, const int64_t elem_cnt, const int64_t n_tensor, float d,
+                     TensorTupleParams<2> tensor_tuple_params) {
+    const auto UpdateRange = [&](int64_t tensor_idx, int64_t begin, int64_t end) {
+      T* model_ptr = (T*)tensor_tuple_params.ptr[0][tensor_idx];
+      const T* model_update_ptr = (const T*)tensor_tuple_params.ptr[1][tensor_idx];
+      for (int64_t i = begin; i < end; ++i) {
+        model_ptr[i] = d * model_ptr[i] + (1 - d) * model_update_ptr[i];
+      }
+    };
+    ForEachTensorRange(stream, n_tensor, tensor_tuple_params, UpdateRange);
+  }
+};
+
+template struct MultiTensorYoloV5WeightUpdateKernelUtil<DeviceType::kCPU, float>;
+
+}  // namespace oneflow
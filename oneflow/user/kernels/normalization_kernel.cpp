@@ -14,89 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/batch_norm_cpu_kernel_util.h"
 
 namespace oneflow {
 
-template<typename T>
-static void ComputeMeanAndVar(const T* input_ptr, T* mean_ptr, T* inv_variance_ptr,
-                              T* moving_mean_ptr, T* moving_variance_ptr, const int64_t batch_size,
-                              const int64_t channel_size, const int64_t spatial_size,
-                              const float epsilon, const float momentum) {
-  // NOTE(Liang Depeng): the following parameters were used to compute mean and var
-  const int64_t jump_step = spatial_size * channel_size;
-  const int64_t reduce_count = batch_size * spatial_size;
-  const int64_t unbias_reduce_count = reduce_count - 1;
-  const T reduce_scale_factor = static_cast<T>(1) / reduce_count;
-  const T unbias_reduce_scale_factor = static_cast<T>(1) / unbias_reduce_count;
-  const T unbias_reduce_scale_factor_m2 = unbias_reduce_scale_factor * -static_cast<T>(2);
-  const T unbias_reduce_scale_factor_mn = reduce_count * unbias_reduce_scale_factor;
-
-  const T exponential_average_factor = 1.0f - momentum;
-
-  for (int64_t channel = 0; channel < channel_size; ++channel) {
-    const T* temp_input_ptr = input_ptr + channel * spatial_size;
-    T sum = 0;
-    T sum_square = 0;
-    for (int64_t batch = 0; batch < batch_size; ++batch) {
-      for (int64_t s = 0; s < spatial_size; ++s) {
-        const T x = temp_input_ptr[s];
-        sum += x;
-        sum_square += x * x;
-      }
-      temp_input_ptr += jump_step;
-    }
-
-    const T temp_mean = sum * reduce_scale_factor;
-    mean_ptr[channel] = temp_mean;
-
-    const T temp_mean_square = temp_mean * temp_mean;
-    const T temp_variance = sum_square * reduce_scale_factor - temp_mean_square;
-
-    const T temp_unbias_variance = sum_square * unbias_reduce_scale_factor
-                                   + unbias_reduce_scale_factor_m2 * temp_mean * sum
-                                   + unbias_reduce_scale_factor_mn * temp_mean_square;
-
-    inv_variance_ptr[channel] = static_cast<T>(1) / std::sqrt(temp_variance + epsilon);
-
-    if (moving_mean_ptr != nullptr && moving_variance_ptr != nullptr) {
-      moving_mean_ptr[channel] =
-          moving_mean_ptr[channel] * momentum + temp_mean * exponential_average_factor;
-      moving_variance_ptr[channel] = moving_variance_ptr[channel] * momentum
-                                     + temp_unbias_variance * exponential_average_factor;
-    }
-  }
-}
-
-template<typename T>
-static void Normalize(const T* input_ptr, const T* mean_ptr, const T* variance_ptr,
-                      const T* gamma_ptr, const T* beta_ptr, T* output_ptr,
-                      const int64_t batch_size, const int64_t channel_size,
-                      const int64_t spatial_size, const float epsilon, const bool training) {
-  const T* temp_input_ptr = input_ptr;
-  T* temp_output_ptr = output_ptr;
-  const int64_t all_channels = batch_size * channel_size;
-  int64_t channel = -1;
-  for (int64_t ac = 0; ac < all_channels; ++ac) {
-    channel += 1;
-    if (channel >= channel_size) { channel = 0; }
-    T inv_variance = variance_ptr[channel];
-    if (!training) { inv_variance = 1.0f / std::sqrt(inv_variance + epsilon); }
-    const T gamma = gamma_ptr[channel] * inv_variance;
-    const T beta = beta_ptr[channel];
-    const T mean = mean_ptr[channel];
-    for (int64_t s = 0; s < spatial_size; ++s) {
-      temp_output_ptr[s] = (temp_input_ptr[s] - mean) * gamma + beta;
-    }
-    temp_input_ptr += spatial_size;
-    temp_output_ptr += spatial_size;
-  }
-}
-
-template<typename T>
-static void AddToOutput(const T* add_to_output_ptr, T* output_ptr, const int64_t elem_count) {
-  for (int64_t i = 0; i < elem_count; ++i) { output_ptr[i] += add_to_output_ptr[i]; }
-}
-
 template<typename T>
 static void AddRelu(const T* addend_ptr, int32_t* mask_ptr, T* output_ptr, const int64_t elem_cnt) {
   const int32_t step = 32;
@@ -223,51 +144,6 @@ static size_t InferGradTmpSizeForCpuKernel(user_op::InferContext* ctx) {
   return tmp_size;
 }
 
-// NOTE(Liang Depeng): helper functions to process datas for specific channel over all samples.
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* data, const int64_t batch_size, const int64_t spatial_size,
-                               const int64_t jump_step, const int64_t channel_idx,
-                               DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_data = data + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) { data_processor(&tmp_data[i]); }
-    tmp_data += jump_step;
-  }
-}
-
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* in_data1, const T* in_data2, const int64_t batch_size,
-                               const int64_t spatial_size, const int64_t jump_step,
-                               const int64_t channel_idx, DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_in_data1 = in_data1 + start_offset;
-  const T* tmp_in_data2 = in_data2 + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) {
-      data_processor(&tmp_in_data1[i], &tmp_in_data2[i]);
-    }
-    tmp_in_data1 += jump_step;
-    tmp_in_data2 += jump_step;
-  }
-}
-
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* in_data, T* out_data, const int64_t batch_size,
-                               const int64_t spatial_size, const int64_t jump_step,
-                               const int64_t channel_idx, DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_in_data = in_data + start_offset;
-  T* tmp_out_data = out_data + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) {
-      data_processor(&tmp_in_data[i], &tmp_out_data[i]);
-    }
-    tmp_in_data += jump_step;
-    tmp_out_data += jump_step;
-  }
-}
-
 template<typename T>
 class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
  public:
@@ -294,34 +170,30 @@ class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
     CHECK_GE(axis, 0);
     CHECK_LT(axis, x->shape_view().NumAxes());
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* input_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* beta_ptr = beta->dptr<T>();
-
-      T* output_ptr = y->mut_dptr<T>();
-      T* moving_mean_ptr = moving_mean->mut_dptr<T>();
-      T* moving_variance_ptr = moving_variance->mut_dptr<T>();
-
-      const int64_t batch_size = x->shape_view().At(0);
-      const int64_t channel_size = x->shape_view().At(axis);
-      const int64_t spatial_size = x->shape_view().Count(axis + 1);
-
-      // NOTE(Liang Depeng):
-      // compute the normalization result
-      Normalize(input_ptr, moving_mean_ptr, moving_variance_ptr, gamma_ptr, beta_ptr, output_ptr,
-                batch_size, channel_size, spatial_size, epsilon, false);
-
-      if (ctx->has_input("_add_to_output", 0)) {
-        const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
-        CHECK_EQ(add_to_output->data_type(), y->data_type());
-        CHECK_EQ(add_to_output->shape_view(), y->shape_view());
-        AddToOutput(add_to_output->dptr<T>(), output_ptr, x->shape_view().elem_cnt());
-      }
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(x->shape_view(), axis);
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* beta_ptr = beta->dptr<T>();
+    const T* moving_mean_ptr = moving_mean->dptr<T>();
+    const T* moving_variance_ptr = moving_variance->dptr<T>();
+
+    // NOTE: fold the moving statistics, gamma and beta into one scale and shift per channel so
+    // that the normalization reads x once.
+    std::vector<T> scale(layout.channel_size);
+    std::vector<T> shift(layout.channel_size);
+    for (int64_t c = 0; c < layout.channel_size; ++c) {
+      scale[c] = gamma_ptr[c] / std::sqrt(moving_variance_ptr[c] + static_cast<T>(epsilon));
+      shift[c] = beta_ptr[c] - moving_mean_ptr[c] * scale[c];
+    }
 
-    } else {  // TODO(Liang Depeng): NHWC format
-      UNIMPLEMENTED() << "cpu normalization op only support nchw data_format now!";
+    const T* addend_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape_view(), y->shape_view());
+      addend_ptr = add_to_output->dptr<T>();
     }
+    batch_norm_cpu::ChannelAffine(ctx->stream()->As<ep::CpuStream>(), layout, x->dptr<T>(),
+                                  scale.data(), shift.data(), addend_ptr, y->mut_dptr<T>());
   }
 
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
@@ -383,56 +255,67 @@ class NormalizationTrainCpuKernel final : public user_op::OpKernel {
       moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
     }
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* input_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* beta_ptr = beta->dptr<T>();
-
-      T* output_ptr = y->mut_dptr<T>();
-      T* mean_ptr = mean->mut_dptr<T>();
-      T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(x->shape_view(), axis);
+    const int64_t channel_size = layout.channel_size;
+    const int64_t reduce_count = layout.outer_size * layout.inner_size;
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* beta_ptr = beta->dptr<T>();
+    T* output_ptr = y->mut_dptr<T>();
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+
+    // NOTE: mean and variance of every channel come from a single Welford pass over x, the
+    // normalization is then folded into one scale and shift per channel.
+    std::vector<double> batch_mean(channel_size);
+    std::vector<double> batch_variance(channel_size);
+    batch_norm_cpu::ComputeMoments(stream, layout, x->dptr<T>(), batch_mean.data(),
+                                   batch_variance.data());
+    std::vector<T> scale(channel_size);
+    std::vector<T> shift(channel_size);
+    for (int64_t c = 0; c < channel_size; ++c) {
+      const double inv_std = 1.0 / std::sqrt(batch_variance[c] + epsilon);
+      mean_ptr[c] = static_cast<T>(batch_mean[c]);
+      inv_variance_ptr[c] = static_cast<T>(inv_std);
+      scale[c] = static_cast<T>(gamma_ptr[c] * inv_std);
+      shift[c] = static_cast<T>(beta_ptr[c] - batch_mean[c] * gamma_ptr[c] * inv_std);
+    }
 
-      T* moving_mean_ptr = nullptr;
-      T* moving_variance_ptr = nullptr;
-      if (moving_mean != nullptr && moving_variance != nullptr) {
-        moving_mean_ptr = moving_mean->mut_dptr<T>();
-        moving_variance_ptr = moving_variance->mut_dptr<T>();
+    if (moving_mean != nullptr && moving_variance != nullptr) {
+      T* moving_mean_ptr = moving_mean->mut_dptr<T>();
+      T* moving_variance_ptr = moving_variance->mut_dptr<T>();
+      const double unbias_factor =
+          reduce_count > 1 ? static_cast<double>(reduce_count) / (reduce_count - 1) : 1.0;
+      for (int64_t c = 0; c < channel_size; ++c) {
+        const double unbiased_variance = batch_variance[c] * unbias_factor;
+        moving_mean_ptr[c] = static_cast<T>(moving_mean_ptr[c] * momentum
+                                            + batch_mean[c] * (1.0 - momentum));
+        moving_variance_ptr[c] = static_cast<T>(moving_variance_ptr[c] * momentum
+                                                + unbiased_variance * (1.0 - momentum));
       }
+    }
 
-      const int64_t batch_size = x->shape_view().At(0);
-      const int64_t channel_size = x->shape_view().At(axis);
-      const int64_t spatial_size = x->shape_view().Count(axis + 1);
-
-      // NOTE(Liang Depeng):
-      // Compute mean & inv_variance and update moving_mean & moving_variance for each channel.
-      ComputeMeanAndVar(input_ptr, mean_ptr, inv_variance_ptr, moving_mean_ptr, moving_variance_ptr,
-                        batch_size, channel_size, spatial_size, epsilon, momentum);
-
-      // NOTE(Liang Depeng):
-      // compute the normalization result
-      Normalize(input_ptr, mean_ptr, inv_variance_ptr, gamma_ptr, beta_ptr, output_ptr, batch_size,
-                channel_size, spatial_size, epsilon, true);
-
-      if (ctx->has_input("_add_to_output", 0)) {
-        const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
-        CHECK_EQ(add_to_output->data_type(), y->data_type());
-        CHECK_EQ(add_to_output->shape_view(), y->shape_view());
-        AddToOutput(add_to_output->dptr<T>(), output_ptr, x->shape_view().elem_cnt());
-      }
+    const T* addend_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape_view(), y->shape_view());
+      addend_ptr = add_to_output->dptr<T>();
+    }
+    batch_norm_cpu::ChannelAffine(stream, layout, x->dptr<T>(), scale.data(), shift.data(),
+                                  addend_ptr, output_ptr);
+
+    if (ctx->op_type_name() == "normalization_add_relu") {
+      CHECK(!ctx->has_input("_add_to_output", 0));
+      auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
 
-      if (ctx->op_type_name() == "normalization_add_relu") {
-        CHECK(!ctx->has_input("_add_to_output", 0));
-        auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
-
-        if (ctx->has_input("addend", 0)) {
-          const auto* addend = ctx->Tensor4ArgNameAndIndex("addend", 0);
-          AddRelu(addend->dptr<T>(), mask->mut_dptr<int32_t>(), output_ptr,
-                  x->shape_view().elem_cnt());
-        } else {
-          Relu(mask->mut_dptr<int32_t>(), output_ptr, x->shape_view().elem_cnt());
-        }
+      if (ctx->has_input("addend", 0)) {
+        const auto* addend = ctx->Tensor4ArgNameAndIndex("addend", 0);
+        AddRelu(addend->dptr<T>(), mask->mut_dptr<int32_t>(), output_ptr,
+                x->shape_view().elem_cnt());
+      } else {
+        Relu(mask->mut_dptr<int32_t>(), output_ptr, x->shape_view().elem_cnt());
       }
-    } else {  // TODO(Liang Depeng): NHWC format
     }
   }
 
@@ -518,62 +401,41 @@ class NormalizationGradCpuKernel final : public user_op::OpKernel {
       UNIMPLEMENTED();
     }
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* x_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* mean_ptr = mean->dptr<T>();
-      const T* inv_variance_ptr = inv_variance->dptr<T>();
-
-      T* dx_ptr = dx->mut_dptr<T>();
-      T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
-      T* beta_diff_ptr = beta_diff->mut_dptr<T>();
-
-      const int64_t batch_size = x->shape_view().At(0);
-      const int64_t channel_size = x->shape_view().At(axis);
-      const int64_t spatial_size = x->shape_view().Count(axis + 1);
-      const int64_t jump_step = spatial_size * channel_size;
-      const int64_t reduce_count = batch_size * spatial_size;
-
-      // NOTE(Liang Depeng):
-      // Borrow the MXNet implementation to compute dx, gamma_diff and beta_diff.
-      // For more details pls refers to:
-      // https://github.com/apache/incubator-mxnet/blob/master/src/operator/nn/batch_norm.cc
-      for (int64_t channel = 0; channel < channel_size; ++channel) {
-        const T gamma_c = gamma_ptr[channel];
-        const T mean_c = mean_ptr[channel];
-        const T inv_variance_c = inv_variance_ptr[channel];
-
-        // NOTE(Liang Depeng): sum dy for specific channel over all samples
-        T sum_dy_out = 0;
-        ForEachFast(dy_ptr, batch_size, spatial_size, jump_step, channel,
-                    [&sum_dy_out](const T* dy_data) { sum_dy_out += *dy_data; });
-
-        // NOTE(Liang Depeng): dot product of the x and dy
-        T dotp = 0;
-        ForEachFast(x_ptr, dy_ptr, batch_size, spatial_size, jump_step, channel,
-                    [&dotp, mean_c](const T* x_data, const T* dy_data) {
-                      dotp += (*x_data - mean_c) * (*dy_data);
-                    });
-
-        // NOTE(Liang Depeng): projection of dy on to output scaled by std
-        const T k = dotp * inv_variance_c * inv_variance_c / reduce_count;
-        const T iw = inv_variance_c * gamma_c;
-        const T grad_mean_c = sum_dy_out / reduce_count;
-        ForEachFast(
-            x_ptr, dx_ptr, batch_size, spatial_size, jump_step, channel,
-            [&mean_c, &k](const T* x_data, T* dx_data) { *dx_data = (*x_data - mean_c) * k; });
-
-        ForEachFast(dy_ptr, dx_ptr, batch_size, spatial_size, jump_step, channel,
-                    [iw, grad_mean_c](const T* dy_data, T* dx_data) {
-                      *dx_data = (*dy_data - grad_mean_c - *dx_data) * iw;
-                    });
-
-        gamma_diff_ptr[channel] = dotp * inv_variance_c;
-        beta_diff_ptr[channel] = sum_dy_out;
-      }
-
-    } else {  // TODO(Liang Depeng): NHWC format
+    const batch_norm_cpu::Layout layout = batch_norm_cpu::MakeLayout(x->shape_view(), axis);
+    const int64_t channel_size = layout.channel_size;
+    const double reduce_count = static_cast<double>(layout.outer_size * layout.inner_size);
+    auto* stream = ctx->stream()->As<ep::CpuStream>();
+    const T* x_ptr = x->dptr<T>();
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+    T* beta_diff_ptr = beta_diff->mut_dptr<T>();
+
+    // NOTE: the MXNet formulation
+    // (https://github.com/apache/incubator-mxnet/blob/master/src/operator/nn/batch_norm.cc)
+    // with sum(dy) and dot(x - mean, dy) reduced in one pass, and
+    // dx = (dy - mean(dy) - (x - mean) * dotp * inv_var^2 / N) * gamma * inv_var
+    // expanded into dy * dy_scale + x * x_scale + shift.
+    std::vector<double> sum_dy(channel_size);
+    std::vector<double> dotp(channel_size);
+    batch_norm_cpu::ComputeGradSums(stream, layout, dy_ptr, x_ptr, mean_ptr, sum_dy.data(),
+                                    dotp.data());
+    std::vector<T> dy_scale(channel_size);
+    std::vector<T> x_scale(channel_size);
+    std::vector<T> shift(channel_size);
+    for (int64_t c = 0; c < channel_size; ++c) {
+      const double inv_variance_c = inv_variance_ptr[c];
+      const double k = dotp[c] * inv_variance_c * inv_variance_c / reduce_count;
+      const double iw = inv_variance_c * gamma_ptr[c];
+      dy_scale[c] = static_cast<T>(iw);
+      x_scale[c] = static_cast<T>(-k * iw);
+      shift[c] = static_cast<T>((mean_ptr[c] * k - sum_dy[c] / reduce_count) * iw);
+      gamma_diff_ptr[c] = static_cast<T>(dotp[c] * inv_variance_c);
+      beta_diff_ptr[c] = static_cast<T>(sum_dy[c]);
     }
+    batch_norm_cpu::ChannelBackwardAffine(stream, layout, dy_ptr, x_ptr, dy_scale.data(),
+                                          x_scale.data(), shift.data(), dx->mut_dptr<T>());
   }
 
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
@@ -0,0 +1,478 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_ONE_EMBEDDING_DATA_SHUFFLE_H_
+#define ONEFLOW_USER_KERNELS_ONE_EMBEDDING_DATA_SHUFFLE_H_
+
+#include <numeric>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/embedding/hash_functions.cuh"
+#include "oneflow/user/kernels/collective_communication/include/all_gather.h"
+#include "oneflow/user/kernels/collective_communication/include/all_to_all.h"
+#include "oneflow/user/kernels/collective_communication/include/communication_context.h"
+
+namespace oneflow {
+
+namespace data_shuffle {
+
+// Host versions of the one_embedding data shuffle in one_embedding_data_shuffle.cuh. The ids
+// are deduplicated in shards which are processed in parallel by the threads of the stream, and
+// the data is exchanged between ranks by the ccl AllGather and AllToAll of the cpu device.
+
+namespace {
+
+constexpr uint32_t PADDING_REV_INDEX = 0xffffffff;
+constexpr int64_t kMinNumIdsPerShard = 4096;
+constexpr int64_t kParallelForElemGrain = 32768;
+
+inline int64_t RowGrainSize(int64_t row_size) {
+  return std::max<int64_t>(kParallelForElemGrain / std::max<int64_t>(row_size, 1), 1);
+}
+
+}  // namespace
+
+template<typename U>
+void GenerateTableIds(ep::CpuStream* stream, int64_t elem_cnt, int32_t num_tables, U* table_ids) {
+  stream->ParallelFor(0, elem_cnt, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) { table_ids[i] = i % num_tables; }
+  });
+}
+
+// Same outputs as the cuda UniqueAndPartition: the unique ids of partition p are stored from
+// partitioned_unique_ids + p * num_ids and the inverse index of an id is p * num_ids plus its
+// position in the partition. Every partition is split into shards by the hash of the id, the
+// shards are deduplicated in parallel and then concatenated, so the result is deterministic.
+template<typename K, typename V, typename IDX, typename HASH>
+void UniqueAndPartition(ep::CpuStream* stream, int64_t num_ids, int64_t num_partition,
+                        const K* ids, const V* table_ids, IDX* num_partitioned_unique_ids_ptr,
+                        K* partitioned_unique_ids, V* partitioned_unique_table_ids,
+                        IDX* inverse_unique_partition_indices, bool need_process_table_ids,
+                        const bool has_padding_idx, const int64_t padding_idx) {
+  const int64_t num_threads = stream->device()->GetNumThreads();
+  const int64_t num_shards =
+      std::max<int64_t>(std::min<int64_t>(num_threads, num_ids / kMinNumIdsPerShard), 1);
+  const int64_t num_buckets = num_partition * num_shards;
+  std::vector<int64_t> bucket_ids(num_ids);
+  stream->ParallelFor(0, num_ids, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const K key = ids[i];
+      if (has_padding_idx && key == static_cast<K>(padding_idx)) {
+        bucket_ids[i] = -1;
+      } else {
+        const size_t key_hash = HASH()(key);
+        bucket_ids[i] = (key_hash % num_partition) * num_shards
+                        + (key_hash / num_partition) % num_shards;
+      }
+    }
+  });
+  // counting sort the ids by bucket, keeping the order of the ids inside a bucket
+  std::vector<int64_t> bucket_offsets(num_buckets + 1, 0);
+  for (int64_t i = 0; i < num_ids; ++i) {
+    if (bucket_ids[i] >= 0) { bucket_offsets[bucket_ids[i] + 1] += 1; }
+  }
+  for (int64_t b = 0; b < num_buckets; ++b) { bucket_offsets[b + 1] += bucket_offsets[b]; }
+  std::vector<int64_t> sorted_ids(bucket_offsets[num_buckets]);
+  {
+    std::vector<int64_t> cursors(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (int64_t i = 0; i < num_ids; ++i) {
+      if (bucket_ids[i] >= 0) { sorted_ids[cursors[bucket_ids[i]]++] = i; }
+    }
+  }
+  // deduplicate every bucket, the unique ids of a bucket are written after the ids of the
+  // previous buckets of the same partition
+  std::vector<int64_t> bucket_num_unique(num_buckets, 0);
+  std::vector<IDX> local_index(num_ids);
+  std::vector<std::vector<int64_t>> bucket_unique_ids(num_buckets);
+  stream->ParallelFor(
+      0, num_buckets,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t b = begin; b < end; ++b) {
+          HashMap<K, IDX> key2index;
+          key2index.reserve(bucket_offsets[b + 1] - bucket_offsets[b]);
+          std::vector<int64_t>* unique_ids = &bucket_unique_ids[b];
+          for (int64_t j = bucket_offsets[b]; j < bucket_offsets[b + 1]; ++j) {
+            const int64_t i = sorted_ids[j];
+            auto ret = key2index.emplace(ids[i], static_cast<IDX>(unique_ids->size()));
+            if (ret.second) { unique_ids->push_back(i); }
+            local_index[i] = ret.first->second;
+          }
+          bucket_num_unique[b] = unique_ids->size();
+        }
+      },
+      1);
+  std::vector<int64_t> bucket_unique_offsets(num_buckets);
+  for (int64_t p = 0; p < num_partition; ++p) {
+    int64_t offset = 0;
+    for (int64_t s = 0; s < num_shards; ++s) {
+      bucket_unique_offsets[p * num_shards + s] = offset;
+      offset += bucket_num_unique[p * num_shards + s];
+    }
+    num_partitioned_unique_ids_ptr[p] = offset;
+  }
+  stream->ParallelFor(
+      0, num_buckets,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t b = begin; b < end; ++b) {
+          const int64_t partition_offset = (b / num_shards) * num_ids + bucket_unique_offsets[b];
+          const std::vector<int64_t>& unique_ids = bucket_unique_ids[b];
+          for (size_t j = 0; j < unique_ids.size(); ++j) {
+            partitioned_unique_ids[partition_offset + j] = ids[unique_ids[j]];
+            if (need_process_table_ids) {
+              partitioned_unique_table_ids[partition_offset + j] = table_ids[unique_ids[j]];
+            }
+          }
+          for (int64_t j = bucket_offsets[b]; j < bucket_offsets[b + 1]; ++j) {
+            const int64_t i = sorted_ids[j];
+            inverse_unique_partition_indices[i] = partition_offset + local_index[i];
+          }
+        }
+      },
+      1);
+  if (has_padding_idx) {
+    stream->ParallelFor(0, num_ids, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        if (bucket_ids[i] < 0) { inverse_unique_partition_indices[i] = PADDING_REV_INDEX; }
+      }
+    });
+  }
+}
+
+// out[i] = in[indices[i]], rows whose index is out of [0, num_in_rows) are set to zero, which
+// covers the PADDING_REV_INDEX of padding ids.
+template<typename T, typename IDX>
+void GatherRows(ep::CpuStream* stream, int64_t num_indices, const IDX* indices,
+                int64_t num_in_rows, int64_t row_size, const T* in, T* out) {
+  stream->ParallelFor(
+      0, num_indices,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t index = static_cast<int64_t>(indices[i]);
+          T* out_row = out + i * row_size;
+          if (index >= 0 && index < num_in_rows) {
+            std::copy(in + index * row_size, in + (index + 1) * row_size, out_row);
+          } else {
+            std::fill(out_row, out_row + row_size, static_cast<T>(0));
+          }
+        }
+      },
+      RowGrainSize(row_size));
+}
+
+// out[s] = sum of data[i] for all i with segment_ids[i] == s, rows whose segment id is out of
+// [0, num_segments) are skipped and segments without rows are left untouched. The rows of a
+// segment are added by one thread in their original order, so the result is deterministic.
+template<typename T, typename IDX>
+void UnsortedSegmentSumRows(ep::CpuStream* stream, int64_t num_rows, const IDX* segment_ids,
+                            const T* data, int64_t num_segments, int64_t row_size, T* out) {
+  using ComputeType = typename std::conditional<std::is_same<T, float16>::value, float, T>::type;
+  std::vector<int64_t> segment_offsets(num_segments + 1, 0);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    const int64_t segment_id = static_cast<int64_t>(segment_ids[i]);
+    if (segment_id >= 0 && segment_id < num_segments) { segment_offsets[segment_id + 1] += 1; }
+  }
+  for (int64_t s = 0; s < num_segments; ++s) { segment_offsets[s + 1] += segment_offsets[s]; }
+  std::vector<int64_t> sorted_rows(segment_offsets[num_segments]);
+  {
+    std::vector<int64_t> cursors(segment_offsets.begin(), segment_offsets.end() - 1);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      const int64_t segment_id = static_cast<int64_t>(segment_ids[i]);
+      if (segment_id >= 0 && segment_id < num_segments) { sorted_rows[cursors[segment_id]++] = i; }
+    }
+  }
+  stream->ParallelFor(
+      0, num_segments,
+      [&](int64_t begin, int64_t end) {
+        std::vector<ComputeType> sum(row_size);
+        for (int64_t s = begin; s < end; ++s) {
+          if (segment_offsets[s] == segment_offsets[s + 1]) { continue; }
+          std::fill(sum.begin(), sum.end(), static_cast<ComputeType>(0));
+          for (int64_t j = segment_offsets[s]; j < segment_offsets[s + 1]; ++j) {
+            const T* row = data + sorted_rows[j] * row_size;
+            for (int64_t k = 0; k < row_size; ++k) { sum[k] += static_cast<ComputeType>(row[k]); }
+          }
+          T* out_row = out + s * row_size;
+          for (int64_t k = 0; k < row_size; ++k) { out_row[k] = static_cast<T>(sum[k]); }
+        }
+      },
+      RowGrainSize(row_size));
+}
+
+// Counts and offsets of the AllToAll of the ids and embeddings. The send side takes
+// num_unique_matrix[parallel_id * parallel_num + i] rows for rank i, the recv side
+// num_unique_matrix[i * parallel_num + parallel_id] rows from rank i. When send_stride is
+// positive the rows for rank i start at i * send_stride, otherwise they are contiguous.
+template<typename IDX>
+void MakeAllToAllParams(const IDX* host_num_unique_matrix, int64_t send_stride, int64_t row_size,
+                        int64_t parallel_id, int64_t parallel_num,
+                        std::vector<int64_t>* send_counts, std::vector<int64_t>* send_offsets,
+                        std::vector<int64_t>* recv_counts, std::vector<int64_t>* recv_offsets) {
+  send_counts->resize(parallel_num);
+  send_offsets->resize(parallel_num);
+  recv_counts->resize(parallel_num);
+  recv_offsets->resize(parallel_num);
+  int64_t send_offset = 0;
+  int64_t recv_offset = 0;
+  for (int64_t i = 0; i < parallel_num; ++i) {
+    send_counts->at(i) = host_num_unique_matrix[parallel_id * parallel_num + i] * row_size;
+    recv_counts->at(i) = host_num_unique_matrix[i * parallel_num + parallel_id] * row_size;
+    send_offsets->at(i) = send_stride > 0 ? i * send_stride * row_size : send_offset;
+    recv_offsets->at(i) = recv_offset;
+    send_offset += send_counts->at(i);
+    recv_offset += recv_counts->at(i);
+  }
+}
+
+template<typename T>
+void AllToAll(ep::CpuStream* stream, const std::shared_ptr<ccl::CommunicationContext>& comm,
+              DataType data_type, const std::vector<int64_t>& send_counts,
+              const std::vector<int64_t>& send_offsets, const T* send_data,
+              const std::vector<int64_t>& recv_counts, const std::vector<int64_t>& recv_offsets,
+              T* recv_data) {
+  std::unique_ptr<ccl::AllToAll> all_to_all =
+      ccl::NewCollectiveCommunication<ccl::AllToAll>(DeviceType::kCPU, data_type);
+  all_to_all->Launch(stream, send_data, send_counts.data(), send_offsets.data(), recv_data,
+                     recv_counts.data(), recv_offsets.data(), comm);
+}
+
+template<typename IDX>
+int64_t CurRankNumIds(const IDX* host_num_unique_matrix, int64_t parallel_id,
+                      int64_t parallel_num) {
+  int64_t cur_rank_num_ids = 0;
+  for (int64_t i = 0; i < parallel_num; ++i) {
+    cur_rank_num_ids += host_num_unique_matrix[i * parallel_num + parallel_id];
+  }
+  return cur_rank_num_ids;
+}
+
+template<typename IDX>
+int64_t UniquePartitionedNumIds(const IDX* host_num_unique_matrix, int64_t parallel_id,
+                                int64_t parallel_num) {
+  int64_t unique_partitioned_num_ids = 0;
+  for (int64_t i = 0; i < parallel_num; ++i) {
+    unique_partitioned_num_ids += host_num_unique_matrix[parallel_id * parallel_num + i];
+  }
+  return unique_partitioned_num_ids;
+}
+
+// The host id_shuffle, all outputs have the layout of the cuda IdShuffle. With a single rank
+// the ids are deduplicated once and cur_rank_inverse_indices is the identity.
+template<typename K, typename U, typename IDX>
+void IdShuffle(ep::CpuStream* stream, const std::shared_ptr<ccl::CommunicationContext>& comm,
+               int64_t num_ids, int64_t parallel_id, int64_t parallel_num,
+               DataType num_unique_matrix_dtype, DataType ids_dtype, DataType table_ids_dtype,
+               const K* ids, const U* table_ids, bool need_process_table_ids,
+               const bool has_padding_idx, const int64_t padding_idx, IDX* num_unique_matrix,
+               IDX* inverse_unique_partition_indices, IDX* cur_rank_num_unique,
+               K* cur_rank_unique_ids, U* cur_rank_unique_table_ids,
+               IDX* cur_rank_inverse_indices) {
+  if (parallel_num == 1) {
+    UniqueAndPartition<K, U, IDX, embedding::LocalUniqueHash>(
+        stream, num_ids, 1, ids, table_ids, cur_rank_num_unique, cur_rank_unique_ids,
+        cur_rank_unique_table_ids, inverse_unique_partition_indices, need_process_table_ids,
+        has_padding_idx, padding_idx);
+    const IDX num_unique = *cur_rank_num_unique;
+    *num_unique_matrix = num_unique;
+    std::iota(cur_rank_inverse_indices, cur_rank_inverse_indices + num_unique, 0);
+    if (!need_process_table_ids) {
+      std::fill(cur_rank_unique_table_ids, cur_rank_unique_table_ids + num_unique, 0);
+    }
+    return;
+  }
+  std::vector<IDX> num_partitioned_unique(parallel_num);
+  std::vector<K> partitioned_unique_ids(parallel_num * num_ids);
+  std::vector<U> partitioned_unique_table_ids(need_process_table_ids ? parallel_num * num_ids
+                                                                     : 0);
+  UniqueAndPartition<K, U, IDX, embedding::ShardingHash>(
+      stream, num_ids, parallel_num, ids, table_ids, num_partitioned_unique.data(),
+      partitioned_unique_ids.data(), partitioned_unique_table_ids.data(),
+      inverse_unique_partition_indices, need_process_table_ids, has_padding_idx, padding_idx);
+  std::unique_ptr<ccl::AllGather> all_gather =
+      ccl::NewCollectiveCommunication<ccl::AllGather>(DeviceType::kCPU, num_unique_matrix_dtype);
+  all_gather->Launch(stream, num_partitioned_unique.data(), num_unique_matrix, parallel_num,
+                     comm);
+  // make the unique ids of all partitions contiguous, as they are sent to the other ranks
+  std::vector<IDX> partition_offsets(parallel_num);
+  IDX offset = 0;
+  for (int64_t p = 0; p < parallel_num; ++p) {
+    partition_offsets[p] = offset;
+    offset += num_partitioned_unique[p];
+  }
+  stream->ParallelFor(0, num_ids, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const IDX index = inverse_unique_partition_indices[i];
+      if (index == static_cast<IDX>(PADDING_REV_INDEX)) { continue; }
+      const int64_t partition_id = index / num_ids;
+      inverse_unique_partition_indices[i] =
+          partition_offsets[partition_id] + index - partition_id * num_ids;
+    }
+  });
+  std::vector<int64_t> send_counts;
+  std::vector<int64_t> send_offsets;
+  std::vector<int64_t> recv_counts;
+  std::vector<int64_t> recv_offsets;
+  MakeAllToAllParams(num_unique_matrix, num_ids, 1, parallel_id, parallel_num, &send_counts,
+                     &send_offsets, &recv_counts, &recv_offsets);
+  const int64_t received_elem_cnt = CurRankNumIds(num_unique_matrix, parallel_id, parallel_num);
+  std::vector<K> received_ids(received_elem_cnt);
+  AllToAll(stream, comm, ids_dtype, send_counts, send_offsets, partitioned_unique_ids.data(),
+           recv_counts, recv_offsets, received_ids.data());
+  std::vector<U> received_table_ids(need_process_table_ids ? received_elem_cnt : 0);
+  if (need_process_table_ids) {
+    AllToAll(stream, comm, table_ids_dtype, send_counts, send_offsets,
+             partitioned_unique_table_ids.data(), recv_counts, recv_offsets,
+             received_table_ids.data());
+  }
+  UniqueAndPartition<K, U, IDX, embedding::LocalUniqueHash>(
+      stream, received_elem_cnt, 1, received_ids.data(), received_table_ids.data(),
+      cur_rank_num_unique, cur_rank_unique_ids, cur_rank_unique_table_ids,
+      cur_rank_inverse_indices, need_process_table_ids, has_padding_idx, padding_idx);
+  if (!need_process_table_ids) {
+    std::fill(cur_rank_unique_table_ids, cur_rank_unique_table_ids + received_elem_cnt, 0);
+  }
+}
+
+// The host embedding_shuffle: sends the embeddings of the ids received by IdShuffle back to
+// their ranks and gathers them in the order of the ids. With skip_last_gather the embeddings are
+// returned in the order of the unique partitioned ids.
+template<typename T, typename IDX>
+void ShuffleEmbeddings(ep::CpuStream* stream,
+                       const std::shared_ptr<ccl::CommunicationContext>& comm, int64_t parallel_id,
+                       int64_t parallel_num, int64_t num_ids, int64_t embedding_size,
+                       DataType data_type, const IDX* host_num_unique_matrix,
+                       const T* cur_rank_embeddings, int64_t cur_rank_num_embeddings,
+                       const IDX* cur_rank_inverse_indices,
+                       const IDX* inverse_unique_partition_indices, bool skip_last_gather,
+                       T* embeddings) {
+  const int64_t cur_rank_num_ids =
+      CurRankNumIds(host_num_unique_matrix, parallel_id, parallel_num);
+  const int64_t unique_partitioned_num_ids =
+      UniquePartitionedNumIds(host_num_unique_matrix, parallel_id, parallel_num);
+  if (parallel_num == 1 && !skip_last_gather) {
+    // fuse the two gathers
+    std::vector<IDX> indices(num_ids);
+    stream->ParallelFor(0, num_ids, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const int64_t index = static_cast<int64_t>(inverse_unique_partition_indices[i]);
+        indices[i] = (index >= 0 && index < cur_rank_num_ids)
+                         ? cur_rank_inverse_indices[index]
+                         : static_cast<IDX>(PADDING_REV_INDEX);
+      }
+    });
+    GatherRows(stream, num_ids, indices.data(), cur_rank_num_embeddings, embedding_size,
+               cur_rank_embeddings, embeddings);
+    return;
+  }
+  std::vector<T> reverse_cur_rank_embeddings(cur_rank_num_ids * embedding_size);
+  GatherRows(stream, cur_rank_num_ids, cur_rank_inverse_indices, cur_rank_num_embeddings,
+             embedding_size, cur_rank_embeddings, reverse_cur_rank_embeddings.data());
+  std::vector<T> received_embeddings(
+      skip_last_gather ? 0 : unique_partitioned_num_ids * embedding_size);
+  T* received_embeddings_ptr = skip_last_gather ? embeddings : received_embeddings.data();
+  if (parallel_num == 1) {
+    std::copy(reverse_cur_rank_embeddings.begin(), reverse_cur_rank_embeddings.end(),
+              received_embeddings_ptr);
+  } else {
+    std::vector<int64_t> send_counts;
+    std::vector<int64_t> send_offsets;
+    std::vector<int64_t> recv_counts;
+    std::vector<int64_t> recv_offsets;
+    // the reverse of the id shuffle
+    MakeAllToAllParams(host_num_unique_matrix, 0, embedding_size, parallel_id, parallel_num,
+                       &recv_counts, &recv_offsets, &send_counts, &send_offsets);
+    AllToAll(stream, comm, data_type, send_counts, send_offsets,
+             reverse_cur_rank_embeddings.data(), recv_counts, recv_offsets,
+             received_embeddings_ptr);
+  }
+  if (!skip_last_gather) {
+    GatherRows(stream, num_ids, inverse_unique_partition_indices, unique_partitioned_num_ids,
+               embedding_size, received_embeddings_ptr, embeddings);
+  }
+}
+
+// The host embedding_gradient_shuffle: sums the gradients of the same id on this rank, sends the
+// sums to the ranks owning the ids and sums them again into cur_rank_unique_embedding_grad whose
+// first num_unique rows are all written. When only_zero_valid_grad is false the other rows are
+// set to zero. With skip_first_scatter embedding_grad is already summed per unique partitioned id.
+template<typename T, typename IDX>
+void ShuffleEmbeddingsGrad(ep::CpuStream* stream,
+                           const std::shared_ptr<ccl::CommunicationContext>& comm,
+                           int64_t parallel_id, int64_t parallel_num, int64_t num_ids,
+                           int64_t embedding_size, DataType data_type,
+                           const IDX* host_num_unique_matrix, const T* embedding_grad,
+                           const IDX* inverse_unique_partition_indices,
+                           const IDX* cur_rank_inverse_indices, bool skip_first_scatter,
+                           bool only_zero_valid_grad, int64_t cur_rank_unique_embedding_grad_rows,
+                           T* cur_rank_unique_embedding_grad) {
+  const int64_t cur_rank_num_ids =
+      CurRankNumIds(host_num_unique_matrix, parallel_id, parallel_num);
+  const int64_t unique_partitioned_num_ids =
+      UniquePartitionedNumIds(host_num_unique_matrix, parallel_id, parallel_num);
+  if (!only_zero_valid_grad) {
+    std::fill(cur_rank_unique_embedding_grad,
+              cur_rank_unique_embedding_grad + cur_rank_unique_embedding_grad_rows * embedding_size,
+              static_cast<T>(0));
+  }
+  if (parallel_num == 1 && !skip_first_scatter) {
+    // fuse the two segment sums
+    std::vector<IDX> segment_ids(num_ids);
+    stream->ParallelFor(0, num_ids, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const int64_t index = static_cast<int64_t>(inverse_unique_partition_indices[i]);
+        segment_ids[i] = (index >= 0 && index < cur_rank_num_ids)
+                             ? cur_rank_inverse_indices[index]
+                             : static_cast<IDX>(PADDING_REV_INDEX);
+      }
+    });
+    UnsortedSegmentSumRows(stream, num_ids, segment_ids.data(), embedding_grad,
+                           cur_rank_unique_embedding_grad_rows, embedding_size,
+                           cur_rank_unique_embedding_grad);
+    return;
+  }
+  std::vector<T> unique_partition_embedding_grad;
+  const T* unique_partition_embedding_grad_ptr = embedding_grad;
+  if (!skip_first_scatter) {
+    unique_partition_embedding_grad.resize(unique_partitioned_num_ids * embedding_size);
+    UnsortedSegmentSumRows(stream, num_ids, inverse_unique_partition_indices, embedding_grad,
+                           unique_partitioned_num_ids, embedding_size,
+                           unique_partition_embedding_grad.data());
+    unique_partition_embedding_grad_ptr = unique_partition_embedding_grad.data();
+  }
+  std::vector<T> received_embedding_grad;
+  const T* received_embedding_grad_ptr = unique_partition_embedding_grad_ptr;
+  if (parallel_num > 1) {
+    received_embedding_grad.resize(cur_rank_num_ids * embedding_size);
+    std::vector<int64_t> send_counts;
+    std::vector<int64_t> send_offsets;
+    std::vector<int64_t> recv_counts;
+    std::vector<int64_t> recv_offsets;
+    MakeAllToAllParams(host_num_unique_matrix, 0, embedding_size, parallel_id, parallel_num,
+                       &send_counts, &send_offsets, &recv_counts, &recv_offsets);
+    AllToAll(stream, comm, data_type, send_counts, send_offsets,
+             unique_partition_embedding_grad_ptr, recv_counts, recv_offsets,
+             received_embedding_grad.data());
+    received_embedding_grad_ptr = received_embedding_grad.data();
+  }
+  UnsortedSegmentSumRows(stream, cur_rank_num_ids, cur_rank_inverse_indices,
+                         received_embedding_grad_ptr, cur_rank_unique_embedding_grad_rows,
+                         embedding_size, cur_rank_unique_embedding_grad);
+}
+
+}  // namespace data_shuffle
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_ONE_EMBEDDING_DATA_SHUFFLE_H_
@@ -0,0 +1,507 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/embedding/key_value_store.h"
+#include "oneflow/core/embedding/embedding_manager.h"
+#include "oneflow/core/ep/include/primitive/cast.h"
+#include "oneflow/user/kernels/one_embedding_data_shuffle.h"
+#include "oneflow/user/kernels/one_embedding_initializer.h"
+
+namespace oneflow {
+
+namespace {
+
+// Host counterpart of the curand philox state of the CUDA kernels: the stream of every
+// (seed, id, col) is independent, so the initial value of an id does not depend on the thread
+// or on the batch it is first seen in. The values differ from the ones of the CUDA kernels.
+class HostInitRandom final {
+ public:
+  HostInitRandom(uint64_t seed, uint64_t id, uint64_t col)
+      : state_(SplitMix(seed ^ SplitMix(id ^ SplitMix(col)))) {}
+
+  // uniform in (0, 1], as curand_uniform
+  float Uniform() { return (static_cast<float>(Next() >> 40) + 1.0f) * (1.0f / 16777216.0f); }
+  float Normal() {
+    const float u1 = Uniform();
+    const float u2 = Uniform();
+    return std::sqrt(-2.0f * std::log(u1)) * std::cos(2.0f * static_cast<float>(M_PI) * u2);
+  }
+
+ private:
+  static uint64_t SplitMix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+  uint64_t Next() {
+    state_ += 0x9E3779B97F4A7C15ULL;
+    return SplitMix(state_);
+  }
+
+  uint64_t state_;
+};
+
+void MakeConstantInitializerAttr(const int64_t embedding_size, const int64_t line_size,
+                                 const std::vector<float>& values, std::string* initializer_attr) {
+  if (embedding_size == line_size) { return; }
+  const int32_t num_states = line_size / embedding_size - 1;
+  CHECK_GT(num_states, 0) << "num_states " << num_states;
+  CHECK(values.size() == 0 || num_states == values.size())
+      << "must set " << num_states << " optimizer states init value, but get " << values.size();
+  nlohmann::json initializers;
+  for (int32_t i = 0; i < num_states; ++i) {
+    nlohmann::json initializer;
+    initializer["type"] = "constant";
+    const float initial_value = values.size() > 0 ? values.at(i) : 0.0;
+    initializer["value"] = initial_value;
+    initializers.push_back(initializer);
+  }
+  *initializer_attr = initializers.dump();
+}
+
+class EmbeddingKernelState final : public user_op::OpKernelState {
+ public:
+  EmbeddingKernelState(user_op::KernelInitContext* ctx, const std::string& state_initializer,
+                       int64_t max_query_length) {
+    const std::string& embedding_name = ctx->Attr<std::string>("embedding_name");
+    const int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+    key_value_store_ = Singleton<embedding::EmbeddingManager>::Get()->GetKeyValueStore(
+        embedding_name, parallel_id);
+    key_value_store_->ReserveQueryLength(max_query_length);
+    ParseInitializers(ctx->Attr<int64_t>("line_size"), ctx->Attr<int64_t>("embedding_size"),
+                      state_initializer, ctx->Attr<std::string>("embedding_tables"),
+                      &initializer_param_, &initializer_index_);
+    if (ctx->parallel_ctx().parallel_num() > 1) {
+      comm_ = ccl::NewCommunicationContext(DeviceType::kCPU, SymbolOf(ctx->parallel_desc()));
+    }
+  }
+  ~EmbeddingKernelState() override = default;
+
+  embedding::KeyValueStore* KeyValueStore() { return key_value_store_; }
+  const std::shared_ptr<ccl::CommunicationContext>& comm() const { return comm_; }
+  const std::vector<int8_t>& InitializerIndex() const { return initializer_index_; }
+  const std::vector<EmbeddingInitializer>& Initializers() const { return initializer_param_; }
+
+ private:
+  embedding::KeyValueStore* key_value_store_;
+  std::shared_ptr<ccl::CommunicationContext> comm_;
+  std::vector<EmbeddingInitializer> initializer_param_;
+  std::vector<int8_t> initializer_index_;
+};
+
+class EmbeddingPutKernelState final : public user_op::OpKernelState {
+ public:
+  explicit EmbeddingPutKernelState(user_op::KernelInitContext* ctx) {
+    const std::string& embedding_name = ctx->Attr<std::string>("embedding_name");
+    const int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+    key_value_store_ = Singleton<embedding::EmbeddingManager>::Get()->GetKeyValueStore(
+        embedding_name, parallel_id);
+    uint32_t max_query_length =
+        ctx->TensorDesc4ArgNameAndIndex("unique_ids", 0)->shape().elem_cnt();
+    key_value_store_->ReserveQueryLength(max_query_length);
+  }
+  ~EmbeddingPutKernelState() override = default;
+
+  embedding::KeyValueStore* KeyValueStore() { return key_value_store_; }
+
+ private:
+  embedding::KeyValueStore* key_value_store_;
+};
+
+template<typename T, typename K, typename U>
+void InitMissingValues(ep::CpuStream* stream, uint64_t seed, const int64_t line_size,
+                       const EmbeddingInitializer* initializer_param,
+                       const int8_t* initializer_index, const K* unique_ids, const U* table_ids,
+                       uint32_t num_missing, const uint32_t* missing_indices, T* values) {
+  stream->ParallelFor(
+      0, num_missing,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const uint32_t index = missing_indices[row];
+          const int32_t table_idx = table_ids[index];
+          const K id = unique_ids[index];
+          for (int64_t col = 0; col < line_size; ++col) {
+            HostInitRandom random(seed, static_cast<uint64_t>(id), col);
+            const EmbeddingInitializer& initializer =
+                initializer_param[initializer_index[table_idx * line_size + col]];
+            float value;
+            if (initializer.type == InitializerType::kUniform) {
+              const float low = initializer.uniform_param.low;
+              const float high = initializer.uniform_param.high;
+              value = random.Uniform() * (high - low) + low;
+            } else if (initializer.type == InitializerType::kNormal) {
+              value = random.Normal() * initializer.normal_param.std
+                      + initializer.normal_param.mean;
+            } else if (initializer.type == InitializerType::kConstant) {
+              value = initializer.constant_param.value;
+            } else if (initializer.type == InitializerType::kTruncNormal) {
+              const float mean = initializer.trunc_normal_param.mean;
+              const float std = initializer.trunc_normal_param.std;
+              const float a = initializer.trunc_normal_param.a;
+              const float b = initializer.trunc_normal_param.b;
+              do { value = random.Normal() * std + mean; } while (value < a || value > b);
+            } else {
+              UNIMPLEMENTED();
+            }
+            values[index * line_size + col] = static_cast<T>(value);
+          }
+        }
+      },
+      1);
+}
+
+template<typename T, typename K, typename U>
+void LookupAndInitMissing(ep::CpuStream* stream, EmbeddingKernelState* kernel_state,
+                          uint64_t seed, uint32_t num_unique, const int64_t line_size,
+                          const bool put_to_store, const void* unique_ids, const void* table_ids,
+                          void* store_values) {
+  embedding::KeyValueStore* store = kernel_state->KeyValueStore();
+  uint32_t num_missing = 0;
+  std::vector<uint32_t> missing_indices(num_unique);
+  store->Get(stream, num_unique, unique_ids, store_values, &num_missing, missing_indices.data());
+  if (num_missing > 0) {
+    InitMissingValues<T, K, U>(stream, seed, line_size, kernel_state->Initializers().data(),
+                               kernel_state->InitializerIndex().data(),
+                               reinterpret_cast<const K*>(unique_ids),
+                               reinterpret_cast<const U*>(table_ids), num_missing,
+                               missing_indices.data(), reinterpret_cast<T*>(store_values));
+  }
+  if (put_to_store) { store->Put(stream, num_unique, unique_ids, store_values); }
+}
+
+template<typename T, typename V>
+void CopyValuesToEmbeddingsImpl(ep::CpuStream* stream, int64_t num_unique,
+                                const int64_t embedding_size, const int64_t line_size,
+                                const T* values, V* embeddings) {
+  stream->ParallelFor(0, num_unique, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const T* src = values + row * line_size;
+      V* dst = embeddings + row * embedding_size;
+      for (int64_t col = 0; col < embedding_size; ++col) { dst[col] = static_cast<V>(src[col]); }
+    }
+  });
+}
+
+template<typename T>
+void CopyValuesToEmbeddings(ep::CpuStream* stream, int64_t num_unique,
+                            const int64_t embedding_size, const int64_t line_size,
+                            DataType value_dtype, DataType embeddings_dtype, const T* values,
+                            void* embeddings) {
+  CHECK_EQ(GetDataType<T>::value, value_dtype);
+  if (embeddings_dtype == DataType::kFloat) {
+    CopyValuesToEmbeddingsImpl(stream, num_unique, embedding_size, line_size, values,
+                               reinterpret_cast<float*>(embeddings));
+  } else if (embeddings_dtype == DataType::kFloat16) {
+    CopyValuesToEmbeddingsImpl(stream, num_unique, embedding_size, line_size, values,
+                               reinterpret_cast<float16*>(embeddings));
+  } else {
+    UNIMPLEMENTED() << "Unimplemented data_type " << embeddings_dtype;
+  }
+}
+
+}  // namespace
+
+#define ID_DATA_TYPE_SEQ                            \
+  OF_PP_MAKE_TUPLE_SEQ(uint32_t, DataType::kUInt32) \
+  OF_PP_MAKE_TUPLE_SEQ(uint64_t, DataType::kUInt64) \
+  OF_PP_MAKE_TUPLE_SEQ(int32_t, DataType::kInt32)   \
+  OF_PP_MAKE_TUPLE_SEQ(int64_t, DataType::kInt64)
+
+#define TABLE_ID_DATA_TYPE_SEQ                      \
+  OF_PP_MAKE_TUPLE_SEQ(uint8_t, DataType::kUInt8)   \
+  OF_PP_MAKE_TUPLE_SEQ(uint32_t, DataType::kUInt32) \
+  OF_PP_MAKE_TUPLE_SEQ(uint64_t, DataType::kUInt64) \
+  OF_PP_MAKE_TUPLE_SEQ(int8_t, DataType::kInt8)     \
+  OF_PP_MAKE_TUPLE_SEQ(int32_t, DataType::kInt32)   \
+  OF_PP_MAKE_TUPLE_SEQ(int64_t, DataType::kInt64)
+
+#define IDX_DATA_TYPE_SEQ                           \
+  OF_PP_MAKE_TUPLE_SEQ(uint32_t, DataType::kUInt32) \
+  OF_PP_MAKE_TUPLE_SEQ(int32_t, DataType::kInt32)
+
+#define EMBEDDING_DATA_TYPE_SEQ OF_PP_MAKE_TUPLE_SEQ(float, DataType::kFloat)
+
+template<typename T, typename K, typename U, typename IDX>
+class EmbeddingLookupKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingLookupKernel() = default;
+  ~EmbeddingLookupKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<EmbeddingKernelState>(
+        ctx, ctx->Attr<std::string>("state_initializer"),
+        ctx->TensorDesc4ArgNameAndIndex("unique_ids", 0)->shape().elem_cnt());
+  }
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    auto* kernel_state = dynamic_cast<EmbeddingKernelState*>(state);
+    CHECK(kernel_state != nullptr);
+    const user_op::Tensor* num_unique_ids = ctx->Tensor4ArgNameAndIndex("num_unique_ids", 0);
+    const user_op::Tensor* unique_ids = ctx->Tensor4ArgNameAndIndex("unique_ids", 0);
+    const user_op::Tensor* table_ids = ctx->Tensor4ArgNameAndIndex("table_ids", 0);
+    user_op::Tensor* unique_values = ctx->Tensor4ArgNameAndIndex("unique_values", 0);
+    const int64_t embedding_size = ctx->Attr<int64_t>("embedding_size");
+    const int64_t line_size = ctx->Attr<int64_t>("line_size");
+    const int64_t seed = ctx->Attr<int64_t>("seed");
+    ep::CpuStream* cpu_stream = ctx->stream()->As<ep::CpuStream>();
+    // num_unique_ids is a host tensor, there is no EmbeddingState to pass it on the CPU
+    const uint32_t num_unique = *reinterpret_cast<const IDX*>(num_unique_ids->dptr());
+    LookupAndInitMissing<T, K, U>(cpu_stream, kernel_state, seed, num_unique, line_size, false,
+                                  unique_ids->dptr(), table_ids->dptr(),
+                                  unique_values->mut_dptr());
+    if (ctx->has_output("embeddings", 0)) {
+      user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+      CopyValuesToEmbeddings<T>(cpu_stream, num_unique, embedding_size, line_size,
+                                unique_values->data_type(), embeddings->data_type(),
+                                unique_values->dptr<T>(), embeddings->mut_dptr());
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_EMBEDDING_LOOKUP_KERNEL(t_dtype_pair, k_dtype_pair, table_dtype_pair, \
+                                             idx_dtype_pair)                               \
+  REGISTER_USER_KERNEL("embedding_lookup")                                                 \
+      .SetCreateFn<EmbeddingLookupKernel<                                                  \
+          OF_PP_PAIR_FIRST(t_dtype_pair), OF_PP_PAIR_FIRST(k_dtype_pair),                  \
+          OF_PP_PAIR_FIRST(table_dtype_pair), OF_PP_PAIR_FIRST(idx_dtype_pair)>>()         \
+      .SetIsMatchedHob(                                                                    \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                   \
+          && (user_op::HobDataType("unique_values", 0) == OF_PP_PAIR_SECOND(t_dtype_pair)) \
+          && (user_op::HobDataType("unique_ids", 0) == OF_PP_PAIR_SECOND(k_dtype_pair))    \
+          && (user_op::HobDataType("table_ids", 0) == OF_PP_PAIR_SECOND(table_dtype_pair)) \
+          && (user_op::HobDataType("num_unique_ids", 0) == OF_PP_PAIR_SECOND(idx_dtype_pair)));
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_EMBEDDING_LOOKUP_KERNEL, EMBEDDING_DATA_TYPE_SEQ,
+                                 ID_DATA_TYPE_SEQ, TABLE_ID_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+
+template<typename IDX>
+class EmbeddingPutKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingPutKernel() = default;
+  ~EmbeddingPutKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<EmbeddingPutKernelState>(ctx);
+  }
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    auto* kernel_state = dynamic_cast<EmbeddingPutKernelState*>(state);
+    CHECK(kernel_state != nullptr);
+    embedding::KeyValueStore* store = kernel_state->KeyValueStore();
+    const user_op::Tensor* num_unique_ids = ctx->Tensor4ArgNameAndIndex("num_unique_ids", 0);
+    const user_op::Tensor* unique_ids = ctx->Tensor4ArgNameAndIndex("unique_ids", 0);
+    const user_op::Tensor* unique_embeddings = ctx->Tensor4ArgNameAndIndex("unique_embeddings", 0);
+    const uint32_t num_unique = *reinterpret_cast<const IDX*>(num_unique_ids->dptr());
+    store->Put(ctx->stream(), num_unique, unique_ids->dptr(), unique_embeddings->dptr());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_EMBEDDING_PUT_KERNEL(dtype, typeproto)           \
+  REGISTER_USER_KERNEL("embedding_put")                               \
+      .SetCreateFn<EmbeddingPutKernel<dtype>>()                       \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("num_unique_ids", 0) == typeproto));
+
+OF_PP_FOR_EACH_TUPLE(REGISTER_CPU_EMBEDDING_PUT_KERNEL, IDX_DATA_TYPE_SEQ)
+
+class IdShuffleCopyOutKernel final : public user_op::OpKernel {
+ public:
+  IdShuffleCopyOutKernel() = default;
+  ~IdShuffleCopyOutKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    for (const std::string& name :
+         {"inverse_unique_partition_indices", "cur_rank_num_unique", "cur_rank_unique_ids",
+          "cur_rank_unique_table_ids", "cur_rank_inverse_indices", "num_unique_matrix"}) {
+      const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex(name, 0);
+      user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out_" + name, 0);
+      const size_t size = in->shape_view().elem_cnt() * GetSizeOfDataType(in->data_type());
+      CHECK_EQ(out->shape_view().elem_cnt() * GetSizeOfDataType(out->data_type()), size);
+      std::memcpy(out->mut_dptr(), in->dptr(), size);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("id_shuffle_copy_out")
+    .SetCreateFn<IdShuffleCopyOutKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU));
+
+template<typename K, typename T, typename V, typename U, typename IDX>
+class OneEmbeddingFusedLookupKernel final : public user_op::OpKernel {
+ public:
+  OneEmbeddingFusedLookupKernel() = default;
+  ~OneEmbeddingFusedLookupKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    // Note(guoran): This op have no optimizer info, so set embedding states initializer constant
+    // 0, which may make error in optimizer with initial_accumulator_value like adagrad and ftrl.
+    std::string state_initializer;
+    MakeConstantInitializerAttr(ctx->Attr<int64_t>("embedding_size"),
+                                ctx->Attr<int64_t>("line_size"), {}, &state_initializer);
+    return std::make_shared<EmbeddingKernelState>(
+        ctx, state_initializer,
+        ctx->TensorDesc4ArgNameAndIndex("ids", 0)->shape().elem_cnt()
+            * ctx->parallel_ctx().parallel_num());
+  }
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    // IDX type is uint32_t, table_ids type is uint8_t.
+    DataType num_unique_matrix_dtype = DataType::kUInt32;
+    DataType table_ids_dtype = DataType::kUInt8;
+    CHECK_EQ(sizeof(IDX), GetSizeOfDataType(num_unique_matrix_dtype));
+    CHECK_EQ(sizeof(U), GetSizeOfDataType(table_ids_dtype));
+    auto* kernel_state = dynamic_cast<EmbeddingKernelState*>(state);
+    CHECK(kernel_state != nullptr);
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+    const int32_t num_tables = ctx->Attr<int32_t>("num_tables");
+    // default uint8_t as table_ids type, so num_tables can not greater than 256.
+    CHECK_LE(num_tables, 256) << num_tables;
+    const bool has_table_ids = ctx->has_input("table_ids", 0);
+    const bool need_process_table_ids = (has_table_ids || num_tables > 1);
+    const int64_t num_ids = ids->shape_view().elem_cnt();
+    const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+    const int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+    DataType value_dtype = ctx->Attr<DataType>("dtype");
+    const int64_t embedding_size = ctx->Attr<int64_t>("embedding_size");
+    const int64_t line_size = ctx->Attr<int64_t>("line_size");
+    const int64_t padding_idx = ctx->Attr<int64_t>("padding_idx");
+    const bool has_padding_idx = ctx->Attr<bool>("has_padding_idx");
+    const bool need_embeddings =
+        (line_size != embedding_size) || (value_dtype != embeddings->data_type());
+    ep::CpuStream* cpu_stream = ctx->stream()->As<ep::CpuStream>();
+
+    std::vector<U> tmp_table_ids;
+    const U* table_ids_ptr = nullptr;
+    if (need_process_table_ids) {
+      if (has_table_ids) {
+        // use table_id default data_type uint8, if has input table_ids with different data_type,
+        // cast it to uint8.
+        const user_op::Tensor* table_ids = ctx->Tensor4ArgNameAndIndex("table_ids", 0);
+        if (table_ids->data_type() != table_ids_dtype) {
+          tmp_table_ids.resize(num_ids);
+          std::unique_ptr<ep::primitive::Cast> cast_primitive =
+              ep::primitive::NewPrimitive<ep::primitive::CastFactory>(
+                  DeviceType::kCPU, table_ids->data_type(), table_ids_dtype);
+          cast_primitive->Launch(ctx->stream(), table_ids->dptr(), tmp_table_ids.data(),
+                                 table_ids->shape_view().elem_cnt());
+          table_ids_ptr = tmp_table_ids.data();
+        } else {
+          table_ids_ptr = reinterpret_cast<const U*>(table_ids->dptr());
+        }
+      } else {
+        tmp_table_ids.resize(num_ids);
+        data_shuffle::GenerateTableIds(cpu_stream, num_ids, num_tables, tmp_table_ids.data());
+        table_ids_ptr = tmp_table_ids.data();
+      }
+    }
+
+    const int64_t max_num_received = num_ids * parallel_num;
+    std::vector<IDX> num_unique_matrix(parallel_num * parallel_num);
+    std::vector<IDX> inverse_unique_partition_indices(num_ids);
+    IDX num_unique = 0;
+    std::vector<K> cur_rank_unique_ids(max_num_received);
+    std::vector<U> cur_rank_unique_table_ids(max_num_received);
+    std::vector<IDX> cur_rank_inverse_indices(max_num_received);
+    data_shuffle::IdShuffle<K, U, IDX>(
+        cpu_stream, kernel_state->comm(), num_ids, parallel_id, parallel_num,
+        num_unique_matrix_dtype, ids->data_type(), table_ids_dtype,
+        reinterpret_cast<const K*>(ids->dptr()), table_ids_ptr, need_process_table_ids,
+        has_padding_idx, padding_idx, num_unique_matrix.data(),
+        inverse_unique_partition_indices.data(), &num_unique, cur_rank_unique_ids.data(),
+        cur_rank_unique_table_ids.data(), cur_rank_inverse_indices.data());
+
+    // lookup and put, if is_full_cache, not put to store.
+    std::vector<V> values(num_unique * line_size);
+    const bool is_full_cache = ctx->Attr<bool>("is_full_cache");
+    const bool put_to_store = (!is_full_cache);
+    const int64_t seed = ctx->Attr<int64_t>("seed");
+    LookupAndInitMissing<V, K, U>(cpu_stream, kernel_state, seed, num_unique, line_size,
+                                  put_to_store, cur_rank_unique_ids.data(),
+                                  cur_rank_unique_table_ids.data(), values.data());
+    std::vector<T> cur_rank_embeddings(need_embeddings ? num_unique * embedding_size : 0);
+    const T* cur_rank_embeddings_ptr = reinterpret_cast<const T*>(values.data());
+    if (need_embeddings) {
+      CopyValuesToEmbeddings<V>(cpu_stream, num_unique, embedding_size, line_size, value_dtype,
+                                embeddings->data_type(), values.data(),
+                                cur_rank_embeddings.data());
+      cur_rank_embeddings_ptr = cur_rank_embeddings.data();
+    }
+
+    // embedding shuffle
+    data_shuffle::ShuffleEmbeddings<T, IDX>(
+        cpu_stream, kernel_state->comm(), parallel_id, parallel_num, num_ids, embedding_size,
+        embeddings->data_type(), num_unique_matrix.data(), cur_rank_embeddings_ptr, num_unique,
+        cur_rank_inverse_indices.data(), inverse_unique_partition_indices.data(), false,
+        embeddings->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+// Note(guoran): Default use U type as uint8_t, IDX as uint32_t. Because table_ids is optional, so
+// can not use it in hob, if has table_ids input and dtype is not uint8_t cast to uint8_t in kernel.
+#define REGISTER_CPU_ONE_EMBEDDING_FUSED_LOOKUP_KERNEL(k_dtype_pair, t_dtype_pair, v_dtype_pair) \
+  REGISTER_USER_KERNEL("one_embedding_fused_lookup")                                             \
+      .SetCreateFn<OneEmbeddingFusedLookupKernel<                                                \
+          OF_PP_PAIR_FIRST(k_dtype_pair), OF_PP_PAIR_FIRST(t_dtype_pair),                        \
+          OF_PP_PAIR_FIRST(v_dtype_pair), uint8_t, uint32_t>>()                                  \
+      .SetIsMatchedHob(                                                                          \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                         \
+          && (user_op::HobDataType("ids", 0) == OF_PP_PAIR_SECOND(k_dtype_pair))                 \
+          && (user_op::HobDataType("embeddings", 0) == OF_PP_PAIR_SECOND(t_dtype_pair))          \
+          && (user_op::HobAttr<DataType>("dtype") == OF_PP_PAIR_SECOND(v_dtype_pair)));
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_FUSED_LOOKUP_KERNEL, ID_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ,
+                                 EMBEDDING_DATA_TYPE_SEQ)
+
+class OneEmbeddingFusedLookupGradKernel final : public user_op::OpKernel {
+ public:
+  OneEmbeddingFusedLookupGradKernel() = default;
+  ~OneEmbeddingFusedLookupGradKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    // do nothing
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("one_embedding_fused_lookup_grad")
+    .SetCreateFn<OneEmbeddingFusedLookupGradKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU));
+
+}  // namespace oneflow
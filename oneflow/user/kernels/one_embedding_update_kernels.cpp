@@ -0,0 +1,301 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/user/kernels/model_update_kernel_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// The inputs shared by all one_embedding update kernels. On the CPU there is no EmbeddingState,
+// the kernels read unique_embeddings and the host num_unique_ids tensor directly.
+template<typename T, typename IDX>
+struct EmbeddingUpdateArgs {
+  explicit EmbeddingUpdateArgs(user_op::KernelComputeContext* ctx) {
+    const user_op::Tensor* num_unique_ids = ctx->Tensor4ArgNameAndIndex("num_unique_ids", 0);
+    const user_op::Tensor* embedding_grad = ctx->Tensor4ArgNameAndIndex("embedding_grad", 0);
+    CHECK_EQ(embedding_grad->shape_view().NumAxes(), 2)
+        << "The NumAxes of embedding_grad should be equal to 2. ";
+    line_size = ctx->Attr<int64_t>("line_size");
+    embedding_size = ctx->Attr<int64_t>("embedding_size");
+    CHECK_EQ(embedding_grad->shape_view().At(1), embedding_size);
+    num_unique = *reinterpret_cast<const IDX*>(num_unique_ids->dptr());
+    scale = static_cast<T>(ctx->Attr<double>("scale"));
+    if (ctx->has_input("scale_by_tensor", 0)) {
+      const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+      CHECK_EQ(scale_by_tensor->shape_view().elem_cnt(), 1);
+      scale *= *scale_by_tensor->dptr<T>();
+    }
+    if (ctx->has_input("down_scale_by_tensor", 0)) {
+      const user_op::Tensor* down_scale_by_tensor =
+          ctx->Tensor4ArgNameAndIndex("down_scale_by_tensor", 0);
+      CHECK_EQ(down_scale_by_tensor->shape_view().elem_cnt(), 1);
+      scale /= *down_scale_by_tensor->dptr<T>();
+    }
+    learning_rate = ctx->Attr<float>("learning_rate_val");
+    if (ctx->has_input("learning_rate", 0)) {
+      learning_rate = *ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>();
+    }
+    skip = false;
+    if (ctx->has_input("skip_if", 0)) {
+      const user_op::Tensor* skip_if = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+      CHECK_EQ(skip_if->shape_view().elem_cnt(), 1);
+      skip = (*skip_if->dptr<int64_t>() != 0);
+    }
+    unique_embeddings = ctx->Tensor4ArgNameAndIndex("unique_embeddings", 0)->dptr<T>();
+    updated_unique_embeddings =
+        ctx->Tensor4ArgNameAndIndex("updated_unique_embeddings", 0)->mut_dptr<T>();
+  }
+
+  int64_t line_size;
+  int64_t embedding_size;
+  int64_t num_unique;
+  T scale;
+  float learning_rate;
+  bool skip;
+  const T* unique_embeddings;
+  T* updated_unique_embeddings;
+};
+
+// Copies the lines of the unique ids to the output and, unless skipped, calls
+// update(model_diff, model, states) for every model column of a line, the optimizer states of
+// the column are at states[k * embedding_size].
+template<typename T, typename G, typename IDX, typename UpdateFn>
+void EmbeddingUpdate(user_op::KernelComputeContext* ctx, const EmbeddingUpdateArgs<T, IDX>& args,
+                     const UpdateFn& update) {
+  const G* embedding_grad = ctx->Tensor4ArgNameAndIndex("embedding_grad", 0)->dptr<G>();
+  const int64_t line_size = args.line_size;
+  const int64_t embedding_size = args.embedding_size;
+  const bool skip = args.skip;
+  ctx->stream()->As<ep::CpuStream>()->ParallelFor(0, args.num_unique, [&](int64_t begin,
+                                                                          int64_t end) {
+    std::copy(args.unique_embeddings + begin * line_size,
+              args.unique_embeddings + end * line_size,
+              args.updated_unique_embeddings + begin * line_size);
+    if (skip) { return; }
+    for (int64_t row = begin; row < end; ++row) {
+      T* model = args.updated_unique_embeddings + row * line_size;
+      const G* model_diff = embedding_grad + row * embedding_size;
+      for (int64_t col = 0; col < embedding_size; ++col) {
+        update(model_diff + col, model + col, model + embedding_size + col);
+      }
+    }
+  });
+}
+
+}  // namespace
+
+template<typename T, typename G, typename IDX>
+class SgdEmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  SgdEmbeddingUpdateKernel() = default;
+  ~SgdEmbeddingUpdateKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const EmbeddingUpdateArgs<T, IDX> args(ctx);
+    const float l1 = ctx->Attr<float>("l1");
+    const float l2 = ctx->Attr<float>("l2");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    EmbeddingUpdate<T, G, IDX>(ctx, args, [&](const G* model_diff, T* model, T* states) {
+      SGDUpdateFunctor<T, G>()(model_diff, model, args.scale, l1, l2, weight_decay,
+                               args.learning_rate);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T, typename G, typename IDX>
+class MomentumEmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  MomentumEmbeddingUpdateKernel() = default;
+  ~MomentumEmbeddingUpdateKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const EmbeddingUpdateArgs<T, IDX> args(ctx);
+    CHECK_EQ(args.line_size, args.embedding_size * 2);
+    const float l1 = ctx->Attr<float>("l1");
+    const float l2 = ctx->Attr<float>("l2");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    const auto beta = ctx->Attr<float>("beta");
+    // TODO: Suppoprt dampening, nesterov, maximize in OneEmbeddingMomentumUpdate(zhengzekang).
+    const float dampening = 0.0;
+    const bool nesterov = false;
+    const bool maximize = false;
+    EmbeddingUpdate<T, G, IDX>(ctx, args, [&](const G* model_diff, T* model, T* states) {
+      MomentumUpdateFunctor<T, G>()(model_diff, model, states, args.scale, l1, l2, beta,
+                                    dampening, nesterov, maximize, weight_decay,
+                                    args.learning_rate);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T, typename G, typename IDX>
+class AdamEmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  AdamEmbeddingUpdateKernel() = default;
+  ~AdamEmbeddingUpdateKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const EmbeddingUpdateArgs<T, IDX> args(ctx);
+    CHECK_EQ(args.line_size, args.embedding_size * 3);
+    const float l1 = ctx->Attr<float>("l1");
+    const float l2 = ctx->Attr<float>("l2");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    const auto beta1 = ctx->Attr<float>("beta1");
+    const auto beta2 = ctx->Attr<float>("beta2");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    float bias_correction1 = ctx->Attr<float>("bias_correction1_val");
+    if (ctx->has_input("bias_correction1", 0)) {
+      bias_correction1 = *ctx->Tensor4ArgNameAndIndex("bias_correction1", 0)->dptr<float>();
+    }
+    float bias_correction2 = ctx->Attr<float>("bias_correction2_val");
+    if (ctx->has_input("bias_correction2", 0)) {
+      bias_correction2 = *ctx->Tensor4ArgNameAndIndex("bias_correction2", 0)->dptr<float>();
+    }
+    const int64_t embedding_size = args.embedding_size;
+    EmbeddingUpdate<T, G, IDX>(ctx, args, [&](const G* model_diff, T* model, T* states) {
+      AdamUpdateFunctor<T, G>()(model_diff, model, states, states + embedding_size, nullptr,
+                                args.scale, l1, l2, beta1, beta2, epsilon, weight_decay, false,
+                                bias_correction1, bias_correction2, args.learning_rate);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T, typename G, typename IDX>
+class AdagradEmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  AdagradEmbeddingUpdateKernel() = default;
+  ~AdagradEmbeddingUpdateKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const EmbeddingUpdateArgs<T, IDX> args(ctx);
+    CHECK_EQ(args.line_size, args.embedding_size * 2);
+    const float l1 = ctx->Attr<float>("l1");
+    const float l2 = ctx->Attr<float>("l2");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    const auto lr_decay = ctx->Attr<float>("lr_decay");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    int64_t train_step = ctx->Attr<int64_t>("train_step_val");
+    if (ctx->has_input("train_step", 0)) {
+      train_step = *ctx->Tensor4ArgNameAndIndex("train_step", 0)->dptr<int64_t>() + 1;
+    }
+    const float learning_rate = args.learning_rate / (1 + (train_step - 1) * lr_decay);
+    EmbeddingUpdate<T, G, IDX>(ctx, args, [&](const G* model_diff, T* model, T* states) {
+      AdagradUpdateFunctor<T, G>()(model_diff, model, states, args.scale, l1, l2, epsilon,
+                                   weight_decay, learning_rate);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T, typename G, typename IDX>
+class FtrlEmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  FtrlEmbeddingUpdateKernel() = default;
+  ~FtrlEmbeddingUpdateKernel() override = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const EmbeddingUpdateArgs<T, IDX> args(ctx);
+    CHECK_EQ(args.line_size, args.embedding_size * 3)
+        << "The line_size should be equal to 3 x embedding_size. ";
+    const float l1 = 0.0;
+    const float l2 = 0.0;
+    const float weight_decay = ctx->Attr<float>("weight_decay");
+    // TODO(zhengzekang): Undefined behavior for ftrl optimizer with weight_decay in `abs(new_z_val)
+    // < lambda1` condition.
+    CHECK_EQ(weight_decay, static_cast<float>(0.0))
+        << "Currently not support for setting weight decay. ";
+    const float lr_power = ctx->Attr<float>("lr_power");
+    const float lambda1 = ctx->Attr<float>("lambda1");
+    const float lambda2 = ctx->Attr<float>("lambda2");
+    const float beta = ctx->Attr<float>("beta");
+    const int64_t embedding_size = args.embedding_size;
+    EmbeddingUpdate<T, G, IDX>(ctx, args, [&](const G* model_diff, T* model, T* states) {
+      FtrlUpdateFunctor<T, G>()(model_diff, model, states, states + embedding_size, args.scale,
+                                l1, l2, lr_power, lambda1, lambda2, beta, weight_decay,
+                                args.learning_rate);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define IDX_DATA_TYPE_SEQ                           \
+  OF_PP_MAKE_TUPLE_SEQ(uint32_t, DataType::kUInt32) \
+  OF_PP_MAKE_TUPLE_SEQ(int32_t, DataType::kInt32)
+
+#define REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL(op_type_name, kernel, t_dtype_pair, g_type_pair, \
+                                                 idx_dtype_pair)                                  \
+  REGISTER_USER_KERNEL(op_type_name)                                                              \
+      .SetCreateFn<kernel<OF_PP_PAIR_FIRST(t_dtype_pair), OF_PP_PAIR_FIRST(g_type_pair),          \
+                          OF_PP_PAIR_FIRST(idx_dtype_pair)>>()                                    \
+      .SetIsMatchedHob(                                                                           \
+          (user_op::HobDeviceType() == DeviceType::kCPU)                                          \
+          && (user_op::HobDataType("num_unique_ids", 0) == OF_PP_PAIR_SECOND(idx_dtype_pair))     \
+          && (user_op::HobDataType("embedding_grad", 0) == OF_PP_PAIR_SECOND(g_type_pair))        \
+          && (user_op::HobDataType("unique_embeddings", 0) == OF_PP_PAIR_SECOND(t_dtype_pair)));
+
+#define REGISTER_CPU_ONE_EMBEDDING_SGD_UPDATE_KERNEL(t_dtype_pair, g_type_pair, idx_dtype_pair)  \
+  REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL("one_embedding_sgd_update", SgdEmbeddingUpdateKernel, \
+                                           t_dtype_pair, g_type_pair, idx_dtype_pair)
+#define REGISTER_CPU_ONE_EMBEDDING_MOMENTUM_UPDATE_KERNEL(t_dtype_pair, g_type_pair,    \
+                                                          idx_dtype_pair)               \
+  REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL("one_embedding_momentum_update",             \
+                                           MomentumEmbeddingUpdateKernel, t_dtype_pair, \
+                                           g_type_pair, idx_dtype_pair)
+#define REGISTER_CPU_ONE_EMBEDDING_ADAM_UPDATE_KERNEL(t_dtype_pair, g_type_pair, idx_dtype_pair) \
+  REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL("one_embedding_adam_update",                          \
+                                           AdamEmbeddingUpdateKernel, t_dtype_pair, g_type_pair, \
+                                           idx_dtype_pair)
+#define REGISTER_CPU_ONE_EMBEDDING_ADAGRAD_UPDATE_KERNEL(t_dtype_pair, g_type_pair,    \
+                                                         idx_dtype_pair)               \
+  REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL("one_embedding_adagrad_update",             \
+                                           AdagradEmbeddingUpdateKernel, t_dtype_pair, \
+                                           g_type_pair, idx_dtype_pair)
+#define REGISTER_CPU_ONE_EMBEDDING_FTRL_UPDATE_KERNEL(t_dtype_pair, g_type_pair, idx_dtype_pair) \
+  REGISTER_CPU_ONE_EMBEDDING_UPDATE_KERNEL("one_embedding_ftrl_update",                          \
+                                           FtrlEmbeddingUpdateKernel, t_dtype_pair, g_type_pair, \
+                                           idx_dtype_pair)
+
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_SGD_UPDATE_KERNEL,
+                                 FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_MOMENTUM_UPDATE_KERNEL,
+                                 FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_ADAM_UPDATE_KERNEL,
+                                 FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_ADAGRAD_UPDATE_KERNEL,
+                                 FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_CPU_ONE_EMBEDDING_FTRL_UPDATE_KERNEL,
+                                 FLOATING_DATA_TYPE_SEQ,
+                                 FLOATING_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ, IDX_DATA_TYPE_SEQ)
+
+}  // namespace oneflow
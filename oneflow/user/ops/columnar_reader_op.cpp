@@ -0,0 +1,116 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/framework/op_generated.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> SetOutputTensorDescs(user_op::InferContext* ctx, int64_t batch_size) {
+  const auto& shapes = ctx->Attr<std::vector<Shape>>("shapes");
+  CHECK_EQ_OR_RETURN(ctx->output_size("out"), static_cast<int32_t>(shapes.size()));
+  FOR_RANGE(int32_t, i, 0, shapes.size()) {
+    DimVector dim_vec = {batch_size};
+    for (int64_t dim : shapes.at(i).dim_vec()) { dim_vec.emplace_back(dim); }
+    user_op::TensorDesc* out_tensor = ctx->MutOutputTensorDesc("out", i);
+    out_tensor->set_shape(Shape(dim_vec));
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+/* static */ Maybe<void> ColumnarReaderOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  return SetOutputTensorDescs(ctx, ctx->Attr<int64_t>("batch_size"));
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  int64_t batch_size = ctx->Attr<int64_t>("batch_size");
+  int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+  if (parallel_num > 1) {
+    int64_t split_num = 1;
+    const NdSbp& nd_sbp = ctx->NdSbp4ArgNameAndIndex("out", 0);
+    const Shape& hierarchy = *ctx->parallel_desc().hierarchy();
+    for (int32_t i = 0; i < nd_sbp.sbp_parallel_size(); ++i) {
+      if (nd_sbp.sbp_parallel(i).has_split_parallel()) { split_num *= hierarchy.At(i); }
+    }
+    CHECK_EQ_OR_RETURN(batch_size % split_num, 0) << "batch_size must be a multiple of shard num";
+    batch_size /= split_num;
+  }
+  return SetOutputTensorDescs(ctx, batch_size);
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::GetSbp(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Split(ctx->outputs(), 0).Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::GetNdSbpSignatureList(
+    user_op::GetNdSbpSignatureListContext* ctx) {
+  NdSbpSignature nd_sbp_signature;
+  SbpParallel split_sbp_parallel;
+  split_sbp_parallel.mutable_split_parallel()->set_axis(0);
+  const int32_t num_outputs = ctx->Attr<std::vector<std::string>>("columns").size();
+  for (int32_t i = 0; i < num_outputs; ++i) {
+    for (int32_t dim_sbp = 0; dim_sbp < ctx->parallel_hierarchy().NumAxes(); dim_sbp++) {
+      *(*nd_sbp_signature.mutable_bn_in_op2nd_sbp())[GenRepeatedBn("out", i)].add_sbp_parallel() =
+          split_sbp_parallel;
+    }
+  }
+  ctx->AddNdSbpSignature(nd_sbp_signature);
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::ModifyOutputArg(
+    const GetOutputArgModifier& GetOutputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  FOR_RANGE(int32_t, i, 0, conf.output_size("out")) {
+    user_op::OutputArgModifier* out_modifier = GetOutputArgModifierFn("out", i);
+    CHECK_OR_RETURN(out_modifier != nullptr);
+  }
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::InferNdSbp(user_op::InferNdSbpFnContext* ctx) {
+  SbpParallel default_sbp;
+  default_sbp.mutable_split_parallel()->set_axis(0);
+  return user_op::InferNdSbp4SrcOp(ctx, default_sbp);
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::CheckAttr(const user_op::UserOpDefWrapper& def,
+                                                     const user_op::UserOpConfWrapper& conf) {
+  const size_t num_outputs = conf.output_size("out");
+  CHECK_GT_OR_RETURN(num_outputs, 0) << "columnar_reader needs at least one output";
+  CHECK_GT_OR_RETURN(conf.attr<int64_t>("batch_size"), 0) << "batch_size must be positive";
+  CHECK_EQ_OR_RETURN(conf.attr<std::vector<std::string>>("columns").size(), num_outputs);
+  CHECK_EQ_OR_RETURN(conf.attr<std::vector<Shape>>("shapes").size(), num_outputs);
+  CHECK_EQ_OR_RETURN(conf.attr<std::vector<DataType>>("data_types").size(), num_outputs);
+  if (!conf.attr<std::string>("predicate_column").empty()) {
+    CHECK_LE_OR_RETURN(conf.attr<double>("predicate_lower"), conf.attr<double>("predicate_upper"))
+        << "predicate_lower must not be greater than predicate_upper";
+  }
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ColumnarReaderOp::InferDataType(user_op::InferContext* ctx) {
+  const auto& data_types = ctx->Attr<std::vector<DataType>>("data_types");
+  CHECK_EQ_OR_RETURN(ctx->output_size("out"), static_cast<int32_t>(data_types.size()));
+  FOR_RANGE(int32_t, i, 0, data_types.size()) { ctx->SetOutputDType("out", i, data_types.at(i)); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
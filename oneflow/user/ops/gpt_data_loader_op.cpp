@@ -52,4 +52,50 @@ namespace oneflow {
   return Maybe<void>::Ok();
 }
 
+namespace {
+
+int64_t GetMaxNumSegments(user_op::InferContext* ctx) {
+  const int64_t max_num_segments = ctx->Attr<int64_t>("max_num_segments");
+  if (max_num_segments > 0) { return max_num_segments; }
+  // every token may start a new document
+  return ctx->Attr<int64_t>("seq_length") + ctx->Attr<int64_t>("label_length");
+}
+
+}  // namespace
+
+/*static*/ auto MegatronGptMmapPackedDataLoaderOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) -> Maybe<void> {
+  int64_t batch_size = ctx->Attr<int64_t>("batch_size");
+  int64_t sample_len = ctx->Attr<int64_t>("seq_length") + ctx->Attr<int64_t>("label_length");
+  CHECK_GE_OR_RETURN(ctx->Attr<int64_t>("max_num_segments"), 0);
+  ctx->MutOutputTensorDesc("out", 0)->set_shape(Shape({batch_size, sample_len}));
+  ctx->MutOutputTensorDesc("position_ids", 0)->set_shape(Shape({batch_size, sample_len}));
+  ctx->MutOutputTensorDesc("cu_seqlens", 0)
+      ->set_shape(Shape({batch_size, GetMaxNumSegments(ctx) + 2}));
+  return Maybe<void>::Ok();
+}
+/*static*/ auto MegatronGptMmapPackedDataLoaderOp::InferDataType(user_op::InferContext* ctx)
+    -> Maybe<void> {
+  ctx->MutOutputTensorDesc("out", 0)->set_data_type(ctx->Attr<DataType>("dtype"));
+  ctx->MutOutputTensorDesc("position_ids", 0)->set_data_type(ctx->Attr<DataType>("dtype"));
+  ctx->MutOutputTensorDesc("cu_seqlens", 0)->set_data_type(DataType::kInt32);
+  return Maybe<void>::Ok();
+}
+/*static*/ auto MegatronGptMmapPackedDataLoaderOp::GetSbp(user_op::SbpContext* ctx)
+    -> Maybe<void> {
+  ctx->NewBuilder().Split(ctx->outputs(), 0).Build();
+  return Maybe<void>::Ok();
+}
+/*static*/ auto MegatronGptMmapPackedDataLoaderOp::InferNdSbp(user_op::InferNdSbpFnContext* ctx)
+    -> Maybe<void> {
+  SbpParallel default_sbp;
+  default_sbp.mutable_split_parallel()->set_axis(0);
+  return user_op::InferNdSbp4SrcOp(ctx, default_sbp);
+}
+/*static*/ auto MegatronGptMmapPackedDataLoaderOp::ModifyInputArg(
+    const user_op::GetInputArgModifier& GetInputArgModifierFn,
+    const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+  return MegatronGptMmapDataLoaderOp::ModifyInputArg(GetInputArgModifierFn, conf);
+}
+
 }  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/framework/op_generated.h"
+#include "oneflow/user/image/image_util.h"
 
 namespace oneflow {
 
@@ -63,4 +64,91 @@ namespace oneflow {
   return Maybe<void>::Ok();
 }
 
+/* static */ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) {
+  const user_op::TensorDesc& in_desc = ctx->InputTensorDesc("in", 0);
+  CHECK_OR_RETURN(in_desc.shape().NumAxes() == 1 && in_desc.shape().At(0) >= 1);
+  const int64_t N = in_desc.shape().At(0);
+  if (ctx->has_input("mirror", 0)) {
+    const user_op::TensorDesc& mirror_desc = ctx->InputTensorDesc("mirror", 0);
+    CHECK_OR_RETURN(mirror_desc.shape().NumAxes() == 1 && mirror_desc.shape().At(0) == N);
+  }
+  const int64_t H = ctx->Attr<int64_t>("target_height");
+  const int64_t W = ctx->Attr<int64_t>("target_width");
+  const int64_t C = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+  user_op::TensorDesc* out_desc = ctx->MutOutputTensorDesc("out", 0);
+  const std::string& output_layout = ctx->Attr<std::string>("output_layout");
+  if (output_layout == "NCHW") {
+    out_desc->set_shape(Shape({N, C, H, W}));
+  } else if (output_layout == "NHWC") {
+    out_desc->set_shape(Shape({N, H, W, C}));
+  } else {
+    return Error::CheckFailedError() << "output_layout: " << output_layout << " is not supported";
+  }
+  return Maybe<void>::Ok();
+}
+
+/*static*/ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::InferPhysicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::GetSbp(
+    user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Split(ctx->inputs(), 0).Split(ctx->outputs(), 0).Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::CheckAttr(
+    const user_op::UserOpDefWrapper& def, const user_op::UserOpConfWrapper& conf) {
+  bool check_failed = false;
+  std::ostringstream err;
+  err << "Illegal attr value for " << conf.op_type_name() << " op, op_name: " << conf.op_name();
+  const std::string& color_space = conf.attr<std::string>("color_space");
+  if (color_space != "BGR" && color_space != "RGB" && color_space != "GRAY") {
+    err << ", color_space: " << color_space
+        << " (color_space can only be one of BGR, RGB and GRAY)";
+    check_failed = true;
+  }
+  const int64_t target_height = conf.attr<int64_t>("target_height");
+  const int64_t target_width = conf.attr<int64_t>("target_width");
+  if (target_height <= 0 || target_width <= 0) {
+    err << ", target_height: " << target_height << ", target_width: " << target_width
+        << " (target size must be positive)";
+    check_failed = true;
+  }
+  const std::string& interp_type = conf.attr<std::string>("interpolation_type");
+  if (!CheckInterpolationValid(interp_type, err)) { check_failed = true; }
+  const size_t C = (color_space == "GRAY") ? 1 : 3;
+  const auto& mean_vec = conf.attr<std::vector<float>>("mean");
+  const auto& std_vec = conf.attr<std::vector<float>>("std");
+  if ((mean_vec.size() != 1 && mean_vec.size() != C)
+      || (std_vec.size() != 1 && std_vec.size() != C)) {
+    err << ", mean size: " << mean_vec.size() << ", std size: " << std_vec.size()
+        << " (mean and std must have 1 or " << C << " elements)";
+    check_failed = true;
+  }
+  if (check_failed) { return oneflow::Error::CheckFailedError() << err.str(); }
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  user_op::InputArgModifier* in_modifier = GetInputArgModifierFn("in", 0);
+  CHECK_NOTNULL_OR_RETURN(in_modifier);
+  in_modifier->set_requires_grad(false);
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> ImageDecodeRandomCropResizeNormalizeOp::InferDataType(
+    user_op::InferContext* ctx) {
+  const user_op::TensorDesc& in_desc = ctx->InputTensorDesc("in", 0);
+  CHECK_OR_RETURN(in_desc.data_type() == DataType::kTensorBuffer);
+  if (ctx->has_input("mirror", 0)) {
+    CHECK_OR_RETURN(ctx->InputTensorDesc("mirror", 0).data_type() == DataType::kInt8);
+  }
+  ctx->SetOutputDType("out", 0, DataType::kFloat);
+  return Maybe<void>::Ok();
+}
+
 }  // namespace oneflow
@@ -55,6 +55,8 @@ SNAPSHOT_DONE_FILENAME = "snapshot_done"
 META_INFO_FILENAME = "meta"
 PICKLE_FILENAME = "pickled_data"
 DATA_FILENAME = "out"
+TENSOR_PACK_SUFFIX = ".ofpack"
+TENSOR_PACK_FILENAME = "model" + TENSOR_PACK_SUFFIX
 PROTOCOL_VERSION = 1
 ONEFLOW_MAGIC_KEY = "__oneflow__"
 
@@ -425,6 +427,41 @@ def load_if(condition):
     return decorator
 
 
+def is_tensor_pack(path: FILE_LIKE, support_pytorch_format: bool):
+    if not _is_path(path):
+        return False
+    if path.is_file():
+        return path.suffix == TENSOR_PACK_SUFFIX
+    if path.is_dir():
+        return len(oneflow._oneflow_internal.ListTensorPackFiles(str(path))) > 0
+    return False
+
+
+@load_if(is_tensor_pack)
+def load_tensor_pack(
+    path: Path, global_src_rank: Optional[int], map_location: MAP_LOCATION,
+) -> Dict[str, "flow.Tensor"]:
+    if path.is_file():
+        paths = [str(path)]
+    else:
+        paths = oneflow._oneflow_internal.ListTensorPackFiles(str(path))
+    rank = flow.env.get_rank()
+    if global_src_rank is None or rank == global_src_rank:
+        # cpu tensors share the memory mapped tensor pack files
+        (names, tensors) = oneflow._oneflow_internal.LoadTensorPacks(paths, "cpu", True)
+        if global_src_rank is not None:
+            _broadcast_py_object(names, global_src_rank)
+    else:
+        names = _broadcast_py_object(None, global_src_rank)
+        tensors = [flow.tensor([]) for _ in names]
+    if global_src_rank is not None:
+        tensors = [
+            x.to_global(flow.placement("cpu", [global_src_rank]), flow.sbp.broadcast)
+            for x in tensors
+        ]
+    return {name: smart_to(x, map_location) for (name, x) in zip(names, tensors)}
+
+
 def is_dir_and_no_pickle_file(path: FILE_LIKE, support_pytorch_format: bool):
     if _is_path(path) and path.is_dir():
         pickle_path = path / PICKLE_FILENAME
@@ -686,6 +723,8 @@ def save(
     path_or_buffer: FILE_LIKE,
     global_dst_rank: Optional[int] = None,
     save_as_external_data: bool = False,
+    *,
+    tensor_pack: bool = False,
 ) -> None:
     r"""Save an object to a directory.
 
@@ -700,6 +739,9 @@ def save(
             disk I/O.
         save_as_external_data (bool): useful only if path_or_buffer is a string or
            os.PathLike object containing a file name
+        tensor_pack (bool): save the tensors of a graph or of a dict from names to tensors
+           into a single tensor pack file, which is loaded in parallel and memory mapped by
+           :func:`oneflow.load` and the C++ Graph API. Default: False
     """
     if isinstance(path_or_buffer, str):
         path_or_buffer = Path(path_or_buffer)
@@ -709,7 +751,23 @@ def save(
             raise ValueError(
                 "path_or_buffer must be the type of {`str`, `pathlib.Path`} while obj is Graph"
             )
-        _save_graph(obj, path_or_buffer)
+        _save_graph(
+            obj,
+            path_or_buffer,
+            (lambda tensors, path: _save_tensor_pack(tensors, path, None))
+            if tensor_pack
+            else None,
+        )
+        return
+
+    if tensor_pack:
+        if not _is_path(path_or_buffer):
+            raise ValueError("a tensor pack can only be saved to a path")
+        if not isinstance(obj, dict) or not all(
+            isinstance(x, Tensor) for x in obj.values()
+        ):
+            raise ValueError("a tensor pack can only save a dict from names to tensors")
+        _save_tensor_pack(obj, path_or_buffer, global_dst_rank)
         return
 
     # this `path` is only used for `ContextData` and is set to empty when `path_or_buffer` is IO[bytes] or BinaryIO
@@ -741,7 +799,29 @@ def save(
         write_file()
 
 
-def _save_graph(obj: graph_util.Graph, path: Union[str, Path]):
+def _to_local_tensors(tensors: Dict[str, "oneflow.Tensor"]):
+    names = list(tensors.keys())
+    local_tensors = []
+    for x in tensors.values():
+        if x.is_global:
+            x = x.to_global(sbp=[flow.sbp.broadcast] * len(x.sbp)).to_local()
+        local_tensors.append(x)
+    return (names, local_tensors)
+
+
+def _save_tensor_pack(
+    tensors: Dict[str, "oneflow.Tensor"], path: Path, global_dst_rank: Optional[int]
+) -> None:
+    (names, local_tensors) = _to_local_tensors(tensors)
+    if global_dst_rank is None or flow.env.get_rank() == global_dst_rank:
+        oneflow._oneflow_internal.SaveTensorPack(str(path), names, local_tensors)
+
+
+def _save_graph(
+    obj: graph_util.Graph,
+    path: Union[str, Path],
+    save_tensor_pack: Optional[Callable] = None,
+):
     path: Path = Path(path)
     graph: graph_util.Graph = obj
     if not graph._is_compiled:
@@ -752,13 +832,78 @@ def _save_graph(obj: graph_util.Graph, path: Union[str, Path]):
     serialized_job = graph._forward_job_proto.SerializeToString()
     oneflow._oneflow_internal.nn.graph.SaveJobToIR(serialized_job, str(path))
 
-    for x in graph._state():
-        _save_tensor_to_disk(
-            x.to(Tensor),
-            path / f"{x.to(GraphTensor).name_prefix}{x.to(GraphTensor).name}",
+    res = None
+    if save_tensor_pack is not None:
+        res = save_tensor_pack(
+            {
+                f"{x.to(GraphTensor).name_prefix}{x.to(GraphTensor).name}": x.to(Tensor)
+                for x in graph._state()
+            },
+            path / TENSOR_PACK_FILENAME,
         )
+    else:
+        for x in graph._state():
+            _save_tensor_to_disk(
+                x.to(Tensor),
+                path / f"{x.to(GraphTensor).name_prefix}{x.to(GraphTensor).name}",
+            )
 
     save_one_embedding_info(obj.state_dict(), path)
+    return res
+
+
+class AsyncCheckpointSaver:
+    r"""Saves checkpoints as tensor packs without blocking training on disk I/O.
+
+    :meth:`save` copies the tensors into a host staging buffer, which is pinned for device
+    tensors and reused across saves, and returns once the copies are done. The file is then
+    written, synced and atomically renamed to its path by a background thread, so the
+    tensors may be updated right after :meth:`save` returns.
+
+    Args:
+        max_pending_saves (int): the number of saves which may be in flight at the same
+            time, :meth:`save` blocks until an earlier save completes. Default: 2
+
+    For example:
+
+    .. code-block:: python
+
+        saver = flow.AsyncCheckpointSaver()
+        for step in range(num_steps):
+            train_one_step()
+            if step % 1000 == 0:
+                saver.save(model.state_dict(), f"step_{step}.ofpack")
+        saver.wait()
+    """
+
+    def __init__(self, max_pending_saves: int = 2):
+        self._saver = oneflow._oneflow_internal.AsyncCheckpointSaver(max_pending_saves)
+
+    def save(self, obj: Any, path: Union[str, Path]):
+        r"""Starts to save a :class:`oneflow.nn.Graph` or a dict from names to tensors.
+
+        Returns:
+            A future with ``progress()``, ``done()`` and ``wait()`` methods, or None on the
+            ranks which do not write when saving global tensors
+        """
+        path = Path(path)
+        if isinstance(obj, graph_util.Graph):
+            return _save_graph(obj, path, self._save_tensor_pack)
+        if not isinstance(obj, dict) or not all(
+            isinstance(x, Tensor) for x in obj.values()
+        ):
+            raise ValueError("a tensor pack can only save a dict from names to tensors")
+        return self._save_tensor_pack(obj, path)
+
+    def wait(self) -> None:
+        r"""Waits for all pending saves to complete."""
+        self._saver.wait_all()
+
+    def _save_tensor_pack(self, tensors: Dict[str, "oneflow.Tensor"], path: Path):
+        (names, local_tensors) = _to_local_tensors(tensors)
+        if flow.env.get_rank() != 0 and any(x.is_global for x in tensors.values()):
+            return None
+        return self._saver.save(str(path), names, local_tensors)
 
 
 def frombuffer(
@@ -281,6 +281,50 @@ def api_nccl_enable_mixed_fusion(val: bool) -> None:
     _set_resource_attr(attrs, val, type_)
 
 
+def api_cpu_enable_collective_boxing(val: bool) -> None:
+    """Whether or not use the cpu collective boxing executor for cpu placed graphs
+
+    Args:
+        val (bool): True or False
+    """
+
+    attrs, type_ = api_attrs_and_type[api_cpu_enable_collective_boxing]
+    _set_resource_attr(attrs, val, type_)
+
+
+def api_cpu_fusion_threshold_mb(val: int) -> None:
+    """Set up threshold for cpu all reduce fusion
+
+    Args:
+        val (int): int number, e.g. 10(mb)
+    """
+
+    attrs, type_ = api_attrs_and_type[api_cpu_fusion_threshold_mb]
+    _set_resource_attr(attrs, val, type_)
+
+
+def api_cpu_fusion_all_reduce(val: bool) -> None:
+    """Whether or not fuse cpu all reduce requests into one buffer
+
+    Args:
+        val (bool): True or False
+    """
+
+    attrs, type_ = api_attrs_and_type[api_cpu_fusion_all_reduce]
+    _set_resource_attr(attrs, val, type_)
+
+
+def api_cpu_fusion_max_ops(val: int) -> None:
+    """Maximum number of ops for cpu all reduce fusion.
+
+    Args:
+        val (int): Maximum number of ops
+    """
+
+    attrs, type_ = api_attrs_and_type[api_cpu_fusion_max_ops]
+    _set_resource_attr(attrs, val, type_)
+
+
 api_attrs_and_type = {
     api_reserved_device_mem_mbyte: ("reserved_device_mem_mbyte", int),
     api_enable_cudnn_fused_normalization_add_relu: (
@@ -332,4 +376,17 @@ api_attrs_and_type = {
         ["collective_boxing_conf", "nccl_enable_mixed_fusion"],
         bool,
     ),
+    api_cpu_enable_collective_boxing: (
+        ["collective_boxing_conf", "cpu_enable_collective_boxing"],
+        bool,
+    ),
+    api_cpu_fusion_threshold_mb: (
+        ["collective_boxing_conf", "cpu_fusion_threshold_mb"],
+        int,
+    ),
+    api_cpu_fusion_all_reduce: (
+        ["collective_boxing_conf", "cpu_fusion_all_reduce"],
+        bool,
+    ),
+    api_cpu_fusion_max_ops: (["collective_boxing_conf", "cpu_fusion_max_ops"], int),
 }
@@ -89,6 +89,7 @@ from oneflow.nn.modules.dataset import (
     COCOReader,
     CoinFlip,
     CropMirrorNormalize,
+    FlatRecordReader,
     OFRecordImageDecoder,
     OFRecordImageDecoderRandomCrop,
     OFRecordImageGpuDecoderRandomCropResize,
@@ -99,6 +100,7 @@ from oneflow.nn.modules.dataset import (
     OFRecordBytesDecoder,
     GPTIndexedBinDataReader,
     RawReader,
+    ColumnarReader,
 )
 
 from oneflow.nn.modules.dropout import Dropout, Dropout1d, Dropout2d, Dropout3d
@@ -216,6 +216,34 @@ class GraphConfig(object):
         """
         self.proto.enable_fuse_cast_scale = mode
 
+    def allow_cpu_channels_last_layout(self, mode: bool = True):
+        r"""If set to true, convolutions of an inference graph on CPU run in channels_last, and
+        the batch normalization, max pooling, relu and add between them keep their activations
+        in channels_last too. Transposes are only inserted where a tensor enters or leaves such
+        a region.
+
+        For example:
+
+        .. code-block:: python
+
+            import oneflow as flow
+
+            class Graph(flow.nn.Graph):
+                def __init__(self):
+                    super().__init__()
+                    self.conv = flow.nn.Conv2d(3, 16, 3, padding=1)
+                    self.bn = flow.nn.BatchNorm2d(16)
+                    self.config.allow_cpu_channels_last_layout(True)
+                def build(self, x):
+                    return flow.relu(self.bn(self.conv(x)))
+
+            graph = Graph()
+
+        Args:
+            mode (bool, optional): The default value is True.
+        """
+        self.proto.enable_cpu_channels_last_layout = mode
+
     def set_gradient_accumulation_steps(self, value):
         r"""Set num of steps to accumulate gradient.
 
@@ -340,6 +368,74 @@ class GraphConfig(object):
         else:
             self.proto.straighten_algorithm_tag_in_task_graph = 5
 
+    def enable_gradient_bucket(self, mode: bool = True, *, bucket_size_mbyte: int = 25):
+        r"""If set to true, the data parallel gradients will be flattened and concatenated into
+        buckets of about ``bucket_size_mbyte`` in the order of backward, and each bucket will be
+        reduced across devices as one contiguous buffer. The reduction of a bucket starts as soon
+        as all of its gradients are produced, which overlaps with the rest of backward.
+
+        Args:
+            mode (bool, optional): The default value is True.
+            bucket_size_mbyte (int, optional): The size of each bucket in MB. Default is 25.
+        """
+        assert type(mode) is bool
+        assert bucket_size_mbyte > 0
+        self.proto.gradient_bucket_size_mbyte = bucket_size_mbyte if mode else 0
+
+    def enable_gradient_compression(
+        self,
+        mode: bool = True,
+        *,
+        dtype: flow.dtype = flow.bfloat16,
+        scale: float = 1.0,
+        min_elem_cnt: int = 0,
+    ):
+        r"""If set to true, the data parallel gradients will be reduced across devices in lower
+        precision, which saves the bandwidth of the gradient allreduce.
+
+        The float gradients are multiplied by ``scale`` and cast to ``dtype`` before the
+        reduction, then cast back to float and divided by ``scale`` after it.
+
+        Top-k sparsification with error feedback is only available in eager mode, through
+        the ``gradient_topk_ratio`` argument of ``oneflow.nn.parallel.DistributedDataParallel``.
+        The graph reduces gradients by partial sum boxing, which only carries dense tensors.
+
+        For example:
+
+        .. code-block:: python
+
+            import oneflow as flow
+
+            class Graph(flow.nn.Graph):
+                def __init__(self):
+                    super().__init__()
+                    self.linear = flow.nn.Linear(3, 8, False)
+                    self.add_optimizer(flow.optim.SGD(self.linear.parameters(), lr=0.1))
+                    self.config.enable_gradient_compression(True, dtype=flow.bfloat16)
+                def build(self, x):
+                    loss = self.linear(x).sum()
+                    loss.backward()
+                    return loss
+
+        Args:
+            mode (bool, optional): The default value is True.
+            dtype (flow.dtype, optional): flow.float16 or flow.bfloat16. Default is flow.bfloat16.
+            scale (float, optional): Keeps small gradients from underflow in flow.float16.
+                Default is 1.0.
+            min_elem_cnt (int, optional): Gradients with fewer elements are reduced in float.
+                Default is 0.
+        """
+        assert type(mode) is bool
+        if not mode:
+            self.proto.ClearField("gradient_compression_conf")
+            return
+        assert dtype in (flow.float16, flow.bfloat16)
+        assert scale > 0
+        conf = self.proto.gradient_compression_conf
+        conf.data_type = flow._oneflow_internal.deprecated.GetProtoDtype4OfDtype(dtype)
+        conf.scale = scale
+        conf.min_elem_cnt = min_elem_cnt
+
     def enable_compress_memory(self, mode: bool = True):
         """If true, then the graph will try its best to find the minimum memory allocation strategy.
         This process might take several minutes for a small graph and half an hour for a large one.
@@ -351,6 +447,22 @@ class GraphConfig(object):
         """
         self.proto.enable_compress_memory = mode
 
+    def set_compress_memory_search(
+        self, random_search_num: int = 0, warm_start: bool = False
+    ):
+        """Set the start points of the memory compression enabled by enable_compress_memory().
+        The compression always starts from the results of all the memory allocation algorithms
+        in parallel and keeps the best one.
+
+        Args:
+            random_search_num (int, optional): The number of extra start points which randomly
+                perturb the order of the best memory allocation algorithm. Default is 0.
+            warm_start (bool, optional): Whether to start from the offsets of the last
+                compilation of the same graph in this session. Default is False.
+        """
+        self.proto.compress_memory_random_search_num = random_search_num
+        self.proto.enable_compress_memory_warm_start = warm_start
+
     def enable_choose_best_memory_allocation(self, mode: bool = True):
         """If true, then the graph will go through all the memory allocation algorithms. Including
         large memory first algorithm,
@@ -417,6 +529,20 @@ class GraphConfig(object):
         """
         self.proto.enable_auto_parallel_sbp_collector = mode
 
+    def set_auto_parallel_cost_database(self, path: str):
+        """
+        Use the measured kernel time and boxing bandwidth in the cost database to compute the cost
+        in auto-parallel and the straighten algorithm.
+
+        The cost database is produced by running the job with the environment variable
+        ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE set to the path of the database. Each kernel
+        is synchronized and timed in that run, so it should only be a short profiling run.
+
+        Args:
+            path (str): The path of the cost database.
+        """
+        self.proto.auto_parallel_cost_database_path = path
+
     def enable_auto_memory(self, mode: str = "AdaptiveMemory"):
         r""" Whether we use a parallelism strategy with less memory
 
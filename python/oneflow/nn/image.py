@@ -15,6 +15,9 @@ limitations under the License.
 """
 from oneflow.nn.modules.dataset import ImageBatchAlign as batch_align
 from oneflow.nn.modules.dataset import ImageDecode as decode
+from oneflow.nn.modules.dataset import (
+    ImageDecodeRandomCropResizeNormalize as decode_random_crop_resize_normalize,
+)
 from oneflow.nn.modules.dataset import ImageFlip as flip
 from oneflow.nn.modules.dataset import ImageNormalize as normalize
 from oneflow.nn.modules.dataset import ImageResize as Resize
@@ -570,8 +570,8 @@ class SyncBatchNorm(_BatchNorm):
     Normalization or Spatio-temporal Batch Normalization.
 
     Currently :class:`SyncBatchNorm` only supports
-    :class:`~oneflow.nn.DistributedDataParallel` (DDP) with single GPU per process. Use
-    :meth:`oneflow.nn.SyncBatchNorm.convert_sync_batchnorm()` to convert
+    :class:`~oneflow.nn.DistributedDataParallel` (DDP) with a single GPU or CPU device
+    per process. Use :meth:`oneflow.nn.SyncBatchNorm.convert_sync_batchnorm()` to convert
     :attr:`BatchNorm*D` layer to :class:`SyncBatchNorm` before wrapping
     Network with DDP.
 
@@ -641,10 +641,6 @@ class SyncBatchNorm(_BatchNorm):
             )
 
     def forward(self, input):
-        # currently only GPU input is supported
-        if not input.is_cuda:
-            raise ValueError("SyncBatchNorm expected input tensor to be on GPU")
-
         self._check_input_dim(input)
         self._check_non_zero_input_channels(input)
 
@@ -124,6 +124,91 @@ class OFRecordReader(Module):
         return res
 
 
+class FlatRecordReader(Module):
+    r"""Reads flat records and decodes the named fields straight into tensors, which gives the
+    same outputs as :class:`OFRecordReader` followed by one :class:`OFRecordRawDecoder` per
+    field, without protobuf parsing. Flat record files can be converted from OFRecord files with
+    ``python3 -m oneflow.utils.data.flat_record``.
+
+    Args:
+        data_dir (str): The directory of the flat record part files.
+        names (list of str): Names of the fields to decode.
+        shapes (list of tuple): Per sample shapes of the fields.
+        dtypes (list of oneflow.dtype): Data types of the output tensors.
+        truncate (bool, optional): Truncate or zero pad the fields to the shapes instead of
+            requiring an exact size. Default: False
+
+    The other arguments have the same meaning as in :class:`OFRecordReader`.
+    """
+
+    def __init__(
+        self,
+        data_dir: str,
+        names: Sequence[str],
+        shapes: Sequence[Sequence[int]],
+        dtypes: Sequence[flow.dtype],
+        batch_size: int = 1,
+        data_part_num: int = 1,
+        part_name_prefix: str = "part-",
+        part_name_suffix_length: int = -1,
+        random_shuffle: bool = False,
+        shuffle_buffer_size: int = 1024,
+        shuffle_after_epoch: bool = False,
+        random_seed: int = -1,
+        truncate: bool = False,
+        device: Union[flow.device, str] = None,
+        placement: flow.placement = None,
+        sbp: Union[flow.sbp.sbp, List[flow.sbp.sbp]] = None,
+    ):
+        super().__init__()
+        if not (len(names) == len(shapes) == len(dtypes)) or len(names) == 0:
+            raise ValueError(
+                "names, shapes and dtypes must be non-empty and of the same size"
+            )
+        self.data_dir = data_dir
+        self.names = list(names)
+        self.shapes = [tuple(shape) for shape in shapes]
+        self.dtypes = list(dtypes)
+        self.batch_size = batch_size
+        self.data_part_num = data_part_num
+        self.part_name_prefix = part_name_prefix
+        self.part_name_suffix_length = part_name_suffix_length
+        self.random_shuffle = random_shuffle
+        self.shuffle_buffer_size = shuffle_buffer_size
+        self.shuffle_after_epoch = shuffle_after_epoch
+        self.truncate = truncate
+        _handle_distributed_args(self, device, placement, sbp)
+        (self.seed, self.has_seed) = local_gen_random_seed(random_seed)
+        self._op = (
+            flow.stateful_op("flat_record_reader")
+            .Output("out", len(self.names))
+            .Build()
+        )
+
+    def forward(self):
+        kwargs = dict(
+            data_dir=self.data_dir,
+            data_part_num=self.data_part_num,
+            part_name_prefix=self.part_name_prefix,
+            part_name_suffix_length=self.part_name_suffix_length,
+            batch_size=self.batch_size,
+            shuffle_buffer_size=self.shuffle_buffer_size,
+            random_shuffle=self.random_shuffle,
+            shuffle_after_epoch=self.shuffle_after_epoch,
+            seed=self.seed,
+            names=self.names,
+            shapes=self.shapes,
+            data_types=self.dtypes,
+            truncate=self.truncate,
+        )
+        if self.placement is None:
+            kwargs["device"] = self.device
+        else:
+            kwargs["placement"] = self.placement
+            kwargs["sbp"] = self.sbp
+        return tuple(_C.dispatch_flat_record_reader(self._op, **kwargs))
+
+
 class OFRecordRawDecoder(Module):
     def __init__(
         self,
@@ -852,6 +937,101 @@ class ImageDecode(Module):
         )
 
 
+class ImageDecodeRandomCropResizeNormalize(Module):
+    r"""Decodes encoded images, randomly crops, resizes, mirrors and normalizes them into a
+    float NCHW (or NHWC) tensor in a single CPU op, without materializing the intermediate
+    images. Jpeg images are decoded with libjpeg which only decodes the crop window and, when
+    ``dct_scaling`` is enabled, downscales in the DCT domain if the crop window is much larger
+    than the target size.
+
+    Args:
+        target_height (int): Height of the output images.
+        target_width (int): Width of the output images.
+        color_space (str, optional): The color space of the output images. Default: "BGR"
+        output_layout (str, optional): "NCHW" or "NHWC". Default: "NCHW"
+        interpolation_type (str, optional): Interpolation method of the resize. Default: "auto"
+        mean (float or list of float, optional): Mean pixel values. Default: [0.0]
+        std (float or list of float, optional): Standard deviation values. Default: [1.0]
+        random_crop (bool, optional): Whether to randomly crop before resizing. Default: True
+        num_attempts (int, optional): Attempts to generate a valid crop window. Default: 10
+        random_seed (int, optional): Random seed of the crop windows. Default: None
+        random_area (list of float, optional): Range of the crop area ratio. Default: [0.08, 1.0]
+        random_aspect_ratio (list of float, optional): Range of the crop aspect ratio.
+            Default: [0.75, 1.333333]
+        dct_scaling (bool, optional): Whether to allow DCT domain downscaling. Default: True
+    """
+
+    def __init__(
+        self,
+        target_height: int,
+        target_width: int,
+        color_space: str = "BGR",
+        output_layout: str = "NCHW",
+        interpolation_type: str = "auto",
+        mean: Sequence[float] = [0.0],
+        std: Sequence[float] = [1.0],
+        random_crop: bool = True,
+        num_attempts: int = 10,
+        random_seed: Optional[int] = None,
+        random_area: Sequence[float] = [0.08, 1.0],
+        random_aspect_ratio: Sequence[float] = [0.75, 1.333333],
+        dct_scaling: bool = True,
+    ):
+        super().__init__()
+        self.target_height = target_height
+        self.target_width = target_width
+        self.color_space = color_space
+        self.output_layout = output_layout
+        self.interpolation_type = interpolation_type
+        self.mean = mean
+        self.std = std
+        self.random_crop = random_crop
+        self.num_attempts = num_attempts
+        self.random_area = random_area
+        self.random_aspect_ratio = random_aspect_ratio
+        self.dct_scaling = dct_scaling
+        (self.seed, self.has_seed) = local_gen_random_seed(random_seed)
+        self._op_with_mirror = (
+            flow.stateful_op("image_decode_random_crop_resize_normalize")
+            .Input("in")
+            .Input("mirror")
+            .Output("out")
+            .Build()
+        )
+        self._op_no_mirror = (
+            flow.stateful_op("image_decode_random_crop_resize_normalize")
+            .Input("in")
+            .Output("out")
+            .Build()
+        )
+
+    def forward(self, input, mirror=None):
+        if mirror is not None:
+            op = self._op_with_mirror
+            inputs = (input, mirror)
+        else:
+            op = self._op_no_mirror
+            inputs = (input,)
+        return _C.dispatch_image_decode_random_crop_resize_normalize(
+            op,
+            inputs,
+            color_space=self.color_space,
+            output_layout=self.output_layout,
+            target_height=self.target_height,
+            target_width=self.target_width,
+            interpolation_type=self.interpolation_type,
+            mean=self.mean,
+            std=self.std,
+            random_crop=self.random_crop,
+            random_area=self.random_area,
+            random_aspect_ratio=self.random_aspect_ratio,
+            num_attempts=self.num_attempts,
+            seed=self.seed,
+            has_seed=self.has_seed,
+            dct_scaling=self.dct_scaling,
+        )
+
+
 class ImageNormalize(Module):
     def __init__(self, std: Sequence[float], mean: Sequence[float]):
         super().__init__()
@@ -1035,6 +1215,9 @@ class GPTIndexedBinDataReader(Module):
         device: Union[flow.device, str] = None,
         placement: flow.placement = None,
         sbp: Union[flow.sbp.sbp, List[flow.sbp.sbp]] = None,
+        packing: bool = False,
+        max_num_segments: int = 0,
+        pad_token_id: int = 0,
     ):
         super().__init__()
 
@@ -1046,6 +1229,9 @@ class GPTIndexedBinDataReader(Module):
         self.num_samples = num_samples
         self.seq_length = seq_length
         self.dtype = dtype
+        self.packing = packing
+        self.max_num_segments = max_num_segments
+        self.pad_token_id = pad_token_id
 
         if split_index is None:
             split_index = 0
@@ -1062,43 +1248,49 @@ class GPTIndexedBinDataReader(Module):
                 )
             )
 
-        self.op_ = (
-            flow.stateful_op("megatron_gpt_mmap_data_loader").Output("out").Build()
-        )
+        if packing:
+            # packed samples carry per sample position ids and cumulative sequence
+            # lengths (padded with the sample length) of the packed documents
+            self.op_ = (
+                flow.stateful_op("megatron_gpt_mmap_packed_data_loader")
+                .Output("out")
+                .Output("position_ids")
+                .Output("cu_seqlens")
+                .Build()
+            )
+        else:
+            self.op_ = (
+                flow.stateful_op("megatron_gpt_mmap_data_loader").Output("out").Build()
+            )
 
     def forward(self):
+        kwargs = dict(
+            data_file_prefix=self.data_file_prefix,
+            seq_length=self.seq_length,
+            label_length=1,
+            num_samples=self.num_samples,
+            batch_size=self.batch_size,
+            dtype=self.dtype,
+            shuffle=self.shuffle,
+            random_seed=self.random_seed,
+            split_sizes=self.split_sizes,
+            split_index=self.split_index,
+        )
         if self.placement is None:
-            output = _C.dispatch_megatron_gpt_mmap_data_loader(
-                self.op_,
-                data_file_prefix=self.data_file_prefix,
-                seq_length=self.seq_length,
-                label_length=1,
-                num_samples=self.num_samples,
-                batch_size=self.batch_size,
-                dtype=self.dtype,
-                shuffle=self.shuffle,
-                random_seed=self.random_seed,
-                split_sizes=self.split_sizes,
-                split_index=self.split_index,
-                device=self.device,
-            )
+            kwargs["device"] = self.device
         else:
-            output = _C.dispatch_megatron_gpt_mmap_data_loader(
+            kwargs["placement"] = self.placement
+            kwargs["sbp"] = self.sbp
+
+        if self.packing:
+            output = _C.dispatch_megatron_gpt_mmap_packed_data_loader(
                 self.op_,
-                data_file_prefix=self.data_file_prefix,
-                seq_length=self.seq_length,
-                label_length=1,
-                num_samples=self.num_samples,
-                batch_size=self.batch_size,
-                dtype=self.dtype,
-                shuffle=self.shuffle,
-                random_seed=self.random_seed,
-                split_sizes=self.split_sizes,
-                split_index=self.split_index,
-                placement=self.placement,
-                sbp=self.sbp,
+                max_num_segments=self.max_num_segments,
+                pad_token_id=self.pad_token_id,
+                **kwargs,
             )
-        return output
+            return tuple(output)
+        return _C.dispatch_megatron_gpt_mmap_data_loader(self.op_, **kwargs)
 
 
 class RawReader(Module):
@@ -1158,6 +1350,92 @@ class RawReader(Module):
         return output
 
 
+class ColumnarReader(Module):
+    r"""Reads batches from columnar files written by
+    :func:`oneflow.utils.data.columnar.write_columnar_file`. Only the chunks of the requested
+    columns are read, and the row groups of all files are split among the ranks. A rank left
+    without a row group returns zero filled batches.
+
+    Args:
+        files (str or list of str): The columnar files, or a directory holding them.
+        columns (list of str): Names of the columns to read.
+        shapes (list of tuple): Per row shapes of the columns.
+        dtypes (list of oneflow.dtype): Data types of the output tensors, the stored values
+            are converted when they differ.
+        batch_size (int): The global batch size.
+        random_shuffle (bool, optional): Shuffle the order of the row groups and the rows in
+            each row group. Default: False
+        random_seed (int, optional): The seed of the shuffle. Default: None
+        predicate_column (str, optional): Only return rows whose value of this scalar column
+            lies in ``predicate_range``. Row groups whose statistics fall outside the range
+            are skipped without being read. Default: None
+        predicate_range (tuple of float, optional): The closed range of the predicate.
+            Default: (-inf, inf)
+    """
+
+    def __init__(
+        self,
+        files: Union[str, List[str]],
+        columns: Sequence[str],
+        shapes: Sequence[Sequence[int]],
+        dtypes: Sequence[flow.dtype],
+        batch_size: int,
+        random_shuffle: bool = False,
+        random_seed: Optional[int] = None,
+        predicate_column: Optional[str] = None,
+        predicate_range: Tuple[float, float] = (float("-inf"), float("inf")),
+        device: Union[flow.device, str] = None,
+        placement: flow.placement = None,
+        sbp: Union[flow.sbp.sbp, List[flow.sbp.sbp]] = None,
+    ):
+        super().__init__()
+        if not (len(columns) == len(shapes) == len(dtypes)) or len(columns) == 0:
+            raise ValueError(
+                "columns, shapes and dtypes must be non-empty and of the same size"
+            )
+        if isinstance(files, str):
+            if os.path.isdir(files):
+                files = [
+                    os.path.join(files, file_name)
+                    for file_name in sorted(os.listdir(files))
+                ]
+            else:
+                files = [files]
+        self.files = list(files)
+        self.columns = list(columns)
+        self.shapes = [tuple(shape) for shape in shapes]
+        self.dtypes = list(dtypes)
+        self.batch_size = batch_size
+        self.random_shuffle = random_shuffle
+        self.predicate_column = predicate_column or ""
+        (self.predicate_lower, self.predicate_upper) = predicate_range
+        _handle_distributed_args(self, device, placement, sbp)
+        (self.seed, self.has_seed) = local_gen_random_seed(random_seed)
+        self._op = (
+            flow.stateful_op("columnar_reader").Output("out", len(self.columns)).Build()
+        )
+
+    def forward(self):
+        kwargs = dict(
+            files=self.files,
+            columns=self.columns,
+            shapes=self.shapes,
+            data_types=self.dtypes,
+            batch_size=self.batch_size,
+            random_shuffle=self.random_shuffle,
+            seed=self.seed,
+            predicate_column=self.predicate_column,
+            predicate_lower=self.predicate_lower,
+            predicate_upper=self.predicate_upper,
+        )
+        if self.placement is None:
+            kwargs["device"] = self.device
+        else:
+            kwargs["placement"] = self.placement
+            kwargs["sbp"] = self.sbp
+        return tuple(_C.dispatch_columnar_reader(self._op, **kwargs))
+
+
 def _handle_distributed_args(module, device, placement, sbp):
     module.placement = placement
     if placement is None:
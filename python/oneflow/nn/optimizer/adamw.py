@@ -163,8 +163,8 @@ class AdamW(Optimizer):
                     warnings.warn("Fused Adamw is not supported when amsgrad=True.")
                     param_group["fused"] = False
 
-                if param_group["fused"] and not param.is_cuda:
-                    warnings.warn("Fused Adamw only support cuda parameters.")
+                if param_group["fused"] and not (param.is_cuda or param.is_cpu):
+                    warnings.warn("Fused Adamw only support cuda and cpu parameters.")
                     param_group["fused"] = False
 
         self._op_with_amsgrad = (
@@ -140,8 +140,8 @@ class SGD(Optimizer):
                 assert param.is_leaf, "parameters must be leaf tensor"
                 self.state[param] = dict()
 
-                if param_group["fused"] and not param.is_cuda:
-                    warnings.warn("Fused SGD only support cuda parameters.")
+                if param_group["fused"] and not (param.is_cuda or param.is_cpu):
+                    warnings.warn("Fused SGD only support cuda and cpu parameters.")
                     param_group["fused"] = False
 
         self._momentum_sgd = (
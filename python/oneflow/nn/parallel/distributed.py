@@ -23,9 +23,37 @@ from oneflow.nn.utils.parameters_grouping import ContiguousParamsGroup
 from oneflow.framework.args_tree import ArgsTree
 
 
+def topk_sparse_all_reduce(module, key, grad):
+    # Only the largest gradients of each rank are gathered and summed. The rest is kept
+    # in a local residual and added to the gradient of the next step (error feedback),
+    # so no gradient is lost, only delayed.
+    with flow.no_grad():
+        acc = grad.flatten()
+        residual = module._gradient_residuals.get(key)
+        if residual is not None:
+            acc = acc + residual
+        k = max(1, int(acc.numel() * module._gradient_topk_ratio))
+        _, indices = flow.topk(acc.abs(), k)
+        values = flow.gather(acc, 0, indices)
+        module._gradient_residuals[key] = flow.scatter(acc, 0, indices, 0.0)
+        world_size = flow.env.get_world_size()
+        all_indices = flow.empty(world_size * k, dtype=indices.dtype, device=acc.device)
+        all_values = flow.empty(world_size * k, dtype=acc.dtype, device=acc.device)
+        flow.comm.all_gather_into_tensor(all_indices, indices)
+        flow.comm.all_gather_into_tensor(all_values, values)
+        reduced = flow.zeros_like(acc).index_add_(0, all_indices, all_values)
+        grad.copy_(reduced.reshape(grad.shape))
+
+
 def allreduce_fn(module, param, use_bucket):
     ddp_state_for_reversed_params = module._ddp_state_for_reversed_params
 
+    def all_reduce(key, grad):
+        if module._gradient_topk_ratio is None:
+            flow._C.local_all_reduce(grad, inplace=True)
+        else:
+            topk_sparse_all_reduce(module, key, grad)
+
     def allreduce_with_bucket(grad):
         buckets = module._buckets
         bucket_tensors = module._bucket_tensors
@@ -45,7 +73,7 @@ def allreduce_fn(module, param, use_bucket):
                     ddp_state_for_reversed_params[x][1] = True
                 # NOTE(jianhao)(higher-order-grad):
                 # local allreduce doesn't have gradient function, higher-order grad may be unsupported
-                flow._C.local_all_reduce(bucket_tensors[index], inplace=True)
+                all_reduce(index, bucket_tensors[index])
             else:
                 break
 
@@ -58,9 +86,9 @@ def allreduce_fn(module, param, use_bucket):
                 ddp_state_for_reversed_params[cur_param][1] = True
                 # NOTE(jianhao)(higher-order-grad): local allreduce doesn't have gradient function, higher-order grad may be unsupported
                 if cur_param is param:
-                    flow._C.local_all_reduce(grad, True)
+                    all_reduce(cur_param, grad)
                 else:
-                    flow._C.local_all_reduce(cur_param.grad, True)
+                    all_reduce(cur_param, cur_param.grad)
             else:
                 break
 
@@ -74,8 +102,25 @@ def DistributedDataParallel(
     broadcast_parameters: bool = True,
     bucket_size: int = 10,
     use_bucket: bool = True,
+    gradient_topk_ratio: float = None,
 ):
+    """
+    Wraps ``module`` for eager data parallel training.
+
+    ``gradient_topk_ratio`` enables top-k sparsification with error feedback: in each
+    step every bucket (or parameter without buckets) sends only this ratio of its
+    largest gradients, and the rest is kept in a residual of the rank and added to the
+    gradients of the next step. The (index, value) pairs of all ranks are gathered, so
+    each rank receives about ``3 * world_size * k`` floats instead of the ``2 * n`` of
+    a dense ring all-reduce, which pays off for small ratios only. It works with CPU and
+    CUDA tensors. Graph mode does not support it, see
+    ``GraphConfig.enable_gradient_compression``.
+    """
     assert all(x.dtype == flow.float32 for x in module.parameters())
+    if gradient_topk_ratio is not None:
+        assert 0 < gradient_topk_ratio <= 1
+    module._gradient_topk_ratio = gradient_topk_ratio
+    module._gradient_residuals = {}
     if use_bucket and parse_boolean_from_env("ONEFLOW_DISABLE_VIEW", False):
         warnings.warn(
             "because the environment variable 'ONEFLOW_DISABLE_VIEW' is set to true, so the view mechanism is disabled, and we will set use_bucket=False"
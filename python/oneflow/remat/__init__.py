@@ -47,6 +47,19 @@ def get_budget():
     return budget_in_bytes
 
 
+def set_swap_budget(budget: str):
+    """Sets the host memory for swapped out tensors. When it is not zero, a tensor
+    evicted for memory is copied to the host if that is estimated to be cheaper than
+    recomputing it."""
+    budget_in_bytes = parse_size(budget)
+    flow._oneflow_internal.remat.set_swap_budget_in_bytes(budget_in_bytes)
+
+
+def get_swap_budget():
+    budget_in_bytes = flow._oneflow_internal.remat.swap_budget_in_bytes()
+    return budget_in_bytes
+
+
 set_small_pieces_optimization = (
     flow._oneflow_internal.remat.set_small_pieces_optimization
 )
@@ -89,6 +89,18 @@ def generate_placeholder(size_mb, device):
         placeholder_size = 0
 
 
+@contextmanager
+def swap_budget(budget, bandwidth=None):
+    flow.remat.set_swap_budget(budget)
+    if bandwidth is not None:
+        os.environ["ONEFLOW_REMAT_SWAP_BANDWIDTH"] = str(bandwidth)
+    try:
+        yield
+    finally:
+        flow.remat.set_swap_budget("0")
+        os.environ.pop("ONEFLOW_REMAT_SWAP_BANDWIDTH", None)
+
+
 def memory_budget(budget_mb, device):
     if device == "cuda" and not oneflow.sysconfig.with_cuda():
         return unittest.skip("Skip CUDA tests on CPU build")
@@ -224,6 +236,54 @@ class TestRemat(flow.unittest.TestCase):
         self.assertTrue(np.array_equal(x6.numpy(), np.ones(x6.shape) * 11))
         self.assertTrue(np.array_equal(x3.numpy(), np.ones(x3.shape) * 5))
 
+    @flow.unittest.skip_unless_1n1d()
+    @memory_budget(12, "cpu")
+    def test_swap_out_and_in(self, device):
+        remat = flow._oneflow_internal.remat
+        with swap_budget("100MB"):
+            x1 = flow.ones(1024 * 1024, device=device)  # 4MB
+            x2 = x1 * 3
+            remat.swap_out(x2)
+            self.assertFalse(is_in_memory(x2))
+            self.assertTrue(remat.is_swapped(x2))
+            self.assertEqual(remat.swap_memory_in_bytes(), 4 * 1024 * 1024)
+            self.assertTrue(np.array_equal(x2.numpy(), np.ones(x2.shape) * 3))
+            self.assertTrue(is_in_memory(x2))
+            # the host copy is still valid, so swapping out again copies nothing
+            remat.swap_out(x2)
+            x3 = x2 + 1
+            self.assertTrue(np.array_equal(x3.numpy(), np.ones(x3.shape) * 4))
+            self.assertEqual(remat.swap_out_num(), 1)
+            self.assertEqual(remat.swap_in_num(), 2)
+            self.assertEqual(remat.recomputation_num(), 0)
+            # mutation invalidates the host copy
+            x2.add_(1)
+            self.assertEqual(remat.swap_memory_in_bytes(), 0)
+            # swapping out again copies the new content instead of restoring the old one
+            remat.swap_out(x2)
+            self.assertTrue(remat.is_swapped(x2))
+            self.assertEqual(remat.swap_out_num(), 2)
+            self.assertTrue(np.array_equal(x2.numpy(), np.ones(x2.shape) * 4))
+            del x1, x2, x3
+
+    @flow.unittest.skip_unless_1n1d()
+    @memory_budget(12, "cpu")
+    def test_forced_eviction_prefers_cheap_swap(self, device):
+        remat = flow._oneflow_internal.remat
+        # with a (fake) very fast copy, swapping is cheaper than recomputing any tensor
+        with swap_budget("100MB", bandwidth=10 ** 15):
+            x1 = flow.ones(1024 * 1024, device=device)  # 4MB
+            x2 = x1 + 2
+            x3 = x2 + 2
+            x4 = x3 + 2
+            self.assertFalse(is_in_memory(x1) and is_in_memory(x2) and is_in_memory(x3))
+            self.assertGreater(remat.swap_out_num(), 0)
+            self.assertTrue(np.array_equal(x4.numpy(), np.ones(x4.shape) * 7))
+            self.assertTrue(np.array_equal(x2.numpy(), np.ones(x2.shape) * 3))
+            self.assertTrue(np.array_equal(x1.numpy(), np.ones(x1.shape)))
+            self.assertEqual(remat.recomputation_num(), 0)
+            del x1, x2, x3, x4
+
     @flow.unittest.skip_unless_1n1d()
     @memory_budget(12, "cpu")
     def test_remat_work_on_simple_case_2(self, device):
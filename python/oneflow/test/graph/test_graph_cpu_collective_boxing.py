@@ -0,0 +1,144 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _test_cpu_collective_boxing(test_case, in_sbp, out_sbp):
+    P = flow.placement("cpu", ranks=[0, 1])
+    np.random.seed(0)
+    np_x = np.random.uniform(-1, 1, (8, 6)).astype(np.float32)
+    np_w = np.random.uniform(-1, 1, (6, 4)).astype(np.float32)
+    x = flow.tensor(np_x).to_global(placement=P, sbp=flow.sbp.broadcast)
+    w = flow.tensor(np_w).to_global(placement=P, sbp=flow.sbp.broadcast)
+    x = x.to_global(sbp=in_sbp[0])
+    w = w.to_global(sbp=in_sbp[1])
+
+    class BoxingGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+
+        def build(self, x, w):
+            y = flow.matmul(x, w)
+            return y.to_global(sbp=out_sbp)
+
+    y = BoxingGraph()(x, w)
+    test_case.assertTrue(
+        np.allclose(y.numpy(), np.matmul(np_x, np_w), rtol=1e-4, atol=1e-4)
+    )
+
+
+def _test_cpu_collective_broadcast(test_case):
+    np.random.seed(0)
+    np_x = np.random.uniform(-1, 1, (8, 6)).astype(np.float32)
+    x = flow.tensor(np_x).to_global(
+        placement=flow.placement("cpu", ranks=[0]), sbp=flow.sbp.broadcast
+    )
+    P = flow.placement("cpu", ranks=[0, 1])
+
+    class BroadcastGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+
+        def build(self, x):
+            return x.to_global(placement=P, sbp=flow.sbp.broadcast) * 2
+
+    y = BroadcastGraph()(x)
+    test_case.assertTrue(np.allclose(y.to_local().numpy(), np_x * 2))
+
+
+def _test_cpu_fused_all_reduce(test_case, num_matmuls):
+    P = flow.placement("cpu", ranks=[0, 1])
+    np.random.seed(0)
+    np_xs = [
+        np.random.uniform(-1, 1, (8, 6)).astype(np.float32) for _ in range(num_matmuls)
+    ]
+    np_ws = [
+        np.random.uniform(-1, 1, (6, 4)).astype(np.float32) for _ in range(num_matmuls)
+    ]
+    xs = [
+        flow.tensor(np_x)
+        .to_global(placement=P, sbp=flow.sbp.broadcast)
+        .to_global(sbp=flow.sbp.split(1))
+        for np_x in np_xs
+    ]
+    ws = [
+        flow.tensor(np_w)
+        .to_global(placement=P, sbp=flow.sbp.broadcast)
+        .to_global(sbp=flow.sbp.split(0))
+        for np_w in np_ws
+    ]
+
+    class FusedAllReduceGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+
+        def build(self, xs, ws):
+            return [
+                flow.matmul(x, w).to_global(sbp=flow.sbp.broadcast)
+                for x, w in zip(xs, ws)
+            ]
+
+    ys = FusedAllReduceGraph()(xs, ws)
+    for y, np_x, np_w in zip(ys, np_xs, np_ws):
+        test_case.assertTrue(
+            np.allclose(y.numpy(), np.matmul(np_x, np_w), rtol=1e-4, atol=1e-4)
+        )
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphCpuCollectiveBoxing(oneflow.unittest.TestCase):
+    def setUp(test_case):
+        flow.boxing.cpu.enable_collective_boxing(True)
+        flow.boxing.cpu.allow_fuse_all_reduce(True)
+
+    def tearDown(test_case):
+        flow.boxing.cpu.enable_collective_boxing(False)
+
+    def test_all_reduce(test_case):
+        _test_cpu_collective_boxing(
+            test_case, (flow.sbp.split(1), flow.sbp.split(0)), flow.sbp.broadcast
+        )
+
+    def test_reduce_scatter(test_case):
+        _test_cpu_collective_boxing(
+            test_case, (flow.sbp.split(1), flow.sbp.split(0)), flow.sbp.split(0)
+        )
+
+    def test_all_gather(test_case):
+        _test_cpu_collective_boxing(
+            test_case, (flow.sbp.split(0), flow.sbp.broadcast), flow.sbp.broadcast
+        )
+
+    def test_broadcast(test_case):
+        _test_cpu_collective_broadcast(test_case)
+
+    def test_fused_all_reduce(test_case):
+        _test_cpu_fused_all_reduce(test_case, 4)
+
+    def test_fused_all_reduce_max_ops_num(test_case):
+        flow.boxing.cpu.set_fusion_max_ops_num(2)
+        try:
+            _test_cpu_fused_all_reduce(test_case, 5)
+        finally:
+            flow.boxing.cpu.set_fusion_max_ops_num(64)
+
+
+if __name__ == "__main__":
+    unittest.main()
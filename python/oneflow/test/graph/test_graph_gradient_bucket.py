@@ -0,0 +1,81 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import os
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _train_data_parallel_mlp(device, bucket_size_mbyte=None, iter_num=3):
+    P = flow.placement(device, ranks=[0, 1])
+    B = flow.sbp.broadcast
+    S0 = flow.sbp.split(0)
+
+    mlp = flow.nn.Sequential(
+        flow.nn.Linear(64, 128), flow.nn.ReLU(), flow.nn.Linear(128, 32)
+    )
+    mlp = mlp.to_global(placement=P, sbp=B)
+    for param in mlp.parameters():
+        flow.nn.init.constant_(param, 0.01)
+    of_sgd = flow.optim.SGD(mlp.parameters(), lr=0.01)
+
+    np.random.seed(0)
+    x = flow.tensor(
+        np.random.uniform(-1, 1, (8, 64)).astype(np.float32), placement=P, sbp=S0
+    )
+
+    class MLPTrainGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.mlp = mlp
+            self.add_optimizer(of_sgd)
+            if bucket_size_mbyte is not None:
+                self.config.enable_gradient_bucket(
+                    True, bucket_size_mbyte=bucket_size_mbyte
+                )
+
+        def build(self, x):
+            loss = self.mlp(x).sum()
+            loss.backward()
+            return loss
+
+    mlp_t_g = MLPTrainGraph()
+    for i in range(iter_num):
+        mlp_t_g(x)
+    return [param.to_local().numpy() for param in mlp.parameters()]
+
+
+def _test_gradient_bucket(test_case, device):
+    params = _train_data_parallel_mlp(device)
+    bucketed_params = _train_data_parallel_mlp(device, bucket_size_mbyte=1)
+    for param, bucketed_param in zip(params, bucketed_params):
+        test_case.assertTrue(np.allclose(param, bucketed_param, rtol=1e-5, atol=1e-5))
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphGradientBucket(oneflow.unittest.TestCase):
+    def test_gradient_bucket_cpu(test_case):
+        _test_gradient_bucket(test_case, "cpu")
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_gradient_bucket_cuda(test_case):
+        _test_gradient_bucket(test_case, "cuda")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,84 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import os
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _train_data_parallel_linear(device, compression_dtype=None, scale=1.0, iter_num=3):
+    P = flow.placement(device, ranks=[0, 1])
+    B = flow.sbp.broadcast
+    S0 = flow.sbp.split(0)
+
+    linear = flow.nn.Linear(64, 32, bias=True)
+    linear = linear.to_global(placement=P, sbp=B)
+    flow.nn.init.constant_(linear.weight, 0.068758)
+    flow.nn.init.constant_(linear.bias, 0.1)
+    of_sgd = flow.optim.SGD(linear.parameters(), lr=0.01)
+
+    np.random.seed(0)
+    x = flow.tensor(
+        np.random.uniform(-1, 1, (8, 64)).astype(np.float32), placement=P, sbp=S0
+    )
+
+    class LinearTrainGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.linear = linear
+            self.add_optimizer(of_sgd)
+            if compression_dtype is not None:
+                self.config.enable_gradient_compression(
+                    True, dtype=compression_dtype, scale=scale
+                )
+
+        def build(self, x):
+            loss = self.linear(x).sum()
+            loss.backward()
+            return loss
+
+    linear_t_g = LinearTrainGraph()
+    for i in range(iter_num):
+        linear_t_g(x)
+    return linear.weight.to_local().numpy(), linear.bias.to_local().numpy()
+
+
+def _test_gradient_compression(test_case, device, dtype, scale):
+    weight, bias = _train_data_parallel_linear(device)
+    compressed_weight, compressed_bias = _train_data_parallel_linear(
+        device, dtype, scale
+    )
+    test_case.assertTrue(np.allclose(weight, compressed_weight, rtol=1e-2, atol=1e-2))
+    test_case.assertTrue(np.allclose(bias, compressed_bias, rtol=1e-2, atol=1e-2))
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphGradientCompression(oneflow.unittest.TestCase):
+    def test_gradient_compression_bf16_cpu(test_case):
+        _test_gradient_compression(test_case, "cpu", flow.bfloat16, 1.0)
+
+    def test_gradient_compression_fp16_cpu(test_case):
+        _test_gradient_compression(test_case, "cpu", flow.float16, 1024.0)
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_gradient_compression_fp16_cuda(test_case):
+        _test_gradient_compression(test_case, "cuda", flow.float16, 1024.0)
+
+
+if __name__ == "__main__":
+    unittest.main()
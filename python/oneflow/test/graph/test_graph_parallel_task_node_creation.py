@@ -0,0 +1,82 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow.core.job import plan_pb2
+
+
+class _TrainGraph(flow.nn.Graph):
+    def __init__(self):
+        super().__init__()
+        self.model = flow.nn.Sequential(
+            *[
+                layer
+                for _ in range(8)
+                for layer in (flow.nn.Linear(16, 16), flow.nn.ReLU())
+            ]
+        )
+        self.add_optimizer(flow.optim.SGD(self.model.parameters(), lr=0.1))
+
+    def build(self, x):
+        loss = self.model(x).sum()
+        loss.backward()
+        return loss
+
+
+def _compile_normalized_plan(parallel):
+    os.environ["ONEFLOW_ENABLE_PARALLEL_COMP_TASK_NODE_CREATION"] = (
+        "1" if parallel else "0"
+    )
+    try:
+        graph = _TrainGraph()
+        graph(flow.randn(4, 16))
+    finally:
+        os.environ.pop("ONEFLOW_ENABLE_PARALLEL_COMP_TASK_NODE_CREATION", None)
+    plan = plan_pb2.Plan()
+    plan.ParseFromString(graph._c_nn_graph.plan)
+    # task ids keep counting across jobs, so tasks are compared by their plan index
+    task_id2index = {task.task_id: i for (i, task) in enumerate(plan.task)}
+    return [
+        (
+            task.task_type,
+            task.machine_id,
+            task.parallel_ctx.parallel_id,
+            sorted(
+                (
+                    name,
+                    sorted(task_id2index.get(t, -1) for t in regst.consumer_task_id),
+                )
+                for (name, regst) in task.produced_regst_desc.items()
+            ),
+        )
+        for task in plan.task
+    ]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestGraphParallelTaskNodeCreation(oneflow.unittest.TestCase):
+    def test_same_plan_with_and_without_parallelism(test_case):
+        serial_plan = _compile_normalized_plan(parallel=False)
+        test_case.assertGreater(len(serial_plan), 0)
+        for _ in range(2):
+            test_case.assertEqual(_compile_normalized_plan(parallel=True), serial_plan)
+
+
+if __name__ == "__main__":
+    unittest.main()
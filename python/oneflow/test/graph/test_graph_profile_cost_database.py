@@ -0,0 +1,65 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+# the kernel observers are created with the env
+os.environ["ONEFLOW_AUTO_PARALLEL_PROFILE_COST_DATABASE"] = os.path.join(
+    tempfile.mkdtemp(), "cost_database.prototxt"
+)
+
+import oneflow as flow
+import oneflow.unittest
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphProfileCostDatabase(flow.unittest.TestCase):
+    def test_cpu_boxing(test_case):
+        P = flow.placement("cpu", ranks=[0, 1])
+        np.random.seed(0)
+        np_x = np.random.uniform(-1, 1, (8, 6)).astype(np.float32)
+        np_w = np.random.uniform(-1, 1, (6, 4)).astype(np.float32)
+        x = flow.tensor(np_x).to_global(placement=P, sbp=flow.sbp.broadcast)
+        w = flow.tensor(np_w).to_global(placement=P, sbp=flow.sbp.broadcast)
+        x = x.to_global(sbp=flow.sbp.split(0))
+
+        class BoxingGraph(flow.nn.Graph):
+            def __init__(self):
+                super().__init__()
+
+            def build(self, x, w):
+                return flow.matmul(x, w).to_global(sbp=flow.sbp.broadcast)
+
+        y = BoxingGraph()(x, w)
+        test_case.assertTrue(
+            np.allclose(
+                y.to_local().numpy(), np.matmul(np_x, np_w), rtol=1e-4, atol=1e-4
+            )
+        )
+        # the matmul is recorded and the S(0) -> B boxing measured the bandwidth
+        test_case.assertGreater(
+            flow._oneflow_internal.GetProfiledCostDatabaseKernelRecordNum(), 0
+        )
+        test_case.assertGreater(
+            flow._oneflow_internal.GetProfiledCostDatabaseTransferBandwidth(), 0
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,70 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _make_state_dict(num_tensors, numel, device):
+    rng = np.random.RandomState(0)
+    return {
+        "layer{}.weight".format(i): flow.tensor(
+            rng.rand(numel).astype(np.float32), device=device
+        )
+        for i in range(num_tensors)
+    }
+
+
+def _test_async_save(test_case, device):
+    state_dict = _make_state_dict(8, 1000, device)
+    expected = {name: x.numpy() for (name, x) in state_dict.items()}
+    saver = flow.AsyncCheckpointSaver(max_pending_saves=2)
+    with tempfile.TemporaryDirectory() as save_dir:
+        futures = []
+        for step in range(4):
+            path = os.path.join(save_dir, "step_{}.ofpack".format(step))
+            futures.append(saver.save(state_dict, path))
+            # the saved snapshot is not affected by updates after save returns
+            for x in state_dict.values():
+                x.add_(1)
+        saver.wait()
+        for (step, future) in enumerate(futures):
+            test_case.assertTrue(future.done())
+            test_case.assertEqual(future.progress(), 1.0)
+            test_case.assertEqual(future.written_bytes, 8 * 1000 * 4)
+            loaded = flow.load(future.path)
+            for (name, value) in expected.items():
+                test_case.assertTrue(np.array_equal(loaded[name].numpy(), value + step))
+        test_case.assertFalse(any(f.endswith(".tmp") for f in os.listdir(save_dir)))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestAsyncCheckpoint(flow.unittest.TestCase):
+    def test_async_save_cpu(test_case):
+        _test_async_save(test_case, "cpu")
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_async_save_cuda(test_case):
+        _test_async_save(test_case, "cuda")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -139,5 +139,62 @@ class TestBatchNormModule(flow.unittest.TestCase):
         )
 
 
+def _normalization_nchw_and_nhwc(test_case, shape, is_training):
+    x = np.random.randn(*shape).astype(np.float32)
+    dy = np.random.randn(*shape).astype(np.float32)
+    gamma = np.random.randn(shape[1]).astype(np.float32)
+    beta = np.random.randn(shape[1]).astype(np.float32)
+    mean = np.random.randn(shape[1]).astype(np.float32)
+    variance = np.random.uniform(0.5, 1.5, shape[1]).astype(np.float32)
+
+    def run(x_np, dy_np, axis):
+        x_tensor = flow.tensor(x_np, requires_grad=True)
+        gamma_tensor = flow.tensor(gamma, requires_grad=True)
+        beta_tensor = flow.tensor(beta, requires_grad=True)
+        moving_mean = flow.tensor(mean)
+        moving_variance = flow.tensor(variance)
+        y = flow._C.normalization(
+            x_tensor,
+            moving_mean,
+            moving_variance,
+            gamma_tensor,
+            beta_tensor,
+            axis=axis,
+            epsilon=1e-5,
+            momentum=0.9,
+            is_training=is_training,
+        )
+        (y * flow.tensor(dy_np)).sum().backward()
+        return (
+            y.numpy(),
+            x_tensor.grad.numpy(),
+            gamma_tensor.grad.numpy(),
+            beta_tensor.grad.numpy(),
+            moving_mean.numpy(),
+            moving_variance.numpy(),
+        )
+
+    nchw = run(x, dy, 1)
+    nhwc = run(x.transpose(0, 2, 3, 1), dy.transpose(0, 2, 3, 1), 3)
+    test_case.assertTrue(
+        np.allclose(nhwc[0].transpose(0, 3, 1, 2), nchw[0], rtol=1e-4, atol=1e-4)
+    )
+    test_case.assertTrue(
+        np.allclose(nhwc[1].transpose(0, 3, 1, 2), nchw[1], rtol=1e-4, atol=1e-4)
+    )
+    for nhwc_out, nchw_out in zip(nhwc[2:], nchw[2:]):
+        test_case.assertTrue(np.allclose(nhwc_out, nchw_out, rtol=1e-4, atol=1e-4))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestBatchNormChannelsLastCpu(flow.unittest.TestCase):
+    def test_normalization_channels_last(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["shape"] = [(2, 3, 5, 4), (4, 16, 7, 7), (1, 8, 1, 1)]
+        arg_dict["is_training"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            _normalization_nchw_and_nhwc(test_case, *arg)
+
+
 if __name__ == "__main__":
     unittest.main()
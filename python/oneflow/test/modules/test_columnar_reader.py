@@ -0,0 +1,130 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow.utils.data.columnar import write_columnar_file
+
+
+def _make_table(num_rows):
+    rng = np.random.RandomState(0)
+    table = {
+        "id": np.arange(num_rows, dtype=np.int64),
+        "label": rng.randint(2, size=num_rows).astype(np.int32),
+        "dense": rng.rand(num_rows, 13).astype(np.float32),
+    }
+    return table
+
+
+def _write_table(data_dir, table, num_files, row_group_size):
+    num_rows = len(table["id"])
+    rows_per_file = num_rows // num_files
+    for i in range(num_files):
+        part = {
+            name: column[i * rows_per_file : (i + 1) * rows_per_file]
+            for (name, column) in table.items()
+        }
+        write_columnar_file(
+            os.path.join(data_dir, "part-{}".format(i)), part, row_group_size
+        )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestColumnarReader(flow.unittest.TestCase):
+    def test_read_columns(test_case):
+        table = _make_table(240)
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_table(data_dir, table, 2, 50)
+            reader = flow.nn.ColumnarReader(
+                data_dir,
+                columns=["dense", "id"],
+                shapes=[(13,), (1,)],
+                dtypes=[flow.float32, flow.int32],
+                batch_size=32,
+            )
+            # batches span row groups and files, and wrap around after one epoch
+            for step in range(10):
+                (dense, ids) = reader()
+                test_case.assertEqual(dense.shape, (32, 13))
+                test_case.assertEqual(ids.dtype, flow.int32)
+                expected_ids = (np.arange(32) + step * 32) % 240
+                test_case.assertTrue(
+                    np.array_equal(ids.numpy().reshape(-1), expected_ids)
+                )
+                test_case.assertTrue(
+                    np.array_equal(dense.numpy(), table["dense"][expected_ids])
+                )
+
+    def test_predicate_and_shuffle(test_case):
+        table = _make_table(400)
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_table(data_dir, table, 1, 40)
+            reader = flow.nn.ColumnarReader(
+                data_dir,
+                columns=["id", "label"],
+                shapes=[(1,), (1,)],
+                dtypes=[flow.int64, flow.int32],
+                batch_size=25,
+                random_shuffle=True,
+                random_seed=1,
+                predicate_column="id",
+                predicate_range=(100, 199),
+            )
+            seen = []
+            for _ in range(4):
+                (ids, labels) = reader()
+                ids = ids.numpy().reshape(-1)
+                test_case.assertTrue(np.all((ids >= 100) & (ids <= 199)))
+                test_case.assertTrue(
+                    np.array_equal(labels.numpy().reshape(-1), table["label"][ids])
+                )
+                seen.extend(ids.tolist())
+            # one epoch covers every matching row once
+            test_case.assertEqual(sorted(seen), list(range(100, 200)))
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestColumnarReaderDDP(flow.unittest.TestCase):
+    def test_fewer_row_groups_than_ranks(test_case):
+        table = _make_table(40)
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_table(data_dir, table, 1, 40)
+            reader = flow.nn.ColumnarReader(
+                data_dir,
+                columns=["id"],
+                shapes=[(1,)],
+                dtypes=[flow.int64],
+                batch_size=16,
+            )
+            # rank 0 owns the only row group, rank 1 gets an empty shard of padding rows
+            for step in range(3):
+                (ids,) = reader()
+                if flow.env.get_rank() == 0:
+                    expected_ids = (np.arange(16) + step * 16) % 40
+                else:
+                    expected_ids = np.zeros(16, dtype=np.int64)
+                test_case.assertTrue(
+                    np.array_equal(ids.numpy().reshape(-1), expected_ids)
+                )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,178 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+# the tuner reads its settings when the first CPU convolution runs
+_CACHE_FILE = os.path.join(tempfile.mkdtemp(), "cpu_conv_tuning_cache")
+os.environ["ONEFLOW_CPU_CONV_TUNING_CACHE_FILE"] = _CACHE_FILE
+os.environ["ONEFLOW_CPU_CONV_ENABLE_TUNING"] = "1"
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _shape_str(shape):
+    return "(" + ",".join(str(dim) for dim in shape) + ")"
+
+
+def _tuning_key(x_shape, w_shape, stride, padding, dilation, channels_last):
+    key = "kFloat:{}:in={}:weight={}:strides={}:dilation_rate={}:padding_before={}"
+    return key.format(
+        "channels_last" if channels_last else "channels_first",
+        _shape_str(x_shape),
+        _shape_str(w_shape),
+        _shape_str((stride, stride)),
+        _shape_str((dilation, dilation)),
+        _shape_str((padding, padding)),
+    )
+
+
+def _np_conv2d(x, w, b, stride, padding, dilation):
+    (n, c, h, width) = x.shape
+    (f, _, kh, kw) = w.shape
+    x = np.pad(x, ((0, 0), (0, 0), (padding, padding), (padding, padding)))
+    oh = (h + 2 * padding - dilation * (kh - 1) - 1) // stride + 1
+    ow = (width + 2 * padding - dilation * (kw - 1) - 1) // stride + 1
+    out = np.zeros((n, f, oh, ow), dtype=np.float64)
+    for i in range(kh):
+        for j in range(kw):
+            patch = x[
+                :,
+                :,
+                i * dilation : i * dilation + (oh - 1) * stride + 1 : stride,
+                j * dilation : j * dilation + (ow - 1) * stride + 1 : stride,
+            ]
+            out += np.einsum("nchw,fc->nfhw", patch, w[:, :, i, j])
+    return out + b.reshape(1, -1, 1, 1)
+
+
+def _conv2d(x, w, b, stride, padding, dilation, channels_last):
+    if channels_last:
+        x = x.transpose(0, 2, 3, 1)
+        w = w.transpose(0, 2, 3, 1)
+    out = flow._C.conv2d(
+        flow.tensor(x),
+        flow.tensor(w),
+        flow.tensor(b),
+        stride=stride,
+        padding=padding,
+        dilation=dilation,
+        channel_pos="channels_last" if channels_last else "channels_first",
+    ).numpy()
+    return out.transpose(0, 3, 1, 2) if channels_last else out
+
+
+# every pinned problem runs with the algorithm written for its key to the cache file
+_PINNED_CASES = [
+    # (algorithm, x shape, filters, kernel, stride, padding, dilation, channels_last)
+    ("winograd_f2x3", (2, 5, 11, 10), 7, 3, 1, 1, 1, False),
+    ("winograd_f4x3", (2, 5, 11, 10), 7, 3, 1, 1, 1, True),
+    ("winograd_f4x3", (1, 16, 13, 13), 24, 3, 1, 0, 1, False),
+    ("fft", (2, 3, 17, 15), 6, 5, 2, 2, 1, False),
+    ("fft", (1, 4, 16, 16), 5, 3, 1, 2, 2, True),
+]
+
+
+def _write_pinned_cache():
+    with open(_CACHE_FILE, "w") as f:
+        for (algorithm, x_shape, filters, k, stride, pad, dilation, cl) in (
+            _PINNED_CASES
+        ):
+            w_shape = (filters, k, k, x_shape[1]) if cl else (filters, x_shape[1], k, k)
+            if cl:
+                x_shape = (x_shape[0], x_shape[2], x_shape[3], x_shape[1])
+            key = _tuning_key(x_shape, w_shape, stride, pad, dilation, cl)
+            f.write("{} {}\n".format(key, algorithm))
+
+
+_write_pinned_cache()
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestConv2dCpuAlgorithms(flow.unittest.TestCase):
+    def test_pinned_algorithms(test_case):
+        for (algorithm, x_shape, filters, k, stride, pad, dilation, cl) in (
+            _PINNED_CASES
+        ):
+            x = np.random.randn(*x_shape).astype(np.float32)
+            w = np.random.randn(filters, x_shape[1], k, k).astype(np.float32)
+            b = np.random.randn(filters).astype(np.float32)
+            out = _conv2d(x, w, b, stride, pad, dilation, cl)
+            expected = _np_conv2d(x, w, b, stride, pad, dilation)
+            test_case.assertTrue(np.allclose(out, expected, rtol=1e-3, atol=1e-3))
+            # the kernel ran with the algorithm pinned for its key
+            if cl:
+                x_shape = (x_shape[0], x_shape[2], x_shape[3], x_shape[1])
+                w_shape = (filters, k, k, x_shape[3])
+            else:
+                w_shape = (filters, x_shape[1], k, k)
+            key = _tuning_key(x_shape, w_shape, stride, pad, dilation, cl)
+            test_case.assertEqual(
+                flow._oneflow_internal.GetCpuConvResolvedAlgorithm(key), algorithm
+            )
+
+    def test_tuning(test_case):
+        x = np.random.randn(2, 32, 28, 28).astype(np.float32)
+        w = np.random.randn(32, 32, 3, 3).astype(np.float32)
+        b = np.random.randn(32).astype(np.float32)
+        out = _conv2d(x, w, b, 1, 1, 1, False)
+        expected = _np_conv2d(x, w, b, 1, 1, 1)
+        test_case.assertTrue(np.allclose(out, expected, rtol=1e-3, atol=1e-3))
+        key = _tuning_key(x.shape, w.shape, 1, 1, 1, False)
+        with open(_CACHE_FILE) as f:
+            tuned = [line.split() for line in f if line.startswith(key + " ")]
+        test_case.assertEqual(len(tuned), 1)
+        test_case.assertIn(
+            tuned[0][1], ["gemm", "winograd_f2x3", "winograd_f4x3", "fft"]
+        )
+        test_case.assertEqual(
+            flow._oneflow_internal.GetCpuConvResolvedAlgorithm(key), tuned[0][1]
+        )
+
+    def test_weight_update(test_case):
+        # the kernel transforms the weight again when it is updated in place
+        for (algorithm, x_shape, filters, k, stride, pad, dilation, cl) in (
+            _PINNED_CASES
+        ):
+            x = np.random.randn(*x_shape).astype(np.float32)
+            w = np.random.randn(filters, x_shape[1], k, k).astype(np.float32)
+            b = np.zeros(filters, dtype=np.float32)
+            x_tensor = flow.tensor(x.transpose(0, 2, 3, 1) if cl else x)
+            w_tensor = flow.tensor(w.transpose(0, 2, 3, 1) if cl else w)
+            expected = _np_conv2d(x, w, b, stride, pad, dilation)
+            for scale in [1, -2]:
+                out = flow._C.conv2d(
+                    x_tensor,
+                    w_tensor,
+                    stride=stride,
+                    padding=pad,
+                    dilation=dilation,
+                    channel_pos="channels_last" if cl else "channels_first",
+                ).numpy()
+                if cl:
+                    out = out.transpose(0, 3, 1, 2)
+                test_case.assertTrue(
+                    np.allclose(out, expected * scale, rtol=1e-3, atol=1e-3)
+                )
+                w_tensor.mul_(-2)
+
+
+if __name__ == "__main__":
+    unittest.main()
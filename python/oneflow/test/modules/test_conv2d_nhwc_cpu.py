@@ -0,0 +1,139 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _conv2d_nchw_and_nhwc(
+    test_case, shape, out_channels, kernel, stride, pad, dilation
+):
+    x = np.random.randn(*shape).astype(np.float32)
+    w = np.random.randn(out_channels, shape[1], kernel, kernel).astype(np.float32)
+    b = np.random.randn(out_channels).astype(np.float32)
+    expected = flow._C.conv2d(
+        flow.tensor(x),
+        flow.tensor(w),
+        flow.tensor(b),
+        stride=stride,
+        padding=pad,
+        dilation=dilation,
+    ).numpy()
+    out = flow._C.conv2d(
+        flow.tensor(x.transpose(0, 2, 3, 1)),
+        flow.tensor(w.transpose(0, 2, 3, 1)),
+        flow.tensor(b),
+        stride=stride,
+        padding=pad,
+        dilation=dilation,
+        channel_pos="channels_last",
+    ).numpy()
+    test_case.assertTrue(
+        np.allclose(out.transpose(0, 3, 1, 2), expected, rtol=1e-4, atol=1e-4)
+    )
+
+
+class _Bottleneck(flow.nn.Module):
+    def __init__(self, channels, width):
+        super().__init__()
+        self.conv1 = flow.nn.Conv2d(channels, width, 1, bias=False)
+        self.bn1 = flow.nn.BatchNorm2d(width)
+        self.conv2 = flow.nn.Conv2d(width, width, 3, padding=1, bias=False)
+        self.bn2 = flow.nn.BatchNorm2d(width)
+        self.conv3 = flow.nn.Conv2d(width, channels, 1, bias=False)
+        self.bn3 = flow.nn.BatchNorm2d(channels)
+        self.relu = flow.nn.ReLU()
+
+    def forward(self, x):
+        y = self.relu(self.bn1(self.conv1(x)))
+        y = self.relu(self.bn2(self.conv2(y)))
+        y = self.bn3(self.conv3(y))
+        return self.relu(y + x)
+
+
+class _Net(flow.nn.Module):
+    def __init__(self):
+        super().__init__()
+        self.stem = flow.nn.Conv2d(3, 64, 7, stride=2, padding=3, bias=False)
+        self.bn = flow.nn.BatchNorm2d(64)
+        self.pool = flow.nn.MaxPool2d(3, stride=2, padding=1)
+        self.blocks = flow.nn.Sequential(_Bottleneck(64, 16), _Bottleneck(64, 16))
+
+    def forward(self, x):
+        x = self.pool(flow.relu(self.bn(self.stem(x))))
+        return self.blocks(x).mean(dim=(2, 3))
+
+
+class _EvalGraph(flow.nn.Graph):
+    def __init__(self, model, channels_last):
+        super().__init__()
+        self.model = model
+        self.config.allow_cpu_channels_last_layout(channels_last)
+
+    def build(self, x):
+        return self.model(x)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestConv2dNhwcCpu(flow.unittest.TestCase):
+    def test_conv2d_nhwc(test_case):
+        _conv2d_nchw_and_nhwc(test_case, (2, 16, 9, 9), 32, 1, 1, 0, 1)
+        _conv2d_nchw_and_nhwc(test_case, (2, 5, 11, 10), 7, 3, 2, 1, 1)
+        _conv2d_nchw_and_nhwc(test_case, (1, 8, 12, 12), 70, 3, 1, 2, 2)
+        _conv2d_nchw_and_nhwc(test_case, (1, 3, 16, 16), 9, 7, 2, 3, 1)
+
+    def test_channels_last_graph(test_case):
+        model = _Net()
+        model.eval()
+        x = flow.randn(4, 3, 64, 64)
+        expected = model(x).numpy()
+        graph = _EvalGraph(model, True)
+        out = graph(x).numpy()
+        test_case.assertTrue(np.allclose(out, expected, rtol=1e-3, atol=1e-3))
+        # every conv2d reads its weight variable transposed to [F, KH, KW, C]
+        ops = graph._full_graph_proto.net.op
+        variables = set(op.name for op in ops if op.HasField("variable_conf"))
+        name2op = dict((op.name, op) for op in ops)
+        conv_num = 0
+        for op in ops:
+            if not op.HasField("user_conf") or op.user_conf.op_type_name != "conv2d":
+                continue
+            conv_num += 1
+            data_format = op.user_conf.attr["data_format"].at_string
+            test_case.assertEqual(data_format, "channels_last")
+            weight_op = name2op[op.user_conf.input["weight"].s[0].split("/")[0]]
+            test_case.assertEqual(weight_op.user_conf.op_type_name, "transpose")
+            perm = list(weight_op.user_conf.attr["perm"].at_list_int32.val)
+            test_case.assertEqual(perm, [0, 2, 3, 1])
+            weight_lbn = weight_op.user_conf.input["input"].s[0]
+            test_case.assertIn(weight_lbn.split("/")[0], variables)
+        test_case.assertEqual(conv_num, 7)
+
+    def test_conv2d_nhwc_weight_update(test_case):
+        # the packed weight kept by the kernel follows in-place updates of the weight
+        x = flow.randn(2, 10, 10, 8)
+        w = flow.randn(16, 3, 3, 8)
+        first = flow._C.conv2d(x, w, padding=1, channel_pos="channels_last").numpy()
+        w.mul_(2)
+        second = flow._C.conv2d(x, w, padding=1, channel_pos="channels_last").numpy()
+        test_case.assertTrue(np.allclose(second, first * 2, rtol=1e-4, atol=1e-4))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -109,6 +109,89 @@ class TestDDP(flow.unittest.TestCase):
         for dev_type, use_bucket in GenCartesianProduct((test_device, [True, False])):
             test_case._test_ddp_multiple_buckets(dev_type, use_bucket)
 
+    def _test_ddp_topk_gradient(test_case, dev_type, use_bucket):
+        class Mul(flow.nn.Module):
+            def __init__(self):
+                super().__init__()
+                self.w = flow.nn.Parameter(flow.Tensor([1, 1, 1, 1]))
+
+            def forward(self, x):
+                return x * self.w
+
+        rank = flow.env.get_rank()
+        if rank == 0:
+            x = flow.Tensor([1, 2, 3, 4])
+        elif rank == 1:
+            x = flow.Tensor([4, 3, 2, 1])
+        else:
+            raise ValueError()
+
+        x = x.to(dev_type)
+        m = Mul().to(dev_type)
+        m = ddp(m, use_bucket=use_bucket, gradient_topk_ratio=0.5)
+
+        # rank 0 sends [_, _, 1.5, 2] and keeps [0.5, 1, _, _],
+        # rank 1 sends [2, 1.5, _, _] and keeps [_, _, 1, 0.5]
+        m(x).sum().backward()
+        test_case.assertTrue(
+            np_allclose_with_shape(m.w.grad.numpy(), np.array([2, 1.5, 1.5, 2]))
+        )
+        # the residuals are added to the gradients of the next step
+        m.w.grad.zero_()
+        m(x).sum().backward()
+        test_case.assertTrue(
+            np_allclose_with_shape(m.w.grad.numpy(), np.array([2, 2, 2, 2]))
+        )
+
+    def test_ddp_topk_gradient(test_case):
+        for dev_type, use_bucket in GenCartesianProduct((test_device, [True, False])):
+            test_case._test_ddp_topk_gradient(dev_type, use_bucket)
+
+    def _test_ddp_topk_gradient_residual(test_case, dev_type, use_bucket):
+        class Mul(flow.nn.Module):
+            def __init__(self):
+                super().__init__()
+                self.w = flow.nn.Parameter(flow.ones(16))
+
+            def forward(self, x):
+                return x * self.w
+
+        world_size = flow.env.get_world_size()
+        np_x = np.random.RandomState(flow.env.get_rank()).uniform(-1, 1, 16)
+        x = flow.tensor(np_x, dtype=flow.float32, device=dev_type)
+        m = Mul().to(dev_type)
+        m = ddp(m, use_bucket=use_bucket, gradient_topk_ratio=0.125)
+        # the gradient of every rank is x / world_size, their sum is the dense gradient
+        local_grad = np_x / world_size
+        dense_grad = flow.tensor(local_grad, dtype=flow.float32, device=dev_type)
+        flow.comm.all_reduce(dense_grad)
+        sent = np.zeros(16)
+        for step in range(1, 33):
+            if m.w.grad is not None:
+                m.w.grad.zero_()
+            m(x).sum().backward()
+            sent += m.w.grad.numpy()
+            (residual,) = m._gradient_residuals.values()
+            total_residual = residual.clone()
+            flow.comm.all_reduce(total_residual)
+            # nothing is lost: what was not sent yet is in the residuals of the ranks
+            test_case.assertTrue(
+                np.allclose(
+                    sent + total_residual.numpy(),
+                    step * dense_grad.numpy(),
+                    atol=1e-4,
+                )
+            )
+            # with k of n elements sent, |residual|_1 <= (n / k - 1) * |grad|_1
+            test_case.assertLessEqual(
+                np.abs(residual.numpy()).sum(),
+                (16 / 2 - 1) * np.abs(local_grad).sum() + 1e-4,
+            )
+
+    def test_ddp_topk_gradient_residual(test_case):
+        for dev_type, use_bucket in GenCartesianProduct((test_device, [True, False])):
+            test_case._test_ddp_topk_gradient_residual(dev_type, use_bucket)
+
     def _test_ddp_with_unused_param(test_case, dev_type):
         class Model(flow.nn.Module):
             def __init__(self):
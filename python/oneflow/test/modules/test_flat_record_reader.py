@@ -0,0 +1,109 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+import oneflow.core.record.record_pb2 as record_pb2
+from oneflow.utils.data.flat_record import convert_ofrecord
+
+_num_dense = 13
+_num_sparse = 26
+_fields = [
+    ("label", (1,), flow.int32),
+    ("dense", (_num_dense,), flow.float32),
+    ("sparse", (_num_sparse,), flow.int64),
+]
+
+
+def _write_ofrecord_parts(data_dir, num_parts, records_per_part):
+    os.makedirs(data_dir)
+    rng = np.random.RandomState(0)
+    for part in range(num_parts):
+        with open(os.path.join(data_dir, "part-{}".format(part)), "wb") as f:
+            for _ in range(records_per_part):
+                record = record_pb2.OFRecord()
+                record.feature["label"].int32_list.value.append(rng.randint(2))
+                record.feature["dense"].float_list.value.extend(
+                    rng.rand(_num_dense).tolist()
+                )
+                record.feature["sparse"].int64_list.value.extend(
+                    rng.randint(1 << 40, size=_num_sparse).tolist()
+                )
+                record_bytes = record.SerializeToString()
+                f.write(struct.pack("<q", len(record_bytes)))
+                f.write(record_bytes)
+
+
+class OFRecordLoader(flow.nn.Module):
+    def __init__(self, data_dir, batch_size):
+        super().__init__()
+        self.reader = flow.nn.OFRecordReader(
+            data_dir, batch_size=batch_size, data_part_num=2
+        )
+        self.decoders = [
+            flow.nn.OFRecordRawDecoder(name, shape=shape, dtype=dtype)
+            for (name, shape, dtype) in _fields
+        ]
+
+    def forward(self):
+        record = self.reader()
+        return tuple(decoder(record) for decoder in self.decoders)
+
+
+def _make_flat_record_loader(data_dir, batch_size):
+    return flow.nn.FlatRecordReader(
+        data_dir,
+        names=[name for (name, _, _) in _fields],
+        shapes=[shape for (_, shape, _) in _fields],
+        dtypes=[dtype for (_, _, dtype) in _fields],
+        batch_size=batch_size,
+        data_part_num=2,
+    )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFlatRecordReader(flow.unittest.TestCase):
+    def test_same_as_ofrecord(test_case):
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            ofrecord_dir = os.path.join(tmp_dir, "ofrecord")
+            flat_record_dir = os.path.join(tmp_dir, "flat_record")
+            _write_ofrecord_parts(ofrecord_dir, 2, 64)
+            test_case.assertEqual(convert_ofrecord(ofrecord_dir, flat_record_dir), 128)
+            ofrecord_loader = OFRecordLoader(ofrecord_dir, 16)
+            flat_record_loader = _make_flat_record_loader(flat_record_dir, 16)
+            # iterate over more than one epoch
+            for _ in range(10):
+                expected = ofrecord_loader()
+                outputs = flat_record_loader()
+                test_case.assertEqual(len(outputs), len(_fields))
+                for (output, expected_output, (_, shape, dtype)) in zip(
+                    outputs, expected, _fields
+                ):
+                    test_case.assertEqual(output.shape, (16,) + shape)
+                    test_case.assertEqual(output.dtype, dtype)
+                    test_case.assertTrue(
+                        np.array_equal(output.numpy(), expected_output.numpy())
+                    )
+
+
+if __name__ == "__main__":
+    unittest.main()
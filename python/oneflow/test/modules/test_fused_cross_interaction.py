@@ -21,6 +21,8 @@ from oneflow.test_utils.test_util import GenArgList
 
 import oneflow as flow
 
+test_device = ["cpu"] if os.getenv("ONEFLOW_TEST_CPU_ONLY") else ["cpu", "cuda"]
+
 
 def _test_fused_cross_feature_interaction_v1(
     test_case, batchsize, in_feature, dtype, device,
@@ -124,7 +126,6 @@ def _test_fused_cross_feature_interaction_v2(
     )
 
 
-@unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
 @flow.unittest.skip_unless_1n1d()
 class TestFusedCrossFeatureInteraction(flow.unittest.TestCase):
     def test_fused_cross_feature_interaction_v1(test_case):
@@ -133,7 +134,7 @@ class TestFusedCrossFeatureInteraction(flow.unittest.TestCase):
         args_dict["batchsize"] = [1, 2, 4]
         args_dict["in_feature"] = [32, 64, 96, 128]
         args_dict["dtype"] = [flow.float32]
-        args_dict["device"] = ["cuda"]
+        args_dict["device"] = test_device
 
         for arg in GenArgList(args_dict):
             arg[0](test_case, *arg[1:])
@@ -144,7 +145,7 @@ class TestFusedCrossFeatureInteraction(flow.unittest.TestCase):
         args_dict["batchsize"] = [1, 2, 4]
         args_dict["in_feature"] = [32, 64, 96, 128]
         args_dict["dtype"] = [flow.float32]
-        args_dict["device"] = ["cuda"]
+        args_dict["device"] = test_device
 
         for arg in GenArgList(args_dict):
             arg[0](test_case, *arg[1:])
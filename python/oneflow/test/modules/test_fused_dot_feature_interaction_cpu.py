@@ -0,0 +1,125 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow.test_utils.test_util import GenArgDict
+
+
+def _naive_dot_interaction(features, output_concat, self_interaction, output_padding):
+    batch_size = features[0].shape[0]
+    num_rows = sum(feature.shape[1] for feature in features)
+    offset = 1 if self_interaction else 0
+    li = flow.tensor([i for i in range(num_rows) for j in range(i + offset)])
+    lj = flow.tensor([j for i in range(num_rows) for j in range(i + offset)])
+    T = flow.cat(features, dim=1)
+    Z = flow.matmul(T, T, transpose_b=True)
+    R = Z[:, li, lj]
+    if output_concat is not None:
+        R = flow.cat([output_concat, R], dim=1)
+    if output_padding != 0:
+        R = flow.cat([R, flow.zeros(batch_size, output_padding, dtype=R.dtype)], dim=1)
+    return R
+
+
+def _test_fused_dot_feature_interaction(
+    test_case, embedding_size, self_interaction, output_concat, output_padding, dtype
+):
+    batch_size = 64
+    np_dtype = np.float64 if dtype == flow.float64 else np.float32
+    feature_0_np = np.random.rand(batch_size, embedding_size).astype(np_dtype)
+    feature_1_np = np.random.rand(batch_size, 26, embedding_size).astype(np_dtype)
+
+    def run(fused):
+        feature_0 = flow.tensor(feature_0_np, requires_grad=True)
+        feature_1 = flow.tensor(feature_1_np, requires_grad=True)
+        features = [feature_0.reshape(batch_size, 1, embedding_size), feature_1]
+        concat = feature_0 if output_concat else None
+        if fused:
+            R = flow._C.fused_dot_feature_interaction(
+                features,
+                output_concat=concat,
+                self_interaction=self_interaction,
+                output_padding=output_padding,
+                pooling="none",
+            )
+        else:
+            R = _naive_dot_interaction(
+                features, concat, self_interaction, output_padding
+            )
+        # a non uniform dy checks that every output element reaches the right features
+        weight = flow.tensor(np.random.RandomState(0).rand(*R.shape).astype(np_dtype))
+        (R * weight).sum().backward()
+        return (R.numpy(), feature_0.grad.numpy(), feature_1.grad.numpy())
+
+    for (fused, naive) in zip(run(True), run(False)):
+        test_case.assertTrue(np.allclose(fused, naive, rtol=1e-4, atol=1e-4))
+
+
+def _test_fused_dot_feature_interaction_pooling_sum(
+    test_case, feature_dims, embedding_size, dtype
+):
+    batch_size = 64
+    np_dtype = np.float64 if dtype == flow.float64 else np.float32
+    features_np = [
+        np.random.uniform(-1, 1, (batch_size, dim, embedding_size)).astype(np_dtype)
+        for dim in feature_dims
+    ]
+    features = [flow.tensor(f, requires_grad=True) for f in features_np]
+    fused_features = [flow.tensor(f, requires_grad=True) for f in features_np]
+
+    concat = flow.cat(features, dim=1)
+    bi_interaction = (flow.sum(concat, dim=1) ** 2 - flow.sum(concat ** 2, dim=1)) * 0.5
+    R = flow.sum(bi_interaction, dim=-1, keepdim=True)
+    R.sum().backward()
+    fused_R = flow._C.fused_dot_feature_interaction(fused_features, pooling="sum")
+    fused_R.sum().backward()
+    test_case.assertTrue(np.allclose(fused_R.numpy(), R.numpy(), rtol=1e-4, atol=1e-4))
+    for (feature, fused_feature) in zip(features, fused_features):
+        test_case.assertTrue(
+            np.allclose(
+                fused_feature.grad.numpy(), feature.grad.numpy(), rtol=1e-4, atol=1e-4
+            )
+        )
+
+
+@flow.unittest.skip_unless_1n1d()
+class FusedDotFeatureInteractionCpuTestCase(flow.unittest.TestCase):
+    def test_fused_dot_feature_interaction(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["embedding_size"] = [128, 127, 16, 15]
+        arg_dict["self_interaction"] = [False, True]
+        arg_dict["output_concat"] = [True, False]
+        arg_dict["output_padding"] = [1, 0]
+        arg_dict["dtype"] = [flow.float32, flow.float64]
+        for kwargs in GenArgDict(arg_dict):
+            _test_fused_dot_feature_interaction(test_case, **kwargs)
+
+    def test_fused_dot_feature_interaction_pooling_sum(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["feature_dims"] = [[39], [13, 26], [1, 10, 3]]
+        arg_dict["embedding_size"] = [16, 11, 12]
+        arg_dict["dtype"] = [flow.float32, flow.float64]
+        for kwargs in GenArgDict(arg_dict):
+            _test_fused_dot_feature_interaction_pooling_sum(test_case, **kwargs)
+
+
+if __name__ == "__main__":
+    unittest.main()
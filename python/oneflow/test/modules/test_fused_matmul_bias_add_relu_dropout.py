@@ -15,11 +15,14 @@ limitations under the License.
 """
 import unittest
 from collections import OrderedDict
+import os
 import numpy as np
 from oneflow.test_utils.test_util import GenArgList
 
 import oneflow as flow
 
+test_device = ["cpu"] if os.getenv("ONEFLOW_TEST_CPU_ONLY") else ["cpu", "cuda"]
+
 
 def _matmul_bias_relu(x, weight, bias, skip_activate):
     # We do not add dropout in unittest, cause its result is random.
@@ -182,7 +185,7 @@ class TestFusedMatmulBiasAddReluDropout(flow.unittest.TestCase):
         args_dict["out_feature"] = [512, 400, 1024, 1]
         args_dict["skip_final_activation"] = [False]
         args_dict["dtype"] = [flow.float32]
-        args_dict["device"] = ["cuda"]
+        args_dict["device"] = test_device
 
         for arg in GenArgList(args_dict):
             arg[0](test_case, *arg[1:])
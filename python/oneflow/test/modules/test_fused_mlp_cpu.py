@@ -0,0 +1,93 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _make_mlp(in_feature, hidden_size_list, requires_grad=False):
+    weights = []
+    biases = []
+    for hidden_size in hidden_size_list:
+        weights.append(flow.randn(hidden_size, in_feature, requires_grad=requires_grad))
+        biases.append(flow.randn(hidden_size, requires_grad=requires_grad))
+        in_feature = hidden_size
+    return (weights, biases)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFusedMLPCpu(flow.unittest.TestCase):
+    def test_dropout(test_case):
+        # rows span several tiles of the kernel, features are not a multiple of 32
+        x = flow.randn(1000, 40, requires_grad=True)
+        (weights, biases) = _make_mlp(40, [72, 33], requires_grad=True)
+        rate = 0.5
+        out = flow._C.fused_matmul_bias_add_relu_dropout(
+            x,
+            weights,
+            biases,
+            skip_final_activation=False,
+            dropout_rate_list=[0.0, rate],
+        )
+        hidden = flow.relu(
+            flow._C.bias_add(
+                flow._C.matmul(x, weights[0], transpose_b=True), biases[0], axis=1
+            )
+        )
+        final = flow._C.bias_add(
+            flow._C.matmul(hidden, weights[1], transpose_b=True), biases[1], axis=1
+        )
+        # every kept element is scaled, every dropped or negative one is zero
+        keep = (out != 0).to(flow.float32)
+        expected = flow.relu(final) * keep / (1 - rate)
+        test_case.assertTrue(
+            np.allclose(out.numpy(), expected.numpy(), rtol=1e-4, atol=1e-4)
+        )
+        kept_ratio = keep.sum().numpy() / (final > 0).sum().numpy()
+        test_case.assertTrue(abs(kept_ratio - (1 - rate)) < 0.05)
+
+        grads = flow.autograd.grad(out.sum(), [x] + weights + biases)
+        expected_grads = flow.autograd.grad(expected.sum(), [x] + weights + biases)
+        for (grad, expected_grad) in zip(grads, expected_grads):
+            test_case.assertTrue(
+                np.allclose(grad.numpy(), expected_grad.numpy(), rtol=1e-4, atol=1e-4)
+            )
+
+    def test_dropout_generator(test_case):
+        x = flow.randn(64, 16)
+        (weights, biases) = _make_mlp(16, [48])
+        outputs = []
+        for _ in range(2):
+            generator = flow.Generator()
+            generator.manual_seed(1)
+            outputs.append(
+                flow._C.fused_matmul_bias_add_relu_dropout(
+                    x,
+                    weights,
+                    biases,
+                    skip_final_activation=True,
+                    dropout_rate_list=[0.3],
+                    generator=generator,
+                ).numpy()
+            )
+        test_case.assertTrue(np.array_equal(outputs[0], outputs[1]))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,158 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _linear(x, w, b):
+    y = flow.matmul(x, w, transpose_b=True)
+    return y if b is None else y + b
+
+
+# reference cells built from elementwise ops only, no fused kernel is involved
+def _lstm_cell_reference(x, h, c, w_ih, w_hh, b_ih, b_hh):
+    gates = _linear(x, w_ih, b_ih) + _linear(h, w_hh, b_hh)
+    (i, f, g, o) = flow.chunk(gates, 4, dim=1)
+    c = flow.sigmoid(f) * c + flow.sigmoid(i) * flow.tanh(g)
+    h = flow.sigmoid(o) * flow.tanh(c)
+    return (h, c)
+
+
+def _gru_cell_reference(x, h, w_ih, w_hh, b_ih, b_hh):
+    (ir, ii, in_) = flow.chunk(_linear(x, w_ih, b_ih), 3, dim=1)
+    (hr, hi, hn) = flow.chunk(_linear(h, w_hh, b_hh), 3, dim=1)
+    r = flow.sigmoid(ir + hr)
+    z = flow.sigmoid(ii + hi)
+    n = flow.tanh(in_ + r * hn)
+    return n + z * (h - n)
+
+
+def _check_grads(test_case, outputs, expected_outputs, inputs):
+    for (output, expected) in zip(outputs, expected_outputs):
+        test_case.assertTrue(
+            np.allclose(output.numpy(), expected.numpy(), rtol=1e-4, atol=1e-5)
+        )
+    grads = flow.autograd.grad(sum(o.sum() for o in outputs), inputs)
+    expected_grads = flow.autograd.grad(
+        sum(o.sum() for o in expected_outputs), inputs
+    )
+    for (grad, expected) in zip(grads, expected_grads):
+        test_case.assertTrue(
+            np.allclose(grad.numpy(), expected.numpy(), rtol=1e-4, atol=1e-5)
+        )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFusedRnnCpu(flow.unittest.TestCase):
+    def test_lstm_cell(test_case):
+        for bias in [True, False]:
+            cell = flow.nn.LSTMCell(6, 8, bias=bias)
+            x = flow.randn(5, 6, requires_grad=True)
+            h = flow.randn(5, 8, requires_grad=True)
+            c = flow.randn(5, 8, requires_grad=True)
+            params = [cell.weight_ih, cell.weight_hh, cell.bias_ih, cell.bias_hh]
+            outputs = cell(x, (h, c))
+            expected = _lstm_cell_reference(x, h, c, *params)
+            inputs = [x, h, c, cell.weight_ih, cell.weight_hh]
+            if bias:
+                inputs += [cell.bias_ih, cell.bias_hh]
+            _check_grads(test_case, outputs, expected, inputs)
+
+    def test_gru_cell(test_case):
+        for bias in [True, False]:
+            cell = flow.nn.GRUCell(6, 8, bias=bias)
+            x = flow.randn(5, 6, requires_grad=True)
+            h = flow.randn(5, 8, requires_grad=True)
+            params = [cell.weight_ih, cell.weight_hh, cell.bias_ih, cell.bias_hh]
+            output = cell(x, h)
+            expected = _gru_cell_reference(x, h, *params)
+            inputs = [x, h, cell.weight_ih, cell.weight_hh]
+            if bias:
+                inputs += [cell.bias_ih, cell.bias_hh]
+            _check_grads(test_case, [output], [expected], inputs)
+
+    def test_lstm_sequence(test_case):
+        lstm = flow.nn.LSTM(6, 8, num_layers=2)
+        x = flow.randn(7, 3, 6, requires_grad=True)
+        h0 = flow.randn(2, 3, 8)
+        c0 = flow.randn(2, 3, 8)
+        (output, (hn, cn)) = lstm(x, (h0, c0))
+        expected = []
+        layer_input = list(flow.unbind(x, 0))
+        for l in range(2):
+            params = [
+                getattr(lstm, "{}_l{}".format(name, l))
+                for name in ["weight_ih", "weight_hh", "bias_ih", "bias_hh"]
+            ]
+            (h, c) = (h0[l], c0[l])
+            for t in range(7):
+                (h, c) = _lstm_cell_reference(layer_input[t], h, c, *params)
+                layer_input[t] = h
+            expected += [h, c]
+        expected_output = flow.stack(layer_input, 0)
+        _check_grads(
+            test_case,
+            [output, hn[0], cn[0], hn[1], cn[1]],
+            [expected_output] + expected,
+            [x, lstm.weight_ih_l0, lstm.bias_hh_l1],
+        )
+
+    def test_bidirectional_gru_sequence(test_case):
+        gru = flow.nn.GRU(6, 8, bidirectional=True, batch_first=True)
+        x = flow.randn(3, 7, 6, requires_grad=True)
+        (output, hn) = gru(x)
+        steps = list(flow.unbind(x, 1))
+        h = flow.zeros(3, 8)
+        fw = []
+        for t in range(7):
+            h = _gru_cell_reference(
+                steps[t],
+                h,
+                gru.weight_ih_l0,
+                gru.weight_hh_l0,
+                gru.bias_ih_l0,
+                gru.bias_hh_l0,
+            )
+            fw.append(h)
+        h = flow.zeros(3, 8)
+        bw = [None] * 7
+        for t in reversed(range(7)):
+            h = _gru_cell_reference(
+                steps[t],
+                h,
+                gru.weight_ih_l0_reverse,
+                gru.weight_hh_l0_reverse,
+                gru.bias_ih_l0_reverse,
+                gru.bias_hh_l0_reverse,
+            )
+            bw[t] = h
+        expected_output = flow.stack(
+            [flow.cat([f, b], dim=1) for (f, b) in zip(fw, bw)], 1
+        )
+        _check_grads(
+            test_case,
+            [output, hn[0], hn[1]],
+            [expected_output, fw[-1], bw[0]],
+            [x, gru.weight_ih_l0, gru.bias_ih_l0_reverse],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
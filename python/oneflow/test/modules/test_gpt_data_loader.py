@@ -15,6 +15,7 @@ limitations under the License.
 """
 import unittest
 import os
+import tempfile
 import numpy as np
 
 import oneflow as flow
@@ -104,5 +105,84 @@ class GPTDataLoaderDistributedTestCase(oneflow.unittest.TestCase):
             )
 
 
+def _get_tokens_with_index_cache(enable_cache, cache_dir, iteration=2):
+    os.environ["ONEFLOW_GPT_DATASET_ENABLE_INDEX_CACHE"] = "1" if enable_cache else "0"
+    os.environ["ONEFLOW_GPT_DATASET_INDEX_CACHE_DIR"] = cache_dir
+    loader = GPTDataLoader(batch_size=4, device=flow.device("cpu"))
+    return [loader().numpy() for _ in range(iteration)]
+
+
+@unittest.skipIf(
+    os.getenv("ONEFLOW_TEST_GITHUB_HOSTED"),
+    "/dataset not available on GitHub hosted servers",
+)
+@flow.unittest.skip_unless_1n1d()
+class GPTDataLoaderIndexCacheTestCase(oneflow.unittest.TestCase):
+    def test_index_cache(test_case):
+        try:
+            with tempfile.TemporaryDirectory() as cache_dir:
+                tokens = _get_tokens_with_index_cache(False, cache_dir)
+                test_case.assertEqual(len(os.listdir(cache_dir)), 0)
+                # the first run builds and saves the cache, the second one maps it
+                for _ in range(2):
+                    cached_tokens = _get_tokens_with_index_cache(True, cache_dir)
+                    test_case.assertEqual(len(os.listdir(cache_dir)), 1)
+                    for lhs, rhs in zip(tokens, cached_tokens):
+                        test_case.assertTrue(np.array_equal(lhs, rhs))
+        finally:
+            os.environ.pop("ONEFLOW_GPT_DATASET_ENABLE_INDEX_CACHE", None)
+            os.environ.pop("ONEFLOW_GPT_DATASET_INDEX_CACHE_DIR", None)
+
+
+@unittest.skipIf(
+    os.getenv("ONEFLOW_TEST_GITHUB_HOSTED"),
+    "/dataset not available on GitHub hosted servers",
+)
+@flow.unittest.skip_unless_1n1d()
+class GPTDataLoaderPackingTestCase(oneflow.unittest.TestCase):
+    def test_packing(test_case):
+        seq_length = 1024
+        batch_size = 4
+        max_num_segments = 16
+        loader = flow.nn.GPTIndexedBinDataReader(
+            data_file_prefix=flow.unittest.dataset_dir(
+                "Megatron-LM/dummy/gpt_sample_dataset_text_document"
+            ),
+            seq_length=seq_length,
+            num_samples=648,
+            batch_size=batch_size,
+            random_seed=12345,
+            device=flow.device("cpu"),
+            packing=True,
+            max_num_segments=max_num_segments,
+            pad_token_id=-1,
+        )
+        for _ in range(2):
+            tokens, position_ids, cu_seqlens = loader()
+            sample_len = seq_length + 1
+            test_case.assertEqual(tokens.shape, (batch_size, sample_len))
+            test_case.assertEqual(position_ids.shape, (batch_size, sample_len))
+            test_case.assertEqual(cu_seqlens.shape, (batch_size, max_num_segments + 2))
+            test_case.assertEqual(cu_seqlens.dtype, flow.int32)
+            tokens = tokens.numpy()
+            position_ids = position_ids.numpy()
+            cu_seqlens = cu_seqlens.numpy()
+            for i in range(batch_size):
+                test_case.assertEqual(cu_seqlens[i][0], 0)
+                test_case.assertEqual(cu_seqlens[i][-1], sample_len)
+                test_case.assertTrue(np.all(np.diff(cu_seqlens[i]) >= 0))
+                for begin, end in zip(cu_seqlens[i][:-1], cu_seqlens[i][1:]):
+                    if begin == end:
+                        continue
+                    # position ids restart at every document boundary
+                    if np.all(tokens[i][begin:end] == -1):
+                        continue
+                    test_case.assertTrue(
+                        np.array_equal(
+                            position_ids[i][begin:end], np.arange(end - begin)
+                        )
+                    )
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,119 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+
+import cv2
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+_images = [
+    "mscoco_2017/val2017/000000000139.jpg",
+    "mscoco_2017/val2017/000000000632.jpg",
+]
+_mean = [123.68, 116.779, 103.939]
+_std = [58.393, 57.12, 57.375]
+
+
+def _read_images_buffer(batch_size=2):
+    image_files = [flow.unittest.dataset_dir(_images[i % 2]) for i in range(batch_size)]
+    images_bytes = []
+    for image_file in image_files:
+        with open(image_file, "rb") as f:
+            images_bytes.append(f.read())
+    static_shape = (len(images_bytes), max([len(bys) for bys in images_bytes]))
+    images_np_arr_static = np.zeros(static_shape, dtype=np.int8)
+    for (idx, bys) in enumerate(images_bytes):
+        images_np_arr_static[idx, : len(bys)] = np.frombuffer(bys, dtype=np.int8)
+    input = flow.tensor(images_np_arr_static, dtype=flow.int8, device="cpu")
+    return image_files, flow.tensor_to_tensor_buffer(input, instance_dims=1)
+
+
+def _cv2_decode_resize_normalize(image_file, height, width, color_space):
+    image = cv2.imread(image_file)
+    if color_space == "RGB":
+        image = cv2.cvtColor(image, cv2.COLOR_BGR2RGB)
+    interpolation = (
+        cv2.INTER_LINEAR
+        if height * width >= image.shape[0] * image.shape[1]
+        else cv2.INTER_AREA
+    )
+    image = cv2.resize(image, (width, height), interpolation=interpolation)
+    image = (image.astype(np.float32) - np.array(_mean)) / np.array(_std)
+    return np.transpose(image, (2, 0, 1))
+
+
+def _test_decode_resize_normalize(test_case, color_space, output_layout):
+    image_files, images_buffer = _read_images_buffer()
+    fused = flow.nn.image.decode_random_crop_resize_normalize(
+        target_height=224,
+        target_width=224,
+        color_space=color_space,
+        output_layout=output_layout,
+        mean=_mean,
+        std=_std,
+        random_crop=False,
+        dct_scaling=False,
+    )
+    of_images = fused(images_buffer).numpy()
+    if output_layout == "NHWC":
+        of_images = np.transpose(of_images, (0, 3, 1, 2))
+    for (of_image, image_file) in zip(of_images, image_files):
+        cv2_image = _cv2_decode_resize_normalize(image_file, 224, 224, color_space)
+        test_case.assertEqual(of_image.shape, cv2_image.shape)
+        test_case.assertTrue(np.allclose(of_image, cv2_image, atol=0.1))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestImageDecodeRandomCropResizeNormalize(flow.unittest.TestCase):
+    def test_decode_resize_normalize(test_case):
+        for color_space in ["BGR", "RGB"]:
+            for output_layout in ["NCHW", "NHWC"]:
+                _test_decode_resize_normalize(test_case, color_space, output_layout)
+
+    def test_mirror(test_case):
+        _, images_buffer = _read_images_buffer()
+        fused = flow.nn.image.decode_random_crop_resize_normalize(
+            target_height=96, target_width=128, random_crop=False
+        )
+        mirror = flow.tensor([1, 0], dtype=flow.int8)
+        images = fused(images_buffer).numpy()
+        mirrored_images = fused(images_buffer, mirror).numpy()
+        test_case.assertTrue(np.array_equal(mirrored_images[0], images[0][..., ::-1]))
+        test_case.assertTrue(np.array_equal(mirrored_images[1], images[1]))
+
+    def test_random_crop_dct_scaling(test_case):
+        _, images_buffer = _read_images_buffer()
+        for dct_scaling in [True, False]:
+            fused = flow.nn.image.decode_random_crop_resize_normalize(
+                target_height=64,
+                target_width=64,
+                color_space="RGB",
+                mean=_mean,
+                std=_std,
+                random_seed=1,
+                dct_scaling=dct_scaling,
+            )
+            images = fused(images_buffer)
+            test_case.assertEqual(images.shape, (2, 3, 64, 64))
+            test_case.assertEqual(images.dtype, flow.float32)
+            test_case.assertTrue(np.all(np.isfinite(images.numpy())))
+
+
+if __name__ == "__main__":
+    unittest.main()
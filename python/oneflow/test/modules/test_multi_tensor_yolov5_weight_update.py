@@ -84,7 +84,7 @@ class TestMultiTensorWeightUpdateModule(flow.unittest.TestCase):
     def test_multi_tensor_weight_update(test_case):
         arg_dict = OrderedDict()
         arg_dict["test_fun"] = [_test_multi_tensor_weight_update_impl]
-        arg_dict["device"] = ["cuda"]
+        arg_dict["device"] = ["cuda", "cpu"]
         arg_dict["shape"] = [(20, 1), (30, 1), (55, 1)]
         arg_dict["n"] = [5, 10, 292]
         arg_dict["d"] = [0.22, 0.5]
@@ -38,6 +38,7 @@ def compare_with_numpy_sgd(
     learning_rate,
     train_iters,
     use_optional_tensor,
+    device="cuda",
 ):
     # if use_optional_tensor, pass lr as tensor to sgd_update, else pass as attr.
     num_rows = 500
@@ -103,15 +104,15 @@ def compare_with_numpy_sgd(
 
     def sgd_by_oneflow():
         unique_embeddings_tensor = flow.tensor(init_value, requires_grad=False).to(
-            "cuda"
+            device
         )
         if use_optional_tensor:
             lr_tensor = flow.tensor(
                 np.array(learning_rate).reshape(1,).astype(np.float32)
-            ).to("cuda")
+            ).to(device)
             down_scale_by_tensor = flow.tensor(
                 np.array((down_scale_by,)).astype(np.float32)
-            ).to("cuda")
+            ).to(device)
         else:
             # pass by attr
             lr_tensor = None
@@ -138,12 +139,12 @@ def compare_with_numpy_sgd(
             np_ids = np.zeros(num_rows)
             np_ids[0 : num_valid_seq[i]] = np.arange(num_valid_seq[i])
             # add ids of num_valid unique to use id_shuffle out_put num_unique as grad input
-            ids = flow.tensor(np_ids.astype(np.int32)).to("cuda")
-            grad_tensor = flow.tensor(random_grad_seq[i]).to("cuda")
+            ids = flow.tensor(np_ids.astype(np.int32)).to(device)
+            grad_tensor = flow.tensor(random_grad_seq[i]).to(device)
             if use_optional_tensor:
                 skip_if_tensor = flow.tensor(
                     np.array(skip_if_seq[i]).reshape(1,).astype(np.int64)
-                ).to("cuda")
+                ).to(device)
             else:
                 skip_if_tensor = None
             updated_tensor = train_one_iter(
@@ -225,5 +226,20 @@ class TestOptimizers(flow.unittest.TestCase):
             compare_with_numpy_sgd(test_case, **arg)
 
 
+@flow.unittest.skip_unless_1n1d()
+class TestCpuOptimizers(flow.unittest.TestCase):
+    def test_one_embedding_sgd_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["momentum"] = [0, 0.9]
+        arg_dict["weight_decay"] = [0, 0.1]
+        arg_dict["scale"] = [1, 0.1]
+        arg_dict["learning_rate"] = [0.9]
+        arg_dict["train_iters"] = [10]
+        arg_dict["use_optional_tensor"] = [True, False]
+        arg_dict["device"] = ["cpu"]
+        for arg in GenArgDict(arg_dict):
+            compare_with_numpy_sgd(test_case, **arg)
+
+
 if __name__ == "__main__":
     unittest.main()
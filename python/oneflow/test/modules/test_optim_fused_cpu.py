@@ -0,0 +1,74 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _make_params(shapes, seed):
+    rng = np.random.RandomState(seed)
+    params = [
+        flow.nn.Parameter(flow.tensor(rng.randn(*shape), dtype=flow.float32))
+        for shape in shapes
+    ]
+    grads = [rng.randn(*shape).astype(np.float32) for shape in shapes]
+    return (params, grads)
+
+
+def _run_steps(optimizer_class, shapes, fused, steps, **kwargs):
+    (params, grads) = _make_params(shapes, seed=0)
+    optimizer = optimizer_class(params, fused=fused, **kwargs)
+    for step in range(steps):
+        for (param, grad) in zip(params, grads):
+            param.grad = flow.tensor(grad * (step + 1))
+        optimizer.step()
+    return [param.numpy() for param in params]
+
+
+# many small parameters and a few large ones, like the parameters of a deep model
+_SHAPES = [(7,), (3, 5), (1,), (4097,), (64, 33), (0,), (2, 2, 2)] * 8
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFusedOptimizerCpu(flow.unittest.TestCase):
+    def _check_fused(test_case, optimizer_class, **kwargs):
+        expected = _run_steps(optimizer_class, _SHAPES, False, 3, **kwargs)
+        actual = _run_steps(optimizer_class, _SHAPES, True, 3, **kwargs)
+        for (a, b) in zip(actual, expected):
+            test_case.assertTrue(np.allclose(a, b, rtol=1e-5, atol=1e-5))
+
+    def test_sgd(test_case):
+        test_case._check_fused(flow.optim.SGD, lr=0.1, weight_decay=0.01)
+
+    def test_momentum(test_case):
+        test_case._check_fused(flow.optim.SGD, lr=0.1, momentum=0.9)
+        test_case._check_fused(
+            flow.optim.SGD, lr=0.1, momentum=0.9, dampening=0.1, nesterov=True
+        )
+
+    def test_adam(test_case):
+        test_case._check_fused(flow.optim.Adam, lr=0.01, weight_decay=0.01)
+        test_case._check_fused(flow.optim.Adam, lr=0.01, do_bias_correction=False)
+
+    def test_adamw(test_case):
+        test_case._check_fused(flow.optim.AdamW, lr=0.01, weight_decay=0.01)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,112 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+# (shape, axes) covering the last dim, first dim, middle dims and all dims
+_REDUCE_CASES = [
+    ((1 << 20,), (0,)),
+    ((3, 70001), (1,)),
+    ((1000, 37), (1,)),
+    ((70001, 3), (0,)),
+    ((129, 2049), (0,)),
+    ((7, 33, 4097), (0, 2)),
+    ((8, 300, 500), (1,)),
+    ((1000, 3, 7), (1,)),
+    ((40, 5, 6, 7), (0, 2, 3)),
+    ((40, 5, 6, 7), (1, 3)),
+    ((16, 32, 64), (0, 1, 2)),
+]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestReduceCpu(flow.unittest.TestCase):
+    def test_reduce_shapes_and_axes(test_case):
+        for (shape, axes) in _REDUCE_CASES:
+            x = np.random.randn(*shape)
+            for dtype in [np.float32, np.float64, np.int64]:
+                x_dtype = (x * 100 if dtype == np.int64 else x).astype(dtype)
+                of_x = flow.tensor(x_dtype)
+                test_case.assertTrue(
+                    np.allclose(
+                        flow.sum(of_x, dim=axes).numpy(),
+                        np.sum(x_dtype.astype(np.float64), axis=axes),
+                        rtol=1e-5,
+                        atol=1e-3,
+                    )
+                )
+                test_case.assertTrue(
+                    np.array_equal(
+                        flow.amax(of_x, dim=axes).numpy(), np.amax(x_dtype, axis=axes)
+                    )
+                )
+                test_case.assertTrue(
+                    np.array_equal(
+                        flow.amin(of_x, dim=axes).numpy(), np.amin(x_dtype, axis=axes)
+                    )
+                )
+            test_case.assertTrue(
+                np.allclose(
+                    flow.mean(flow.tensor(x.astype(np.float32)), dim=axes).numpy(),
+                    np.mean(x, axis=axes),
+                    rtol=1e-5,
+                    atol=1e-6,
+                )
+            )
+
+    def test_float_sum_accuracy(test_case):
+        # a naive float32 sum of 2^24 values close to 1 loses several digits
+        x = np.random.uniform(0.5, 1.5, size=1 << 24).astype(np.float32)
+        expected = np.sum(x.astype(np.float64))
+        of_sum = flow.sum(flow.tensor(x)).numpy()
+        test_case.assertLess(abs(of_sum - expected) / expected, 1e-6)
+        # the chunks of a reduction do not depend on scheduling
+        test_case.assertEqual(flow.sum(flow.tensor(x)).numpy(), of_sum)
+
+    def test_broadcast_div_backward(test_case):
+        # broadcast_div_grad reduces its tmp buffer into dy and passes it as tmp_storage too
+        for (x_shape, b_shape) in [
+            ((70001, 3), (3,)),
+            ((129, 2049), (2049,)),
+            ((3, 70001), (3, 1)),
+            ((7, 33, 4097), (33, 1)),
+        ]:
+            x = np.random.randn(*x_shape)
+            b = np.random.uniform(0.5, 1.5, size=b_shape)
+            of_x = flow.tensor(x, requires_grad=True)
+            of_b = flow.tensor(b, requires_grad=True)
+            (of_x / of_b).sum().backward()
+            reduce_axes = tuple(
+                i
+                for i in range(len(x_shape))
+                if i < len(x_shape) - len(b_shape)
+                or b_shape[i - len(x_shape) + len(b_shape)] == 1
+            )
+            expected = np.sum(-x / (b * b), axis=reduce_axes).reshape(b_shape)
+            test_case.assertTrue(
+                np.allclose(of_b.grad.numpy(), expected, rtol=1e-5, atol=1e-5)
+            )
+            test_case.assertTrue(
+                np.allclose(of_x.grad.numpy(), np.broadcast_to(1 / b, x_shape))
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
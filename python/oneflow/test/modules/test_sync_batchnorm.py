@@ -96,5 +96,45 @@ class TestSyncBatchNorm(flow.unittest.TestCase):
         test_case.assertTrue(np.allclose(torch_grad, of_input.grad.numpy(), atol=1e-8,))
 
 
+@flow.unittest.skip_unless_1n2d()
+class TestSyncBatchNormCpu(flow.unittest.TestCase):
+    def test_sync_batchnorm2d_cpu(test_case):
+        os.environ["ONEFLOW_ENABLE_NHWC"] = "0"
+        rank = flow.env.get_rank()
+        rng = np.random.RandomState(0)
+        input_np = rng.randn(8, 4, 5, 6)
+        dy_np = rng.randn(8, 4, 5, 6)
+        local = slice(rank * 4, (rank + 1) * 4)
+
+        of_input = flow.tensor(
+            input_np[local], dtype=flow.float32, requires_grad=True
+        )
+        of_bn = flow.nn.SyncBatchNorm.convert_sync_batchnorm(flow.nn.BatchNorm2d(4))
+        of_res = of_bn(of_input)
+        (of_res * flow.tensor(dy_np[local], dtype=flow.float32)).sum().backward()
+
+        # batch norm over the global batch of both ranks
+        axes = (0, 2, 3)
+        mean = input_np.mean(axis=axes, keepdims=True)
+        var = input_np.var(axis=axes, keepdims=True)
+        x_hat = (input_np - mean) / np.sqrt(var + 1e-5)
+        grad = (
+            dy_np
+            - dy_np.mean(axis=axes, keepdims=True)
+            - x_hat * (dy_np * x_hat).mean(axis=axes, keepdims=True)
+        ) / np.sqrt(var + 1e-5)
+        count = input_np.size // 4
+        unbiased_var = var.reshape(-1) * count / (count - 1)
+
+        test_case.assertTrue(np.allclose(of_res.numpy(), x_hat[local], atol=1e-5))
+        test_case.assertTrue(np.allclose(of_input.grad.numpy(), grad[local], atol=1e-5))
+        test_case.assertTrue(
+            np.allclose(of_bn.running_mean.numpy(), 0.1 * mean.reshape(-1), atol=1e-5)
+        )
+        test_case.assertTrue(
+            np.allclose(of_bn.running_var.numpy(), 0.9 + 0.1 * unbiased_var, atol=1e-5)
+        )
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,60 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _make_state_dict(num_tensors, numel):
+    rng = np.random.RandomState(0)
+    return {
+        "layer{}.weight".format(i): flow.tensor(
+            rng.rand(numel).astype(np.float32).reshape(-1, 64)
+        )
+        for i in range(num_tensors)
+    }
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestTensorPack(flow.unittest.TestCase):
+    def test_save_and_load(test_case):
+        state_dict = _make_state_dict(4, 64 * 10)
+        state_dict["step"] = flow.tensor([7], dtype=flow.int64)
+        with tempfile.TemporaryDirectory() as save_dir:
+            path = os.path.join(save_dir, "model.ofpack")
+            flow.save(state_dict, path, tensor_pack=True)
+            for load_path in [path, save_dir]:
+                loaded = flow.load(load_path)
+                test_case.assertEqual(list(loaded.keys()), list(state_dict.keys()))
+                for (name, x) in state_dict.items():
+                    test_case.assertEqual(loaded[name].dtype, x.dtype)
+                    test_case.assertTrue(
+                        np.array_equal(loaded[name].numpy(), x.numpy())
+                    )
+            # tensors backed by a private mapping can be updated in place
+            loaded = flow.load(path)
+            loaded["step"] += 1
+            test_case.assertEqual(loaded["step"].item(), 8)
+            test_case.assertEqual(flow.load(path)["step"].item(), 7)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,100 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+"""Writer of the columnar files read by ``oneflow.nn.ColumnarReader``. The layout must match
+``oneflow/user/data/columnar_file.h``.
+"""
+import struct
+from typing import Dict
+
+import numpy as np
+
+import oneflow.core.common.data_type_pb2 as data_type_pb2
+
+_MAGIC = 0x4C43464F
+_VERSION = 1
+_ALIGNMENT = 64
+_FOOTER_HEADER = struct.Struct("<IIQ")
+_COLUMN_META = struct.Struct("<IIiIQ")
+_CHUNK_META = struct.Struct("<QQdd")
+_TRAILER = struct.Struct("<QII")
+
+_NUMPY_TO_DATA_TYPE = {
+    np.dtype(np.int8): data_type_pb2.kInt8,
+    np.dtype(np.uint8): data_type_pb2.kUInt8,
+    np.dtype(np.int32): data_type_pb2.kInt32,
+    np.dtype(np.int64): data_type_pb2.kInt64,
+    np.dtype(np.float32): data_type_pb2.kFloat,
+    np.dtype(np.float64): data_type_pb2.kDouble,
+}
+
+
+def write_columnar_file(
+    path: str, columns: Dict[str, np.ndarray], row_group_size: int = 65536
+) -> None:
+    """Writes a table to a columnar file. Every column is an array whose first dimension is
+    the row, all columns must have the same number of rows."""
+    names = [name.encode("utf-8") for name in columns.keys()]
+    arrays = [np.ascontiguousarray(array) for array in columns.values()]
+    if len(arrays) == 0:
+        raise ValueError("a columnar file needs at least one column")
+    num_rows = arrays[0].shape[0]
+    for (name, array) in zip(columns.keys(), arrays):
+        if array.shape[0] != num_rows:
+            raise ValueError("column {} has a different number of rows".format(name))
+        if array.dtype not in _NUMPY_TO_DATA_TYPE:
+            raise ValueError("unsupported columnar dtype {}".format(array.dtype))
+    arrays = [array.reshape(num_rows, -1) for array in arrays]
+
+    chunks = []
+    with open(path, "wb") as f:
+        offset = 0
+        for begin in range(0, num_rows, row_group_size):
+            end = min(begin + row_group_size, num_rows)
+            for array in arrays:
+                padding = -offset % _ALIGNMENT
+                f.write(b"\0" * padding)
+                offset += padding
+                chunk = array[begin:end]
+                chunks.append(
+                    (offset, end - begin, float(chunk.min()), float(chunk.max()))
+                    if chunk.size > 0
+                    else (offset, end - begin, 0.0, 0.0)
+                )
+                f.write(chunk.tobytes())
+                offset += chunk.nbytes
+
+        footer = bytearray()
+        footer += _FOOTER_HEADER.pack(len(arrays), 0, len(chunks) // len(arrays))
+        name_offset = (
+            _FOOTER_HEADER.size
+            + len(arrays) * _COLUMN_META.size
+            + len(chunks) * _CHUNK_META.size
+        )
+        for (name, array) in zip(names, arrays):
+            footer += _COLUMN_META.pack(
+                name_offset,
+                len(name),
+                _NUMPY_TO_DATA_TYPE[array.dtype],
+                0,
+                array.shape[1],
+            )
+            name_offset += len(name)
+        for chunk in chunks:
+            footer += _CHUNK_META.pack(*chunk)
+        for name in names:
+            footer += name
+        f.write(footer)
+        f.write(_TRAILER.pack(len(footer), _VERSION, _MAGIC))
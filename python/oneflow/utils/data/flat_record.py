@@ -0,0 +1,157 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+"""Writer of the flat record format read by ``oneflow.nn.FlatRecordReader`` and a converter
+from OFRecord files. The layout must match ``oneflow/user/data/flat_record.h``.
+
+Usage::
+
+    python3 -m oneflow.utils.data.flat_record <ofrecord dir or file> <output dir or file>
+"""
+import argparse
+import os
+import struct
+from typing import Dict
+
+import numpy as np
+
+import oneflow.core.common.data_type_pb2 as data_type_pb2
+import oneflow.core.record.record_pb2 as record_pb2
+
+_MAGIC = 0x5246464F
+_ALIGNMENT = 8
+_HEADER = struct.Struct("<II")
+_FIELD_HEADER = struct.Struct("<IIiIQQ")
+
+_NUMPY_TO_DATA_TYPE = {
+    np.dtype(np.int8): data_type_pb2.kInt8,
+    np.dtype(np.uint8): data_type_pb2.kUInt8,
+    np.dtype(np.int32): data_type_pb2.kInt32,
+    np.dtype(np.int64): data_type_pb2.kInt64,
+    np.dtype(np.float32): data_type_pb2.kFloat,
+    np.dtype(np.float64): data_type_pb2.kDouble,
+}
+
+
+def _round_up(n, align):
+    return (n + align - 1) // align * align
+
+
+def serialize_flat_record(fields: Dict[str, np.ndarray]) -> bytes:
+    """Serializes a dict of 1-d numpy arrays into one flat record."""
+    names = [name.encode("utf-8") for name in fields.keys()]
+    arrays = [np.ascontiguousarray(array).reshape(-1) for array in fields.values()]
+    offset = _HEADER.size + len(arrays) * _FIELD_HEADER.size
+    name_offsets = []
+    for name in names:
+        name_offsets.append(offset)
+        offset += len(name)
+    data_offsets = []
+    for array in arrays:
+        offset = _round_up(offset, _ALIGNMENT)
+        data_offsets.append(offset)
+        offset += array.nbytes
+
+    record = bytearray(offset)
+    _HEADER.pack_into(record, 0, _MAGIC, len(arrays))
+    for (i, (name, array)) in enumerate(zip(names, arrays)):
+        if array.dtype not in _NUMPY_TO_DATA_TYPE:
+            raise ValueError("unsupported flat record dtype {}".format(array.dtype))
+        _FIELD_HEADER.pack_into(
+            record,
+            _HEADER.size + i * _FIELD_HEADER.size,
+            name_offsets[i],
+            len(name),
+            _NUMPY_TO_DATA_TYPE[array.dtype],
+            0,
+            data_offsets[i],
+            array.size,
+        )
+        record[name_offsets[i] : name_offsets[i] + len(name)] = name
+        record[data_offsets[i] : data_offsets[i] + array.nbytes] = array.tobytes()
+    return bytes(record)
+
+
+def ofrecord_to_fields(record: record_pb2.OFRecord) -> Dict[str, np.ndarray]:
+    fields = {}
+    for (name, feature) in sorted(record.feature.items()):
+        kind = feature.WhichOneof("kind")
+        if kind == "bytes_list":
+            if len(feature.bytes_list.value) != 1:
+                raise ValueError(
+                    "bytes_list feature {} must have one value".format(name)
+                )
+            fields[name] = np.frombuffer(feature.bytes_list.value[0], dtype=np.int8)
+        elif kind == "float_list":
+            fields[name] = np.array(feature.float_list.value, dtype=np.float32)
+        elif kind == "double_list":
+            fields[name] = np.array(feature.double_list.value, dtype=np.float64)
+        elif kind == "int32_list":
+            fields[name] = np.array(feature.int32_list.value, dtype=np.int32)
+        elif kind == "int64_list":
+            fields[name] = np.array(feature.int64_list.value, dtype=np.int64)
+        else:
+            raise ValueError("unsupported feature {} of kind {}".format(name, kind))
+    return fields
+
+
+def _read_framed_records(path):
+    with open(path, "rb") as f:
+        while True:
+            size_bytes = f.read(8)
+            if len(size_bytes) < 8:
+                return
+            (size,) = struct.unpack("<q", size_bytes)
+            yield f.read(size)
+
+
+def _write_framed_record(f, record):
+    f.write(struct.pack("<q", len(record)))
+    f.write(record)
+
+
+def convert_ofrecord_file(ofrecord_path: str, flat_record_path: str) -> int:
+    """Converts one OFRecord part file, returns the number of records."""
+    num_records = 0
+    with open(flat_record_path, "wb") as f:
+        for record_bytes in _read_framed_records(ofrecord_path):
+            record = record_pb2.OFRecord()
+            record.ParseFromString(record_bytes)
+            _write_framed_record(f, serialize_flat_record(ofrecord_to_fields(record)))
+            num_records += 1
+    return num_records
+
+
+def convert_ofrecord(src: str, dst: str) -> int:
+    """Converts an OFRecord part file or every part file of a directory, keeping file names."""
+    if not os.path.isdir(src):
+        return convert_ofrecord_file(src, dst)
+    os.makedirs(dst, exist_ok=True)
+    num_records = 0
+    for file_name in sorted(os.listdir(src)):
+        src_path = os.path.join(src, file_name)
+        if os.path.isfile(src_path):
+            num_records += convert_ofrecord_file(src_path, os.path.join(dst, file_name))
+    return num_records
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Convert OFRecord files to flat records"
+    )
+    parser.add_argument("src", help="OFRecord part file or directory")
+    parser.add_argument("dst", help="output part file or directory")
+    args = parser.parse_args()
+    print("converted {} records".format(convert_ofrecord(args.src, args.dst)))